@@ -47,4 +47,21 @@ namespace Core
     }
     return true;
   }
-}
\ No newline at end of file
+
+  uint64_t Hash64(void const * a_pData, size_t a_size, uint64_t a_seed)
+  {
+    byte const * pBytes = static_cast<byte const *>(a_pData);
+    uint64_t hash = a_seed;
+    for (size_t i = 0; i < a_size; i++)
+    {
+      hash ^= pBytes[i];
+      hash *= 0x100'0000'01B3ULL;
+    }
+    return hash;
+  }
+
+  uint64_t Hash64(std::string const & a_str, uint64_t a_seed)
+  {
+    return Hash64(a_str.data(), a_str.size(), a_seed);
+  }
+}
@@ -72,6 +72,12 @@ namespace Core
 
   //Compare two serialized strings
   bool AreEqual(void const *, void const *);
+
+  //64-bit FNV-1a. Feed the previous result back in as the seed to hash
+  //several buffers as one.
+  uint64_t const HashSeed64 = 0xCBF2'9CE4'8422'2325ULL;
+  uint64_t Hash64(void const *, size_t, uint64_t seed = HashSeed64);
+  uint64_t Hash64(std::string const &, uint64_t seed = HashSeed64);
 }
 
 #endif
\ No newline at end of file
@@ -1,14 +1,25 @@
 
 #include <exception>
+#include <algorithm>
+#include <vector>
+#include <float.h>
+#include <cmath>
 
 #include "BSPTreeBuilder.h"
 #include "DgDynamicArray.h"
 #include "BSR_Assert.h"
+#include "ThreadPool/gc_ParallelFor.h"
 
 #define SCORE_BY_AREA
 
+//Nodes with fewer blocks than this are split on the current thread.
+static size_t const PARALLEL_THRESHOLD = 128;
+
+static uint32_t const INVALID_INDEX = 0xFFFFFFFF;
+
 BSPTreeBuilder::BSPTreeBuilder(Dg::DynamicArray<Block> const & a_blocks)
   : m_rBlocks(a_blocks)
+  , m_pThreadPool(nullptr)
 {
 
 }
@@ -18,9 +29,15 @@ BSPTreeBuilder::~BSPTreeBuilder()
 
 }
 
+void BSPTreeBuilder::SetThreadPool(GC::ThreadPool * a_pPool)
+{
+  m_pThreadPool = a_pPool;
+}
+
 void BSPTreeBuilder::Run()
 {
   m_result.clear();
+  m_leafIndices.clear();
 
   if (m_rBlocks.size()  > 0)
   {
@@ -32,171 +49,252 @@ void BSPTreeBuilder::Run()
       nodeBlocks.push_back(i);
     }
 
-    if (nodeBlocks.size() == 1)
-    {
-      uint32_t ind = GetLeafIndex(nodeBlocks[0]);
-    }
-    else
-    {
-      m_result.push_back(Node());
-      Split(0, nodeBlocks);
-    }
+    //Subtrees are built by tasks into their own buffers, then written out in the
+    //order the tree is walked, so the result does not depend on the thread count.
+    SubTree tree;
+    tree.root = Build(tree, nodeBlocks);
+
+    m_leafIndices.resize(m_rBlocks.size(), INVALID_INDEX);
+    Emit(tree, tree.root);
   }
 }
 
-void  BSPTreeBuilder::Split(uint32_t a_nodeIndex,
-                            Dg::DynamicArray<BlockID> const & a_nodeBlocks)
+//page 362, real time collision detection
+//score = K * straddling + (1 - K) * abs(below - above)
+//where each term is the total area (or number) of blocks on that side.
+static float const K = 0.5f;
+
+//The edge of a block along one axis.
+struct SweepEdge
 {
-  uint32_t bestScore = FLT_MAX;
-  int bestElement = -1;
-  float bestOffset = 0.0f;
-  Dg::DynamicArray<BlockID> aboveBlocks, belowBlocks;
+  uint32_t  coord;
+  uint32_t  weight;
+};
 
-  Dg::DynamicArray<vec2> candidates = GetCandidatePoints(a_nodeBlocks);
+//A split plane to try. Order is the position the plane was found in when walking the
+//node blocks, used to pick the same split each build when scores tie.
+struct SweepCandidate
+{
+  uint32_t  coord;
+  uint32_t  order;
+};
 
-  for (size_t c = 0; c < candidates.size(); c++)
-  {
-    for (int i = 0; i < 2; i++)
-    {
-      Dg::DynamicArray<BlockID> newAbovePolys, newBelowPolys;
-
-      float newScore = MakeSplit(candidates[c][i], i, a_nodeBlocks, newAbovePolys, newBelowPolys);
-
-      if (newScore < bestScore)
-      {
-        bestElement = i;
-        bestOffset = candidates[c][i];
-        bestScore = newScore;
-        aboveBlocks = newAbovePolys;
-        belowBlocks = newBelowPolys;
-      }
-    }
-  }
+static bool operator<(SweepEdge const & a_left, SweepEdge const & a_right)
+{
+  return a_left.coord < a_right.coord;
+}
 
-  BSR_ASSERT(bestScore < FLT_MAX, "BSPTreeBuilder::Split() No valid split found!");
-  
-  m_result[a_nodeIndex].SetType(Node::E_Branch);
+static bool operator<(SweepCandidate const & a_left, SweepCandidate const & a_right)
+{
+  if (a_left.coord != a_right.coord)
+    return a_left.coord < a_right.coord;
+  return a_left.order < a_right.order;
+}
+
+BSPTreeBuilder::ChildRef BSPTreeBuilder::Build(SubTree & a_tree,
+                                               Dg::DynamicArray<BlockID> const & a_nodeBlocks) const
+{
+  if (a_nodeBlocks.size() == 1)
+    return ChildRef{ChildRef::E_Leaf, a_nodeBlocks[0]};
+
+  SplitPlane best;
+  best.score = FLT_MAX;
+  best.order = UINT32_MAX;
+  best.element = -1;
+  best.offset = 0;
 
-  bestOffset = round(bestOffset);
+  for (int i = 0; i < 2; i++)
+    FindBestSplit(i, a_nodeBlocks, best);
 
-  BSR_ASSERT(bestOffset >= 0.0f);
-  BSR_ASSERT(bestOffset <= 255.0f);
+  BSR_ASSERT(best.score < FLT_MAX, "BSPTreeBuilder::Build() No valid split found!");
+  BSR_ASSERT(best.offset <= 255);
 
-  m_result[a_nodeIndex].SetElement(bestElement);
-  m_result[a_nodeIndex].SetOffset(bestOffset);
+  Dg::DynamicArray<BlockID> childBlocks[2];
+  MakeSplit(best.offset, best.element, a_nodeBlocks, childBlocks[1], childBlocks[0]);
 
-  if (aboveBlocks.size() == 1)
+  uint32_t nodeIndex = uint32_t(a_tree.nodes.size());
+  BuildNode node;
+  node.element = best.element;
+  node.offset = best.offset;
+  a_tree.nodes.push_back(node);
+
+  if (m_pThreadPool == nullptr || a_nodeBlocks.size() < PARALLEL_THRESHOLD)
   {
-    uint32_t ind = GetLeafIndex(aboveBlocks[0]);
-    m_result[a_nodeIndex].SetChildAboveInd(ind);
+    for (int c = 0; c < 2; c++)
+    {
+      ChildRef child = Build(a_tree, childBlocks[c]);
+      a_tree.nodes[nodeIndex].children[c] = child;
+    }
+    return ChildRef{ChildRef::E_Node, nodeIndex};
   }
-  else
+
+  //Tasks only touch their own subtree. The buffers are created up front so they do
+  //not move while the tasks run.
+  uint32_t firstTask = uint32_t(a_tree.tasks.size());
+  for (int c = 0; c < 2; c++)
   {
-    m_result.push_back(Node());
-    uint32_t ind = (uint32_t)m_result.size() - 1;
-    m_result[a_nodeIndex].SetChildAboveInd(ind);
-    Split(ind, aboveBlocks);
+    a_tree.tasks.push_back(std::unique_ptr<SubTree>(new SubTree()));
+    a_tree.nodes[nodeIndex].children[c] = ChildRef{ChildRef::E_Task, firstTask + c};
   }
 
-  if (belowBlocks.size() == 1)
+  GC::ParallelFor(m_pThreadPool, 2, 1, [&](uint32_t a_begin, uint32_t a_end)
   {
-    uint32_t ind = GetLeafIndex(belowBlocks[0]);
-    m_result[a_nodeIndex].SetChildBelowInd(ind);
-  }
-  else
+    for (uint32_t c = a_begin; c < a_end; c++)
+    {
+      SubTree & subTree = *a_tree.tasks[firstTask + c];
+      subTree.root = Build(subTree, childBlocks[c]);
+    }
+  });
+
+  return ChildRef{ChildRef::E_Node, nodeIndex};
+}
+
+//Writes out the nodes depth first, each branch before its children and the child
+//above before the child below. A leaf is written the first time its block is reached.
+uint32_t BSPTreeBuilder::Emit(SubTree const & a_tree, ChildRef a_ref)
+{
+  if (a_ref.type == ChildRef::E_Leaf)
+    return GetLeafIndex(a_ref.index);
+
+  if (a_ref.type == ChildRef::E_Task)
   {
-    m_result.push_back(Node());
-    uint32_t ind = (uint32_t)m_result.size() - 1;
-    m_result[a_nodeIndex].SetChildBelowInd(ind);
-    Split(ind, belowBlocks);
+    SubTree const & subTree = *a_tree.tasks[a_ref.index];
+    return Emit(subTree, subTree.root);
   }
-}
 
+  BuildNode const & node = a_tree.nodes[a_ref.index];
+
+  m_result.push_back(Node());
+  uint32_t ind = (uint32_t)m_result.size() - 1;
+  m_result[ind].SetType(Node::E_Branch);
+  m_result[ind].SetElement(node.element);
+  m_result[ind].SetOffset(float(node.offset));
+
+  uint32_t aboveInd = Emit(a_tree, node.children[0]);
+  m_result[ind].SetChildAboveInd(aboveInd);
+
+  uint32_t belowInd = Emit(a_tree, node.children[1]);
+  m_result[ind].SetChildBelowInd(belowInd);
+
+  return ind;
+}
 
 uint32_t BSPTreeBuilder::GetLeafIndex(BlockID a_id)
 {
-  for (size_t i = 0; i < m_result.size(); i++)
-  {
-    if (m_result[i].GetType() == Node::E_Leaf)
-    {
-      if (m_result[i].GetBlockID() == a_id)
-      {
-        return (uint32_t)i;
-      }
-    }
-  }
+  if (m_leafIndices[a_id] != INVALID_INDEX)
+    return m_leafIndices[a_id];
 
   m_result.push_back(Node());
   uint32_t ind = (uint32_t)m_result.size() - 1;
   m_result[ind].SetType(Node::E_Leaf);
   m_result[ind].SetBlockID(a_id);
+  m_leafIndices[a_id] = ind;
   return ind;
 }
 
-Dg::DynamicArray<vec2> BSPTreeBuilder::GetCandidatePoints(Dg::DynamicArray<BlockID> const & a_blocks) const
+//Scores every split plane along one axis in a single sweep. The block edges are
+//sorted, so moving the plane forward only ever moves blocks from 'above' to
+//'straddling' to 'below', and running sums give the totals on each side.
+//
+//Candidate planes are the block corners, visited in the order the blocks appear in
+//the node, x before y. Ties go to the plane visited first.
+//
+//Scores are compared as floats. The builder used to truncate the best score to an
+//integer, so planes scoring within 1 of each other tied and the first visited won.
+//The lower score now wins, so trees can differ from those built before.
+void BSPTreeBuilder::FindBestSplit(int a_ele,
+                                   Dg::DynamicArray<BlockID> const & a_nodeBlocks,
+                                   SplitPlane & a_best) const
 {
-  Dg::DynamicArray<vec2> result;
+  size_t count = a_nodeBlocks.size();
+  std::vector<SweepEdge> starts(count), ends(count);
+  std::vector<SweepCandidate> candidates(count * 2);
+  uint32_t totalWeight = 0;
 
-  for (size_t i = 0; i < a_blocks.size(); i++)
+  for (size_t i = 0; i < count; i++)
   {
-    BlockID id = a_blocks[i];
-    Block block = m_rBlocks[id];
-    vec2 p0, p1;
+    Block const & block = m_rBlocks[a_nodeBlocks[i]];
+    uint32_t p0 = uint32_t(block.lowerLeft[a_ele]);
+    uint32_t p1 = p0 + uint32_t(block.dimensions[a_ele]);
+    uint32_t weight = BlockWeight(block);
+
+    starts[i].coord = p0;
+    starts[i].weight = weight;
+    ends[i].coord = p1;
+    ends[i].weight = weight;
+
+    //Lower left corner then upper right, each tried along x then y.
+    candidates[i * 2 + 0].coord = p0;
+    candidates[i * 2 + 0].order = uint32_t(((i * 2 + 0) * 2) + a_ele);
+    candidates[i * 2 + 1].coord = p1;
+    candidates[i * 2 + 1].order = uint32_t(((i * 2 + 1) * 2) + a_ele);
+
+    totalWeight += weight;
+  }
+
+  std::sort(starts.begin(), starts.end());
+  std::sort(ends.begin(), ends.end());
+  std::sort(candidates.begin(), candidates.end());
+
+  size_t s = 0, e = 0;
+  size_t nBefore = 0, nBelow = 0;
+  uint32_t weightBefore = 0, weightBelow = 0;
 
-    p0[0] = float(block.lowerLeft[Block::X]);
-    p0[1] = float(block.lowerLeft[Block::Y]);
+  for (size_t c = 0; c < candidates.size(); c++)
+  {
+    //Duplicates follow the first time the plane was visited.
+    if (c > 0 && candidates[c].coord == candidates[c - 1].coord)
+      continue;
 
-    p1[0] = float(block.lowerLeft[Block::X]) + block.dimensions[Block::W];
-    p1[1] = float(block.lowerLeft[Block::Y]) + block.dimensions[Block::H];
+    uint32_t offset = candidates[c].coord;
 
-    bool p0_exists = false;
-    bool p1_exists = false;
-    for (size_t b = 0; b < result.size(); b++)
+    //Blocks starting before the plane are below it or straddle it...
+    for (; s < count && starts[s].coord < offset; s++)
     {
-      if (result[b] == p0)
-        p0_exists = true;
-      if (result[b] == p1)
-        p1_exists = true;
+      nBefore++;
+      weightBefore += starts[s].weight;
+    }
 
-      if (p0_exists && p1_exists)
-        break;
+    //...and of those, blocks ending at or before it are below. Blocks are never
+    //empty, so an edge ending at the plane must have started before it.
+    for (; e < count && ends[e].coord <= offset; e++)
+    {
+      nBelow++;
+      weightBelow += ends[e].weight;
     }
 
-    if (!p0_exists)
-      result.push_back(p0);
-    if (!p1_exists)
-      result.push_back(p1);
+    size_t nAbove = count - nBefore;
+
+    //Every block would end up on one side, recursing forever.
+    if (nAbove == 0 || nBelow == 0)
+      continue;
+
+    float weightAbove = float(totalWeight - weightBefore);
+    float weightStraddling = float(weightBefore - weightBelow);
+    float score = K * weightStraddling + (1.0f - K) * abs(float(weightBelow) - weightAbove);
+
+    if (score < a_best.score || (score == a_best.score && candidates[c].order < a_best.order))
+    {
+      a_best.score = score;
+      a_best.order = candidates[c].order;
+      a_best.element = a_ele;
+      a_best.offset = offset;
+    }
   }
-  return result;
 }
 
-float BSPTreeBuilder::MakeSplit(float a_offset, int a_ele, 
-                                Dg::DynamicArray<BlockID> const & a_nodeBlocks,
-                                Dg::DynamicArray<BlockID> & a_belowBlocks,
-                                Dg::DynamicArray<BlockID> & a_aboveBlocks) const
+void BSPTreeBuilder::MakeSplit(uint32_t a_offset, int a_ele, 
+                               Dg::DynamicArray<BlockID> const & a_nodeBlocks,
+                               Dg::DynamicArray<BlockID> & a_belowBlocks,
+                               Dg::DynamicArray<BlockID> & a_aboveBlocks) const
 {
-  //page 362, float time collision detection
-  //score = K * nStraddling + (1 - K) * abs(nAbove - nBelow)
-
-  float K = 0.5f;
-  float epsilon = 0.0001f;
   Dg::DynamicArray<BlockID> straddlingBlocks;
 
   for (size_t i = 0; i < a_nodeBlocks.size(); i++)
   {
     BlockID id = a_nodeBlocks[i];
-
-    //flag values:
-    // 1 : polygon sits completely to the LEFT of the line
-    // 2 : polygon sits completely to the RIGHT of the line
-    // 3 : polygon straddles line
-    // 0 : Something weird is happening. Could be polygon has no vertices
-    //     or the polygon is ultra thin, is aligned with the line and 
-    //     straddles it.
-    int flag = 0;
-    float p0, p1;
-    p0 = m_rBlocks[id].lowerLeft[a_ele];
-    p1 = p0 + m_rBlocks[id].dimensions[a_ele];
+    uint32_t p0 = uint32_t(m_rBlocks[id].lowerLeft[a_ele]);
+    uint32_t p1 = p0 + uint32_t(m_rBlocks[id].dimensions[a_ele]);
 
     if (p0 >= a_offset)
     {
@@ -212,47 +310,21 @@ float BSPTreeBuilder::MakeSplit(float a_offset, int a_ele,
     }
   }
 
-  //Invalid splits
-  bool badSplit = (a_belowBlocks.size() == 0) && (a_aboveBlocks.size() == 0); //Splitting line intersects all polygons
-
-#ifdef SCORE_BY_AREA
-  float areaBelow = TotalArea(a_belowBlocks);
-  float areaAbove = TotalArea(a_aboveBlocks);
-  float areaStraddling = TotalArea(straddlingBlocks);
-  float score = K * areaStraddling + (1.0f - K) * abs(areaBelow - areaAbove);
-#else
-  float nBelow = (float)a_belowBlocks.size();
-  float nAbove = (float)a_aboveBlocks.size();
-  float nStraddling = (float)straddlingBlocks.size();
-  float score = K * nStraddling + (1.0 - K) * abs(nBelow - nAbove);
-#endif
-
+  //Straddling blocks go down both sides
   for (size_t i = 0; i < straddlingBlocks.size(); i++)
   {
     a_belowBlocks.push_back(straddlingBlocks[i]);
     a_aboveBlocks.push_back(straddlingBlocks[i]);
   }
-
-  badSplit = badSplit || (a_aboveBlocks.size() == a_nodeBlocks.size()); //Infinite recursion
-  badSplit = badSplit || (a_belowBlocks.size() == a_nodeBlocks.size()); //Infinite recursion
-
-  if (badSplit)
-  {
-    return FLT_MAX;
-  }
-
-  return score;
 }
 
-float BSPTreeBuilder::TotalArea(Dg::DynamicArray<BlockID> const & a_blocks) const
+uint32_t BSPTreeBuilder::BlockWeight(Block const & a_block)
 {
-  float result = 0.0f;
-  for (size_t i = 0; i < a_blocks.size(); i++)
-  {
-    Block block = m_rBlocks[a_blocks[i]];
-    result += block.dimensions[0] * block.dimensions[1];
-  }
-  return result;
+#ifdef SCORE_BY_AREA
+  return uint32_t(a_block.dimensions[0]) * uint32_t(a_block.dimensions[1]);
+#else
+  return 1;
+#endif
 }
 
 Dg::DynamicArray<Node> const & BSPTreeBuilder::GetResults() const
@@ -1,10 +1,18 @@
 #ifndef BSPTREEBUILDER_H
 #define BSPTREEBUILDER_H
 
+#include <vector>
+#include <memory>
+
 #include "Types.h"
 #include "MapData.h"
 #include "DgDynamicArray.h"
 
+namespace GC
+{
+  class ThreadPool;
+}
+
 class BSPTreeBuilder
 {
   typedef uint32_t BlockID;
@@ -14,6 +22,10 @@ public:
   BSPTreeBuilder(Dg::DynamicArray<Block> const &);
   ~BSPTreeBuilder();
 
+  //Subtrees are built in parallel on this pool. The tree is the same with or
+  //without one.
+  void SetThreadPool(GC::ThreadPool *);
+
   void Run();
   Dg::DynamicArray<Node> const & GetResults() const;
 
@@ -23,19 +35,62 @@ private:
   BSPTreeBuilder & operator=(BSPTreeBuilder const &);
 
 private:
-  void  Split(uint32_t a_nodeIndex,
-              Dg::DynamicArray<BlockID> const &);
+
+  //Best split found so far
+  struct SplitPlane
+  {
+    float     score;
+    uint32_t  order;
+    int       element;
+    uint32_t  offset;
+  };
+
+  //Child of a node being built: a leaf block, a node in the same subtree, or the
+  //root of a subtree built by another task.
+  struct ChildRef
+  {
+    enum Type
+    {
+      E_Leaf,
+      E_Node,
+      E_Task
+    };
+
+    Type      type;
+    uint32_t  index;
+  };
+
+  struct BuildNode
+  {
+    int       element;
+    uint32_t  offset;
+    ChildRef  children[2]; //above, below
+  };
+
+  struct SubTree
+  {
+    ChildRef                              root;
+    std::vector<BuildNode>                nodes;
+    std::vector<std::unique_ptr<SubTree>> tasks;
+  };
+
+  ChildRef Build(SubTree &, Dg::DynamicArray<BlockID> const & nodeBlocks) const;
+  uint32_t Emit(SubTree const &, ChildRef);
   uint32_t GetLeafIndex(BlockID);
-  Dg::DynamicArray<vec2> GetCandidatePoints(Dg::DynamicArray<BlockID> const &) const;
-  float MakeSplit(float, int, 
-                  Dg::DynamicArray<BlockID> const & nodeBlocks,
-                  Dg::DynamicArray<BlockID> & below,
-                  Dg::DynamicArray<BlockID> & above) const;
-  float TotalArea(Dg::DynamicArray<BlockID> const &) const;
+  void FindBestSplit(int element,
+                     Dg::DynamicArray<BlockID> const & nodeBlocks,
+                     SplitPlane & best) const;
+  void MakeSplit(uint32_t offset, int element,
+                 Dg::DynamicArray<BlockID> const & nodeBlocks,
+                 Dg::DynamicArray<BlockID> & below,
+                 Dg::DynamicArray<BlockID> & above) const;
+  static uint32_t BlockWeight(Block const &);
 private:
 
   Dg::DynamicArray<Block> const & m_rBlocks;
   Dg::DynamicArray<Node>          m_result;
+  std::vector<uint32_t>           m_leafIndices;
+  GC::ThreadPool *                m_pThreadPool;
 };
 
 #endif
\ No newline at end of file
@@ -4,158 +4,77 @@
 #include "BlockPartition.h"
 #include "BSR_Assert.h"
 
-int BlockPartition::X(int a_val) const
+float BlockPartition::Stats::MeanArea() const
 {
-  return a_val % int(m_mask.length(1));
+  if (blockCount == 0)
+    return 0.0f;
+  return float(totalArea) / float(blockCount);
 }
 
-int BlockPartition::Y(int a_val) const
+//Finds the largest rectangle of empty cells using the histogram method. Row by row,
+//each column holds the height of the empty run ending at that row. A stack of
+//columns with increasing heights gives, for each column, the widest rectangle of its
+//height, so each row is done in a single pass. Ties go to the first rectangle found.
+bool BlockPartition::FindLargestBlock(Block & a_out)
 {
-  return a_val / int(m_mask.length(1));
-}
-
-int BlockPartition::GetNextSeed(int a_seed)
-{
-  while (a_seed < m_mask.length(0) * m_mask.length(1))
-  {
-    int x = X(a_seed);
-    int y = Y(a_seed);
-
-    if (!m_mask.at(x, y))
-      return a_seed;
-    a_seed++;
-  }
-
-  return INVALID_SEED;
-}
-
-bool BlockPartition::GetNextBlock(unsigned a_blockSize, int & a_seed, Block & a_out)
-{
-  while (true)
-  {
-    a_seed = GetNextSeed(a_seed);
-    if (a_seed == INVALID_SEED)
-      break;
-
-    a_out = BuildBlock(a_seed);
-    if (a_out.dimensions[Block::W] >= a_blockSize && a_out.dimensions[Block::H] >= a_blockSize)
-      return true;
-  }
-  return false;
-}
+  uint32_t const width = uint32_t(m_mask.length(0));
+  uint32_t const height = uint32_t(m_mask.length(1));
 
-Block BlockPartition::BuildBlock(int a_seed)
-{
-  uint32_t h = 1;
-  uint32_t w = 1;
-  uint32_t min_y = Y(a_seed);
-  uint32_t min_x = X(a_seed);
+  uint32_t bestArea = 0;
+  uint32_t bestX = 0, bestY = 0, bestW = 0, bestH = 0;
 
-  //CheckCoordinate(a_seed);
-  BSR_ASSERT(!m_mask(min_x, min_y), "Not a proper seed");
+  m_heights.assign(width, 0);
 
-  uint32_t flags = 0;
-  while (flags != 0xF)
+  for (uint32_t y = 0; y < height; y++)
   {
-    //Try to expand block in the -x direction
-    if (!(flags & 1))
+    for (uint32_t x = 0; x < width; x++)
     {
-      if (min_x > 0)
-      {
-        for (uint32_t y = min_y; y < min_y + h; y++)
-        {
-          if (m_mask.at(size_t(min_x - 1), size_t(y)))
-          {
-            flags |= 1;
-            break;
-          }
-        }
-
-        if (!(flags & 1))
-        {
-          min_x = min_x - 1;
-          w = w + 1;
-        }
-      }
+      if (m_mask(size_t(x), size_t(y)))
+        m_heights[x] = 0;
       else
-        flags |= 1;
+        m_heights[x]++;
     }
 
-    //Try to expand block in the +y direction
-    if (!(flags & 2))
+    //Column 'width' acts as a zero height sentinel which empties the stack.
+    m_stack.clear();
+    for (uint32_t x = 0; x <= width; x++)
     {
-      if (min_y + h < uint32_t(m_mask.length(1)))
+      uint32_t h = (x < width) ? m_heights[x] : 0;
+      while (!m_stack.empty() && m_heights[m_stack.back()] >= h)
       {
-        for (uint32_t x = min_x; x < min_x + w; x++)
-        {
-          if (m_mask.at(size_t(x), size_t(min_y + h)))
-          {
-            flags |= 2;
-            break;
-          }
-        }
+        uint32_t top = m_heights[m_stack.back()];
+        m_stack.pop_back();
 
-        if (!(flags & 2))
-          h = h + 1;
-      }
-      else
-        flags |= 2;
-    }
-
-    //Try to expand block in the +x direction
-    if (!(flags & 4))
-    {
-      if (min_x + w < uint32_t(m_mask.length(0)))
-      {
-        for (uint32_t y = min_y; y < min_y + h; y++)
+        uint32_t left = m_stack.empty() ? 0 : m_stack.back() + 1;
+        uint32_t w = x - left;
+        uint32_t area = w * top;
+        if (area > bestArea)
         {
-          if (m_mask.at(size_t(min_x + w), size_t(y)))
-          {
-            flags |= 4;
-            break;
-          }
+          bestArea = area;
+          bestX = left;
+          bestY = y + 1 - top;
+          bestW = w;
+          bestH = top;
         }
-
-        if (!(flags & 4))
-          w = w + 1;
       }
-      else
-        flags |= 4;
-    }
-
-    //Try to expand block in the -y direction
-    if (!(flags & 8))
-    {
-      if (min_y > 0)
-      {
-        for (uint32_t x = min_x; x < min_x + w; x++)
-        {
-          if (m_mask.at(size_t(x), size_t(min_y - 1)))
-          {
-            flags |= 8;
-            break;
-          }
-        }
-
-        if (!(flags & 8))
-        {
-          min_y = min_y - 1;
-          h = h + 1;
-        }
-      }
-      else
-        flags |= 8;
+      m_stack.push_back(x);
     }
   }
 
-  Block result;
+  if (bestArea == 0)
+    return false;
 
-  result.lowerLeft[Block::X] = min_x;
-  result.lowerLeft[Block::Y] = min_y;
-  result.dimensions[Block::W] = w;
-  result.dimensions[Block::H] = h;
+  //Any part of an empty rectangle is empty too. The rest is picked up later.
+  if (bestW > m_maxBlockSize)
+    bestW = m_maxBlockSize;
+  if (bestH > m_maxBlockSize)
+    bestH = m_maxBlockSize;
 
-  return result;
+  a_out.lowerLeft[Block::X] = bestX;
+  a_out.lowerLeft[Block::Y] = bestY;
+  a_out.dimensions[Block::W] = bestW;
+  a_out.dimensions[Block::H] = bestH;
+  return true;
 }
 
 void BlockPartition::MaskOut(Block const & a_block)
@@ -172,6 +91,7 @@ void BlockPartition::MaskOut(Block const & a_block)
 BlockPartition::BlockPartition(Dg::HyperArray<bool, 2> const & m_mask)
   : m_mask(m_mask)
   , m_maxBlockSize(64)
+  , m_stats()
 {
   BSR_ASSERT(m_mask.length(0) <= 256);
   BSR_ASSERT(m_mask.length(1) <= 256);
@@ -179,27 +99,36 @@ BlockPartition::BlockPartition(Dg::HyperArray<bool, 2> const & m_mask)
 
 void BlockPartition::SetMaxBlockSize(unsigned a_val)
 {
+  //Block sides are stored in 8 bits
+  BSR_ASSERT(a_val > 0 && a_val <= 255);
   m_maxBlockSize = a_val;
 }
 
 Dg::DynamicArray<Block> BlockPartition::Run()
 {
   Dg::DynamicArray<Block> result;
-  unsigned blockSize = m_maxBlockSize;
-  int seed = 0;
+  m_stats = Stats();
 
-  while (blockSize > 0)
+  Block block;
+  while (FindLargestBlock(block))
   {
-    Block block;
-    if (GetNextBlock(blockSize, seed, block))
-    {
-      MaskOut(block);
-      result.push_back(block);
-      continue;
-    }
-
-    blockSize--;
-    seed = 0;
+    MaskOut(block);
+    result.push_back(block);
+
+    uint32_t area = uint32_t(block.dimensions[Block::W]) * uint32_t(block.dimensions[Block::H]);
+    if (m_stats.blockCount == 0 || area < m_stats.smallestArea)
+      m_stats.smallestArea = area;
+    if (area > m_stats.largestArea)
+      m_stats.largestArea = area;
+    if (area == 1)
+      m_stats.unitBlocks++;
+    m_stats.totalArea += area;
+    m_stats.blockCount++;
   }
   return result;
-}
\ No newline at end of file
+}
+
+BlockPartition::Stats const & BlockPartition::GetStats() const
+{
+  return m_stats;
+}
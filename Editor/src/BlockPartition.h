@@ -1,38 +1,54 @@
 #ifndef BLOCKPARTITION_H
 #define BLOCKPARTITION_H
 
+#include <vector>
+
 #include "Types.h"
 #include "DgDynamicArray.h"
 #include "DgHyperArray.h"
 #include "MapData.h"
 
-//TODO  Look for large blocks first (10 x 10 for exmaple). This way we can ensure larger areas are not
-//      split by smaller ones. We can the decrement and search again (9 x 9 for example) all the way to 1.
+//Covers the empty cells of a mask with rectangular blocks, largest first. Each step
+//takes the largest empty rectangle left in the mask, so open areas are not split up
+//by small blocks found earlier.
 class BlockPartition
 {
 public:
 
+  struct Stats
+  {
+    uint32_t blockCount;
+    uint32_t totalArea;     //Cells covered by all blocks
+    uint32_t largestArea;
+    uint32_t smallestArea;
+    uint32_t unitBlocks;    //Blocks of a single cell
+
+    float MeanArea() const;
+  };
+
   BlockPartition(Dg::HyperArray<bool, 2> const &);
+
+  //Blocks larger than this along either side are cut down to size.
   void SetMaxBlockSize(unsigned);
   Dg::DynamicArray<Block> Run();
 
+  //Of the last call to Run()
+  Stats const & GetStats() const;
+
 private:
 
-  int GetNextSeed(int currentSeed); //change to 'bool GetNextSeed(XY & currentSeed, int size) const;'
-  
-  bool GetNextBlock(unsigned blockSize, int & seed, Block &);
-  Block BuildBlock(int seed);
+  bool FindLargestBlock(Block &);
   void MaskOut(Block const &);
 
 private:
 
-  static int const INVALID_SEED = -1;
-
-  int X(int) const;
-  int Y(int) const;
-
   Dg::HyperArray<bool, 2> m_mask;
   unsigned                m_maxBlockSize;
+  Stats                   m_stats;
+
+  //Per column, the number of empty cells running down from the current row
+  std::vector<uint32_t>   m_heights;
+  std::vector<uint32_t>   m_stack;
 };
 
-#endif
\ No newline at end of file
+#endif
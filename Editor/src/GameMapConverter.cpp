@@ -1,5 +1,9 @@
 #include <exception>
 #include <fstream>
+#include <vector>
+#include <atomic>
+#include <mutex>
+#include <string.h>
 
 //DEBUG
 #include <iostream>
@@ -13,6 +17,12 @@
 #include "BlockPartition.h"
 #include "BSPTreeBuilder.h"
 #include "WallAssembler.h"
+#include "ThreadPool/gc_ParallelFor.h"
+#include "ThreadPool/gc_Mediator.h"
+#include "Data/gc_MapFile.h"
+#include "gc_RLEW.h"
+#include "gc_Constants.h"
+#include "core_utils.h"
 
 //All defines should be in a common file
 #define MAPHEADER_DIR "../Resources/game_data/MAPHEAD.BS6"
@@ -26,10 +36,16 @@
 
 #define MAX_MAPS 100
 
-#define PUSH_WALL 98
-#define CEILINGFLOOR 64256
-
-#define READ16(pData) *((uint16_t const*)pData); pData++; pData++;
+//Bump a stage's version whenever its output changes. On the next run that stage, and
+//every stage depending on it, is rebuilt. Sections from other stages are copied from
+//the existing output. Blocks and walls both depend on the wall mask.
+namespace StageVersion
+{
+  uint32_t const Planes = 1;
+  uint32_t const Blocks = 1;
+  uint32_t const BSP    = 1;
+  uint32_t const Walls  = 1;
+}
 
 class GameMapConverter::PIMPL
 {
@@ -41,9 +57,22 @@ private:
     Dg::DynamicArray<uint32_t>	headeroffsets;
   };
 
-  struct BSRGameMapHeader
+  //Everything written out for one map
+  struct ConvertedMap
   {
-    uint32_t const version = BSR_VERSION;
+    char                        name[16];
+    uint16_t                    width;
+    uint16_t                    height;
+    uint8_t                     ceilingTile;
+    uint8_t                     floorTile;
+    Dg::HyperArray<uint16_t, 2> planes[2];
+    std::vector<GC::Block>      blocks;
+    std::vector<GC::BSP_Node>   bspNodes;
+    std::vector<GC::Wall>       walls;
+    std::vector<GC::Corner>     corners;
+
+    //Hash of what each section was built from
+    uint64_t                    sourceHashes[static_cast<uint32_t>(GC::MapSection::COUNT)];
   };
 
 public:
@@ -55,8 +84,10 @@ public:
                      std::string const & gameData);
 
   void SetOutputFile(std::string const & mapHeader);
+  void SetThreadPool(GC::ThreadPool *);
+  void SetIncremental(bool);
 
-  void Convert();
+  void Convert(std::shared_ptr<GC::Mediator>);
 
 private:
 
@@ -65,12 +96,19 @@ private:
 
 private:
 
-  void BeginFile(BSRGameMapHeader const & );
-  void WriteMetaData(MapFileType const &);
   MapFileType GetHeaderData();
-  void OutputMap(MapFileData const &, uint32_t);
-  MapFileData ConvertMap(uint32_t offset);
-  Dg::HyperArray<uint16_t, 2> UncompressPlane(char const *, uint16_t size, uint16_t w, uint16_t h);
+  void LoadGameData();
+  void LoadPreviousOutput(GC::MapFile &) const;
+  void OutputMap(GC::MapFileBuilder &, ConvertedMap const &) const;
+  void WriteFile(std::vector<uint8_t> const &) const;
+
+  //These only read the game data, so can run on several threads at once.
+  //Sections of 'previous' built from the same inputs are reused. If 'pool' is given
+  //the BSP tree is built on it.
+  ConvertedMap ConvertMap(uint32_t offset, GC::MapView const * previous, GC::ThreadPool * pool) const;
+  char const * GetGameData(size_t offset, size_t size) const;
+  void ReadGameData(size_t offset, void * out, size_t size) const;
+  Dg::HyperArray<uint16_t, 2> UncompressPlane(char const *, uint16_t size, uint16_t w, uint16_t h) const;
   bool IsWall(uint16_t) const;
 
 private:
@@ -79,6 +117,11 @@ private:
   std::string m_inputGameDataFile;
   std::string m_outputFile;
   uint16_t m_RLEWtag;
+  GC::ThreadPool * m_pThreadPool;
+  bool m_incremental;
+
+  //The whole of MAPTEMP, read once and shared by all maps
+  std::vector<char> m_gameData;
 };
 
 GameMapConverter::GameMapConverter()
@@ -103,9 +146,19 @@ void GameMapConverter::SetOutputFile(std::string const & a_outFile)
   m_pimpl->SetOutputFile(a_outFile);
 }
 
-void GameMapConverter::Convert()
+void GameMapConverter::SetThreadPool(GC::ThreadPool * a_pPool)
+{
+  m_pimpl->SetThreadPool(a_pPool);
+}
+
+void GameMapConverter::SetIncremental(bool a_val)
+{
+  m_pimpl->SetIncremental(a_val);
+}
+
+void GameMapConverter::Convert(std::shared_ptr<GC::Mediator> a_pMediator)
 {
-  m_pimpl->Convert();
+  m_pimpl->Convert(a_pMediator);
 }
 
 GameMapConverter::PIMPL::PIMPL()
@@ -113,6 +166,8 @@ GameMapConverter::PIMPL::PIMPL()
   , m_inputGameDataFile(MAPTEMP_DIR)
   , m_outputFile(MAP_OUTPUT_FILE)
   , m_RLEWtag(0xABCD)
+  , m_pThreadPool(nullptr)
+  , m_incremental(true)
 {
 
 }
@@ -134,6 +189,16 @@ void GameMapConverter::PIMPL::SetOutputFile(std::string const & a_outFIle)
   m_outputFile = a_outFIle;
 }
 
+void GameMapConverter::PIMPL::SetThreadPool(GC::ThreadPool * a_pPool)
+{
+  m_pThreadPool = a_pPool;
+}
+
+void GameMapConverter::PIMPL::SetIncremental(bool a_val)
+{
+  m_incremental = a_val;
+}
+
 GameMapConverter::PIMPL::MapFileType GameMapConverter::PIMPL::GetHeaderData()
 {
   std::ifstream fHeader(m_inputHeaderFile, std::ios::binary);
@@ -160,62 +225,130 @@ GameMapConverter::PIMPL::MapFileType GameMapConverter::PIMPL::GetHeaderData()
   return mapHeaderData;
 }
 
-void GameMapConverter::PIMPL::OutputMap(MapFileData const &, uint32_t a_index)
+void GameMapConverter::PIMPL::LoadGameData()
 {
+  std::ifstream fMapData(m_inputGameDataFile, std::ios::binary | std::ios::ate);
+
+  if (!fMapData.good())
+  {
+    throw std::exception((std::string("Failed to open ") + m_inputGameDataFile).c_str());
+  }
 
+  std::streamoff size = fMapData.tellg();
+  m_gameData.resize(size_t(size));
+  fMapData.seekg(0);
+  fMapData.read(m_gameData.data(), size);
+
+  if (!fMapData.good())
+  {
+    throw std::exception((std::string("Failed to read ") + m_inputGameDataFile).c_str());
+  }
 }
 
-Dg::HyperArray<uint16_t, 2> GameMapConverter::PIMPL::UncompressPlane(char const * a_pData, 
-                                                                     uint16_t a_size,
-                                                                     uint16_t a_w,
-                                                                     uint16_t a_h)
+char const * GameMapConverter::PIMPL::GetGameData(size_t a_offset, size_t a_size) const
 {
-  Dg::DynamicArray<uint16_t> raw;
+  if (a_offset > m_gameData.size() || a_size > m_gameData.size() - a_offset)
+  {
+    throw std::exception("Map data out of range!");
+  }
 
-  uint16_t pos = 0;
+  return m_gameData.data() + a_offset;
+}
 
-  //There seems to be an extra word at the start of each map, the same value each time (0x2000).
-  //Not sure what this is, so discard.
-  //TODO find out what this value is.
-  uint16_t word = READ16(a_pData); 
-  pos += 2;
+void GameMapConverter::PIMPL::ReadGameData(size_t a_offset, void * a_out, size_t a_size) const
+{
+  memcpy(a_out, GetGameData(a_offset, a_size), a_size);
+}
+
+void GameMapConverter::PIMPL::LoadPreviousOutput(GC::MapFile & a_out) const
+{
+  //Nothing to reuse on the first run. An unreadable or out of date file is rebuilt.
+  std::ifstream fGameMaps(m_outputFile, std::ios::binary);
+  if (!fGameMaps.good())
+    return;
+  fGameMaps.close();
 
-  while (pos < a_size)
+  if (!a_out.Load(m_outputFile))
+    a_out.Clear();
+}
+
+static uint64_t StageHash(uint64_t a_sourceHash, uint32_t a_version)
+{
+  return Core::Hash64(&a_version, sizeof(a_version), a_sourceHash);
+}
+
+static bool IsUpToDate(GC::MapView const * a_pPrevious, GC::MapSection a_section, uint64_t a_hash)
+{
+  return a_pPrevious != nullptr
+    && a_pPrevious->pHeader->sections[static_cast<uint32_t>(a_section)].sourceHash == a_hash;
+}
+
+template<typename T>
+static void CopySection(GC::MapArray<T> const & a_section, std::vector<T> & a_out)
+{
+  a_out.assign(a_section.begin(), a_section.end());
+}
+
+static GC::BSP_Node ToBSPNode(Node const & a_node)
+{
+  GC::BSP_Node result;
+  if (a_node.GetType() == Node::E_Leaf)
   {
-    uint16_t word = READ16(a_pData); 
-    pos += 2;
+    result.Set<GC::BSP_Node::Item::Type>(GC::BSP_Node::Leaf);
+    result.Set<GC::BSP_Node::Item::BlockIndex>(a_node.GetBlockID());
+    return result;
+  }
 
-    if (word == m_RLEWtag)
-    {
-      uint16_t count = READ16(a_pData);
-      pos += 2;
-      uint16_t value = READ16(a_pData);
-      pos += 2;
+  result.Set<GC::BSP_Node::Item::Type>(GC::BSP_Node::Branch);
+  result.Set<GC::BSP_Node::Item::Element>(a_node.GetElement());
+  result.Set<GC::BSP_Node::Item::Offset>(uint32_t(a_node.GetOffset()));
+  result.Set<GC::BSP_Node::Item::ChildAboveIndex>(a_node.GetChildAboveInd());
+  result.Set<GC::BSP_Node::Item::ChildBelowIndex>(a_node.GetChildBelowInd());
+  return result;
+}
 
-      for (uint16_t i = 0; i < count; i++)
-      {
-        raw.push_back(value);
-      }
-    }
-    else
-    {
-      raw.push_back(word);
-    }
+void GameMapConverter::PIMPL::OutputMap(GC::MapFileBuilder & a_file, ConvertedMap const & a_map) const
+{
+  uint64_t const * pHashes = a_map.sourceHashes;
+  uint32_t tiles = uint32_t(a_map.width) * uint32_t(a_map.height);
+
+  //Associated geometry is not generated yet. Its sections are left empty.
+  a_file.BeginMap(a_map.name, a_map.width, a_map.height, a_map.ceilingTile, a_map.floorTile);
+  a_file.AddSection(GC::MapSection::Blocks, a_map.blocks.data(), uint32_t(a_map.blocks.size()), pHashes[uint32_t(GC::MapSection::Blocks)]);
+  a_file.AddSection(GC::MapSection::BSPNodes, a_map.bspNodes.data(), uint32_t(a_map.bspNodes.size()), pHashes[uint32_t(GC::MapSection::BSPNodes)]);
+  a_file.AddSection(GC::MapSection::Walls, a_map.walls.data(), uint32_t(a_map.walls.size()), pHashes[uint32_t(GC::MapSection::Walls)]);
+  a_file.AddSection(GC::MapSection::Corners, a_map.corners.data(), uint32_t(a_map.corners.size()), pHashes[uint32_t(GC::MapSection::Corners)]);
+  a_file.AddSection(GC::MapSection::Plane0, a_map.planes[0].data(), tiles, pHashes[uint32_t(GC::MapSection::Plane0)]);
+  a_file.AddSection(GC::MapSection::Plane1, a_map.planes[1].data(), tiles, pHashes[uint32_t(GC::MapSection::Plane1)]);
+}
+
+void GameMapConverter::PIMPL::WriteFile(std::vector<uint8_t> const & a_data) const
+{
+  std::ofstream fGameMaps(m_outputFile, std::ios::binary);
+
+  if (!fGameMaps.good())
+  {
+    throw std::exception((std::string("Failed to open ") + m_outputFile).c_str());
   }
 
-  if (raw.size() != a_w * a_h)
+  fGameMaps.write((char const*)a_data.data(), std::streamsize(a_data.size()));
+
+  if (!fGameMaps.good())
   {
-    throw std::exception("Incorrect map size!");
+    throw std::exception((std::string("Failed to write ") + m_outputFile).c_str());
   }
+}
 
+Dg::HyperArray<uint16_t, 2> GameMapConverter::PIMPL::UncompressPlane(char const * a_pData, 
+                                                                     uint16_t a_size,
+                                                                     uint16_t a_w,
+                                                                     uint16_t a_h) const
+{
+  //Words decode in the order the plane stores them
   Dg::HyperArray<uint16_t, 2> result({size_t(a_w), size_t(a_h)});
-
-  for (size_t y = 0; y < a_h; y++)
+  if (!GC::DecodeRLEW(a_pData, a_size, m_RLEWtag, result.data(), size_t(a_w) * a_h))
   {
-    for (size_t x = 0; x < a_w; x++)
-    {
-      result(x, y) = raw[(y * a_w) + x];
-    }
+    throw std::exception("Corrupt plane or incorrect map size!");
   }
 
   return result;
@@ -223,7 +356,7 @@ Dg::HyperArray<uint16_t, 2> GameMapConverter::PIMPL::UncompressPlane(char const
 
 bool GameMapConverter::PIMPL::IsWall(uint16_t a_val) const
 {
-  return (a_val > 0) && (a_val <= 63);
+  return (a_val >= GC::Tile::WallBegin) && (a_val <= GC::Tile::WallEnd);
 }
 
 class Counter
@@ -239,10 +372,12 @@ public:
 //std::map<uint16_t, std::map<int, Counter>> g_objects;
 //int g_Map = -1;
 
-MapFileData GameMapConverter::PIMPL::ConvertMap(uint32_t a_offset)
+GameMapConverter::PIMPL::ConvertedMap GameMapConverter::PIMPL::ConvertMap(uint32_t a_offset,
+                                                                       GC::MapView const * a_pPrevious,
+                                                                       GC::ThreadPool * a_pPool) const
 {
   //g_Map++;
-  MapFileData result;
+  ConvertedMap converted = {};
 
   //------------------------------------------------------------------------------------------
   // Read the map header
@@ -260,41 +395,48 @@ MapFileData GameMapConverter::PIMPL::ConvertMap(uint32_t a_offset)
     char       mapName[16];
   };
 
-  std::ifstream fMapData(m_inputGameDataFile, std::ios::binary);
-
-  if (!fMapData.good())
-  {
-    throw std::exception((std::string("Failed to open ") + m_inputGameDataFile).c_str());
-  }
-
-  fMapData.seekg(a_offset);
-
+  size_t pos = a_offset;
   GameMapHeader gameMapHeader;
-  fMapData.read((char*)&gameMapHeader.planeoffset_0, sizeof(GameMapHeader::planeoffset_0));
-  fMapData.read((char*)&gameMapHeader.planeoffset_1, sizeof(GameMapHeader::planeoffset_1));
-  fMapData.read((char*)&gameMapHeader.planeoffset_2, sizeof(GameMapHeader::planeoffset_2));
-  fMapData.read((char*)&gameMapHeader.planeSize_0, sizeof(GameMapHeader::planeSize_0));
-  fMapData.read((char*)&gameMapHeader.planeSize_1, sizeof(GameMapHeader::planeSize_1));
-  fMapData.read((char*)&gameMapHeader.planeSize_2, sizeof(GameMapHeader::planeSize_2));
-  fMapData.read((char*)&gameMapHeader.mapLength, sizeof(GameMapHeader::mapLength));
-  fMapData.read((char*)&gameMapHeader.mapWidth, sizeof(GameMapHeader::mapWidth));
-  fMapData.read((char*)&gameMapHeader.mapName, sizeof(GameMapHeader::mapName));
-
-  //------------------------------------------------------------------------------------------
-  // Read the map data
-  //------------------------------------------------------------------------------------------
-  char * plane_0_data = new char[gameMapHeader.planeSize_0]();
-  char * plane_1_data = new char[gameMapHeader.planeSize_1]();
-
-  fMapData.seekg(gameMapHeader.planeoffset_0);
-  fMapData.read(plane_0_data, gameMapHeader.planeSize_0);
-
-  fMapData.seekg(gameMapHeader.planeoffset_1);
-  fMapData.read(plane_1_data, gameMapHeader.planeSize_1);
+  ReadGameData(pos, &gameMapHeader.planeoffset_0, sizeof(GameMapHeader::planeoffset_0)); pos += sizeof(GameMapHeader::planeoffset_0);
+  ReadGameData(pos, &gameMapHeader.planeoffset_1, sizeof(GameMapHeader::planeoffset_1)); pos += sizeof(GameMapHeader::planeoffset_1);
+  ReadGameData(pos, &gameMapHeader.planeoffset_2, sizeof(GameMapHeader::planeoffset_2)); pos += sizeof(GameMapHeader::planeoffset_2);
+  ReadGameData(pos, &gameMapHeader.planeSize_0, sizeof(GameMapHeader::planeSize_0)); pos += sizeof(GameMapHeader::planeSize_0);
+  ReadGameData(pos, &gameMapHeader.planeSize_1, sizeof(GameMapHeader::planeSize_1)); pos += sizeof(GameMapHeader::planeSize_1);
+  ReadGameData(pos, &gameMapHeader.planeSize_2, sizeof(GameMapHeader::planeSize_2)); pos += sizeof(GameMapHeader::planeSize_2);
+  ReadGameData(pos, &gameMapHeader.mapLength, sizeof(GameMapHeader::mapLength)); pos += sizeof(GameMapHeader::mapLength);
+  ReadGameData(pos, &gameMapHeader.mapWidth, sizeof(GameMapHeader::mapWidth)); pos += sizeof(GameMapHeader::mapWidth);
+  ReadGameData(pos, &gameMapHeader.mapName, sizeof(GameMapHeader::mapName));
 
   //------------------------------------------------------------------------------------------
   // Uncompress map data
   //------------------------------------------------------------------------------------------
+  //Planes are decoded straight out of the game data
+  char const * plane_0_data = GetGameData(gameMapHeader.planeoffset_0, gameMapHeader.planeSize_0);
+  char const * plane_1_data = GetGameData(gameMapHeader.planeoffset_1, gameMapHeader.planeSize_1);
+
+  //Everything the map is built from. Plane offsets are left out; they move whenever an
+  //earlier map changes size. Each stage hashes its version with the hash of its input,
+  //so a change to a stage reaches every stage after it.
+  uint64_t inputHash = Core::Hash64(&m_RLEWtag, sizeof(m_RLEWtag));
+  inputHash = Core::Hash64(&gameMapHeader.mapLength, sizeof(GameMapHeader::mapLength), inputHash);
+  inputHash = Core::Hash64(&gameMapHeader.mapWidth, sizeof(GameMapHeader::mapWidth), inputHash);
+  inputHash = Core::Hash64(gameMapHeader.mapName, sizeof(GameMapHeader::mapName), inputHash);
+  inputHash = Core::Hash64(plane_0_data, gameMapHeader.planeSize_0, inputHash);
+  inputHash = Core::Hash64(plane_1_data, gameMapHeader.planeSize_1, inputHash);
+
+  uint64_t planesHash = StageHash(inputHash, StageVersion::Planes);
+  uint64_t blocksHash = StageHash(planesHash, StageVersion::Blocks);
+  uint64_t bspHash = StageHash(blocksHash, StageVersion::BSP);
+  uint64_t wallsHash = StageHash(planesHash, StageVersion::Walls);
+
+  converted.sourceHashes[uint32_t(GC::MapSection::Plane0)] = planesHash;
+  converted.sourceHashes[uint32_t(GC::MapSection::Plane1)] = planesHash;
+  converted.sourceHashes[uint32_t(GC::MapSection::Blocks)] = blocksHash;
+  converted.sourceHashes[uint32_t(GC::MapSection::BSPNodes)] = bspHash;
+  converted.sourceHashes[uint32_t(GC::MapSection::Walls)] = wallsHash;
+  converted.sourceHashes[uint32_t(GC::MapSection::Corners)] = wallsHash;
+
+  //Decoding is cheap, and every other stage needs the planes, so it is always done.
   Dg::HyperArray<uint16_t, 2> plane_0 = UncompressPlane(plane_0_data, gameMapHeader.planeSize_0, gameMapHeader.mapLength, gameMapHeader.mapWidth);
   Dg::HyperArray<uint16_t, 2> plane_1 = UncompressPlane(plane_1_data, gameMapHeader.planeSize_1, gameMapHeader.mapLength, gameMapHeader.mapWidth);
 
@@ -314,14 +456,11 @@ MapFileData GameMapConverter::PIMPL::ConvertMap(uint32_t a_offset)
         g_objects[p1Val][g_Map].val++;
       }
 
-      cfFoundTxt = p1Val == CEILINGFLOOR;
+      cfFoundTxt = p1Val == GC::Tile::CeilingFloor;
       cfFoundClr = p1Val == 65024;
     }
   }*/
 
-  delete[] plane_0_data;
-  delete[] plane_1_data;
-
   //------------------------------------------------------------------------------------------
   // Generate the floor/wall mask
   //------------------------------------------------------------------------------------------
@@ -332,7 +471,7 @@ MapFileData GameMapConverter::PIMPL::ConvertMap(uint32_t a_offset)
     for (uint16_t x = 0; x < gameMapHeader.mapLength; x++)
     {
       bool isWall = IsWall(plane_0(size_t(x), size_t(y)));
-      bool isPushWall = plane_1(size_t(x), size_t(y)) == PUSH_WALL;
+      bool isPushWall = plane_1(size_t(x), size_t(y)) == GC::Tile::PushWall;
       mask(x, y) = (isWall) && !(isPushWall);
     }
   }
@@ -340,23 +479,93 @@ MapFileData GameMapConverter::PIMPL::ConvertMap(uint32_t a_offset)
   //------------------------------------------------------------------------------------------
   // Generate block partition
   //------------------------------------------------------------------------------------------
-  BlockPartition blockPart(mask);
-  result.blocks = blockPart.Run();
+  bool bspUpToDate = IsUpToDate(a_pPrevious, GC::MapSection::BSPNodes, bspHash);
+  Dg::DynamicArray<Block> blocks;
+
+  if (IsUpToDate(a_pPrevious, GC::MapSection::Blocks, blocksHash))
+  {
+    CopySection(a_pPrevious->blocks, converted.blocks);
+
+    //The BSP tree is built from the blocks
+    if (!bspUpToDate)
+    {
+      for (GC::Block const & mapBlock : converted.blocks)
+      {
+        Block block;
+        block.lowerLeft[Block::X] = mapBlock.GetX();
+        block.lowerLeft[Block::Y] = mapBlock.GetY();
+        block.dimensions[Block::W] = mapBlock.GetW();
+        block.dimensions[Block::H] = mapBlock.GetH();
+        blocks.push_back(block);
+      }
+    }
+  }
+  else
+  {
+    BlockPartition blockPart(mask);
+    blocks = blockPart.Run();
+
+    converted.blocks.resize(blocks.size());
+    for (size_t i = 0; i < blocks.size(); i++)
+    {
+      converted.blocks[i].SetX(blocks[i].lowerLeft[Block::X]);
+      converted.blocks[i].SetY(blocks[i].lowerLeft[Block::Y]);
+      converted.blocks[i].SetW(blocks[i].dimensions[Block::W]);
+      converted.blocks[i].SetH(blocks[i].dimensions[Block::H]);
+    }
+  }
 
   //------------------------------------------------------------------------------------------
   // Generate Wall Geometry
   //------------------------------------------------------------------------------------------
-  WallAssembler wallAss(mask);
-  wallAss.Run();
-  result.wallGeometryLines = wallAss.GetWalls();
-  result.wallGeometryPoints = wallAss.GetCorners();
+  static_assert(sizeof(Wall) == sizeof(GC::Wall), "Walls are written as they are");
+  static_assert(sizeof(Corner) == sizeof(GC::Corner), "Corners are written as they are");
+
+  if (IsUpToDate(a_pPrevious, GC::MapSection::Walls, wallsHash)
+    && IsUpToDate(a_pPrevious, GC::MapSection::Corners, wallsHash))
+  {
+    CopySection(a_pPrevious->walls, converted.walls);
+    CopySection(a_pPrevious->corners, converted.corners);
+  }
+  else
+  {
+    WallAssembler wallAss(mask);
+    wallAss.Run();
+
+    Dg::DynamicArray<Wall> const & walls = wallAss.GetWalls();
+    Dg::DynamicArray<Corner> const & corners = wallAss.GetCorners();
+    converted.walls.resize(walls.size());
+    converted.corners.resize(corners.size());
+    if (walls.size() != 0)
+      memcpy(converted.walls.data(), walls.data(), walls.size() * sizeof(GC::Wall));
+    if (corners.size() != 0)
+      memcpy(converted.corners.data(), corners.data(), corners.size() * sizeof(GC::Corner));
+  }
 
   //------------------------------------------------------------------------------------------
   // Generate BSP Tree
   //------------------------------------------------------------------------------------------
-  BSPTreeBuilder bsp(result.blocks);
-  bsp.Run();
-  result.bspTree = bsp.GetResults();
+  if (bspUpToDate)
+  {
+    CopySection(a_pPrevious->bspNodes, converted.bspNodes);
+  }
+  else
+  {
+    BSPTreeBuilder bsp(blocks);
+    bsp.SetThreadPool(a_pPool);
+    bsp.Run();
+    Dg::DynamicArray<Node> const & nodes = bsp.GetResults();
+
+    //Child indices are 12 bits
+    if (nodes.size() > 4096)
+    {
+      throw std::exception("BSP tree is too large!");
+    }
+
+    converted.bspNodes.resize(nodes.size());
+    for (size_t i = 0; i < nodes.size(); i++)
+      converted.bspNodes[i] = ToBSPNode(nodes[i]);
+  }
 
   //------------------------------------------------------------------------------------------
   // Get ceiling/floor tiles
@@ -365,12 +574,12 @@ MapFileData GameMapConverter::PIMPL::ConvertMap(uint32_t a_offset)
   {
     for (size_t x = 0; x < plane_1.length(0); x++)
     {
-      if (plane_1(x, y) == CEILINGFLOOR)
+      if (plane_1(x, y) == GC::Tile::CeilingFloor)
       {
         uint16_t val = plane_1(x + 1, y);
 
-        result.ceilingTile = (val >> 8);
-        result.floorTile = val & 0xFF;
+        converted.ceilingTile = uint8_t(val >> 8);
+        converted.floorTile = uint8_t(val & 0xFF);
         goto end_ceilingfloor;
       }
     }
@@ -382,55 +591,100 @@ end_ceilingfloor:
   //------------------------------------------------------------------------------------------
 
 
-  return result;
+  memcpy(converted.name, gameMapHeader.mapName, sizeof(converted.name));
+  converted.width = gameMapHeader.mapLength;
+  converted.height = gameMapHeader.mapWidth;
+  converted.planes[0] = plane_0;
+  converted.planes[1] = plane_1;
+
+  return converted;
 }
 
-void GameMapConverter::PIMPL::BeginFile(BSRGameMapHeader const & a_headerData)
+void GameMapConverter::PIMPL::Convert(std::shared_ptr<GC::Mediator> a_pMediator)
 {
-  std::ofstream fGameMaps(m_outputFile, std::ios::binary);
-
-  if (!fGameMaps.good())
+  MapFileType headerData = GetHeaderData();
+  LoadGameData();
+
+  //Loaded into memory, so the file can be overwritten afterwards
+  GC::MapFile previous;
+  if (m_incremental)
+    LoadPreviousOutput(previous);
+
+  //Each map is independent. Results are kept by index, so the output is in map order
+  //however the work is split.
+  uint32_t mapCount = uint32_t(headerData.headeroffsets.size());
+  std::vector<ConvertedMap> results(mapCount);
+  std::atomic<uint32_t> completed(0);
+
+  //Exceptions cannot leave a pool thread. The error from the lowest map index is
+  //rethrown. Maps below a failed map are still converted, so which error is reported
+  //does not depend on timing either.
+  std::mutex errorMutex;
+  std::atomic<uint32_t> errorIndex(mapCount);
+  std::string error;
+
+  //Several maps already keep the pool busy. A single map would leave it idle, so its
+  //BSP tree is built in parallel instead.
+  GC::ThreadPool * pBSPPool = mapCount == 1 ? m_pThreadPool : nullptr;
+
+  GC::ParallelFor(m_pThreadPool, mapCount, 1, [&](uint32_t a_begin, uint32_t a_end)
   {
-    throw std::exception((std::string("Failed to open ") + m_outputFile).c_str());
-  }
+    for (uint32_t i = a_begin; i < a_end; i++)
+    {
+      if (i > errorIndex.load() || (a_pMediator != nullptr && a_pMediator->ShouldStop()))
+        return;
 
-  fGameMaps.write((char*)&a_headerData.version, sizeof(BSRGameMapHeader::version));
-}
+      try
+      {
+        GC::MapView previousMap;
+        GC::MapView const * pPrevious = nullptr;
+        if (i < previous.GetMapCount())
+        {
+          previousMap = previous.GetMap(i);
+          pPrevious = &previousMap;
+        }
+
+        results[i] = ConvertMap(headerData.headeroffsets[i], pPrevious, pBSPPool);
+      }
+      catch (std::exception & e)
+      {
+        std::lock_guard<std::mutex> lock(errorMutex);
+        if (i < errorIndex.load())
+        {
+          errorIndex = i;
+          error = e.what();
+        }
+        return;
+      }
 
-void GameMapConverter::PIMPL::WriteMetaData(MapFileType const & a_data)
-{
-  std::ofstream fGameMaps(m_outputFile, std::ios::binary | std::ofstream::app);
+      uint32_t done = completed.fetch_add(1) + 1;
+      if (a_pMediator != nullptr)
+        a_pMediator->Report(100.0f * float(done) / float(mapCount));
+    }
+  });
 
-  if (!fGameMaps.good())
+  if (errorIndex.load() < mapCount)
   {
-    throw std::exception((std::string("Failed to open ") + m_outputFile).c_str());
+    if (a_pMediator != nullptr)
+      a_pMediator->Done();
+    throw std::exception(("Map " + std::to_string(errorIndex.load()) + ": " + error).c_str());
   }
 
-  uint32_t nMaps = uint32_t(a_data.headeroffsets.size());
-  fGameMaps.write((char*)&nMaps, sizeof(nMaps));
-
-  size_t bufSze = a_data.headeroffsets.size() * sizeof(uint32_t);
-  char * dummyBuf = new char[bufSze]();
-  fGameMaps.write(dummyBuf, bufSze);
-  delete[] dummyBuf;
-}
+  if (a_pMediator != nullptr && a_pMediator->ShouldStop())
+  {
+    a_pMediator->Done();
+    return;
+  }
 
-void GameMapConverter::PIMPL::Convert()
-{
-  //Start the file and output the header
-  BSRGameMapHeader BSRHeader;
-  BeginFile(BSRHeader);
+  //The file is assembled in memory and written in one go
+  GC::MapFileBuilder file(mapCount);
+  for (uint32_t i = 0; i < mapCount; i++)
+    OutputMap(file, results[i]);
 
-  //Write the map meta data
-  MapFileType headerData = GetHeaderData();
-  WriteMetaData(headerData);
+  WriteFile(file.Finish());
 
-  for (uint32_t i = 0; i < uint32_t(headerData.headeroffsets.size()); i++)
-  {
-    MapFileData data = ConvertMap(headerData.headeroffsets[i]);
-    std::cout << i << " of " << headerData.headeroffsets.size() << " Complete\n";
-    //OutputMap(data, i);
-  }
+  if (a_pMediator != nullptr)
+    a_pMediator->Done();
 
   /*std::ofstream fs("CodeCount.txt");
   fs << "Structural:\n";
@@ -2,10 +2,17 @@
 #define GAMEMAPCONVERTER_H
 
 #include <string>
+#include <memory>
 
 #include "MapData.h"
 #include "Types.h"
 
+namespace GC
+{
+  class ThreadPool;
+  class Mediator;
+}
+
 class GameMapConverter
 {
 public:
@@ -18,7 +25,18 @@ public:
 
   void SetOutputFile(std::string const & mapHeader);
 
-  void Convert();
+  //Maps are converted in parallel on this pool. If not set, they are converted one
+  //after another on the calling thread.
+  void SetThreadPool(GC::ThreadPool *);
+
+  //If set, which is the default, sections of the existing output file are reused when
+  //they were built from the same map data by the same version of their stage.
+  void SetIncremental(bool);
+
+  //Progress is reported to the mediator as maps complete, and conversion stops early if
+  //it is flagged to stop. Nothing is written if conversion is stopped. The output does
+  //not depend on the number of threads.
+  void Convert(std::shared_ptr<GC::Mediator> = nullptr);
 
 private:
 
@@ -16,6 +16,7 @@
 #include "Message.h"
 #include "Memory.h"
 #include "Renderer.h"
+#include "WorkerPool.h"
 
 #include "Layer_Console.h"
 #include "Layer_InputHandler.h"
@@ -92,6 +93,9 @@ namespace Engine
 
     InitWindow();
 
+    if (!WorkerPool::Init())
+      throw std::runtime_error("Failed to initialise worker pool!");
+
     if (!Renderer::Init())
       throw std::runtime_error("Failed to initialise Renderer!");
 
@@ -113,6 +117,7 @@ namespace Engine
 
   Application::~Application()
   {
+    WorkerPool::ShutDown();
     RenderThread::ShutDown();
     Renderer::ShutDown();
 
@@ -0,0 +1,602 @@
+//@group Renderer
+
+#include <float.h>
+#include <stdlib.h>
+#include <math.h>
+#include <string.h>
+
+#include "BlockCompression.h"
+#include "core_Assert.h"
+#include "WorkerPool.h"
+#include "ThreadPool/gc_ParallelFor.h"
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__SSE2__)
+#define BLOCKCOMPRESSION_USE_SSE
+#include <emmintrin.h>
+#endif
+
+namespace Engine
+{
+  namespace
+  {
+    uint32_t const BlockPixels = BlockDim * BlockDim;
+    uint32_t const BlockRowsPerTask = 4;
+    uint32_t const PowerIterations = 8;
+    uint32_t const RefineIterations = 2;
+    uint32_t const AlphaThreshold = 128;
+
+    //Colours as floats, one array per channel so four pixels can be tested at once.
+    struct ColorBlock
+    {
+      float     r[BlockPixels];
+      float     g[BlockPixels];
+      float     b[BlockPixels];
+
+      //Pixels the colour endpoints should be fitted to. Transparent pixels in a
+      //1-bit alpha BC1 block are left out.
+      uint32_t  mask;
+    };
+
+    struct ColorEncoding
+    {
+      uint16_t  c0;
+      uint16_t  c1;
+      uint32_t  indices;
+      float     error;
+    };
+  }
+
+  //-----------------------------------------------------------------------------------------------
+  // Helper functions
+  //-----------------------------------------------------------------------------------------------
+
+  static float Clamp255(float a_val)
+  {
+    return a_val < 0.0f ? 0.0f : (a_val > 255.0f ? 255.0f : a_val);
+  }
+
+  static uint16_t Pack565(float const * a_rgb)
+  {
+    uint32_t r = static_cast<uint32_t>(Clamp255(a_rgb[0]) * (31.0f / 255.0f) + 0.5f);
+    uint32_t g = static_cast<uint32_t>(Clamp255(a_rgb[1]) * (63.0f / 255.0f) + 0.5f);
+    uint32_t b = static_cast<uint32_t>(Clamp255(a_rgb[2]) * (31.0f / 255.0f) + 0.5f);
+    return static_cast<uint16_t>((r << 11) | (g << 5) | b);
+  }
+
+  static void Unpack565(uint16_t a_color, uint32_t * a_rgb)
+  {
+    uint32_t r = (a_color >> 11) & 31;
+    uint32_t g = (a_color >> 5) & 63;
+    uint32_t b = a_color & 31;
+    a_rgb[0] = (r << 3) | (r >> 2);
+    a_rgb[1] = (g << 2) | (g >> 4);
+    a_rgb[2] = (b << 3) | (b >> 2);
+  }
+
+  //Palette as the decoder will see it. Returns the number of usable colours.
+  static uint32_t BuildPalette(uint16_t a_c0, uint16_t a_c1, bool a_threeColor, uint32_t (*a_palette)[3])
+  {
+    Unpack565(a_c0, a_palette[0]);
+    Unpack565(a_c1, a_palette[1]);
+
+    if (a_threeColor)
+    {
+      for (int i = 0; i < 3; i++)
+      {
+        a_palette[2][i] = (a_palette[0][i] + a_palette[1][i]) / 2;
+        a_palette[3][i] = 0;
+      }
+      return 3;
+    }
+
+    for (int i = 0; i < 3; i++)
+    {
+      a_palette[2][i] = (2 * a_palette[0][i] + a_palette[1][i]) / 3;
+      a_palette[3][i] = (a_palette[0][i] + 2 * a_palette[1][i]) / 3;
+    }
+    return 4;
+  }
+
+  static void WriteU16(byte * a_out, uint32_t a_val)
+  {
+    a_out[0] = static_cast<byte>(a_val & 0xFF);
+    a_out[1] = static_cast<byte>((a_val >> 8) & 0xFF);
+  }
+
+  static uint32_t ReadU16(byte const * a_in)
+  {
+    return uint32_t(a_in[0]) | (uint32_t(a_in[1]) << 8);
+  }
+
+  static void WriteU32(byte * a_out, uint32_t a_val)
+  {
+    WriteU16(a_out, a_val & 0xFFFF);
+    WriteU16(a_out + 2, a_val >> 16);
+  }
+
+  static uint32_t ReadU32(byte const * a_in)
+  {
+    return ReadU16(a_in) | (ReadU16(a_in + 2) << 16);
+  }
+
+  //-----------------------------------------------------------------------------------------------
+  // Colour block
+  //-----------------------------------------------------------------------------------------------
+
+  //Nearest palette entry for each pixel. Returns the squared error summed over the mask.
+  static float FindIndices(ColorBlock const & a_block, uint32_t const (*a_palette)[3], uint32_t a_count, uint32_t * a_indices)
+  {
+    float errors[BlockPixels];
+
+#ifdef BLOCKCOMPRESSION_USE_SSE
+    for (uint32_t i = 0; i < BlockPixels; i += 4)
+    {
+      __m128 r = _mm_loadu_ps(a_block.r + i);
+      __m128 g = _mm_loadu_ps(a_block.g + i);
+      __m128 b = _mm_loadu_ps(a_block.b + i);
+      __m128 best = _mm_set1_ps(FLT_MAX);
+      __m128i bestIndex = _mm_setzero_si128();
+
+      for (uint32_t k = 0; k < a_count; k++)
+      {
+        __m128 dr = _mm_sub_ps(r, _mm_set1_ps(float(a_palette[k][0])));
+        __m128 dg = _mm_sub_ps(g, _mm_set1_ps(float(a_palette[k][1])));
+        __m128 db = _mm_sub_ps(b, _mm_set1_ps(float(a_palette[k][2])));
+        __m128 d = _mm_add_ps(_mm_add_ps(_mm_mul_ps(dr, dr), _mm_mul_ps(dg, dg)), _mm_mul_ps(db, db));
+
+        __m128i closer = _mm_castps_si128(_mm_cmplt_ps(d, best));
+        best = _mm_min_ps(d, best);
+        bestIndex = _mm_or_si128(_mm_and_si128(closer, _mm_set1_epi32(int(k))), _mm_andnot_si128(closer, bestIndex));
+      }
+
+      _mm_storeu_ps(errors + i, best);
+      _mm_storeu_si128(reinterpret_cast<__m128i*>(a_indices + i), bestIndex);
+    }
+#else
+    for (uint32_t i = 0; i < BlockPixels; i++)
+    {
+      float best = FLT_MAX;
+      uint32_t bestIndex = 0;
+      for (uint32_t k = 0; k < a_count; k++)
+      {
+        float dr = a_block.r[i] - float(a_palette[k][0]);
+        float dg = a_block.g[i] - float(a_palette[k][1]);
+        float db = a_block.b[i] - float(a_palette[k][2]);
+        float d = dr * dr + dg * dg + db * db;
+        if (d < best)
+        {
+          best = d;
+          bestIndex = k;
+        }
+      }
+      errors[i] = best;
+      a_indices[i] = bestIndex;
+    }
+#endif
+
+    float total = 0.0f;
+    for (uint32_t i = 0; i < BlockPixels; i++)
+    {
+      if (a_block.mask & (1u << i))
+        total += errors[i];
+    }
+    return total;
+  }
+
+  //Orders the endpoints for the block mode, then assigns indices.
+  static ColorEncoding Evaluate(ColorBlock const & a_block, uint16_t a_c0, uint16_t a_c1, bool a_threeColor)
+  {
+    //The decoder picks 4 colour mode when c0 > c1.
+    if (a_threeColor ? (a_c0 > a_c1) : (a_c0 < a_c1))
+    {
+      uint16_t temp = a_c0;
+      a_c0 = a_c1;
+      a_c1 = temp;
+    }
+
+    uint32_t palette[4][3];
+    uint32_t count = BuildPalette(a_c0, a_c1, a_threeColor, palette);
+
+    //Equal endpoints read as 3 colour mode. Index 0 is correct in either mode.
+    if (!a_threeColor && a_c0 == a_c1)
+      count = 1;
+
+    uint32_t indices[BlockPixels];
+    ColorEncoding result;
+    result.c0 = a_c0;
+    result.c1 = a_c1;
+    result.error = FindIndices(a_block, palette, count, indices);
+    result.indices = 0;
+    for (uint32_t i = 0; i < BlockPixels; i++)
+    {
+      uint32_t index = (a_block.mask & (1u << i)) ? indices[i] : 3;
+      result.indices |= index << (2 * i);
+    }
+    return result;
+  }
+
+  //Initial endpoints: the extent of the block along its principal axis.
+  static void FitPrincipalAxis(ColorBlock const & a_block, uint16_t & a_c0, uint16_t & a_c1)
+  {
+    float mean[3] = {0.0f, 0.0f, 0.0f};
+    float count = 0.0f;
+    for (uint32_t i = 0; i < BlockPixels; i++)
+    {
+      if ((a_block.mask & (1u << i)) == 0)
+        continue;
+      mean[0] += a_block.r[i];
+      mean[1] += a_block.g[i];
+      mean[2] += a_block.b[i];
+      count += 1.0f;
+    }
+
+    for (int i = 0; i < 3; i++)
+      mean[i] /= count;
+
+    //Covariance: xx, xy, xz, yy, yz, zz
+    float cov[6] = {0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f};
+    for (uint32_t i = 0; i < BlockPixels; i++)
+    {
+      if ((a_block.mask & (1u << i)) == 0)
+        continue;
+      float r = a_block.r[i] - mean[0];
+      float g = a_block.g[i] - mean[1];
+      float b = a_block.b[i] - mean[2];
+      cov[0] += r * r;
+      cov[1] += r * g;
+      cov[2] += r * b;
+      cov[3] += g * g;
+      cov[4] += g * b;
+      cov[5] += b * b;
+    }
+
+    //Power iteration, starting from the column with the largest variance
+    float axis[3];
+    if (cov[0] >= cov[3] && cov[0] >= cov[5])
+    {
+      axis[0] = cov[0]; axis[1] = cov[1]; axis[2] = cov[2];
+    }
+    else if (cov[3] >= cov[5])
+    {
+      axis[0] = cov[1]; axis[1] = cov[3]; axis[2] = cov[4];
+    }
+    else
+    {
+      axis[0] = cov[2]; axis[1] = cov[4]; axis[2] = cov[5];
+    }
+
+    for (uint32_t it = 0; it < PowerIterations; it++)
+    {
+      float x = cov[0] * axis[0] + cov[1] * axis[1] + cov[2] * axis[2];
+      float y = cov[1] * axis[0] + cov[3] * axis[1] + cov[4] * axis[2];
+      float z = cov[2] * axis[0] + cov[4] * axis[1] + cov[5] * axis[2];
+      float largest = fmaxf(fabsf(x), fmaxf(fabsf(y), fabsf(z)));
+      if (largest < 1.0e-6f)
+        break;
+      axis[0] = x / largest;
+      axis[1] = y / largest;
+      axis[2] = z / largest;
+    }
+
+    float lengthSq = axis[0] * axis[0] + axis[1] * axis[1] + axis[2] * axis[2];
+    if (lengthSq > 1.0e-12f)
+    {
+      float invLength = 1.0f / sqrtf(lengthSq);
+      for (int i = 0; i < 3; i++)
+        axis[i] *= invLength;
+    }
+
+    float minProj = FLT_MAX;
+    float maxProj = -FLT_MAX;
+    for (uint32_t i = 0; i < BlockPixels; i++)
+    {
+      if ((a_block.mask & (1u << i)) == 0)
+        continue;
+      float proj = (a_block.r[i] - mean[0]) * axis[0]
+                 + (a_block.g[i] - mean[1]) * axis[1]
+                 + (a_block.b[i] - mean[2]) * axis[2];
+      minProj = proj < minProj ? proj : minProj;
+      maxProj = proj > maxProj ? proj : maxProj;
+    }
+
+    float e0[3], e1[3];
+    for (int i = 0; i < 3; i++)
+    {
+      e0[i] = mean[i] + axis[i] * maxProj;
+      e1[i] = mean[i] + axis[i] * minProj;
+    }
+    a_c0 = Pack565(e0);
+    a_c1 = Pack565(e1);
+  }
+
+  //Least squares fit of the endpoints to the current indices. Returns false if the
+  //system is degenerate, ie all pixels share one index.
+  static bool RefineEndpoints(ColorBlock const & a_block, ColorEncoding const & a_current, bool a_threeColor,
+                              uint16_t & a_c0, uint16_t & a_c1)
+  {
+    static float const s_weights4[4] = {1.0f, 0.0f, 2.0f / 3.0f, 1.0f / 3.0f};
+    static float const s_weights3[4] = {1.0f, 0.0f, 0.5f, 0.0f};
+    float const * weights = a_threeColor ? s_weights3 : s_weights4;
+
+    float aa = 0.0f, bb = 0.0f, ab = 0.0f;
+    float ax[3] = {0.0f, 0.0f, 0.0f};
+    float bx[3] = {0.0f, 0.0f, 0.0f};
+    for (uint32_t i = 0; i < BlockPixels; i++)
+    {
+      if ((a_block.mask & (1u << i)) == 0)
+        continue;
+
+      float a = weights[(a_current.indices >> (2 * i)) & 3];
+      float b = 1.0f - a;
+      aa += a * a;
+      bb += b * b;
+      ab += a * b;
+      ax[0] += a * a_block.r[i];
+      ax[1] += a * a_block.g[i];
+      ax[2] += a * a_block.b[i];
+      bx[0] += b * a_block.r[i];
+      bx[1] += b * a_block.g[i];
+      bx[2] += b * a_block.b[i];
+    }
+
+    float det = aa * bb - ab * ab;
+    if (fabsf(det) < 1.0e-6f)
+      return false;
+
+    float invDet = 1.0f / det;
+    float e0[3], e1[3];
+    for (int i = 0; i < 3; i++)
+    {
+      e0[i] = (ax[i] * bb - bx[i] * ab) * invDet;
+      e1[i] = (bx[i] * aa - ax[i] * ab) * invDet;
+    }
+    a_c0 = Pack565(e0);
+    a_c1 = Pack565(e1);
+    return true;
+  }
+
+  static void EncodeColor(ColorBlock const & a_block, bool a_threeColor, byte * a_out)
+  {
+    ColorEncoding best;
+    if (a_block.mask == 0)
+    {
+      //Fully transparent
+      best.c0 = 0;
+      best.c1 = 0;
+      best.indices = 0xFFFFFFFF;
+    }
+    else
+    {
+      uint16_t c0, c1;
+      FitPrincipalAxis(a_block, c0, c1);
+      best = Evaluate(a_block, c0, c1, a_threeColor);
+
+      for (uint32_t it = 0; it < RefineIterations; it++)
+      {
+        if (best.error == 0.0f || !RefineEndpoints(a_block, best, a_threeColor, c0, c1))
+          break;
+
+        ColorEncoding candidate = Evaluate(a_block, c0, c1, a_threeColor);
+        if (candidate.error >= best.error)
+          break;
+        best = candidate;
+      }
+    }
+
+    WriteU16(a_out, best.c0);
+    WriteU16(a_out + 2, best.c1);
+    WriteU32(a_out + 4, best.indices);
+  }
+
+  static void DecodeColor(byte const * a_block, RGBA * a_pixels, bool a_allowThreeColor)
+  {
+    uint16_t c0 = static_cast<uint16_t>(ReadU16(a_block));
+    uint16_t c1 = static_cast<uint16_t>(ReadU16(a_block + 2));
+    bool threeColor = a_allowThreeColor && c0 <= c1;
+
+    uint32_t palette[4][3];
+    BuildPalette(c0, c1, threeColor, palette);
+
+    uint32_t indices = ReadU32(a_block + 4);
+    for (uint32_t i = 0; i < BlockPixels; i++)
+    {
+      uint32_t index = (indices >> (2 * i)) & 3;
+      RGBA pixel;
+      pixel.r(palette[index][0]);
+      pixel.g(palette[index][1]);
+      pixel.b(palette[index][2]);
+      pixel.a((threeColor && index == 3) ? 0 : 255);
+      a_pixels[i] = pixel;
+    }
+  }
+
+  static void LoadColorBlock(RGBA const * a_pixels, uint32_t a_alphaThreshold, ColorBlock & a_block)
+  {
+    a_block.mask = 0;
+    for (uint32_t i = 0; i < BlockPixels; i++)
+    {
+      a_block.r[i] = float(a_pixels[i].r());
+      a_block.g[i] = float(a_pixels[i].g());
+      a_block.b[i] = float(a_pixels[i].b());
+      if (a_pixels[i].a() >= a_alphaThreshold)
+        a_block.mask |= (1u << i);
+    }
+  }
+
+  //-----------------------------------------------------------------------------------------------
+  // Alpha block
+  //-----------------------------------------------------------------------------------------------
+
+  static void BuildAlphaPalette(uint32_t a_a0, uint32_t a_a1, uint32_t * a_palette)
+  {
+    a_palette[0] = a_a0;
+    a_palette[1] = a_a1;
+    if (a_a0 > a_a1)
+    {
+      for (uint32_t i = 1; i < 7; i++)
+        a_palette[i + 1] = ((7 - i) * a_a0 + i * a_a1) / 7;
+    }
+    else
+    {
+      for (uint32_t i = 1; i < 5; i++)
+        a_palette[i + 1] = ((5 - i) * a_a0 + i * a_a1) / 5;
+      a_palette[6] = 0;
+      a_palette[7] = 255;
+    }
+  }
+
+  //Always uses the 8 value mode, with the block's own alpha range as endpoints.
+  static void EncodeAlpha(RGBA const * a_pixels, byte * a_out)
+  {
+    uint32_t a0 = 0;
+    uint32_t a1 = 255;
+    for (uint32_t i = 0; i < BlockPixels; i++)
+    {
+      uint32_t a = a_pixels[i].a();
+      a0 = a > a0 ? a : a0;
+      a1 = a < a1 ? a : a1;
+    }
+
+    uint64_t bits = 0;
+    if (a0 > a1)
+    {
+      uint32_t palette[8];
+      BuildAlphaPalette(a0, a1, palette);
+      for (uint32_t i = 0; i < BlockPixels; i++)
+      {
+        int32_t a = int32_t(a_pixels[i].a());
+        uint32_t bestIndex = 0;
+        int32_t bestError = 256;
+        for (uint32_t k = 0; k < 8; k++)
+        {
+          int32_t error = abs(a - int32_t(palette[k]));
+          if (error < bestError)
+          {
+            bestError = error;
+            bestIndex = k;
+          }
+        }
+        bits |= uint64_t(bestIndex) << (3 * i);
+      }
+    }
+
+    a_out[0] = static_cast<byte>(a0);
+    a_out[1] = static_cast<byte>(a1);
+    for (uint32_t i = 0; i < 6; i++)
+      a_out[2 + i] = static_cast<byte>((bits >> (8 * i)) & 0xFF);
+  }
+
+  static void DecodeAlpha(byte const * a_block, RGBA * a_pixels)
+  {
+    uint32_t palette[8];
+    BuildAlphaPalette(a_block[0], a_block[1], palette);
+
+    uint64_t bits = 0;
+    for (uint32_t i = 0; i < 6; i++)
+      bits |= uint64_t(a_block[2 + i]) << (8 * i);
+
+    for (uint32_t i = 0; i < BlockPixels; i++)
+      a_pixels[i].a(palette[(bits >> (3 * i)) & 7]);
+  }
+
+  //-----------------------------------------------------------------------------------------------
+  // Interface
+  //-----------------------------------------------------------------------------------------------
+
+  uint32_t BlockSize(TextureFormat a_format)
+  {
+    switch (a_format)
+    {
+      case TextureFormat::BC1: return 8;
+      case TextureFormat::BC3: return 16;
+      default:                 return 0;
+    }
+  }
+
+  size_t ImageDataSize(TextureFormat a_format, uint32_t a_width, uint32_t a_height)
+  {
+    if (a_format == TextureFormat::Index8)
+    {
+      //Padded so the next level starts on an RGBA boundary
+      size_t size = size_t(a_width) * a_height;
+      return (size + sizeof(RGBA) - 1) & ~(sizeof(RGBA) - 1);
+    }
+
+    uint32_t blockSize = BlockSize(a_format);
+    if (blockSize == 0)
+      return size_t(a_width) * a_height * sizeof(RGBA);
+
+    size_t blocksX = (a_width + BlockDim - 1) / BlockDim;
+    size_t blocksY = (a_height + BlockDim - 1) / BlockDim;
+    return blocksX * blocksY * blockSize;
+  }
+
+  void EncodeBC1Block(RGBA const * a_pPixels, byte * a_out)
+  {
+    ColorBlock block;
+    LoadColorBlock(a_pPixels, AlphaThreshold, block);
+    EncodeColor(block, block.mask != 0xFFFF, a_out);
+  }
+
+  void EncodeBC3Block(RGBA const * a_pPixels, byte * a_out)
+  {
+    ColorBlock block;
+    LoadColorBlock(a_pPixels, 0, block);
+    EncodeAlpha(a_pPixels, a_out);
+    EncodeColor(block, false, a_out + 8);
+  }
+
+  void DecodeBC1Block(byte const * a_block, RGBA * a_pPixels)
+  {
+    DecodeColor(a_block, a_pPixels, true);
+  }
+
+  void DecodeBC3Block(byte const * a_block, RGBA * a_pPixels)
+  {
+    DecodeColor(a_block + 8, a_pPixels, false);
+    DecodeAlpha(a_block, a_pPixels);
+  }
+
+  void CompressImage(RGBA const * a_pSrc, uint32_t a_width, uint32_t a_height, TextureFormat a_format, byte * a_pDst)
+  {
+    uint32_t blockSize = BlockSize(a_format);
+    if (blockSize == 0)
+    {
+      BSR_ASSERT(a_format == TextureFormat::RGBA8, "CompressImage(): Not a block format");
+      memcpy(a_pDst, a_pSrc, ImageDataSize(a_format, a_width, a_height));
+      return;
+    }
+
+    uint32_t blocksX = (a_width + BlockDim - 1) / BlockDim;
+    uint32_t blocksY = (a_height + BlockDim - 1) / BlockDim;
+
+    GC::ParallelFor(WorkerPool::Instance(), blocksY, BlockRowsPerTask,
+      [=](uint32_t a_begin, uint32_t a_end)
+      {
+        RGBA pixels[BlockPixels];
+        for (uint32_t by = a_begin; by < a_end; by++)
+        {
+          for (uint32_t bx = 0; bx < blocksX; bx++)
+          {
+            for (uint32_t y = 0; y < BlockDim; y++)
+            {
+              uint32_t sy = by * BlockDim + y;
+              sy = sy < a_height ? sy : a_height - 1;
+              for (uint32_t x = 0; x < BlockDim; x++)
+              {
+                uint32_t sx = bx * BlockDim + x;
+                sx = sx < a_width ? sx : a_width - 1;
+                pixels[y * BlockDim + x] = a_pSrc[size_t(sy) * a_width + sx];
+              }
+            }
+
+            byte * pOut = a_pDst + (size_t(by) * blocksX + bx) * blockSize;
+            if (a_format == TextureFormat::BC1)
+              EncodeBC1Block(pixels, pOut);
+            else
+              EncodeBC3Block(pixels, pOut);
+          }
+        }
+      });
+  }
+}
@@ -0,0 +1,36 @@
+//@group Renderer
+
+#ifndef BLOCKCOMPRESSION_H
+#define BLOCKCOMPRESSION_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+#include "core_utils.h"
+#include "TextureData.h"
+
+namespace Engine
+{
+  uint32_t const BlockDim = 4;
+
+  //Bytes per 4x4 block. Returns 0 for uncompressed formats.
+  uint32_t BlockSize(TextureFormat);
+
+  //Bytes needed to store one image in the given format.
+  size_t ImageDataSize(TextureFormat, uint32_t width, uint32_t height);
+
+  //Encodes one 4x4 block of pixels, stored row by row.
+  //BC1 blocks containing pixels with alpha < 128 are encoded with 1-bit alpha.
+  void EncodeBC1Block(RGBA const * pixels, byte * out);
+  void EncodeBC3Block(RGBA const * pixels, byte * out);
+
+  void DecodeBC1Block(byte const * block, RGBA * pixels);
+  void DecodeBC3Block(byte const * block, RGBA * pixels);
+
+  //Compresses a whole image into 'dst', which must hold ImageDataSize() bytes. Edge blocks
+  //on images that are not a multiple of 4 repeat the last row and column. Rows of blocks
+  //are encoded on the WorkerPool, if it is running.
+  void CompressImage(RGBA const * src, uint32_t width, uint32_t height, TextureFormat, byte * dst);
+}
+
+#endif
@@ -173,6 +173,77 @@ namespace Engine
     return pBuf;
   }
 
+  //------------------------------------------------------------------------------------------------
+  // Batch staging
+  //------------------------------------------------------------------------------------------------
+
+  //A batch is staged in a single render allocation:
+  //
+  //  [StagedBuffer x count][RendererID x count][data...]
+  //
+  //The RendererID block is scratch space for the render thread to create the names into.
+  struct StagedBuffer
+  {
+    RenderHandle  handle;
+    uint32_t      size;
+    uint32_t      offset;
+    BufferUsage   usage;
+    bool          hasData;
+  };
+
+  struct StagedBufferBatch
+  {
+    StagedBuffer *  pBuffers;
+    RendererID *    pIDs;
+    byte *          pData;
+    uint32_t        count;
+  };
+
+  template<typename T>
+  static StagedBufferBatch StageBuffers(BufferDesc const * a_descs, Ref<T> const * a_buffers, uint32_t a_count)
+  {
+    size_t dataSize = 0;
+    for (uint32_t i = 0; i < a_count; i++)
+    {
+      if (a_descs[i].data != nullptr)
+        dataSize += a_descs[i].size;
+    }
+
+    size_t headerSize = a_count * (sizeof(StagedBuffer) + sizeof(RendererID));
+    byte * pMem = static_cast<byte*>(RENDER_ALLOCATE(static_cast<uint32_t>(headerSize + dataSize)));
+
+    StagedBufferBatch batch;
+    batch.pBuffers = reinterpret_cast<StagedBuffer*>(pMem);
+    batch.pIDs = reinterpret_cast<RendererID*>(pMem + a_count * sizeof(StagedBuffer));
+    batch.pData = pMem + headerSize;
+    batch.count = a_count;
+
+    uint32_t offset = 0;
+    for (uint32_t i = 0; i < a_count; i++)
+    {
+      BufferDesc const & desc = a_descs[i];
+      StagedBuffer & staged = batch.pBuffers[i];
+      staged.handle = a_buffers[i]->GetHandle();
+      staged.size = desc.size;
+      staged.offset = offset;
+      staged.usage = desc.usage;
+      staged.hasData = desc.data != nullptr;
+
+      if (staged.hasData)
+      {
+        memcpy(batch.pData + offset, desc.data, desc.size);
+        offset += desc.size;
+      }
+    }
+    return batch;
+  }
+
+  static void const * StagedData(StagedBufferBatch const & a_batch, uint32_t a_index)
+  {
+    StagedBuffer const & staged = a_batch.pBuffers[a_index];
+    return staged.hasData ? a_batch.pData + staged.offset : nullptr;
+  }
+
   //------------------------------------------------------------------------------------------------
   // VertexBuffer
   //------------------------------------------------------------------------------------------------
@@ -191,7 +262,7 @@ namespace Engine
     state.Set<RenderState::Attr::Type>(RenderState::Type::Command);
     state.Set<RenderState::Attr::Command>(RenderState::Command::BufferCreate);
 
-    RENDER_SUBMIT(state, [resID = GetRefID().GetID(), size = a_size, usage = a_usage, data]()
+    RENDER_SUBMIT(state, [resID = GetHandle(), size = a_size, usage = a_usage, data]()
       {
         ::Engine::RT_VertexBuffer vb;
         vb.Init(data, size, usage);
@@ -205,7 +276,7 @@ namespace Engine
     state.Set<RenderState::Attr::Type>(RenderState::Type::Command);
     state.Set<RenderState::Attr::Command>(RenderState::Command::BufferCreate);
 
-    RENDER_SUBMIT(state, [resID = GetRefID().GetID(), size = a_size, usage = a_usage]()
+    RENDER_SUBMIT(state, [resID = GetHandle(), size = a_size, usage = a_usage]()
       {
         ::Engine::RT_VertexBuffer vb;
         vb.Init(size, usage);
@@ -213,18 +284,44 @@ namespace Engine
       });
   }
   
+  void VertexBuffer::CreateBatch(BufferDesc const * a_descs, uint32_t a_count, Ref<VertexBuffer> * a_out)
+  {
+    if (a_count == 0)
+      return;
+
+    for (uint32_t i = 0; i < a_count; i++)
+      a_out[i] = Ref<VertexBuffer>(new VertexBuffer());
+
+    StagedBufferBatch batch = StageBuffers(a_descs, a_out, a_count);
+
+    RenderState state = RenderState::Create();
+    state.Set<RenderState::Attr::Type>(RenderState::Type::Command);
+    state.Set<RenderState::Attr::Command>(RenderState::Command::BufferCreate);
+
+    RENDER_SUBMIT(state, [batch]()
+      {
+        ::Engine::RT_BufferBase::CreateRendererIDs(batch.count, batch.pIDs);
+        for (uint32_t i = 0; i < batch.count; i++)
+        {
+          StagedBuffer const & staged = batch.pBuffers[i];
+          ::Engine::RT_VertexBuffer * pVBO = ::Engine::RenderThreadData::Instance()->VBOs.insert(staged.handle, ::Engine::RT_VertexBuffer());
+          pVBO->Init(batch.pIDs[i], StagedData(batch, i), staged.size, staged.usage);
+        }
+      });
+  }
+
   VertexBuffer::~VertexBuffer()
   {
     RenderState state = RenderState::Create();
     state.Set<RenderState::Attr::Type>(RenderState::Type::Command);
     state.Set<RenderState::Attr::Command>(RenderState::Command::BufferDelete);
 
-    RENDER_SUBMIT(state, [resID = GetRefID().GetID()]() mutable
+    RENDER_SUBMIT(state, [resID = GetHandle()]() mutable
       {
         RT_VertexBuffer * pVBO =  RenderThreadData::Instance()->VBOs.at(resID);
         if (pVBO == nullptr)
         {
-          LOG_WARN("VertexBuffer::~VertexBuffer: RefID '{}' does not exist!", resID);
+          LOG_WARN("VertexBuffer::~VertexBuffer: handle '{}' does not exist!", resID.index);
           return;
         }
         pVBO->Destroy();
@@ -241,12 +338,12 @@ namespace Engine
     state.Set<RenderState::Attr::Type>(RenderState::Type::Command);
     state.Set<RenderState::Attr::Command>(RenderState::Command::BufferSetData);
 
-    RENDER_SUBMIT(state, [resID = GetRefID().GetID(), offset = a_offset, size = a_size, data]()
+    RENDER_SUBMIT(state, [resID = GetHandle(), offset = a_offset, size = a_size, data]()
       {
         ::Engine::RT_VertexBuffer * pVBO = ::Engine::RenderThreadData::Instance()->VBOs.at(resID);
         if (pVBO == nullptr)
         {
-          LOG_WARN("VertexBuffer::SetData(): RefID '{}' does not exist!", resID);
+          LOG_WARN("VertexBuffer::SetData(): handle '{}' does not exist!", resID.index);
           return;
         }
 
@@ -260,12 +357,12 @@ namespace Engine
     state.Set<RenderState::Attr::Type>(RenderState::Type::Command);
     state.Set<RenderState::Attr::Command>(RenderState::Command::BufferBind);
 
-    RENDER_SUBMIT(state, [resID = GetRefID().GetID()]()
+    RENDER_SUBMIT(state, [resID = GetHandle()]()
       {
         ::Engine::RT_VertexBuffer * pVBO = ::Engine::RenderThreadData::Instance()->VBOs.at(resID);
         if (pVBO == nullptr)
         {
-          LOG_WARN("VertexBuffer::Bind(): RefID '{}' does not exist!", resID);
+          LOG_WARN("VertexBuffer::Bind(): handle '{}' does not exist!", resID.index);
           return;
         }
 
@@ -282,12 +379,12 @@ namespace Engine
     state.Set<RenderState::Attr::Type>(RenderState::Type::Command);
     state.Set<RenderState::Attr::Command>(RenderState::Command::BufferSetLayout);
 
-    RENDER_SUBMIT(state, [resID = GetRefID().GetID(), buffer = buffer]()
+    RENDER_SUBMIT(state, [resID = GetHandle(), buffer = buffer]()
     {
       ::Engine::RT_VertexBuffer* pVBO = ::Engine::RenderThreadData::Instance()->VBOs.at(resID);
       if (pVBO == nullptr)
       {
-        LOG_WARN("VertexBuffer::SetLayout(): RefID '{}' does not exist!", resID);
+        LOG_WARN("VertexBuffer::SetLayout(): handle '{}' does not exist!", resID.index);
         return;
       }
       BufferLayout layout;
@@ -333,7 +430,7 @@ namespace Engine
     state.Set<RenderState::Attr::Type>(RenderState::Type::Command);
     state.Set<RenderState::Attr::Command>(RenderState::Command::BufferCreate);
 
-    RENDER_SUBMIT(state, [resID = GetRefID().GetID(), size = a_size, usage = a_usage, data]()
+    RENDER_SUBMIT(state, [resID = GetHandle(), size = a_size, usage = a_usage, data]()
     {
       ::Engine::RT_UniformBuffer ub;
       ub.Init(data, size, usage);
@@ -347,7 +444,7 @@ namespace Engine
     state.Set<RenderState::Attr::Type>(RenderState::Type::Command);
     state.Set<RenderState::Attr::Command>(RenderState::Command::BufferCreate);
 
-    RENDER_SUBMIT(state, [resID = GetRefID().GetID(), size = a_size, usage = a_usage]()
+    RENDER_SUBMIT(state, [resID = GetHandle(), size = a_size, usage = a_usage]()
     {
       ::Engine::RT_UniformBuffer ub;
       ub.Init(size, usage);
@@ -361,12 +458,12 @@ namespace Engine
     state.Set<RenderState::Attr::Type>(RenderState::Type::Command);
     state.Set<RenderState::Attr::Command>(RenderState::Command::BufferDelete);
 
-    RENDER_SUBMIT(state, [resID = GetRefID().GetID()]() mutable
+    RENDER_SUBMIT(state, [resID = GetHandle()]() mutable
     {
       RT_UniformBuffer* pUBO =  RenderThreadData::Instance()->UBOs.at(resID);
       if (pUBO == nullptr)
       {
-        LOG_WARN("UniformBuffer::~UniformBuffer: RefID '{}' does not exist!", resID);
+        LOG_WARN("UniformBuffer::~UniformBuffer: handle '{}' does not exist!", resID.index);
         return;
       }
       pUBO->Destroy();
@@ -383,12 +480,12 @@ namespace Engine
     state.Set<RenderState::Attr::Type>(RenderState::Type::Command);
     state.Set<RenderState::Attr::Command>(RenderState::Command::BufferSetData);
 
-    RENDER_SUBMIT(state, [resID = GetRefID().GetID(), offset = a_offset, size = a_size, data]()
+    RENDER_SUBMIT(state, [resID = GetHandle(), offset = a_offset, size = a_size, data]()
     {
       ::Engine::RT_UniformBuffer* pUBO = ::Engine::RenderThreadData::Instance()->UBOs.at(resID);
       if (pUBO == nullptr)
       {
-        LOG_WARN("UniformBuffer::SetData(): RefID '{}' does not exist!", resID);
+        LOG_WARN("UniformBuffer::SetData(): handle '{}' does not exist!", resID.index);
         return;
       }
 
@@ -402,12 +499,12 @@ namespace Engine
     state.Set<RenderState::Attr::Type>(RenderState::Type::Command);
     state.Set<RenderState::Attr::Command>(RenderState::Command::BufferBind);
 
-    RENDER_SUBMIT(state, [resID = GetRefID().GetID()]()
+    RENDER_SUBMIT(state, [resID = GetHandle()]()
     {
       ::Engine::RT_UniformBuffer* pUBO = ::Engine::RenderThreadData::Instance()->UBOs.at(resID);
       if (pUBO == nullptr)
       {
-        LOG_WARN("UniformBuffer::Bind(): RefID '{}' does not exist!", resID);
+        LOG_WARN("UniformBuffer::Bind(): handle '{}' does not exist!", resID.index);
         return;
       }
 
@@ -424,12 +521,12 @@ namespace Engine
     state.Set<RenderState::Attr::Type>(RenderState::Type::Command);
     state.Set<RenderState::Attr::Command>(RenderState::Command::BufferSetLayout);
 
-    RENDER_SUBMIT(state, [resID = GetRefID().GetID(), buffer = buffer]()
+    RENDER_SUBMIT(state, [resID = GetHandle(), buffer = buffer]()
     {
       ::Engine::RT_UniformBuffer* pUBO = ::Engine::RenderThreadData::Instance()->UBOs.at(resID);
       if (pUBO == nullptr)
       {
-        LOG_WARN("UniformBuffer::SetLayout(): RefID '{}' does not exist!", resID);
+        LOG_WARN("UniformBuffer::SetLayout(): handle '{}' does not exist!", resID.index);
         return;
       }
       BufferLayout layout;
@@ -463,19 +560,19 @@ namespace Engine
     state.Set<RenderState::Attr::Type>(RenderState::Type::Command);
     state.Set<RenderState::Attr::Command>(RenderState::Command::IndexedBufferBind);
 
-    RENDER_SUBMIT(state, [uboID = GetRefID().GetID(), bpID = a_bp->GetRefID().GetID()]()
+    RENDER_SUBMIT(state, [uboID = GetHandle(), bpID = a_bp->GetHandle()]()
     {
       ::Engine::RT_UniformBuffer* pUBO = ::Engine::RenderThreadData::Instance()->UBOs.at(uboID);
       if (pUBO == nullptr)
       {
-        LOG_WARN("UniformBuffer::SetLayout(): UBO RefID '{}' does not exist!", uboID);
+        LOG_WARN("UniformBuffer::SetLayout(): UBO handle '{}' does not exist!", uboID.index);
         return;
       }
 
       ::Engine::RT_BindingPoint* pBP = ::Engine::RenderThreadData::Instance()->bindingPoints.at(bpID);
       if (pUBO == nullptr)
       {
-        LOG_WARN("UniformBuffer::SetLayout(): BP RefID '{}' does not exist!", bpID);
+        LOG_WARN("UniformBuffer::SetLayout(): BP handle '{}' does not exist!", bpID.index);
         return;
       }
       
@@ -500,7 +597,7 @@ namespace Engine
     state.Set<RenderState::Attr::Type>(RenderState::Type::Command);
     state.Set<RenderState::Attr::Command>(RenderState::Command::BufferCreate);
 
-    RENDER_SUBMIT(state, [resID = GetRefID().GetID(), size = a_size, usage = a_usage, data]()
+    RENDER_SUBMIT(state, [resID = GetHandle(), size = a_size, usage = a_usage, data]()
     {
       ::Engine::RT_ShaderStorageBuffer ssb;
       ssb.Init(data, size, usage);
@@ -514,7 +611,7 @@ namespace Engine
     state.Set<RenderState::Attr::Type>(RenderState::Type::Command);
     state.Set<RenderState::Attr::Command>(RenderState::Command::BufferCreate);
 
-    RENDER_SUBMIT(state, [resID = GetRefID().GetID(), size = a_size, usage = a_usage]()
+    RENDER_SUBMIT(state, [resID = GetHandle(), size = a_size, usage = a_usage]()
     {
       ::Engine::RT_ShaderStorageBuffer ssb;
       ssb.Init(size, usage);
@@ -528,12 +625,12 @@ namespace Engine
     state.Set<RenderState::Attr::Type>(RenderState::Type::Command);
     state.Set<RenderState::Attr::Command>(RenderState::Command::BufferDelete);
 
-    RENDER_SUBMIT(state, [resID = GetRefID().GetID()]() mutable
+    RENDER_SUBMIT(state, [resID = GetHandle()]() mutable
     {
       RT_ShaderStorageBuffer* pSSBO =  RenderThreadData::Instance()->SSBOs.at(resID);
       if (pSSBO == nullptr)
       {
-        LOG_WARN("ShaderStorageBuffer::~ShaderStorageBuffer: RefID '{}' does not exist!", resID);
+        LOG_WARN("ShaderStorageBuffer::~ShaderStorageBuffer: handle '{}' does not exist!", resID.index);
         return;
       }
       pSSBO->Destroy();
@@ -550,12 +647,12 @@ namespace Engine
     state.Set<RenderState::Attr::Type>(RenderState::Type::Command);
     state.Set<RenderState::Attr::Command>(RenderState::Command::BufferSetData);
 
-    RENDER_SUBMIT(state, [resID = GetRefID().GetID(), offset = a_offset, size = a_size, data]()
+    RENDER_SUBMIT(state, [resID = GetHandle(), offset = a_offset, size = a_size, data]()
     {
       ::Engine::RT_ShaderStorageBuffer* pSSBO = ::Engine::RenderThreadData::Instance()->SSBOs.at(resID);
       if (pSSBO == nullptr)
       {
-        LOG_WARN("ShaderStorageBuffer::SetData(): RefID '{}' does not exist!", resID);
+        LOG_WARN("ShaderStorageBuffer::SetData(): handle '{}' does not exist!", resID.index);
         return;
       }
 
@@ -569,12 +666,12 @@ namespace Engine
     state.Set<RenderState::Attr::Type>(RenderState::Type::Command);
     state.Set<RenderState::Attr::Command>(RenderState::Command::BufferBind);
 
-    RENDER_SUBMIT(state, [resID = GetRefID().GetID()]()
+    RENDER_SUBMIT(state, [resID = GetHandle()]()
     {
       ::Engine::RT_ShaderStorageBuffer* pSSBO = ::Engine::RenderThreadData::Instance()->SSBOs.at(resID);
       if (pSSBO == nullptr)
       {
-        LOG_WARN("ShaderStorageBuffer::Bind(): RefID '{}' does not exist!", resID);
+        LOG_WARN("ShaderStorageBuffer::Bind(): handle '{}' does not exist!", resID.index);
         return;
       }
 
@@ -591,12 +688,12 @@ namespace Engine
     state.Set<RenderState::Attr::Type>(RenderState::Type::Command);
     state.Set<RenderState::Attr::Command>(RenderState::Command::BufferSetLayout);
 
-    RENDER_SUBMIT(state, [resID = GetRefID().GetID(), buffer = buffer]()
+    RENDER_SUBMIT(state, [resID = GetHandle(), buffer = buffer]()
     {
       ::Engine::RT_ShaderStorageBuffer* pSSBO = ::Engine::RenderThreadData::Instance()->SSBOs.at(resID);
       if (pSSBO == nullptr)
       {
-        LOG_WARN("ShaderStorageBuffer::SetLayout(): RefID '{}' does not exist!", resID);
+        LOG_WARN("ShaderStorageBuffer::SetLayout(): handle '{}' does not exist!", resID.index);
         return;
       }
       BufferLayout layout;
@@ -630,19 +727,19 @@ namespace Engine
     state.Set<RenderState::Attr::Type>(RenderState::Type::Command);
     state.Set<RenderState::Attr::Command>(RenderState::Command::IndexedBufferBind);
 
-    RENDER_SUBMIT(state, [uboID = GetRefID().GetID(), bpID = a_bp->GetRefID().GetID()]()
+    RENDER_SUBMIT(state, [uboID = GetHandle(), bpID = a_bp->GetHandle()]()
     {
       ::Engine::RT_ShaderStorageBuffer* pSSBO = ::Engine::RenderThreadData::Instance()->SSBOs.at(uboID);
       if (pSSBO == nullptr)
       {
-        LOG_WARN("ShaderStorageBuffer::SetLayout(): SSBO RefID '{}' does not exist!", uboID);
+        LOG_WARN("ShaderStorageBuffer::SetLayout(): SSBO handle '{}' does not exist!", uboID.index);
         return;
       }
 
       ::Engine::RT_BindingPoint* pBP = ::Engine::RenderThreadData::Instance()->bindingPoints.at(bpID);
       if (pSSBO == nullptr)
       {
-        LOG_WARN("ShaderStorageBuffer::SetLayout(): BP RefID '{}' does not exist!", bpID);
+        LOG_WARN("ShaderStorageBuffer::SetLayout(): BP handle '{}' does not exist!", bpID.index);
         return;
       }
       
@@ -668,7 +765,7 @@ namespace Engine
     state.Set<RenderState::Attr::Type>(RenderState::Type::Command);
     state.Set<RenderState::Attr::Command>(RenderState::Command::BufferCreate);
 
-    RENDER_SUBMIT(state, [resID = GetRefID().GetID(), size = a_size, data]()
+    RENDER_SUBMIT(state, [resID = GetHandle(), size = a_size, data]()
       {
         ::Engine::RT_IndexBuffer ib;
         ib.Init(data, size);
@@ -684,18 +781,44 @@ namespace Engine
     return ref;
   }
 
+  void IndexBuffer::CreateBatch(BufferDesc const * a_descs, uint32_t a_count, Ref<IndexBuffer> * a_out)
+  {
+    if (a_count == 0)
+      return;
+
+    for (uint32_t i = 0; i < a_count; i++)
+      a_out[i] = Ref<IndexBuffer>(new IndexBuffer());
+
+    StagedBufferBatch batch = StageBuffers(a_descs, a_out, a_count);
+
+    RenderState state = RenderState::Create();
+    state.Set<RenderState::Attr::Type>(RenderState::Type::Command);
+    state.Set<RenderState::Attr::Command>(RenderState::Command::BufferCreate);
+
+    RENDER_SUBMIT(state, [batch]()
+      {
+        ::Engine::RT_BufferBase::CreateRendererIDs(batch.count, batch.pIDs);
+        for (uint32_t i = 0; i < batch.count; i++)
+        {
+          StagedBuffer const & staged = batch.pBuffers[i];
+          ::Engine::RT_IndexBuffer * pIBO = ::Engine::RenderThreadData::Instance()->IBOs.insert(staged.handle, ::Engine::RT_IndexBuffer());
+          pIBO->Init(batch.pIDs[i], StagedData(batch, i), staged.size);
+        }
+      });
+  }
+
   IndexBuffer::~IndexBuffer()
   {
     RenderState state = RenderState::Create();
     state.Set<RenderState::Attr::Type>(RenderState::Type::Command);
     state.Set<RenderState::Attr::Command>(RenderState::Command::BufferDelete);
 
-    RENDER_SUBMIT(state, [resID = GetRefID().GetID()]() mutable
+    RENDER_SUBMIT(state, [resID = GetHandle()]() mutable
       {
         RT_IndexBuffer * pIB =  RenderThreadData::Instance()->IBOs.at(resID);
         if (pIB == nullptr)
         {
-          LOG_WARN("IndexBuffer::~IndexBuffer: RefID '{}' does not exist!", resID);
+          LOG_WARN("IndexBuffer::~IndexBuffer: handle '{}' does not exist!", resID.index);
           return;
         }
         pIB->Destroy();
@@ -712,12 +835,12 @@ namespace Engine
     state.Set<RenderState::Attr::Type>(RenderState::Type::Command);
     state.Set<RenderState::Attr::Command>(RenderState::Command::BufferSetData);
 
-    RENDER_SUBMIT(state, [resID = GetRefID().GetID(), offset = a_offset, size = a_size, data]()
+    RENDER_SUBMIT(state, [resID = GetHandle(), offset = a_offset, size = a_size, data]()
       {
         ::Engine::RT_IndexBuffer * pIBO = ::Engine::RenderThreadData::Instance()->IBOs.at(resID);
         if (pIBO == nullptr)
         {
-          LOG_WARN("IndexBuffer::SetData(): RefID '{}' does not exist!", resID);
+          LOG_WARN("IndexBuffer::SetData(): handle '{}' does not exist!", resID.index);
           return;
         }
 
@@ -731,12 +854,12 @@ namespace Engine
     state.Set<RenderState::Attr::Type>(RenderState::Type::Command);
     state.Set<RenderState::Attr::Command>(RenderState::Command::BufferBind);
 
-    RENDER_SUBMIT(state, [resID = GetRefID().GetID()]()
+    RENDER_SUBMIT(state, [resID = GetHandle()]()
       {
         ::Engine::RT_IndexBuffer * pIBO = ::Engine::RenderThreadData::Instance()->IBOs.at(resID);
         if (pIBO == nullptr)
         {
-          LOG_WARN("IndexBuffer::Bind(): RefID '{}' does not exist!", resID);
+          LOG_WARN("IndexBuffer::Bind(): handle '{}' does not exist!", resID.index);
           return;
         }
 
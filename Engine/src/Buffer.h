@@ -25,7 +25,7 @@
 
 #include "Memory.h"
 #include "core_Assert.h"
-#include "Resource.h"
+#include "RenderResource.h"
 #include "ShaderUniform.h"
 #include "ShaderUtils.h"
 
@@ -88,11 +88,19 @@ namespace Engine
     uint32_t m_stride;
   };
 
+  //Describes one buffer in a batch. 'data' can be null.
+  struct BufferDesc
+  {
+    void const *  data;
+    uint32_t      size;
+    BufferUsage   usage;
+  };
+
   //------------------------------------------------------------------------------------------------
   // VertexBuffer
   //------------------------------------------------------------------------------------------------
 
-  class VertexBuffer : public Resource
+  class VertexBuffer : public RenderResource<VertexBuffer>
   {
   private:
     void Init(void* data, uint32_t size, BufferUsage a_usage = BufferUsage::Static);
@@ -112,6 +120,10 @@ namespace Engine
     static Ref<VertexBuffer> Create(uint32_t a_size,
                                     BufferUsage a_usage = BufferUsage::Static);
 
+    //Creates 'count' buffers with one render command and one staging allocation.
+    //Results are written to 'out', which must hold 'count' elements.
+    static void CreateBatch(BufferDesc const * descs, uint32_t count, Ref<VertexBuffer> * out);
+
     ~VertexBuffer();
 
     void SetData(void* data, uint32_t size, uint32_t offset = 0);
@@ -124,7 +136,7 @@ namespace Engine
   // UniformBuffer
   //------------------------------------------------------------------------------------------------
 
-  class UniformBuffer : public Resource
+  class UniformBuffer : public RenderResource<UniformBuffer>
   {
   private:
     void Init(void* data, uint32_t size, BufferUsage a_usage = BufferUsage::Static);
@@ -157,7 +169,7 @@ namespace Engine
   // ShaderStorageBuffer
   //------------------------------------------------------------------------------------------------
 
-  class ShaderStorageBuffer : public Resource
+  class ShaderStorageBuffer : public RenderResource<ShaderStorageBuffer>
   {
   private:
     void Init(void* data, uint32_t size, BufferUsage a_usage = BufferUsage::Static);
@@ -191,7 +203,7 @@ namespace Engine
   // IndexBuffer
   //------------------------------------------------------------------------------------------------
 
-  class IndexBuffer : public Resource
+  class IndexBuffer : public RenderResource<IndexBuffer>
   {
     void Init(void* data, uint32_t size);
     IndexBuffer();
@@ -203,6 +215,10 @@ namespace Engine
 
     static Ref<IndexBuffer> Create(void* a_data, uint32_t a_size);
 
+    //Creates 'count' buffers with one render command and one staging allocation.
+    //Results are written to 'out', which must hold 'count' elements. Usage is ignored.
+    static void CreateBatch(BufferDesc const * descs, uint32_t count, Ref<IndexBuffer> * out);
+
      ~IndexBuffer();
 
     void SetData(void* data, uint32_t size, uint32_t offset);
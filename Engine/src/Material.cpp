@@ -64,13 +64,31 @@ namespace Engine
        delete[] m_pBuf;
     }
 
-    void MaterialBase::Bind()
+    bool MaterialBase::Bind()
     {
       BSR_ASSERT(!m_materialData.IsNull());
       BSR_ASSERT(!m_materialData->m_prog.IsNull());
 
+      if (!IsReady())
+      {
+        if (m_fallback.IsNull())
+          return false;
+        return m_fallback->Bind();
+      }
+
       m_materialData->m_prog->Bind();
       m_materialData->m_prog->UploadUniformBuffer(m_pBuf);
+      return true;
+    }
+
+    bool MaterialBase::IsReady() const
+    {
+      return m_materialData->m_prog->IsReady();
+    }
+
+    void MaterialBase::SetFallback(Ref<Material> const & a_fallback)
+    {
+      m_fallback = a_fallback;
     }
 
     ShaderUniformDeclaration const* MaterialBase::FindUniform(std::string const& a_name)
@@ -147,16 +165,31 @@ namespace Engine
   }
 
   void Material::SetTexture(std::string const & a_name, Ref<Texture2D> const & a_texture)
+  {
+    SetTextureHandle(a_name, a_texture->GetHandle());
+  }
+
+  void Material::SetTexture(std::string const & a_name, Ref<Texture2DArray> const & a_texture)
+  {
+    SetTextureHandle(a_name, a_texture->GetHandle());
+  }
+
+  void Material::SetTextureHandle(std::string const & a_name, RenderHandle a_handle)
   {
     ShaderUniformDeclaration const * pdecl = FindUniform(a_name);
-    UniformBufferElementHeader header = CreateHeader(pdecl, sizeof(RefID));
+    UniformBufferElementHeader header = CreateHeader(pdecl, sizeof(RenderHandle));
 
     uint32_t offset = pdecl->GetDataOffset();
-    RefID id = a_texture->GetRefID().GetID();
-    WriteToBuffer(offset, header, &id);
+    RenderHandle handle = a_handle;
+    WriteToBuffer(offset, header, &handle);
 
     for (auto pInst : m_materialInstances)
-      pInst->SetUniform(offset, &id, sizeof(RefID));
+      pInst->SetUniform(offset, &handle, sizeof(RenderHandle));
+  }
+
+  void Material::SetTextureRegion(std::string const & a_name, AtlasRegion const & a_region)
+  {
+    SetUniform(a_name, a_region.uv, sizeof(a_region.uv));
   }
 
   //-----------------------------------------------------------------------------------------------
@@ -190,14 +223,29 @@ namespace Engine
   }
 
   void MaterialInstance::SetTexture(std::string const & a_name, Ref<Texture2D> const & a_texture)
+  {
+    SetTextureHandle(a_name, a_texture->GetHandle());
+  }
+
+  void MaterialInstance::SetTexture(std::string const & a_name, Ref<Texture2DArray> const & a_texture)
+  {
+    SetTextureHandle(a_name, a_texture->GetHandle());
+  }
+
+  void MaterialInstance::SetTextureHandle(std::string const & a_name, RenderHandle a_handle)
   {
     ShaderUniformDeclaration const * pdecl = FindUniform(a_name);
-    UniformBufferElementHeader header = CreateHeader(pdecl, sizeof(RefID));
+    UniformBufferElementHeader header = CreateHeader(pdecl, sizeof(RenderHandle));
     header.SetFlag(UniformBufferElementHeader::ElementLocked, true);
 
     uint32_t offset = pdecl->GetDataOffset();
-    RefID id = a_texture->GetRefID().GetID();
-    WriteToBuffer(offset, header, &id);
+    RenderHandle handle = a_handle;
+    WriteToBuffer(offset, header, &handle);
+  }
+
+  void MaterialInstance::SetTextureRegion(std::string const & a_name, AtlasRegion const & a_region)
+  {
+    SetUniform(a_name, a_region.uv, sizeof(a_region.uv));
   }
 
   void MaterialInstance::SetUniform(uint32_t a_offset, void const* a_pBuf, uint32_t a_size)
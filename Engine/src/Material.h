@@ -29,9 +29,13 @@
 #include "DgDynamicArray.h"
 #include "DgMap_AVL.h"
 #include "Texture.h"
+#include "TextureArray.h"
+#include "TextureAtlas.h"
 
 namespace Engine
 {
+  class Material;
+
   namespace impl
   {
     class MaterialData : public Resource
@@ -52,7 +56,12 @@ namespace Engine
 
       MaterialBase(Ref<impl::MaterialData>);
       virtual ~MaterialBase();
-      void Bind();
+
+      //Returns false if nothing was bound, in which case the draw should be skipped.
+      //If the program is still compiling, the fallback material is bound instead, if set.
+      bool Bind();
+      bool IsReady() const;
+      void SetFallback(Ref<Material> const &);
 
     protected:
 
@@ -63,6 +72,7 @@ namespace Engine
     protected:
 
       Ref<impl::MaterialData>               m_materialData;
+      Ref<Material>                         m_fallback;
       uint32_t                              m_bufSize;
       byte*                                 m_pBuf;
     };
@@ -76,6 +86,15 @@ namespace Engine
     ~MaterialInstance();
     void SetUniform(std::string const& uniform, void const* data, uint32_t size);
     void SetTexture(std::string const& name, Ref<Texture2D> const&);
+    void SetTexture(std::string const& name, Ref<Texture2DArray> const&);
+
+    //Writes the uv rectangle of an atlas region to a vec4 uniform. Instances sharing an
+    //atlas page share a texture, so they can be drawn together.
+    void SetTextureRegion(std::string const& name, AtlasRegion const&);
+
+  private:
+
+    void SetTextureHandle(std::string const& name, RenderHandle);
 
   private: //Accessed by Material
 
@@ -98,6 +117,17 @@ namespace Engine
     void SetUniform(std::string const& name, void const* data, uint32_t size);
     void SetTexture(std::string const& name, Ref<Texture2D> const&);
 
+    //For a sampler2DArray uniform. Every surface using the array can share the material.
+    void SetTexture(std::string const& name, Ref<Texture2DArray> const&);
+
+    //Writes the uv rectangle (u0, v0, u1, v1) of an atlas region to a vec4 uniform.
+    //Shaders map texture coordinates into it with mix(region.xy, region.zw, uv).
+    void SetTextureRegion(std::string const& name, AtlasRegion const&);
+
+  private:
+
+    void SetTextureHandle(std::string const& name, RenderHandle);
+
   private:
     Dg::Map_AVL<std::string, ResourceID>  m_textureBindings;
     Dg::DynamicArray<Ref<MaterialInstance>> m_materialInstances;
@@ -0,0 +1,358 @@
+//@group Renderer
+
+#include <math.h>
+#include <vector>
+
+#include "MipmapBuilder.h"
+#include "TextureData.h"
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__SSE2__)
+#define MIPMAP_USE_SSE
+#include <emmintrin.h>
+#endif
+
+namespace Engine
+{
+  //-----------------------------------------------------------------------------------------------
+  // Vec4
+  //-----------------------------------------------------------------------------------------------
+
+  // One pixel, as linear r, g, b, a floats.
+
+#ifdef MIPMAP_USE_SSE
+  typedef __m128 Vec4;
+
+  static inline Vec4 Vec4Set(float r, float g, float b, float a)
+  {
+    return _mm_setr_ps(r, g, b, a);
+  }
+
+  static inline Vec4 Vec4Zero()
+  {
+    return _mm_setzero_ps();
+  }
+
+  static inline Vec4 Vec4MulAdd(Vec4 a_acc, Vec4 a_v, float a_weight)
+  {
+    return _mm_add_ps(a_acc, _mm_mul_ps(a_v, _mm_set1_ps(a_weight)));
+  }
+
+  static inline Vec4 Vec4Clamp01(Vec4 a_v)
+  {
+    return _mm_min_ps(_mm_max_ps(a_v, _mm_setzero_ps()), _mm_set1_ps(1.0f));
+  }
+
+  static inline void Vec4Store(float * a_out, Vec4 a_v)
+  {
+    _mm_storeu_ps(a_out, a_v);
+  }
+#else
+  struct Vec4
+  {
+    float v[4];
+  };
+
+  static inline Vec4 Vec4Set(float r, float g, float b, float a)
+  {
+    return Vec4{{r, g, b, a}};
+  }
+
+  static inline Vec4 Vec4Zero()
+  {
+    return Vec4{{0.0f, 0.0f, 0.0f, 0.0f}};
+  }
+
+  static inline Vec4 Vec4MulAdd(Vec4 a_acc, Vec4 a_v, float a_weight)
+  {
+    for (int i = 0; i < 4; i++)
+      a_acc.v[i] += a_v.v[i] * a_weight;
+    return a_acc;
+  }
+
+  static inline Vec4 Vec4Clamp01(Vec4 a_v)
+  {
+    for (int i = 0; i < 4; i++)
+      a_v.v[i] = a_v.v[i] < 0.0f ? 0.0f : (a_v.v[i] > 1.0f ? 1.0f : a_v.v[i]);
+    return a_v;
+  }
+
+  static inline void Vec4Store(float * a_out, Vec4 a_v)
+  {
+    for (int i = 0; i < 4; i++)
+      a_out[i] = a_v.v[i];
+  }
+#endif
+
+  //-----------------------------------------------------------------------------------------------
+  // Tables
+  //-----------------------------------------------------------------------------------------------
+
+  namespace
+  {
+    uint32_t const LinearTableSize = 4096;
+    int32_t const KaiserFirstTap = -2;
+    uint32_t const KaiserTapCount = 6;
+    float const KaiserAlpha = 4.0f;
+    float const Pi = 3.14159265358979f;
+
+    //Filter for a 2:1 reduction. Destination pixel x is centred between
+    //source pixels 2x and 2x + 1.
+    struct Kernel
+    {
+      int32_t   first;
+      uint32_t  count;
+      float     weights[KaiserTapCount];
+    };
+
+    //Modified Bessel function of the first kind, order 0.
+    float BesselI0(float a_x)
+    {
+      float sum = 1.0f;
+      float term = 1.0f;
+      float halfX = a_x * 0.5f;
+      for (int k = 1; k < 32; k++)
+      {
+        term *= (halfX / float(k)) * (halfX / float(k));
+        sum += term;
+        if (term < sum * 1.0e-8f)
+          break;
+      }
+      return sum;
+    }
+
+    float Sinc(float a_x)
+    {
+      if (a_x == 0.0f)
+        return 1.0f;
+      return sinf(Pi * a_x) / (Pi * a_x);
+    }
+
+    struct Tables
+    {
+      Tables()
+      {
+        for (uint32_t i = 0; i < 256; i++)
+        {
+          float c = float(i) / 255.0f;
+          toLinear[i] = c <= 0.04045f ? c / 12.92f : powf((c + 0.055f) / 1.055f, 2.4f);
+        }
+
+        for (uint32_t i = 0; i < LinearTableSize; i++)
+        {
+          float l = float(i) / float(LinearTableSize - 1);
+          float c = l <= 0.0031308f ? l * 12.92f : 1.055f * powf(l, 1.0f / 2.4f) - 0.055f;
+          toSRGB[i] = static_cast<uint8_t>(c * 255.0f + 0.5f);
+        }
+
+        box.first = 0;
+        box.count = 2;
+        box.weights[0] = 0.5f;
+        box.weights[1] = 0.5f;
+
+        //Taps sit at -2.5 ... 2.5 source pixels from the destination centre. Sinc is
+        //scaled by 2 for the 2:1 reduction and windowed over the width of the kernel.
+        kaiser.first = KaiserFirstTap;
+        kaiser.count = KaiserTapCount;
+        float halfWidth = float(KaiserTapCount) * 0.5f;
+        float sum = 0.0f;
+        for (uint32_t i = 0; i < KaiserTapCount; i++)
+        {
+          float x = float(KaiserFirstTap) + float(i) - 0.5f;
+          float t = x / halfWidth;
+          float window = BesselI0(KaiserAlpha * sqrtf(1.0f - t * t)) / BesselI0(KaiserAlpha);
+          kaiser.weights[i] = Sinc(x * 0.5f) * window;
+          sum += kaiser.weights[i];
+        }
+
+        for (uint32_t i = 0; i < KaiserTapCount; i++)
+          kaiser.weights[i] /= sum;
+      }
+
+      float   toLinear[256];
+      uint8_t toSRGB[LinearTableSize];
+      Kernel  box;
+      Kernel  kaiser;
+    };
+
+    //Builds on first use. Safe to call from worker threads.
+    Tables const & GetTables()
+    {
+      static Tables const s_tables;
+      return s_tables;
+    }
+  }
+
+  //-----------------------------------------------------------------------------------------------
+  // Helper functions
+  //-----------------------------------------------------------------------------------------------
+
+  static int32_t ResolveIndex(int32_t a_index, int32_t a_size, TextureWrap a_wrap)
+  {
+    if (a_index >= 0 && a_index < a_size)
+      return a_index;
+
+    if (a_wrap == TextureWrap::Repeat)
+    {
+      a_index %= a_size;
+      return a_index < 0 ? a_index + a_size : a_index;
+    }
+
+    if (a_wrap == TextureWrap::Mirror)
+    {
+      int32_t period = a_size * 2;
+      a_index %= period;
+      if (a_index < 0)
+        a_index += period;
+      return a_index < a_size ? a_index : period - 1 - a_index;
+    }
+
+    return a_index < 0 ? 0 : a_size - 1;
+  }
+
+  static Vec4 Decode(RGBA a_pixel, Tables const & a_tables, MipmapBuildOptions const & a_opts)
+  {
+    float alpha = float(a_pixel.a()) * (1.0f / 255.0f);
+    float r, g, b;
+    if (a_opts.sRGB)
+    {
+      r = a_tables.toLinear[a_pixel.r()];
+      g = a_tables.toLinear[a_pixel.g()];
+      b = a_tables.toLinear[a_pixel.b()];
+    }
+    else
+    {
+      r = float(a_pixel.r()) * (1.0f / 255.0f);
+      g = float(a_pixel.g()) * (1.0f / 255.0f);
+      b = float(a_pixel.b()) * (1.0f / 255.0f);
+    }
+
+    if (a_opts.premultipliedAlpha)
+      return Vec4Set(r * alpha, g * alpha, b * alpha, alpha);
+    return Vec4Set(r, g, b, alpha);
+  }
+
+  static RGBA Encode(Vec4 a_value, Tables const & a_tables, MipmapBuildOptions const & a_opts)
+  {
+    float c[4];
+    Vec4Store(c, Vec4Clamp01(a_value));
+
+    if (a_opts.premultipliedAlpha)
+    {
+      if (c[3] > 0.0f)
+      {
+        float invAlpha = 1.0f / c[3];
+        for (int i = 0; i < 3; i++)
+          c[i] = c[i] * invAlpha > 1.0f ? 1.0f : c[i] * invAlpha;
+      }
+      else
+      {
+        c[0] = c[1] = c[2] = 0.0f;
+      }
+    }
+
+    RGBA result;
+    if (a_opts.sRGB)
+    {
+      float scale = float(LinearTableSize - 1);
+      result.r(a_tables.toSRGB[static_cast<uint32_t>(c[0] * scale + 0.5f)]);
+      result.g(a_tables.toSRGB[static_cast<uint32_t>(c[1] * scale + 0.5f)]);
+      result.b(a_tables.toSRGB[static_cast<uint32_t>(c[2] * scale + 0.5f)]);
+    }
+    else
+    {
+      result.r(static_cast<uint32_t>(c[0] * 255.0f + 0.5f));
+      result.g(static_cast<uint32_t>(c[1] * 255.0f + 0.5f));
+      result.b(static_cast<uint32_t>(c[2] * 255.0f + 0.5f));
+    }
+    result.a(static_cast<uint32_t>(c[3] * 255.0f + 0.5f));
+    return result;
+  }
+
+  //Reduces a row (or column) of 'srcCount' pixels spaced 'srcStride' apart into 'dstCount'
+  //pixels spaced 'dstStride' apart. A dimension of 1 is passed straight through.
+  static void Reduce(Vec4 const * a_pSrc, int32_t a_srcCount, size_t a_srcStride,
+                     Vec4 * a_pDst, int32_t a_dstCount, size_t a_dstStride,
+                     Kernel const & a_kernel, TextureWrap a_wrap)
+  {
+    if (a_srcCount == a_dstCount)
+    {
+      for (int32_t i = 0; i < a_dstCount; i++)
+        a_pDst[i * a_dstStride] = a_pSrc[i * a_srcStride];
+      return;
+    }
+
+    for (int32_t i = 0; i < a_dstCount; i++)
+    {
+      Vec4 acc = Vec4Zero();
+      int32_t begin = 2 * i + a_kernel.first;
+      for (uint32_t t = 0; t < a_kernel.count; t++)
+      {
+        int32_t index = ResolveIndex(begin + int32_t(t), a_srcCount, a_wrap);
+        acc = Vec4MulAdd(acc, a_pSrc[index * a_srcStride], a_kernel.weights[t]);
+      }
+      a_pDst[i * a_dstStride] = acc;
+    }
+  }
+
+  //-----------------------------------------------------------------------------------------------
+  // MipmapBuildOptions
+  //-----------------------------------------------------------------------------------------------
+
+  MipmapBuildOptions::MipmapBuildOptions()
+    : filter(MipmapBuildFilter::Box)
+    , sRGB(true)
+    , premultipliedAlpha(false)
+  {
+
+  }
+
+  //-----------------------------------------------------------------------------------------------
+  // Builder
+  //-----------------------------------------------------------------------------------------------
+
+  uint32_t MipLevelCount(uint32_t a_width, uint32_t a_height)
+  {
+    uint32_t size = a_width > a_height ? a_width : a_height;
+    uint32_t count = 1;
+    while (size > 1)
+    {
+      size >>= 1;
+      count++;
+    }
+    return count;
+  }
+
+  uint32_t MipLevelSize(uint32_t a_baseSize, uint32_t a_level)
+  {
+    uint32_t size = a_baseSize >> a_level;
+    return size == 0 ? 1 : size;
+  }
+
+  void BuildMipLevel(RGBA const * a_pSrc, uint32_t a_width, uint32_t a_height,
+                     RGBA * a_pDst, TextureWrap a_wrap, MipmapBuildOptions const & a_opts)
+  {
+    Tables const & tables = GetTables();
+    Kernel const & kernel = a_opts.filter == MipmapBuildFilter::Kaiser ? tables.kaiser : tables.box;
+
+    int32_t srcW = int32_t(a_width);
+    int32_t srcH = int32_t(a_height);
+    int32_t dstW = int32_t(MipLevelSize(a_width, 1));
+    int32_t dstH = int32_t(MipLevelSize(a_height, 1));
+
+    std::vector<Vec4> source(size_t(srcW) * srcH);
+    for (size_t i = 0; i < source.size(); i++)
+      source[i] = Decode(a_pSrc[i], tables, a_opts);
+
+    //Separable: rows first, then columns.
+    std::vector<Vec4> rows(size_t(dstW) * srcH);
+    for (int32_t y = 0; y < srcH; y++)
+      Reduce(&source[size_t(y) * srcW], srcW, 1, &rows[size_t(y) * dstW], dstW, 1, kernel, a_wrap);
+
+    std::vector<Vec4> result(size_t(dstW) * dstH);
+    for (int32_t x = 0; x < dstW; x++)
+      Reduce(&rows[x], srcH, dstW, &result[x], dstH, dstW, kernel, a_wrap);
+
+    for (size_t i = 0; i < result.size(); i++)
+      a_pDst[i] = Encode(result[i], tables, a_opts);
+  }
+}
@@ -0,0 +1,45 @@
+//@group Renderer
+
+#ifndef MIPMAPBUILDER_H
+#define MIPMAPBUILDER_H
+
+#include <stdint.h>
+#include "core_utils.h"
+
+namespace Engine
+{
+  enum class TextureWrap;
+
+  enum class MipmapBuildFilter
+  {
+    Box,    //2x2 average
+    Kaiser  //6-tap Kaiser-windowed sinc. Sharper, at the cost of a little ringing.
+  };
+
+  struct MipmapBuildOptions
+  {
+    MipmapBuildOptions();
+
+    MipmapBuildFilter filter;
+
+    //Colour channels are sRGB encoded, so filter them in linear space.
+    bool              sRGB;
+
+    //Weight colour by alpha while filtering. Stops the colour of fully transparent
+    //texels bleeding into the edges of sprites. Output is still straight alpha.
+    bool              premultipliedAlpha;
+  };
+
+  //Number of levels in a full chain, including the base level.
+  uint32_t MipLevelCount(uint32_t width, uint32_t height);
+
+  //Size of a dimension at a given level.
+  uint32_t MipLevelSize(uint32_t baseSize, uint32_t level);
+
+  //Builds the next level down from 'src' into 'dst'. 'dst' must hold
+  //MipLevelSize(width, 1) * MipLevelSize(height, 1) pixels.
+  void BuildMipLevel(RGBA const * src, uint32_t width, uint32_t height,
+                     RGBA * dst, TextureWrap, MipmapBuildOptions const &);
+}
+
+#endif
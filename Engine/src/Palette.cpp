@@ -0,0 +1,203 @@
+//@group Renderer
+
+#include <string.h>
+
+#include "Palette.h"
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__SSE2__)
+#define PALETTE_USE_SSE
+#include <emmintrin.h>
+#endif
+
+namespace Engine
+{
+  //-----------------------------------------------------------------------------------------------
+  // Helper functions
+  //-----------------------------------------------------------------------------------------------
+
+  static uint32_t HashColor(uint32_t a_val)
+  {
+    a_val ^= a_val >> 16;
+    a_val *= 0x7FEB352Du;
+    a_val ^= a_val >> 15;
+    return a_val;
+  }
+
+  namespace
+  {
+    //Remembers the last colour looked up. Pixel art is mostly runs of one colour.
+    struct IndexCache
+    {
+      IndexCache()
+        : color(0)
+        , index(0)
+        , valid(false)
+        , exact(false)
+        , misses(0)
+      {
+
+      }
+
+      byte Map(RGBA a_pixel, PaletteLookup const & a_lookup)
+      {
+        if (!valid || a_pixel.data != color)
+        {
+          exact = a_lookup.Find(a_pixel, index);
+          if (!exact)
+            index = a_lookup.Nearest(a_pixel);
+
+          color = a_pixel.data;
+          valid = true;
+        }
+
+        if (!exact)
+          misses++;
+        return index;
+      }
+
+      uint32_t  color;
+      byte      index;
+      bool      valid;
+      bool      exact;
+      size_t    misses;
+    };
+  }
+
+  //-----------------------------------------------------------------------------------------------
+  // PaletteLookup
+  //-----------------------------------------------------------------------------------------------
+
+  PaletteLookup::PaletteLookup(RGBA const * a_pPalette, uint32_t a_count)
+    : m_pPalette(a_pPalette)
+    , m_count(a_count < PaletteSize ? a_count : PaletteSize)
+  {
+    for (uint32_t i = 0; i < TableSize; i++)
+    {
+      m_keys[i] = 0;
+      m_values[i] = -1;
+    }
+
+    for (uint32_t i = 0; i < m_count; i++)
+    {
+      uint32_t slot = HashColor(a_pPalette[i].data) & (TableSize - 1);
+      while (m_values[slot] >= 0 && m_keys[slot] != a_pPalette[i].data)
+        slot = (slot + 1) & (TableSize - 1);
+
+      if (m_values[slot] >= 0)
+        continue;
+
+      m_keys[slot] = a_pPalette[i].data;
+      m_values[slot] = static_cast<int16_t>(i);
+    }
+  }
+
+  bool PaletteLookup::Find(RGBA a_color, byte & a_index) const
+  {
+    uint32_t slot = HashColor(a_color.data) & (TableSize - 1);
+    while (m_values[slot] >= 0)
+    {
+      if (m_keys[slot] == a_color.data)
+      {
+        a_index = static_cast<byte>(m_values[slot]);
+        return true;
+      }
+      slot = (slot + 1) & (TableSize - 1);
+    }
+    return false;
+  }
+
+  byte PaletteLookup::Nearest(RGBA a_color) const
+  {
+    uint32_t best = 0;
+    int32_t bestError = INT32_MAX;
+    for (uint32_t i = 0; i < m_count; i++)
+    {
+      RGBA c = m_pPalette[i];
+      int32_t dr = int32_t(c.r()) - int32_t(a_color.r());
+      int32_t dg = int32_t(c.g()) - int32_t(a_color.g());
+      int32_t db = int32_t(c.b()) - int32_t(a_color.b());
+      int32_t da = int32_t(c.a()) - int32_t(a_color.a());
+      int32_t error = dr * dr + dg * dg + db * db + da * da;
+      if (error < bestError)
+      {
+        bestError = error;
+        best = i;
+      }
+    }
+    return static_cast<byte>(best);
+  }
+
+  //-----------------------------------------------------------------------------------------------
+  // Conversion
+  //-----------------------------------------------------------------------------------------------
+
+  void IndexedToRGBA(byte const * a_pIndices, size_t a_count, RGBA const * a_pPalette, RGBA * a_pOut)
+  {
+    size_t i = 0;
+
+#ifdef PALETTE_USE_SSE
+    //There is no gather in SSE2, but filling a register and storing 16 bytes at a time
+    //still halves the stores.
+    for (; i + 8 <= a_count; i += 8)
+    {
+      __m128i lo = _mm_setr_epi32(int(a_pPalette[a_pIndices[i + 0]].data),
+                                  int(a_pPalette[a_pIndices[i + 1]].data),
+                                  int(a_pPalette[a_pIndices[i + 2]].data),
+                                  int(a_pPalette[a_pIndices[i + 3]].data));
+      __m128i hi = _mm_setr_epi32(int(a_pPalette[a_pIndices[i + 4]].data),
+                                  int(a_pPalette[a_pIndices[i + 5]].data),
+                                  int(a_pPalette[a_pIndices[i + 6]].data),
+                                  int(a_pPalette[a_pIndices[i + 7]].data));
+      _mm_storeu_si128(reinterpret_cast<__m128i*>(a_pOut + i), lo);
+      _mm_storeu_si128(reinterpret_cast<__m128i*>(a_pOut + i + 4), hi);
+    }
+#endif
+
+    for (; i < a_count; i++)
+      a_pOut[i] = a_pPalette[a_pIndices[i]];
+  }
+
+  size_t RGBAToIndexed(RGBA const * a_pPixels, size_t a_count, PaletteLookup const & a_lookup, byte * a_pOut)
+  {
+    IndexCache cache;
+    size_t i = 0;
+
+#ifdef PALETTE_USE_SSE
+    //Four pixels matching the last colour are written without a lookup.
+    for (; i + 4 <= a_count; i += 4)
+    {
+      __m128i pixels = _mm_loadu_si128(reinterpret_cast<__m128i const *>(a_pPixels + i));
+      __m128i same = _mm_cmpeq_epi32(pixels, _mm_set1_epi32(int(cache.color)));
+      if (cache.valid && _mm_movemask_epi8(same) == 0xFFFF)
+      {
+        memset(a_pOut + i, cache.index, 4);
+        if (!cache.exact)
+          cache.misses += 4;
+        continue;
+      }
+
+      for (size_t j = i; j < i + 4; j++)
+        a_pOut[j] = cache.Map(a_pPixels[j], a_lookup);
+    }
+#endif
+
+    for (; i < a_count; i++)
+      a_pOut[i] = cache.Map(a_pPixels[i], a_lookup);
+
+    return cache.misses;
+  }
+
+  void MakePaletteTexture(RGBA const * a_pPalettes, uint32_t a_rows, TextureData & a_out)
+  {
+    size_t count = size_t(PaletteSize) * a_rows;
+    RGBA * pPixels = new RGBA[count];
+    memcpy(pPixels, a_pPalettes, count * sizeof(RGBA));
+
+    //Looked up with texelFetch, but keep sampling exact in case it is not.
+    TextureFlags flags;
+    flags.SetFilter(TextureFilter::Nearest);
+    flags.SetWrap(TextureWrap::Clamp);
+    flags.SetIsMipmapped(false);
+    a_out.Set(PaletteSize, a_rows, pPixels, flags);
+  }
+}
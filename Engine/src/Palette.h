@@ -0,0 +1,52 @@
+//@group Renderer
+
+#ifndef PALETTE_H
+#define PALETTE_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+#include "core_utils.h"
+#include "TextureData.h"
+
+namespace Engine
+{
+  uint32_t const PaletteSize = 256;
+
+  //Reverse lookup from colour to palette index.
+  class PaletteLookup
+  {
+  public:
+
+    //Duplicate colours map to the lowest index.
+    PaletteLookup(RGBA const * palette, uint32_t count);
+
+    //Exact matches only
+    bool Find(RGBA, byte & index) const;
+
+    //Closest colour by RGBA distance. Slow; used for colours not in the palette.
+    byte Nearest(RGBA) const;
+
+  private:
+
+    static uint32_t const TableSize = 2 * PaletteSize;
+
+    RGBA const *  m_pPalette;
+    uint32_t      m_count;
+    uint32_t      m_keys[TableSize];
+    int16_t       m_values[TableSize];
+  };
+
+  //Expands 'count' indices into 'out' through a palette of PaletteSize colours.
+  void IndexedToRGBA(byte const * indices, size_t count, RGBA const * palette, RGBA * out);
+
+  //Maps each pixel to its palette index. Colours not in the palette take the nearest
+  //entry. Returns the number of pixels which had no exact match.
+  size_t RGBAToIndexed(RGBA const * pixels, size_t count, PaletteLookup const &, byte * out);
+
+  //A PaletteSize x rows texture, one palette per row, for lookup in the fragment shader.
+  //Palette effects can swap rows or re-upload this texture instead of every image.
+  void MakePaletteTexture(RGBA const * palettes, uint32_t rows, TextureData & out);
+}
+
+#endif
@@ -0,0 +1,402 @@
+//@group Renderer
+
+#include <stdlib.h>
+#include <vector>
+
+#include "PixelScaler.h"
+#include "WorkerPool.h"
+#include "ThreadPool/gc_ParallelFor.h"
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__SSE2__)
+#define SCALER_USE_SSE
+#include <emmintrin.h>
+#endif
+
+namespace Engine
+{
+  namespace
+  {
+    uint32_t const BandHeight = 8;
+    uint32_t const SuperSamples = 16;
+
+    //Regions a rule blends over. Coordinates are in the frame of the bottom-right
+    //corner of a source pixel: (u, v) in [0, 1], corner at (1, 1).
+    enum Region : uint32_t
+    {
+      R_Weak,          //Corner sub-pixel only
+      R_Diagonal,      //45 degree edge
+      R_Left,          //Shallow edge, reaching into the bottom-left
+      R_Up,            //Steep edge, reaching into the top-right
+      R_LeftUp,
+      R_BlendEdge,
+      R_BlendEdgeStrong,
+      R_BlendCorner,
+      R_COUNT
+    };
+
+    //Blend weight, out of 256, of each output sub-pixel for each region and each of the
+    //four corner rotations.
+    struct WeightTable
+    {
+      uint32_t factor;
+      uint32_t weights[R_COUNT][4][PixelScalerMaxFactor * PixelScalerMaxFactor];
+    };
+
+    //Source pixels with their YUV values, for the similarity tests.
+    struct SourceImage
+    {
+      RGBA const *          pPixels;
+      int32_t               width;
+      int32_t               height;
+      std::vector<int32_t>  yuva;
+    };
+
+    //Indices of the 5x5 block of source pixels around the current one.
+    struct Neighbourhood
+    {
+      uint32_t index[5][5];
+    };
+  }
+
+  //-----------------------------------------------------------------------------------------------
+  // Pixel operations
+  //-----------------------------------------------------------------------------------------------
+
+  //a_weight is out of 256
+  static inline RGBA Blend(RGBA a_from, RGBA a_to, uint32_t a_weight)
+  {
+#ifdef SCALER_USE_SSE
+    __m128i zero = _mm_setzero_si128();
+    __m128i from = _mm_unpacklo_epi8(_mm_cvtsi32_si128(int(a_from.data)), zero);
+    __m128i to = _mm_unpacklo_epi8(_mm_cvtsi32_si128(int(a_to.data)), zero);
+    __m128i w = _mm_set1_epi16(short(a_weight));
+    __m128i iw = _mm_set1_epi16(short(256 - a_weight));
+    __m128i sum = _mm_add_epi16(_mm_mullo_epi16(from, iw), _mm_mullo_epi16(to, w));
+    __m128i result = _mm_packus_epi16(_mm_srli_epi16(sum, 8), zero);
+    return RGBA(uint32_t(_mm_cvtsi128_si32(result)));
+#else
+    uint32_t result = 0;
+    for (uint32_t shift = 0; shift < 32; shift += 8)
+    {
+      uint32_t f = (a_from.data >> shift) & 0xFF;
+      uint32_t t = (a_to.data >> shift) & 0xFF;
+      result |= (((f * (256 - a_weight) + t * a_weight) >> 8) & 0xFF) << shift;
+    }
+    return RGBA(result);
+#endif
+  }
+
+  static inline RGBA Average(RGBA a_a, RGBA a_b)
+  {
+#ifdef SCALER_USE_SSE
+    __m128i result = _mm_avg_epu8(_mm_cvtsi32_si128(int(a_a.data)), _mm_cvtsi32_si128(int(a_b.data)));
+    return RGBA(uint32_t(_mm_cvtsi128_si32(result)));
+#else
+    uint32_t result = 0;
+    for (uint32_t shift = 0; shift < 32; shift += 8)
+    {
+      uint32_t a = (a_a.data >> shift) & 0xFF;
+      uint32_t b = (a_b.data >> shift) & 0xFF;
+      result |= (((a + b + 1) >> 1) & 0xFF) << shift;
+    }
+    return RGBA(result);
+#endif
+  }
+
+  static void ToYUVA(RGBA a_pixel, int32_t * a_pOut)
+  {
+    int32_t r = int32_t(a_pixel.r());
+    int32_t g = int32_t(a_pixel.g());
+    int32_t b = int32_t(a_pixel.b());
+    a_pOut[0] = (299 * r + 587 * g + 114 * b) / 1000;
+    a_pOut[1] = (-169 * r - 331 * g + 500 * b) / 1000 + 128;
+    a_pOut[2] = (500 * r - 419 * g - 81 * b) / 1000 + 128;
+    a_pOut[3] = int32_t(a_pixel.a());
+  }
+
+  //Weighted YUV distance used by xBR. Alpha is weighted like luma so transparent
+  //texels never match opaque ones.
+  static inline uint32_t Distance(SourceImage const & a_img, uint32_t a_a, uint32_t a_b)
+  {
+    int32_t const * pA = &a_img.yuva[size_t(a_a) * 4];
+    int32_t const * pB = &a_img.yuva[size_t(a_b) * 4];
+    return uint32_t(48 * abs(pA[0] - pB[0]) + 7 * abs(pA[1] - pB[1]) + 6 * abs(pA[2] - pB[2]) + 48 * abs(pA[3] - pB[3]));
+  }
+
+  static inline bool SimilarBR(SourceImage const & a_img, uint32_t a_a, uint32_t a_b)
+  {
+    return Distance(a_img, a_a, a_b) < 155;
+  }
+
+  //The hqx similarity test
+  static inline bool SimilarHQ(SourceImage const & a_img, uint32_t a_a, uint32_t a_b)
+  {
+    int32_t const * pA = &a_img.yuva[size_t(a_a) * 4];
+    int32_t const * pB = &a_img.yuva[size_t(a_b) * 4];
+    return abs(pA[0] - pB[0]) <= 48 && abs(pA[1] - pB[1]) <= 7 && abs(pA[2] - pB[2]) <= 6 && abs(pA[3] - pB[3]) <= 48;
+  }
+
+  static inline bool Equal(SourceImage const & a_img, uint32_t a_a, uint32_t a_b)
+  {
+    return a_img.pPixels[a_a].data == a_img.pPixels[a_b].data;
+  }
+
+  //-----------------------------------------------------------------------------------------------
+  // Weight tables
+  //-----------------------------------------------------------------------------------------------
+
+  static bool InRegion(Region a_region, float u, float v, uint32_t a_factor)
+  {
+    switch (a_region)
+    {
+      case R_Weak:          return u + v > 2.0f - 1.0f / float(a_factor);
+      case R_Diagonal:      return u + v > 1.5f;
+      case R_Left:          return v + 0.5f * u > 1.0f;
+      case R_Up:            return u + 0.5f * v > 1.0f;
+      case R_LeftUp:        return v + 0.5f * u > 1.0f || u + 0.5f * v > 1.0f;
+      case R_BlendEdge:        return u + v > 1.5f;
+      case R_BlendEdgeStrong:  return u + v > 1.375f;
+      case R_BlendCorner:      return u + v > 2.0f - 1.0f / float(a_factor);
+      default:              return false;
+    }
+  }
+
+  static uint32_t RegionStrength(Region a_region)
+  {
+    return a_region == R_BlendCorner ? 128 : 256;
+  }
+
+  //Rotates a_x, a_y a quarter turn clockwise, a_turns times.
+  template<typename T>
+  static void Rotate(T & a_x, T & a_y, uint32_t a_turns)
+  {
+    for (uint32_t i = 0; i < (a_turns & 3); i++)
+    {
+      T x = a_x;
+      a_x = -a_y;
+      a_y = x;
+    }
+  }
+
+  static void BuildWeightTable(uint32_t a_factor, WeightTable & a_table)
+  {
+    a_table.factor = a_factor;
+    float sampleSize = 1.0f / float(a_factor * SuperSamples);
+
+    for (uint32_t region = 0; region < R_COUNT; region++)
+    {
+      for (uint32_t turns = 0; turns < 4; turns++)
+      {
+        for (uint32_t sy = 0; sy < a_factor; sy++)
+        {
+          for (uint32_t sx = 0; sx < a_factor; sx++)
+          {
+            uint32_t covered = 0;
+            for (uint32_t j = 0; j < SuperSamples; j++)
+            {
+              for (uint32_t i = 0; i < SuperSamples; i++)
+              {
+                //Relative to the pixel centre, then into the corner frame
+                float x = (float(sx * SuperSamples + i) + 0.5f) * sampleSize - 0.5f;
+                float y = (float(sy * SuperSamples + j) + 0.5f) * sampleSize - 0.5f;
+                Rotate(x, y, 4 - turns);
+                if (InRegion(Region(region), x + 0.5f, y + 0.5f, a_factor))
+                  covered++;
+              }
+            }
+            uint32_t weight = (covered * RegionStrength(Region(region)) + SuperSamples * SuperSamples / 2) / (SuperSamples * SuperSamples);
+            a_table.weights[region][turns][sy * a_factor + sx] = weight;
+          }
+        }
+      }
+    }
+  }
+
+  static void ApplyRegion(RGBA * a_pBlock, WeightTable const & a_table, Region a_region, uint32_t a_turns, RGBA a_colour)
+  {
+    uint32_t const * pWeights = a_table.weights[a_region][a_turns];
+    uint32_t count = a_table.factor * a_table.factor;
+    for (uint32_t i = 0; i < count; i++)
+    {
+      if (pWeights[i] != 0)
+        a_pBlock[i] = Blend(a_pBlock[i], a_colour, pWeights[i]);
+    }
+  }
+
+  //-----------------------------------------------------------------------------------------------
+  // Rules
+  //-----------------------------------------------------------------------------------------------
+
+  static inline uint32_t At(Neighbourhood const & a_n, uint32_t a_turns, int32_t a_dx, int32_t a_dy)
+  {
+    Rotate(a_dx, a_dy, a_turns);
+    return a_n.index[a_dy + 2][a_dx + 2];
+  }
+
+  static void CornerBR(SourceImage const & a_img, Neighbourhood const & a_n, uint32_t a_turns,
+                       WeightTable const & a_table, RGBA * a_pBlock)
+  {
+    uint32_t PE = At(a_n, a_turns, 0, 0);
+    uint32_t PF = At(a_n, a_turns, 1, 0);
+    uint32_t PH = At(a_n, a_turns, 0, 1);
+
+    if (Equal(a_img, PE, PH) || Equal(a_img, PE, PF))
+      return;
+
+    uint32_t PB = At(a_n, a_turns, 0, -1);
+    uint32_t PC = At(a_n, a_turns, 1, -1);
+    uint32_t PD = At(a_n, a_turns, -1, 0);
+    uint32_t PG = At(a_n, a_turns, -1, 1);
+    uint32_t PI = At(a_n, a_turns, 1, 1);
+    uint32_t F4 = At(a_n, a_turns, 2, 0);
+    uint32_t I4 = At(a_n, a_turns, 2, 1);
+    uint32_t H5 = At(a_n, a_turns, 0, 2);
+    uint32_t I5 = At(a_n, a_turns, 1, 2);
+
+    uint32_t e = Distance(a_img, PE, PC) + Distance(a_img, PE, PG) + Distance(a_img, PI, H5)
+      + Distance(a_img, PI, F4) + (Distance(a_img, PH, PF) << 2);
+    uint32_t i = Distance(a_img, PH, PD) + Distance(a_img, PH, I5) + Distance(a_img, PF, I4)
+      + Distance(a_img, PF, PB) + (Distance(a_img, PE, PI) << 2);
+
+    if (e > i)
+      return;
+
+    RGBA px = a_img.pPixels[Distance(a_img, PE, PF) <= Distance(a_img, PE, PH) ? PF : PH];
+
+    bool strong = e < i &&
+      ((!SimilarBR(a_img, PF, PB) && !SimilarBR(a_img, PH, PD))
+        || (SimilarBR(a_img, PE, PI) && !SimilarBR(a_img, PF, I4) && !SimilarBR(a_img, PH, I5))
+        || SimilarBR(a_img, PE, PG) || SimilarBR(a_img, PE, PC));
+
+    Region region = R_Weak;
+    if (strong)
+    {
+      uint32_t ke = Distance(a_img, PF, PG);
+      uint32_t ki = Distance(a_img, PH, PC);
+      bool left = (ke << 1) <= ki && !Equal(a_img, PE, PG) && !Equal(a_img, PD, PG);
+      bool up = ke >= (ki << 1) && !Equal(a_img, PE, PC) && !Equal(a_img, PB, PC);
+
+      if (left && up)
+        region = R_LeftUp;
+      else if (left)
+        region = R_Left;
+      else if (up)
+        region = R_Up;
+      else
+        region = R_Diagonal;
+    }
+
+    ApplyRegion(a_pBlock, a_table, region, a_turns, px);
+  }
+
+  static void CornerBlend(SourceImage const & a_img, Neighbourhood const & a_n, uint32_t a_turns,
+                       WeightTable const & a_table, RGBA * a_pBlock)
+  {
+    uint32_t PE = At(a_n, a_turns, 0, 0);
+    uint32_t PF = At(a_n, a_turns, 1, 0);
+    uint32_t PH = At(a_n, a_turns, 0, 1);
+    uint32_t PI = At(a_n, a_turns, 1, 1);
+
+    bool simF = SimilarHQ(a_img, PE, PF);
+    bool simH = SimilarHQ(a_img, PE, PH);
+
+    //An edge crossing the corner
+    if (!simF && !simH && SimilarHQ(a_img, PF, PH))
+    {
+      RGBA target = Average(a_img.pPixels[PF], a_img.pPixels[PH]);
+      Region region = SimilarHQ(a_img, PE, PI) ? R_BlendEdge : R_BlendEdgeStrong;
+      ApplyRegion(a_pBlock, a_table, region, a_turns, target);
+      return;
+    }
+
+    //A lone diagonal neighbour
+    if (simF && simH && !SimilarHQ(a_img, PE, PI))
+      ApplyRegion(a_pBlock, a_table, R_BlendCorner, a_turns, a_img.pPixels[PI]);
+  }
+
+  //-----------------------------------------------------------------------------------------------
+  // Scaler
+  //-----------------------------------------------------------------------------------------------
+
+  static void ScaleRows(SourceImage const & a_img, WeightTable const & a_table, ResizeMethod a_method,
+                        uint32_t a_rowBegin, uint32_t a_rowEnd, RGBA * a_pDst)
+  {
+    uint32_t factor = a_table.factor;
+    size_t dstWidth = size_t(a_img.width) * factor;
+    RGBA block[PixelScalerMaxFactor * PixelScalerMaxFactor];
+    Neighbourhood n;
+
+    for (int32_t y = int32_t(a_rowBegin); y < int32_t(a_rowEnd); y++)
+    {
+      for (int32_t x = 0; x < a_img.width; x++)
+      {
+        for (int32_t j = 0; j < 5; j++)
+        {
+          int32_t sy = y + j - 2;
+          sy = sy < 0 ? 0 : (sy >= a_img.height ? a_img.height - 1 : sy);
+          for (int32_t i = 0; i < 5; i++)
+          {
+            int32_t sx = x + i - 2;
+            sx = sx < 0 ? 0 : (sx >= a_img.width ? a_img.width - 1 : sx);
+            n.index[j][i] = uint32_t(sy * a_img.width + sx);
+          }
+        }
+
+        RGBA centre = a_img.pPixels[n.index[2][2]];
+        for (uint32_t i = 0; i < factor * factor; i++)
+          block[i] = centre;
+
+        for (uint32_t turns = 0; turns < 4; turns++)
+        {
+          if (a_method == ResizeMethod::BRz)
+            CornerBR(a_img, n, turns, a_table, block);
+          else
+            CornerBlend(a_img, n, turns, a_table, block);
+        }
+
+        RGBA * pOut = a_pDst + size_t(y) * factor * dstWidth + size_t(x) * factor;
+        for (uint32_t sy = 0; sy < factor; sy++)
+          memcpy(pOut + sy * dstWidth, &block[sy * factor], factor * sizeof(RGBA));
+      }
+    }
+  }
+
+  bool ScalePixelArt(TextureData const & a_src, TextureData & a_dst, ResizeMethod a_method, uint32_t a_factor)
+  {
+    if (a_factor < PixelScalerMinFactor || a_factor > PixelScalerMaxFactor)
+      return false;
+
+    if (a_src.pPixels == nullptr || a_src.width == 0 || a_src.height == 0)
+      return false;
+
+    if (a_src.flags.GetFormat() != TextureFormat::RGBA8)
+      return false;
+
+    SourceImage img;
+    img.pPixels = a_src.pPixels;
+    img.width = int32_t(a_src.width);
+    img.height = int32_t(a_src.height);
+    img.yuva.resize(size_t(a_src.width) * a_src.height * 4);
+    for (size_t i = 0; i < size_t(a_src.width) * a_src.height; i++)
+      ToYUVA(a_src.pPixels[i], &img.yuva[i * 4]);
+
+    WeightTable table;
+    BuildWeightTable(a_factor, table);
+
+    uint32_t dstWidth = a_src.width * a_factor;
+    uint32_t dstHeight = a_src.height * a_factor;
+    RGBA * pDst = new RGBA[size_t(dstWidth) * dstHeight];
+
+    GC::ParallelFor(WorkerPool::Instance(), a_src.height, BandHeight,
+      [&img, &table, a_method, pDst](uint32_t a_begin, uint32_t a_end)
+      {
+        ScaleRows(img, table, a_method, a_begin, a_end, pDst);
+      });
+
+    //Mip levels no longer match
+    TextureFlags flags = a_src.flags;
+    flags.SetIsMipmapped(false);
+    a_dst.Set(dstWidth, dstHeight, pDst, flags);
+    return true;
+  }
+}
@@ -0,0 +1,35 @@
+//@group Renderer
+
+#ifndef PIXELSCALER_H
+#define PIXELSCALER_H
+
+#include <stdint.h>
+#include "TextureData.h"
+
+namespace Engine
+{
+  enum class ResizeMethod
+  {
+    HQx,
+    BRz
+  };
+
+  uint32_t const PixelScalerMinFactor = 2;
+  uint32_t const PixelScalerMaxFactor = 4;
+
+  //Pixel-art upscalers. HQx is meant for walls, xBR for sprites.
+  //
+  //Both compare neighbours with the hqx YUV similarity test. xBR applies the level 1
+  //edge rules. The hqx pattern tables are not implemented: HQx stands in with two
+  //corner rules, blending a corner towards an edge which crosses it or towards a lone
+  //diagonal neighbour, so its output is not that of hq2x/hq3x/hq4x. The area each rule
+  //blends over is worked out geometrically, so one code path serves 2x, 3x and 4x.
+  //
+  //Rows are split into bands and scaled on the WorkerPool, if it is running. The rules
+  //run one pixel at a time; only the blends use SSE2.
+  //Only the base level of 'src' is scaled. Returns false if 'factor' is out of range or
+  //'src' is block compressed.
+  bool ScalePixelArt(TextureData const & src, TextureData & dst, ResizeMethod, uint32_t factor);
+}
+
+#endif
@@ -0,0 +1,69 @@
+//@group Renderer
+
+#include "PixelStorage.h"
+#include "core_Assert.h"
+
+namespace Engine
+{
+  PixelStorage::PixelStorage(RGBA * a_pData, size_t a_count, bool a_owned)
+    : m_refs(1)
+    , m_pData(a_pData)
+    , m_count(a_count)
+    , m_owned(a_owned)
+  {
+
+  }
+
+  PixelStorage::~PixelStorage()
+  {
+    if (m_owned)
+      delete[] m_pData;
+  }
+
+  PixelStorage * PixelStorage::Adopt(RGBA * a_pPixels, size_t a_count)
+  {
+    return new PixelStorage(a_pPixels, a_count, true);
+  }
+
+  PixelStorage * PixelStorage::View(RGBA const * a_pPixels, size_t a_count)
+  {
+    return new PixelStorage(const_cast<RGBA*>(a_pPixels), a_count, false);
+  }
+
+  void PixelStorage::AddRef()
+  {
+    m_refs.fetch_add(1, std::memory_order_relaxed);
+  }
+
+  void PixelStorage::Release()
+  {
+    if (m_refs.fetch_sub(1, std::memory_order_acq_rel) == 1)
+      delete this;
+  }
+
+  bool PixelStorage::IsExclusive() const
+  {
+    return m_owned && m_refs.load(std::memory_order_acquire) == 1;
+  }
+
+  RGBA const * PixelStorage::Data() const
+  {
+    return m_pData;
+  }
+
+  size_t PixelStorage::Count() const
+  {
+    return m_count;
+  }
+
+  uint32_t PixelStorage::RefCount() const
+  {
+    return m_refs.load(std::memory_order_acquire);
+  }
+
+  RGBA * PixelStorage::MutableData()
+  {
+    BSR_ASSERT(IsExclusive(), "PixelStorage::MutableData(): Storage is shared or read only");
+    return m_pData;
+  }
+}
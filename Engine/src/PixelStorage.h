@@ -0,0 +1,62 @@
+//@group Renderer
+
+#ifndef PIXELSTORAGE_H
+#define PIXELSTORAGE_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <atomic>
+
+#include "core_utils.h"
+
+namespace Engine
+{
+  //A reference counted block of pixel data, shared between copies of a TextureData.
+  //Contents must not change once the block is shared; TextureData copies on write.
+  //Reference counting is atomic, so blocks can be released on the render thread.
+  class PixelStorage
+  {
+  public:
+
+    //Takes ownership of an array allocated with new RGBA[]. Starts with one reference.
+    static PixelStorage * Adopt(RGBA * pixels, size_t count);
+
+    //Points at memory owned elsewhere, such as a memory mapped pack file. The memory
+    //is never written to or freed, and must outlive every reference.
+    static PixelStorage * View(RGBA const * pixels, size_t count);
+
+    void AddRef();
+
+    //Deletes the storage when the last reference is released.
+    void Release();
+
+    //True if nobody else holds a reference and the data is ours to modify.
+    bool IsExclusive() const;
+
+    RGBA const * Data() const;
+    size_t Count() const;
+
+    //Number of references held. Only meaningful while no other thread may change it.
+    uint32_t RefCount() const;
+
+    //Only valid while IsExclusive()
+    RGBA * MutableData();
+
+  private:
+
+    PixelStorage(RGBA * pixels, size_t count, bool owned);
+    ~PixelStorage();
+
+    PixelStorage(PixelStorage const &) = delete;
+    PixelStorage & operator=(PixelStorage const &) = delete;
+
+  private:
+
+    std::atomic<uint32_t> m_refs;
+    RGBA *                m_pData;
+    size_t                m_count;
+    bool                  m_owned;
+  };
+}
+
+#endif
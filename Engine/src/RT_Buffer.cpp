@@ -68,20 +68,33 @@ namespace Engine
                              uint32_t a_size,
                              BufferUsage a_usage)
   {
-    m_size = a_size;
-    m_usage = a_usage;
-
-    glCreateBuffers(1, &m_rendererID);
-    glNamedBufferData(m_rendererID, m_size, a_data, OpenGLUsage(m_usage));
+    RendererID id = 0;
+    glCreateBuffers(1, &id);
+    Init(id, a_data, a_size, a_usage);
   }
 
   void RT_BufferBase::Init(uint32_t a_size, BufferUsage a_usage)
   {
+    RendererID id = 0;
+    glCreateBuffers(1, &id);
+    Init(id, nullptr, a_size, a_usage);
+  }
+
+  void RT_BufferBase::Init(RendererID a_id,
+                           void const * a_data,
+                           uint32_t a_size,
+                           BufferUsage a_usage)
+  {
+    m_rendererID = a_id;
     m_size = a_size;
     m_usage = a_usage;
 
-    glCreateBuffers(1, &m_rendererID);
-    glNamedBufferData(m_rendererID, m_size, nullptr, OpenGLUsage(m_usage));
+    glNamedBufferData(m_rendererID, m_size, a_data, OpenGLUsage(m_usage));
+  }
+
+  void RT_BufferBase::CreateRendererIDs(uint32_t a_count, RendererID * a_out)
+  {
+    glCreateBuffers(a_count, a_out);
   }
 
   RT_BufferBase::~RT_BufferBase()
@@ -187,9 +200,16 @@ namespace Engine
 
   void RT_IndexBuffer::Init(void* a_data, uint32_t a_size)
   {
+    RendererID id = 0;
+    glCreateBuffers(1, &id);
+    Init(id, a_data, a_size);
+  }
+
+  void RT_IndexBuffer::Init(RendererID a_id, void const * a_data, uint32_t a_size)
+  {
+    m_rendererID = a_id;
     m_size = a_size;
 
-    glCreateBuffers(1, &m_rendererID);
     glNamedBufferData(m_rendererID, m_size, a_data, GL_STATIC_DRAW);
   }
 
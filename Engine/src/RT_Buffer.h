@@ -54,8 +54,14 @@ namespace Engine
 
     void Init(void* data, uint32_t size, BufferUsage usage = BufferUsage::Dynamic);
     void Init(uint32_t size, BufferUsage usage = BufferUsage::Dynamic);
+
+    //Initialise with a name from CreateRendererIDs(). 'data' can be null.
+    void Init(RendererID, void const * data, uint32_t size, BufferUsage usage);
     void Destroy();
 
+    //Creates 'count' buffer names in one call, for batch creation.
+    static void CreateRendererIDs(uint32_t count, RendererID * out);
+
     BufferLayout const& GetLayout() const;
     void SetLayout(BufferLayout const&);
     uint32_t GetSize() const;
@@ -124,6 +130,7 @@ namespace Engine
     ~RT_IndexBuffer();
 
     void Init(void* data, uint32_t size);
+    void Init(RendererID, void const * data, uint32_t size);
     void Destroy();
 
     void SetData(void* data, uint32_t size, uint32_t offset = 0);
@@ -16,6 +16,7 @@
   Copyright 2017-2019 Frank Hart <frankhart010@gmail.com>
 */
 
+#include <cstring>
 #include <glad/glad.h>
 #include "RT_RendererAPI.h"
 #include "core_Log.h"
@@ -76,6 +77,20 @@ namespace Engine
     glGetIntegerv(GL_MAX_FRAGMENT_SHADER_STORAGE_BLOCKS, &caps.maxFragmentShaderStorageBlocks);
     glGetIntegerv(GL_MAX_SHADER_STORAGE_BLOCK_SIZE, &caps.maxShaderStorageBlockSize);
     glGetIntegerv(GL_MAX_SHADER_STORAGE_BUFFER_BINDINGS, &caps.maxShaderStorageBufferBindings);
+
+    caps.parallelShaderCompile = false;
+    GLint extensionCount = 0;
+    glGetIntegerv(GL_NUM_EXTENSIONS, &extensionCount);
+    for (GLint i = 0; i < extensionCount; i++)
+    {
+      char const * ext = (char const *)glGetStringi(GL_EXTENSIONS, i);
+      if (strcmp(ext, "GL_KHR_parallel_shader_compile") == 0 
+       || strcmp(ext, "GL_ARB_parallel_shader_compile") == 0)
+      {
+        caps.parallelShaderCompile = true;
+        break;
+      }
+    }
     
     GLenum error = glGetError();
     while (error != GL_NO_ERROR)
@@ -48,6 +48,9 @@ namespace Engine
     int maxGeometryShaderStorageBlocks;
     int maxShaderStorageBlockSize;
     int maxShaderStorageBufferBindings;
+
+    //GL_KHR_parallel_shader_compile or GL_ARB_parallel_shader_compile
+    bool parallelShaderCompile;
   };
 
   class RendererAPI
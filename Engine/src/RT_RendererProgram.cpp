@@ -31,6 +31,11 @@
 
 //TODO Parse uniform blocks, shader storage blocks
 
+//glad is generated without extensions. ARB_parallel_shader_compile shares the value.
+#ifndef GL_COMPLETION_STATUS_KHR
+#define GL_COMPLETION_STATUS_KHR 0x91B1
+#endif
+
 namespace Engine
 {
   //--------------------------------------------------------------------------------------------------
@@ -44,11 +49,11 @@ namespace Engine
 
   }
 
-  RT_RendererProgram::RT_RendererProgram(impl::ResourceID64 a_id)
+  RT_RendererProgram::RT_RendererProgram(impl::ResourceID64 a_shaderDataID, impl::ResourceID64 a_statusID)
     : m_rendererID(0)
     , m_loaded(false)
   {
-    Init(a_id);
+    Init(a_shaderDataID, a_statusID);
   }
 
   RT_RendererProgram::~RT_RendererProgram()
@@ -58,16 +63,17 @@ namespace Engine
 
   void RT_RendererProgram::Destroy()
   {
-    if (m_loaded)
+    DeleteShaders();
+
+    if (m_rendererID != 0)
     {
       glDeleteProgram(m_rendererID);
       m_rendererID = 0;
-
-      m_shaderData = Ref<ShaderData>();
-      m_uniformLocations.clear();
-
-      m_loaded = false;
     }
+
+    m_shaderData = Ref<ShaderData>();
+    m_uniformLocations.clear();
+    m_loaded = false;
   }
 
   void RT_RendererProgram::Bind() const
@@ -81,33 +87,86 @@ namespace Engine
     glUseProgram(0);
   }
 
-  bool RT_RendererProgram::Init(impl::ResourceID64 a_id)
+  void RT_RendererProgram::Init(impl::ResourceID64 a_shaderDataID, impl::ResourceID64 a_statusID)
   {
     Destroy();
-    m_shaderData = Ref<ShaderData>(a_id);
+    m_shaderData = Ref<ShaderData>(a_shaderDataID);
+    m_status = Ref<impl::ProgramStatus>(a_statusID);
+
+    if (m_status.IsNull())
+    {
+      LOG_WARN("RT_RendererProgram failed to find program status resource!");
+      return;
+    }
+
     if (m_shaderData.IsNull())
     {
       LOG_WARN("RT_RendererProgram failed to find shader data resource!");
-      return false;
+      m_status->Set(impl::ProgramStatus::Failed);
+    }
+  }
+
+  void RT_RendererProgram::UpdatePending()
+  {
+    Dg::DynamicArray<RenderHandle> & pending = RenderThreadData::Instance()->pendingPrograms;
+    for (size_t i = 0; i < pending.size();)
+    {
+      RT_RendererProgram* pRP = RenderThreadData::Instance()->rendererPrograms.at(pending[i]);
+      if (pRP == nullptr || !pRP->Update())
+      {
+        pending.erase_swap(i);
+        continue;
+      }
+      i++;
     }
+  }
 
-    if (!CompileAndUploadShader())
+  bool RT_RendererProgram::Update()
+  {
+    if (m_status.IsNull())
       return false;
 
-    ResolveUniforms();
+    switch (m_status->Get())
+    {
+      case impl::ProgramStatus::Parsing:
+      {
+        return true;
+      }
+      case impl::ProgramStatus::Parsed:
+      {
+        if (!SubmitShaders())
+        {
+          m_status->Set(impl::ProgramStatus::Failed);
+          return false;
+        }
+        m_status->Set(impl::ProgramStatus::Compiling);
 
-    m_loaded = true;
-    return m_loaded;
+        //Without parallel compile the first query would block anyway, so
+        //finish up in the same frame.
+        if (RendererAPI::GetCapabilities().parallelShaderCompile)
+          return true;
+        [[fallthrough]];
+      }
+      case impl::ProgramStatus::Compiling:
+      {
+        if (!CompletionStatusAvailable())
+          return true;
+
+        m_status->Set(FinaliseLink() ? impl::ProgramStatus::Ready : impl::ProgramStatus::Failed);
+        return false;
+      }
+      default:
+        return false;
+    }
   }
 
-  bool RT_RendererProgram::CompileAndUploadShader()
+  bool RT_RendererProgram::SubmitShaders()
   {
     if (m_shaderData.IsNull())
       return false;
 
-    bool result = true;
-    Dg::DynamicArray<GLuint> shaderRendererIDs;
-
+    //No status queries here; with KHR_parallel_shader_compile the driver is free to
+    //compile and link in the background until we ask for the result.
     GLuint program = glCreateProgram();
     for (int i = 0; i < ShaderDomain_COUNT; i++)
     {
@@ -124,63 +183,82 @@ namespace Engine
 
       glCompileShader(shaderRendererID);
 
-      GLint isCompiled = 0;
-      glGetShaderiv(shaderRendererID, GL_COMPILE_STATUS, &isCompiled);
-      if (isCompiled == GL_FALSE)
-      {
-        GLint maxLength = 0;
-        glGetShaderiv(shaderRendererID, GL_INFO_LOG_LENGTH, &maxLength);
-
-        // The maxLength includes the NULL character
-        std::vector<GLchar> infoLog(maxLength);
-        glGetShaderInfoLog(shaderRendererID, maxLength, &maxLength, &infoLog[0]);
-
-        LOG_ERROR("Shader compilation failed:\n{0}", &infoLog[0]);
-
-        // We don't need the shader anymore.
-        glDeleteShader(shaderRendererID);
-
-        BSR_ASSERT(false, "Failed");
-        result = false;
-      }
-
-      shaderRendererIDs.push_back(shaderRendererID);
+      m_shaderIDs.push_back(shaderRendererID);
       glAttachShader(program, shaderRendererID);
     }
 
-    // Link our program
     glLinkProgram(program);
+    m_rendererID = program;
+    return true;
+  }
 
+  bool RT_RendererProgram::CompletionStatusAvailable() const
+  {
+    if (!RendererAPI::GetCapabilities().parallelShaderCompile)
+      return true;
+
+    GLint isComplete = GL_FALSE;
+    glGetProgramiv(m_rendererID, GL_COMPLETION_STATUS_KHR, &isComplete);
+    return isComplete == GL_TRUE;
+  }
+
+  bool RT_RendererProgram::FinaliseLink()
+  {
     // Note the different functions here: glGetProgram* instead of glGetShader*.
     GLint isLinked = 0;
-    glGetProgramiv(program, GL_LINK_STATUS, (int*)&isLinked);
+    glGetProgramiv(m_rendererID, GL_LINK_STATUS, (int*)&isLinked);
     if (isLinked == GL_FALSE)
     {
+      //Find out which stage failed, if any
+      for (auto id : m_shaderIDs)
+      {
+        GLint isCompiled = 0;
+        glGetShaderiv(id, GL_COMPILE_STATUS, &isCompiled);
+        if (isCompiled == GL_TRUE)
+          continue;
+
+        GLint maxLength = 0;
+        glGetShaderiv(id, GL_INFO_LOG_LENGTH, &maxLength);
+
+        std::vector<GLchar> infoLog(maxLength + 1);
+        glGetShaderInfoLog(id, maxLength, &maxLength, &infoLog[0]);
+        LOG_ERROR("Shader compilation failed:\n{0}", &infoLog[0]);
+      }
+
       GLint maxLength = 0;
-      glGetProgramiv(program, GL_INFO_LOG_LENGTH, &maxLength);
+      glGetProgramiv(m_rendererID, GL_INFO_LOG_LENGTH, &maxLength);
 
-      // The maxLength includes the NULL character
-      std::vector<GLchar> infoLog(maxLength);
-      glGetProgramInfoLog(program, maxLength, &maxLength, &infoLog[0]);
-      LOG_ERROR("Shader compilation failed:\n{0}", &infoLog[0]);
+      std::vector<GLchar> infoLog(maxLength + 1);
+      glGetProgramInfoLog(m_rendererID, maxLength, &maxLength, &infoLog[0]);
+      LOG_ERROR("Shader link failed:\n{0}", &infoLog[0]);
 
       // We don't need the program anymore.
-      glDeleteProgram(program);
+      glDeleteProgram(m_rendererID);
+      m_rendererID = 0;
       // Don't leak shaders either.
-      for (auto id : shaderRendererIDs)
-        glDeleteShader(id);
-      result = false;
+      DeleteShaders();
+
+      BSR_ASSERT(false, "Failed");
+      return false;
     }
 
     // Always detach shaders after a successful link.
-    for (auto id : shaderRendererIDs)
-      glDetachShader(program, id);
+    for (auto id : m_shaderIDs)
+      glDetachShader(m_rendererID, id);
+    DeleteShaders();
 
-    m_rendererID = program;
+    ResolveUniforms();
+    m_loaded = true;
 
     LOG_DEBUG("Successfully created program");
+    return true;
+  }
 
-    return result;
+  void RT_RendererProgram::DeleteShaders()
+  {
+    for (auto id : m_shaderIDs)
+      glDeleteShader(id);
+    m_shaderIDs.clear();
   }
 
   void RT_RendererProgram::ResolveUniforms()
@@ -192,9 +270,9 @@ namespace Engine
 
     uint32_t sampler = 0;
     Index ind = 0;
-    for (ShaderUniformDeclaration & uniform : m_shaderData->GetUniforms())
+    for (ShaderUniformDeclaration const & uniform : m_shaderData->GetUniforms())
     {
-      if (uniform.GetType() == ShaderDataType::TEXTURE2D)
+      if (GetShaderDataClass(uniform.GetType()) == ShaderDataClass::Texture)
       {
         int32_t location = GetUniformLocation(uniform.GetName());
         m_textureBindingPoints.insert(ind, sampler);
@@ -232,24 +310,34 @@ namespace Engine
     return result;
   }
 
-  void RT_RendererProgram::UploadTexture(TextureUnit a_textureUnit, RefID const * a_textureIDs, uint32_t a_count)
+  void RT_RendererProgram::UploadTexture(TextureUnit a_textureUnit, RenderHandle const * a_textures, uint32_t a_count)
+  {
+    uint32_t textureUnit = a_textureUnit;
+    for (uint32_t i = 0; i < a_count; i++)
+    {
+      RT_Texture2D::Bind(a_textures[i], textureUnit);
+      textureUnit++;
+    }
+  }
+
+  void RT_RendererProgram::UploadTextureArray(TextureUnit a_textureUnit, RenderHandle const * a_textures, uint32_t a_count)
   {
     uint32_t textureUnit = a_textureUnit;
     for (uint32_t i = 0; i < a_count; i++)
     {
-      RefID id = a_textureIDs[i];
+      RT_Texture2DArray *pTexture = RenderThreadData::Instance()->textureArrays.at(a_textures[i]);
 
-      RT_Texture2D *pTexture = RenderThreadData::Instance()->textures.at(id);
-      
       if (pTexture != nullptr)
         pTexture->Bind(textureUnit);
+      else
+        RT_Texture2DArray::BindPlaceholder(textureUnit);
       textureUnit++;
     }
   }
 
   void RT_RendererProgram::UploadUniformBuffer(byte const* a_pbuf)
   {
-    if (m_shaderData.IsNull() || a_pbuf == nullptr)
+    if (!m_loaded || m_shaderData.IsNull() || a_pbuf == nullptr)
       return;
 
     Bind();
@@ -268,7 +356,13 @@ namespace Engine
       {
         TextureUnit const * pUnit = m_textureBindingPoints.at(i);
         if (pUnit != nullptr)
-          UploadTexture(*pUnit, (RefID*)buf, count);
+          UploadTexture(*pUnit, (RenderHandle*)buf, count);
+      }
+      else if (pdecl->GetType() == ShaderDataType::TEXTURE2DARRAY)
+      {
+        TextureUnit const * pUnit = m_textureBindingPoints.at(i);
+        if (pUnit != nullptr)
+          UploadTextureArray(*pUnit, (RenderHandle*)buf, count);
       }
       else
       {
@@ -327,7 +421,7 @@ namespace Engine
 
   void RT_RendererProgram::UploadUniform(std::string const& a_name, void const* a_pbuf, uint32_t a_size)
   {
-    if (m_shaderData.IsNull() || a_pbuf == nullptr)
+    if (!m_loaded || m_shaderData.IsNull() || a_pbuf == nullptr)
       return;
 
     uint32_t index = m_shaderData->FindUniformIndex(a_name);
@@ -337,7 +431,7 @@ namespace Engine
       return;
     }
 
-    ShaderUniformDeclaration * pdecl = &m_shaderData->GetUniforms()[index];
+    ShaderUniformDeclaration const * pdecl = &m_shaderData->GetUniforms()[index];
     uint32_t elementSize = SizeOfShaderDataType(pdecl->GetType());
     uint32_t count = a_size / elementSize;
 
@@ -20,18 +20,59 @@
 #define RT_RENDERERPROGRAM_H
 
 #include <stdint.h>
+#include <atomic>
 #include "MemBuffer.h"
 #include "Memory.h"
 #include "core_utils.h"
 #include "ShaderUniform.h"
 #include "RT_RendererAPI.h"
 #include "ShaderSource.h"
+#include "RenderResource.h"
 #include "DgOpenHashMap.h"
 
 namespace Engine
 {
   class RT_BindingPoint;
 
+  namespace impl
+  {
+    //Tracks a program from parsing through to linking. Shared between the client
+    //RendererProgram, the parse job and the render thread.
+    class ProgramStatus : public Resource
+    {
+    public:
+
+      enum State : uint32_t
+      {
+        Parsing,    //ShaderData being built on a worker thread
+        Parsed,     //Waiting for the render thread to submit to the driver
+        Compiling,  //Compile and link submitted, waiting on the driver
+        Ready,
+        Failed
+      };
+
+      ProgramStatus()
+        : m_state(Parsing)
+      {
+
+      }
+
+      State Get() const
+      {
+        return static_cast<State>(m_state.load(std::memory_order_acquire));
+      }
+
+      void Set(State a_state)
+      {
+        m_state.store(a_state, std::memory_order_release);
+      }
+
+    private:
+
+      std::atomic<uint32_t> m_state;
+    };
+  }
+
   class RT_RendererProgram
   {
     typedef uint32_t Index;
@@ -40,12 +81,19 @@ namespace Engine
   public:
 
     RT_RendererProgram();
-    RT_RendererProgram(impl::ResourceID64);
+    RT_RendererProgram(impl::ResourceID64 shaderData, impl::ResourceID64 status);
     ~RT_RendererProgram();
 
-    bool Init(impl::ResourceID64);
+    void Init(impl::ResourceID64 shaderData, impl::ResourceID64 status);
     void Destroy();
 
+    //Advance the program through parse -> compile -> link without blocking.
+    //Returns true while the program is still pending.
+    bool Update();
+
+    //Calls Update() on all pending programs in the RenderThreadData.
+    static void UpdatePending();
+
     void Bind() const;
     void Unbind() const;
 
@@ -59,14 +107,18 @@ namespace Engine
 
   private:
 
-    bool CompileAndUploadShader();
+    bool SubmitShaders();
+    bool CompletionStatusAvailable() const;
+    bool FinaliseLink();
+    void DeleteShaders();
     void ResolveUniforms();
 
     //bool Bind(ShaderDomain, std::string const & name, RT_BindingPoint const &);
 
     int32_t GetUniformLocation(std::string const& name) const;
     void UploadUniform(uint32_t index, void const * buf, uint32_t count);
-    void UploadTexture(TextureUnit textureUnit, RefID const * textureIDs, uint32_t count);
+    void UploadTexture(TextureUnit textureUnit, RenderHandle const * textures, uint32_t count);
+    void UploadTextureArray(TextureUnit textureUnit, RenderHandle const * textures, uint32_t count);
     void UploadUniformSingle(int location, ShaderDataType, void const* buf);
     void UploadUniformArray(int location, ShaderDataType, void const* buf, uint32_t count);
 
@@ -77,6 +129,8 @@ namespace Engine
 
     std::string m_name;
     Ref<ShaderData> m_shaderData; //TODO this needs to be const
+    Ref<impl::ProgramStatus> m_status;
+    Dg::DynamicArray<RendererID> m_shaderIDs; //Only alive while compiling
     Dg::DynamicArray<int32_t> m_uniformLocations;
     Dg::OpenHashMap<Index, TextureUnit> m_textureBindingPoints;
   };
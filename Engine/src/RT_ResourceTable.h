@@ -0,0 +1,77 @@
+//@group Renderer/RenderThread
+
+#ifndef RT_RESOURCETABLE_H
+#define RT_RESOURCETABLE_H
+
+#include <stdint.h>
+#include <vector>
+
+#include "RenderResource.h"
+
+namespace Engine
+{
+  //Dense storage for render thread objects, indexed by the slot in a RenderHandle.
+  //Has the same interface the render thread used on the old hash maps: at() returns
+  //nullptr if the handle does not refer to a live object.
+  template<typename T>
+  class RT_ResourceTable
+  {
+    struct Slot
+    {
+      T         item;
+      uint32_t  generation;
+      bool      inUse;
+    };
+
+  public:
+
+    T * at(RenderHandle a_handle)
+    {
+      if (a_handle.index >= m_slots.size())
+        return nullptr;
+
+      Slot & slot = m_slots[a_handle.index];
+      if (!slot.inUse)
+        return nullptr;
+
+#ifdef BSR_DEBUG
+      if (slot.generation != a_handle.generation)
+        return nullptr;
+#endif
+
+      return &slot.item;
+    }
+
+    //Overwrites anything already in the slot.
+    T * insert(RenderHandle a_handle, T const & a_item)
+    {
+      if (!a_handle.IsValid())
+        return nullptr;
+
+      if (a_handle.index >= m_slots.size())
+        m_slots.resize(a_handle.index + 1, Slot{T(), 0, false});
+
+      Slot & slot = m_slots[a_handle.index];
+      slot.item = a_item;
+      slot.generation = a_handle.generation;
+      slot.inUse = true;
+      return &slot.item;
+    }
+
+    void erase(RenderHandle a_handle)
+    {
+      T * pItem = at(a_handle);
+      if (pItem == nullptr)
+        return;
+
+      Slot & slot = m_slots[a_handle.index];
+      slot.item = T();
+      slot.inUse = false;
+    }
+
+  private:
+    std::vector<Slot> m_slots;
+  };
+}
+
+#endif
@@ -1,8 +1,21 @@
 //@group Renderer/RenderThread
 
+#include <mutex>
 #include <glad/glad.h>
 #include "RT_Texture.h"
 #include "RT_RendererAPI.h"
+#include "BlockCompression.h"
+#include "RenderThreadData.h"
+#include "core_Assert.h"
+
+//From EXT_texture_compression_s3tc
+#ifndef GL_COMPRESSED_RGBA_S3TC_DXT1_EXT
+#define GL_COMPRESSED_RGBA_S3TC_DXT1_EXT 0x83F1
+#endif
+
+#ifndef GL_COMPRESSED_RGBA_S3TC_DXT5_EXT
+#define GL_COMPRESSED_RGBA_S3TC_DXT5_EXT 0x83F3
+#endif
 
 namespace Engine
 {
@@ -37,6 +50,61 @@ namespace Engine
     }
   }
 
+  static GLenum GetGL(TextureFormat a_val)
+  {
+    switch (a_val)
+    {
+      case TextureFormat::BC1:  return GL_COMPRESSED_RGBA_S3TC_DXT1_EXT;
+      case TextureFormat::BC3:  return GL_COMPRESSED_RGBA_S3TC_DXT5_EXT;
+      default:                  return GL_RGBA;
+    }
+  }
+
+  //Published at the end of each frame for the client to read
+  static std::mutex s_statsMutex;
+  static TextureResidencyStats s_residencyStats;
+
+  //Shared by 2D textures and arrays. The texture must be bound to 'target'.
+  static void SetSamplerState(GLenum a_target, RendererID a_id, TextureFlags a_flags)
+  {
+    //Filtering indices would blend unrelated palette entries. Look up the palette
+    //first and filter the result in the shader, if needed.
+    bool indexed = a_flags.GetFormat() == TextureFormat::Index8;
+    TextureFilter filter = indexed ? TextureFilter::Nearest : a_flags.GetFilter();
+    TextureMipmapFilter mipmapFilter = indexed ? TextureMipmapFilter::Nearest_Nearest : a_flags.GetMipmapFilter();
+    float anisotropy = indexed ? 1.0f : RendererAPI::GetCapabilities().maxAnisotropy;
+
+    glTexParameteri(a_target, GL_TEXTURE_WRAP_S, GetGL(a_flags.GetWrap()));
+    glTexParameteri(a_target, GL_TEXTURE_WRAP_T, GetGL(a_flags.GetWrap()));
+    glTexParameteri(a_target, GL_TEXTURE_MAG_FILTER, GetGL(filter));
+    glTextureParameterf(a_id, GL_TEXTURE_MAX_ANISOTROPY, anisotropy);
+
+    if (a_flags.IsMipmapped())
+      glTexParameteri(a_target, GL_TEXTURE_MIN_FILTER, GetGL(mipmapFilter));
+    else
+      glTexParameteri(a_target, GL_TEXTURE_MIN_FILTER, GetGL(filter));
+  }
+
+  //Levels built on the CPU are uploaded as is. Only fall back to the driver if we have none.
+  //The driver cannot build mipmaps for compressed or indexed data.
+  static bool UseDriverMipmaps(TextureFlags a_flags, uint32_t a_mipLevels)
+  {
+    return a_flags.IsMipmapped() && a_mipLevels <= 1 && a_flags.GetFormat() == TextureFormat::RGBA8;
+  }
+
+  static GLint MaxLevel(TextureFlags a_flags, uint32_t a_mipLevels)
+  {
+    if (a_mipLevels > 1)
+      return static_cast<GLint>(a_mipLevels - 1);
+    if (a_flags.GetFormat() != TextureFormat::RGBA8)
+      return 0;
+    return 1000;
+  }
+
+  //-----------------------------------------------------------------------------------------------
+  // RT_Texture2D
+  //-----------------------------------------------------------------------------------------------
+
   RT_Texture2D::RT_Texture2D()
     : m_rendererID(0)
   {
@@ -50,23 +118,60 @@ namespace Engine
 
   void RT_Texture2D::Init(TextureData const & a_data)
   {
-    m_flags = a_data.flags;
-    glCreateTextures(GL_TEXTURE_2D, 1, &m_rendererID);
+    RendererID id = 0;
+    glCreateTextures(GL_TEXTURE_2D, 1, &id);
+    Init(id, a_data.flags, a_data.width, a_data.height, a_data.mipLevels, a_data.pPixels);
+  }
+
+  void RT_Texture2D::Init(TextureData const & a_data, uint32_t a_baseLevel)
+  {
+    BSR_ASSERT(a_baseLevel < a_data.mipLevels, "RT_Texture2D::Init(): Base level out of range");
+
+    RendererID id = 0;
+    glCreateTextures(GL_TEXTURE_2D, 1, &id);
+    Init(id, a_data.flags, a_data.LevelWidth(a_baseLevel), a_data.LevelHeight(a_baseLevel),
+         a_data.mipLevels - a_baseLevel, a_data.Level(a_baseLevel));
+  }
+
+  void RT_Texture2D::Init(RendererID a_id, TextureFlags a_flags,
+                          uint32_t a_width, uint32_t a_height,
+                          uint32_t a_mipLevels, void const * a_pData)
+  {
+    m_rendererID = a_id;
+    m_flags = a_flags;
     glBindTexture(GL_TEXTURE_2D, m_rendererID);
 
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GetGL(m_flags.GetWrap()));
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GetGL(m_flags.GetWrap()));
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GetGL(m_flags.GetFilter()));
-    glTextureParameterf(m_rendererID, GL_TEXTURE_MAX_ANISOTROPY, RendererAPI::GetCapabilities().maxAnisotropy);
+    TextureFormat format = m_flags.GetFormat();
+    bool compressed = BlockSize(format) != 0;
+    bool indexed = format == TextureFormat::Index8;
+    SetSamplerState(GL_TEXTURE_2D, m_rendererID, m_flags);
 
-    if (m_flags.IsMipmapped())
-      glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GetGL(m_flags.GetMipmapFilter()));
-    else
-      glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GetGL(m_flags.GetFilter()));
+    //Index rows are tightly packed
+    if (indexed)
+      glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
 
-    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, a_data.width, a_data.height, 0, GL_RGBA, GL_UNSIGNED_BYTE, (uint8_t*)a_data.pPixels);
-    
-    if (m_flags.IsMipmapped())
+    //Compressed blocks go straight to the card
+    byte const * pLevel = static_cast<byte const *>(a_pData);
+    for (uint32_t i = 0; i < a_mipLevels; i++)
+    {
+      uint32_t w = MipLevelSize(a_width, i);
+      uint32_t h = MipLevelSize(a_height, i);
+      size_t size = ImageDataSize(format, w, h);
+      if (compressed)
+        glCompressedTexImage2D(GL_TEXTURE_2D, i, GetGL(format), w, h, 0, static_cast<GLsizei>(size), pLevel);
+      else if (indexed)
+        glTexImage2D(GL_TEXTURE_2D, i, GL_R8, w, h, 0, GL_RED, GL_UNSIGNED_BYTE, pLevel);
+      else
+        glTexImage2D(GL_TEXTURE_2D, i, GL_RGBA, w, h, 0, GL_RGBA, GL_UNSIGNED_BYTE, pLevel);
+      if (pLevel != nullptr)
+        pLevel += size;
+    }
+
+    if (indexed)
+      glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, MaxLevel(m_flags, a_mipLevels));
+    if (UseDriverMipmaps(m_flags, a_mipLevels))
       glGenerateMipmap(GL_TEXTURE_2D);
 
     glBindTexture(GL_TEXTURE_2D, 0);
@@ -74,13 +179,240 @@ namespace Engine
 
   void RT_Texture2D::Destroy()
   {
-    GLuint count = 1;
-    glDeleteTextures(m_rendererID, &count);
+    glDeleteTextures(1, &m_rendererID);
     m_rendererID = 0;
   }
 
+  void RT_Texture2D::CreateRendererIDs(uint32_t a_count, RendererID * a_out)
+  {
+    glCreateTextures(GL_TEXTURE_2D, a_count, a_out);
+  }
+
+  void RT_Texture2D::Create(RenderHandle a_handle, TextureData const & a_data, RendererID a_id)
+  {
+    RenderThreadData * pData = RenderThreadData::Instance();
+    RT_Texture2D * pTexture = pData->textures.at(a_handle);
+    if (pTexture != nullptr)
+      pTexture->Destroy();
+    else
+      pTexture = pData->textures.insert(a_handle, RT_Texture2D());
+
+    if (a_id == 0)
+      pTexture->Init(a_data);
+    else
+      pTexture->Init(a_id, a_data.flags, a_data.width, a_data.height, a_data.mipLevels, a_data.pPixels);
+
+    if (a_data.flags.IsStreamable() && a_data.pPixels != nullptr)
+      pData->textureResidency.Add(a_handle, a_data);
+    else
+      pData->textureResidency.Remove(a_handle);
+  }
+
+  void RT_Texture2D::Delete(RenderHandle a_handle)
+  {
+    RenderThreadData * pData = RenderThreadData::Instance();
+    pData->textureResidency.Remove(a_handle);
+
+    RT_Texture2D * pTexture = pData->textures.at(a_handle);
+    if (pTexture == nullptr)
+      return;
+
+    pTexture->Destroy();
+    pData->textures.erase(a_handle);
+  }
+
   void RT_Texture2D::Bind(uint32_t a_slot)
   {
     glBindTextureUnit(a_slot, m_rendererID);
   }
-}
\ No newline at end of file
+
+  void RT_Texture2D::Bind(RenderHandle a_handle, uint32_t a_slot)
+  {
+    RenderThreadData * pData = RenderThreadData::Instance();
+    pData->textureResidency.Touch(a_handle);
+
+    //Still loading, never uploaded or evicted
+    RT_Texture2D * pTexture = pData->textures.at(a_handle);
+    if (pTexture == nullptr || pTexture->m_rendererID == 0)
+      BindPlaceholder(a_slot);
+    else
+      pTexture->Bind(a_slot);
+  }
+
+  void RT_Texture2D::BindPlaceholder(uint32_t a_slot)
+  {
+    RenderThreadData::Instance()->placeholderTexture.Bind(a_slot);
+  }
+
+  void RT_Texture2D::UpdatePending()
+  {
+    RenderThreadData * pData = RenderThreadData::Instance();
+    std::vector<PendingTexture> & pending = pData->pendingTextures;
+    size_t uploaded = 0;
+
+    for (size_t i = 0; i < pending.size();)
+    {
+      impl::TextureStatus::State state = pending[i].status->Get();
+      if (state == impl::TextureStatus::Decoding)
+      {
+        i++;
+        continue;
+      }
+
+      if (state == impl::TextureStatus::Decoded)
+      {
+        TextureData & data = pending[i].staging->data;
+
+        //Always let the first one through, so textures larger than the budget still load.
+        size_t size = data.DataSize();
+        if (uploaded != 0 && uploaded + size > pData->textureUploadBudget)
+          break;
+
+        Create(pending[i].handle, data);
+        data.Clear();
+        pending[i].status->Set(impl::TextureStatus::Ready);
+        uploaded += size;
+      }
+
+      pending.erase(pending.begin() + i);
+    }
+  }
+
+  void RT_Texture2D::CancelPending(RenderHandle a_handle)
+  {
+    std::vector<PendingTexture> & pending = RenderThreadData::Instance()->pendingTextures;
+    for (size_t i = 0; i < pending.size();)
+    {
+      if (pending[i].handle.index == a_handle.index && pending[i].handle.generation == a_handle.generation)
+        pending.erase(pending.begin() + i);
+      else
+        i++;
+    }
+  }
+
+  void RT_Texture2D::UpdateResidency()
+  {
+    RenderThreadData * pData = RenderThreadData::Instance();
+    TextureResidency & residency = pData->textureResidency;
+
+    //Restores are limited by the same per-frame upload budget as asynchronous loads
+    std::vector<TextureResidency::Change> changes;
+    residency.Restore(pData->textureUploadBudget, changes);
+    residency.Trim(changes);
+
+    for (TextureResidency::Change const & change : changes)
+    {
+      TextureData const * pSource = residency.GetData(change.handle);
+      RT_Texture2D * pTexture = pData->textures.at(change.handle);
+      if (pSource == nullptr || pTexture == nullptr)
+        continue;
+
+      pTexture->Destroy();
+      if (change.baseLevel < pSource->mipLevels)
+        pTexture->Init(*pSource, change.baseLevel);
+    }
+
+    residency.EndFrame();
+
+    std::lock_guard<std::mutex> lock(s_statsMutex);
+    s_residencyStats = residency.GetStats();
+  }
+
+  TextureResidencyStats RT_Texture2D::GetResidencyStats()
+  {
+    std::lock_guard<std::mutex> lock(s_statsMutex);
+    return s_residencyStats;
+  }
+
+  //-----------------------------------------------------------------------------------------------
+  // RT_Texture2DArray
+  //-----------------------------------------------------------------------------------------------
+
+  RT_Texture2DArray::RT_Texture2DArray()
+    : m_rendererID(0)
+  {
+
+  }
+
+  RT_Texture2DArray::~RT_Texture2DArray()
+  {
+
+  }
+
+  void RT_Texture2DArray::Init(TextureData const * a_pLayers, uint32_t a_count)
+  {
+    BSR_ASSERT(a_count > 0, "RT_Texture2DArray::Init(): Empty array");
+
+    TextureData const & first = a_pLayers[0];
+    m_flags = first.flags;
+    glCreateTextures(GL_TEXTURE_2D_ARRAY, 1, &m_rendererID);
+    glBindTexture(GL_TEXTURE_2D_ARRAY, m_rendererID);
+
+    TextureFormat format = m_flags.GetFormat();
+    bool compressed = BlockSize(format) != 0;
+    bool indexed = format == TextureFormat::Index8;
+    SetSamplerState(GL_TEXTURE_2D_ARRAY, m_rendererID, m_flags);
+
+    if (indexed)
+      glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+
+    //Allocate each level for all layers, then fill one layer at a time. Layers share
+    //a size, format and level count, so level offsets are the same in every layer.
+    GLsizei layers = static_cast<GLsizei>(a_count);
+    size_t offset = 0;
+    for (uint32_t i = 0; i < first.mipLevels; i++)
+    {
+      uint32_t w = MipLevelSize(first.width, i);
+      uint32_t h = MipLevelSize(first.height, i);
+      size_t size = ImageDataSize(format, w, h);
+
+      if (compressed)
+        glCompressedTexImage3D(GL_TEXTURE_2D_ARRAY, i, GetGL(format), w, h, layers, 0, static_cast<GLsizei>(size * a_count), nullptr);
+      else if (indexed)
+        glTexImage3D(GL_TEXTURE_2D_ARRAY, i, GL_R8, w, h, layers, 0, GL_RED, GL_UNSIGNED_BYTE, nullptr);
+      else
+        glTexImage3D(GL_TEXTURE_2D_ARRAY, i, GL_RGBA, w, h, layers, 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+
+      for (uint32_t l = 0; l < a_count; l++)
+      {
+        byte const * pLevel = reinterpret_cast<byte const *>(a_pLayers[l].pPixels);
+        if (pLevel == nullptr)
+          continue;
+        pLevel += offset;
+
+        if (compressed)
+          glCompressedTexSubImage3D(GL_TEXTURE_2D_ARRAY, i, 0, 0, l, w, h, 1, GetGL(format), static_cast<GLsizei>(size), pLevel);
+        else if (indexed)
+          glTexSubImage3D(GL_TEXTURE_2D_ARRAY, i, 0, 0, l, w, h, 1, GL_RED, GL_UNSIGNED_BYTE, pLevel);
+        else
+          glTexSubImage3D(GL_TEXTURE_2D_ARRAY, i, 0, 0, l, w, h, 1, GL_RGBA, GL_UNSIGNED_BYTE, pLevel);
+      }
+      offset += size;
+    }
+
+    if (indexed)
+      glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAX_LEVEL, MaxLevel(m_flags, first.mipLevels));
+    if (UseDriverMipmaps(m_flags, first.mipLevels))
+      glGenerateMipmap(GL_TEXTURE_2D_ARRAY);
+
+    glBindTexture(GL_TEXTURE_2D_ARRAY, 0);
+  }
+
+  void RT_Texture2DArray::Destroy()
+  {
+    glDeleteTextures(1, &m_rendererID);
+    m_rendererID = 0;
+  }
+
+  void RT_Texture2DArray::Bind(uint32_t a_slot)
+  {
+    glBindTextureUnit(a_slot, m_rendererID);
+  }
+
+  void RT_Texture2DArray::BindPlaceholder(uint32_t a_slot)
+  {
+    RenderThreadData::Instance()->placeholderTextureArray.Bind(a_slot);
+  }
+}
@@ -3,11 +3,68 @@
 #ifndef RT_TEXTURE_H
 #define RT_TEXTURE_H
 
+#include <atomic>
+
 #include "RT_RendererAPI.h"
 #include "TextureData.h"
+#include "TextureResidency.h"
+#include "RenderResource.h"
+#include "Memory.h"
 
 namespace Engine
 {
+  namespace impl
+  {
+    //Tracks an asynchronous texture load. Shared between the client Texture2D, the
+    //load job and the render thread.
+    class TextureStatus : public Resource
+    {
+    public:
+
+      enum State : uint32_t
+      {
+        Decoding, //Decoder running on a worker thread
+        Decoded,  //Waiting for the render thread to upload
+        Ready,
+        Failed
+      };
+
+      TextureStatus()
+        : m_state(Decoding)
+      {
+
+      }
+
+      State Get() const
+      {
+        return static_cast<State>(m_state.load(std::memory_order_acquire));
+      }
+
+      void Set(State a_state)
+      {
+        m_state.store(a_state, std::memory_order_release);
+      }
+
+    private:
+
+      std::atomic<uint32_t> m_state;
+    };
+
+    //Decoded pixels waiting for upload. Only the load job writes to this, and only
+    //the render thread reads it once the status is Decoded.
+    class TextureStaging : public Resource
+    {
+    public:
+
+      ~TextureStaging()
+      {
+        data.Clear();
+      }
+
+      TextureData data;
+    };
+  }
+
   class RT_Texture2D
   {
   public:
@@ -16,10 +73,66 @@ namespace Engine
     ~RT_Texture2D();
 
     void Init(TextureData const &);
+
+    //Uploads levels [baseLevel, mipLevels) only
+    void Init(TextureData const &, uint32_t baseLevel);
+
+    //Initialise with a name from CreateRendererIDs(). 'data' is laid out as in TextureData,
+    //in the format given by the flags.
+    void Init(RendererID, TextureFlags, uint32_t width, uint32_t height, uint32_t mipLevels, void const * data);
     void Destroy();
 
+    //Creates 'count' texture names in one call, for batch creation.
+    static void CreateRendererIDs(uint32_t count, RendererID * out);
+
+    //Creates or replaces the texture for a handle. 'id' is from CreateRendererIDs(), or 0
+    //to create one. Streamable textures are handed to the residency manager.
+    static void Create(RenderHandle, TextureData const &, RendererID id = 0);
+    static void Delete(RenderHandle);
+
     void Bind(uint32_t slot = 0);
 
+    //Binds the texture for a handle, or the placeholder if it is missing or evicted.
+    //Counts as a use of the texture for residency.
+    static void Bind(RenderHandle, uint32_t slot);
+
+    //Bound in place of textures which are missing or still loading.
+    static void BindPlaceholder(uint32_t slot = 0);
+
+    //Uploads decoded textures from the pending list, within the per-frame upload budget.
+    static void UpdatePending();
+
+    //Drops any asynchronous load still in flight for this texture.
+    static void CancelPending(RenderHandle);
+
+    //Streams textures back in, then degrades or evicts streamable textures to stay
+    //under budget. Called once per frame, after the frame's commands.
+    static void UpdateResidency();
+
+    //Stats as of the end of the last frame. Can be called from any thread.
+    static TextureResidencyStats GetResidencyStats();
+
+  private:
+    RendererID    m_rendererID;
+    TextureFlags  m_flags;
+  };
+
+  //Layers must all have the same size, format and number of mip levels.
+  class RT_Texture2DArray
+  {
+  public:
+
+    RT_Texture2DArray();
+    ~RT_Texture2DArray();
+
+    void Init(TextureData const * layers, uint32_t count);
+    void Destroy();
+
+    void Bind(uint32_t slot = 0);
+
+    //A single layer. Out of range layers clamp to it, so it stands in for any array.
+    static void BindPlaceholder(uint32_t slot = 0);
+
   private:
     RendererID    m_rendererID;
     TextureFlags  m_flags;
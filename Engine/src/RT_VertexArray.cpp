@@ -27,7 +27,7 @@ namespace Engine
 {
   RT_VertexArray::RT_VertexArray()
     : m_rendererID(0)
-    , m_indexBuffer(INVALID_REFID)
+    , m_indexBuffer{RenderHandle::INVALID_SLOT, 0}
     , m_vertexAttribIndex(0)
   {
 
@@ -44,6 +44,17 @@ namespace Engine
     glCreateVertexArrays(1, &m_rendererID);
   }
 
+  void RT_VertexArray::Init(RendererID a_id)
+  {
+    BSR_ASSERT(m_rendererID == 0, "Already initialized!");
+    m_rendererID = a_id;
+  }
+
+  void RT_VertexArray::CreateRendererIDs(uint32_t a_count, RendererID * a_out)
+  {
+    glCreateVertexArrays(a_count, a_out);
+  }
+
   void RT_VertexArray::Destroy()
   {
     BSR_ASSERT(m_rendererID != 0, "Trying to destroy a verex array that wasn't initialized!");
@@ -61,12 +72,12 @@ namespace Engine
     glBindVertexArray(0);
   }
 
-  void RT_VertexArray::AddVertexBuffer(RefID a_id)
+  void RT_VertexArray::AddVertexBuffer(RenderHandle a_id)
   {
     RT_VertexBuffer* pVB = RenderThreadData::Instance()->VBOs.at(a_id);
     if (pVB == nullptr)
     {
-      LOG_WARN("RT_VertexArray::AddVertexBuffer(): Failed to find the index buffer! RefID : {}", a_id);
+      LOG_WARN("RT_VertexArray::AddVertexBuffer(): Failed to find the index buffer! Handle : {}", a_id.index);
       return;
     }
 
@@ -101,12 +112,12 @@ namespace Engine
     m_vertexBuffers.push_back(a_id);
   }
 
-  void RT_VertexArray::SetIndexBuffer(RefID a_id)
+  void RT_VertexArray::SetIndexBuffer(RenderHandle a_id)
   {
     RT_IndexBuffer * pIB = RenderThreadData::Instance()->IBOs.at(a_id);
     if (pIB == nullptr)
     {
-      LOG_WARN("RT_VertexArray::SetIndexBuffer(): Failed to find the index buffer! RefID : {}", a_id);
+      LOG_WARN("RT_VertexArray::SetIndexBuffer(): Failed to find the index buffer! Handle : {}", a_id.index);
       return;
     }
 
@@ -115,12 +126,12 @@ namespace Engine
     m_indexBuffer = a_id;
   }
 
-  Dg::DynamicArray<RefID> const & RT_VertexArray::GetVertexBuffers() const
+  Dg::DynamicArray<RenderHandle> const & RT_VertexArray::GetVertexBuffers() const
   {
     return m_vertexBuffers;
   }
 
-  RefID RT_VertexArray::GetIndexBuffer() const
+  RenderHandle RT_VertexArray::GetIndexBuffer() const
   {
     return m_indexBuffer;
   }
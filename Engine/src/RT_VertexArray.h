@@ -22,7 +22,7 @@
 #include <stdint.h>
 #include "DgDynamicArray.h"
 #include "RT_RendererAPI.h"
-#include "ResourceID.h"
+#include "RenderResource.h"
 
 namespace Engine
 {
@@ -34,22 +34,26 @@ namespace Engine
     ~RT_VertexArray();
 
     void Init();
+    void Init(RendererID);
     void Destroy();
 
+    //Creates 'count' vertex array names in one call, for batch creation.
+    static void CreateRendererIDs(uint32_t count, RendererID * out);
+
     void Bind() const;
     void Unbind() const;
 
-    void AddVertexBuffer(RefID id);
-    void SetIndexBuffer(RefID id);
+    void AddVertexBuffer(RenderHandle);
+    void SetIndexBuffer(RenderHandle);
 
-    Dg::DynamicArray<RefID> const & GetVertexBuffers() const;
-    RefID GetIndexBuffer() const;
+    Dg::DynamicArray<RenderHandle> const & GetVertexBuffers() const;
+    RenderHandle GetIndexBuffer() const;
 
   private:
 
     RendererID m_rendererID;
-    Dg::DynamicArray<RefID> m_vertexBuffers; //TODO is this even needed?
-    RefID m_indexBuffer; //TODO is this even needed?
+    Dg::DynamicArray<RenderHandle> m_vertexBuffers; //TODO is this even needed?
+    RenderHandle m_indexBuffer; //TODO is this even needed?
     uint32_t m_vertexAttribIndex;
   };
 }
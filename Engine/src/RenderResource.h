@@ -0,0 +1,107 @@
+//@group Renderer
+
+#ifndef RENDERRESOURCE_H
+#define RENDERRESOURCE_H
+
+#include <stdint.h>
+#include <vector>
+
+#include "Resource.h"
+
+// Resources owned by the render thread are stored in dense tables, one per resource
+// type. A client object claims a slot when it is constructed and hands it back when it
+// is destroyed. The slot index is what gets captured in render commands, so the render
+// thread never has to hash a RefID to find its object.
+//
+// Each time a slot is reused its generation is bumped. Debug builds check the generation
+// on every lookup to catch commands referring to a resource which has since been destroyed.
+
+namespace Engine
+{
+  struct RenderHandle
+  {
+    static uint32_t const INVALID_SLOT = 0xFFFF'FFFF;
+
+    uint32_t index;
+    uint32_t generation;
+
+    bool IsValid() const
+    {
+      return index != INVALID_SLOT;
+    }
+  };
+
+  //Handles are written straight into material uniform buffers in place of a texture ID.
+  static_assert(sizeof(RenderHandle) == sizeof(RefID), "RenderHandle must be the same size as a RefID");
+
+  //Main-thread only.
+  class RenderHandlePool
+  {
+  public:
+
+    RenderHandle Acquire()
+    {
+      uint32_t index;
+      if (m_freeList.empty())
+      {
+        index = static_cast<uint32_t>(m_generations.size());
+        m_generations.push_back(0);
+      }
+      else
+      {
+        index = m_freeList.back();
+        m_freeList.pop_back();
+      }
+
+      m_generations[index]++;
+      return RenderHandle{index, m_generations[index]};
+    }
+
+    //The slot can be handed out again straight away. Commands are executed in order, so
+    //the render thread will have processed the delete command by the time the
+    //create command for the next owner runs.
+    void Release(RenderHandle a_handle)
+    {
+      if (a_handle.IsValid())
+        m_freeList.push_back(a_handle.index);
+    }
+
+  private:
+    std::vector<uint32_t> m_generations;
+    std::vector<uint32_t> m_freeList;
+  };
+
+  //Derive 'T' from this instead of Resource to give it a render handle.
+  template<typename T>
+  class RenderResource : public Resource
+  {
+  public:
+
+    RenderHandle GetHandle() const
+    {
+      return m_handle;
+    }
+
+  protected:
+
+    RenderResource()
+      : m_handle(s_handles.Acquire())
+    {
+
+    }
+
+    ~RenderResource()
+    {
+      s_handles.Release(m_handle);
+    }
+
+  private:
+    static RenderHandlePool s_handles;
+    RenderHandle m_handle;
+  };
+
+  template<typename T>
+  RenderHandlePool RenderResource<T>::s_handles;
+}
+
+#endif
@@ -122,6 +122,12 @@ namespace Engine
         TextureCreate,
         TextureDelete,
         TextureBindToSlot,
+        TextureSetUploadBudget,
+        TextureSetResidencyBudget,
+
+        TextureArrayCreate,
+        TextureArrayDelete,
+        TextureArrayBindToSlot,
       };
     };
 
@@ -6,6 +6,8 @@
 #include "RT_RendererAPI.h"
 #include "RenderThreadData.h"
 #include "RT_BindingPoint.h"
+#include "RT_RendererProgram.h"
+#include "RT_Texture.h"
 #include "Renderer.h"
 
 #define OTHER(index) ((index + 1) % 2)
@@ -32,6 +34,9 @@ namespace Engine
     while (!RenderThread::Instance()->ShouldExit())
     {
       Renderer::Instance()->ExecuteRenderCommands();
+      RT_RendererProgram::UpdatePending();
+      RT_Texture2D::UpdatePending();
+      RT_Texture2D::UpdateResidency();
       RenderThread::Instance()->RenderThreadFrameFinished();
     }
     RenderThreadData::ShutDown();
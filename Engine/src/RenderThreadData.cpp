@@ -7,15 +7,44 @@ namespace Engine
 {
   RenderThreadData* RenderThreadData::s_instance = nullptr;
 
+  static uint32_t const DefaultTextureUploadBudget = 4 * 1024 * 1024;
+
+  RenderThreadData::RenderThreadData()
+    : textureUploadBudget(DefaultTextureUploadBudget)
+  {
+
+  }
+
+  //Mid grey, so unloaded surfaces neither stand out nor look finished.
+  static void CreatePlaceholderTexture(RT_Texture2D & a_texture, RT_Texture2DArray & a_array)
+  {
+    RGBA * pPixels = new RGBA[4];
+    for (int i = 0; i < 4; i++)
+      pPixels[i].data = (i == 0 || i == 3) ? 0xFF808080 : 0xFF606060;
+
+    TextureFlags flags;
+    flags.SetFilter(TextureFilter::Nearest);
+    flags.SetWrap(TextureWrap::Repeat);
+    flags.SetIsMipmapped(false);
+
+    TextureData data(2, 2, pPixels, flags);
+    a_texture.Init(data);
+    a_array.Init(&data, 1);
+    data.Clear();
+  }
+
   bool RenderThreadData::Init()
   {
     BSR_ASSERT(s_instance == nullptr, "RenderThreadData already intialised!");
     s_instance = new RenderThreadData();
+    CreatePlaceholderTexture(s_instance->placeholderTexture, s_instance->placeholderTextureArray);
     return true;
   }
 
   void RenderThreadData::ShutDown()
   {
+    s_instance->placeholderTexture.Destroy();
+    s_instance->placeholderTextureArray.Destroy();
     delete s_instance;
     s_instance = nullptr;
   }
@@ -3,17 +3,26 @@
 #ifndef RENDERTHREADDATA_H
 #define RENDERTHREADDATA_H
 
-#include "DgOpenHashMap.h"
+#include <vector>
+
+#include "DgDynamicArray.h"
 //#include "RT_RendererAPI.h"
 #include "RT_Buffer.h"
 #include "RT_VertexArray.h"
 #include "RT_RendererProgram.h"
 #include "RT_BindingPoint.h"
 #include "RT_Texture.h"
-#include "ResourceID.h"
+#include "RT_ResourceTable.h"
 
 namespace Engine
 {
+  struct PendingTexture
+  {
+    RenderHandle                  handle;
+    Ref<impl::TextureStaging>     staging;
+    Ref<impl::TextureStatus>      status;
+  };
+
   class RenderThreadData
   {
     static RenderThreadData* s_instance;
@@ -23,16 +32,34 @@ namespace Engine
     static void ShutDown();
     static RenderThreadData* Instance();
 
+    RenderThreadData();
+
   public:
 
-    Dg::OpenHashMap<RefID, RT_VertexArray>          VAOs;
-    Dg::OpenHashMap<RefID, RT_IndexBuffer>          IBOs;
-    Dg::OpenHashMap<RefID, RT_VertexBuffer>         VBOs;
-    Dg::OpenHashMap<RefID, RT_UniformBuffer>        UBOs;
-    Dg::OpenHashMap<RefID, RT_ShaderStorageBuffer>  SSBOs;
-    Dg::OpenHashMap<RefID, RT_BindingPoint>         bindingPoints;
-    Dg::OpenHashMap<RefID, RT_Texture2D>            textures;
-    Dg::OpenHashMap<RefID, RT_RendererProgram>      rendererPrograms;
+    RT_ResourceTable<RT_VertexArray>          VAOs;
+    RT_ResourceTable<RT_IndexBuffer>          IBOs;
+    RT_ResourceTable<RT_VertexBuffer>         VBOs;
+    RT_ResourceTable<RT_UniformBuffer>        UBOs;
+    RT_ResourceTable<RT_ShaderStorageBuffer>  SSBOs;
+    RT_ResourceTable<RT_BindingPoint>         bindingPoints;
+    RT_ResourceTable<RT_Texture2D>            textures;
+    RT_ResourceTable<RT_Texture2DArray>       textureArrays;
+    RT_ResourceTable<RT_RendererProgram>      rendererPrograms;
+
+    //Programs still being parsed or compiled. Polled once per frame.
+    Dg::DynamicArray<RenderHandle>            pendingPrograms;
+
+    //Textures being loaded asynchronously, in the order they were requested.
+    std::vector<PendingTexture>               pendingTextures;
+
+    //Bytes of asynchronously loaded texture data to upload each frame.
+    uint32_t                                  textureUploadBudget;
+
+    //Streamable textures, kept under the video memory budget
+    TextureResidency                          textureResidency;
+
+    RT_Texture2D                              placeholderTexture;
+    RT_Texture2DArray                         placeholderTextureArray;
   };
 }
 
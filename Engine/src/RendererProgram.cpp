@@ -1,54 +1,205 @@
 //@group Renderer
 
+#include <thread>
+#include <vector>
+#include <algorithm>
+#include <unordered_map>
+
 #include "RendererProgram.h"
 #include "RT_RendererProgram.h"
 #include "Renderer.h"
 #include  "core_Log.h"
 #include "Serialize.h"
 #include "RenderThreadData.h"
+#include "WorkerPool.h"
+#include "ThreadPool/gc_ThreadPool.h"
+#include "ThreadPool/gc_Job.h"
 
 namespace Engine
 {
-  void RendererProgram::Init(std::initializer_list<ShaderSourceElement> const& a_src)
+  //-----------------------------------------------------------------------------------------------
+  // ShaderParseJob
+  //-----------------------------------------------------------------------------------------------
+
+  //Reads, strips and parses the shader source off the main thread.
+  class ShaderParseJob : public GC::Job
   {
-    m_shaderData = ShaderData::Create(a_src);
+  public:
+
+    ShaderParseJob(Ref<ShaderData> const & a_shaderData, 
+                   Ref<impl::ProgramStatus> const & a_status,
+                   std::vector<ShaderSourceElement> const & a_src,
+                   ShaderDefines const & a_defines)
+      : m_shaderData(a_shaderData)
+      , m_status(a_status)
+      , m_src(a_src)
+      , m_defines(a_defines)
+      , m_ran(false)
+    {
+
+    }
+
+    //The pool drops jobs it has not started when it shuts down. The program will never
+    //be parsed, so fail it rather than leave anyone waiting.
+    ~ShaderParseJob()
+    {
+      if (!m_ran)
+        m_status->Set(impl::ProgramStatus::Failed);
+    }
+
+    void Run() override
+    {
+      m_ran = true;
+      m_shaderData->Init(m_src, m_defines);
+    }
+
+    void Done() override
+    {
+      m_status->Set(impl::ProgramStatus::Parsed);
+    }
+
+  private:
+
+    Ref<ShaderData>                   m_shaderData;
+    Ref<impl::ProgramStatus>          m_status;
+    std::vector<ShaderSourceElement>  m_src;
+    ShaderDefines                     m_defines;
+    bool                              m_ran;
+  };
+
+  //-----------------------------------------------------------------------------------------------
+  // Program cache
+  //-----------------------------------------------------------------------------------------------
+
+  //Does not hold a reference; programs remove themselves on destruction.
+  static std::unordered_map<uint64_t, impl::ResourceID64> s_programCache;
+
+  //Sorted, so the order defines are given in does not produce new variants.
+  static ShaderDefines NormaliseDefines(ShaderDefines const & a_defines)
+  {
+    ShaderDefines result(a_defines);
+    std::sort(result.begin(), result.end());
+    result.erase(std::unique(result.begin(), result.end()), result.end());
+    return result;
+  }
+
+  //Path sources are keyed on the path, not the file contents.
+  static uint64_t ProgramKey(std::vector<ShaderSourceElement> const & a_src, ShaderDefines const & a_defines)
+  {
+    uint64_t hash = Core::HashSeed64;
+    for (auto const & ele : a_src)
+    {
+      hash = Core::Hash64(&ele.domain, sizeof(ele.domain), hash);
+      hash = Core::Hash64(&ele.strType, sizeof(ele.strType), hash);
+      hash = Core::Hash64(ele.str, hash);
+    }
+
+    //Separate sources from defines
+    uint32_t const separator = 0xFFFFFFFF;
+    hash = Core::Hash64(&separator, sizeof(separator), hash);
+
+    for (auto const & define : a_defines)
+    {
+      hash = Core::Hash64(define, hash);
+      hash = Core::Hash64("\n", 1, hash);
+    }
+    return hash;
+  }
+
+  //-----------------------------------------------------------------------------------------------
+  // RendererProgram
+  //-----------------------------------------------------------------------------------------------
+
+  void RendererProgram::Init(std::vector<ShaderSourceElement> const& a_src, 
+                             ShaderDefines const & a_defines, uint64_t a_key)
+  {
+    m_src = a_src;
+    m_cacheKey = a_key;
+    m_shaderData = Ref<ShaderData>(new ShaderData());
+    m_status = Ref<impl::ProgramStatus>(new impl::ProgramStatus());
+
+    ShaderParseJob * pJob = new ShaderParseJob(m_shaderData, m_status, a_src, a_defines);
+    GC::ThreadPool * pPool = WorkerPool::Instance();
+    if (pPool != nullptr)
+    {
+      pPool->Schedule(pJob);
+    }
+    else
+    {
+      pJob->Run();
+      pJob->Done();
+      delete pJob;
+    }
 
     RenderState state = RenderState::Create();
     state.Set<RenderState::Attr::Type>(RenderState::Type::Command);
     state.Set<RenderState::Attr::Command>(RenderState::Command::RendererProgramCreate);
 
-    RENDER_SUBMIT(state, [resID = GetRefID().GetID(), shaderDataID = m_shaderData->GetRefID()]()
+    //The render thread will pick this program up once parsing has finished.
+    RENDER_SUBMIT(state, [resID = GetHandle(), 
+                          shaderDataID = m_shaderData->GetRefID(), 
+                          statusID = m_status->GetRefID()]()
     {
-      RT_RendererProgram rp(shaderDataID);
+      RT_RendererProgram rp(shaderDataID, statusID);
       RenderThreadData::Instance()->rendererPrograms.insert(resID, rp);
+      RenderThreadData::Instance()->pendingPrograms.push_back(resID);
     });
   }
 
   RendererProgram::RendererProgram()
+    : m_cacheKey(0)
   {
   
   }
 
-  Ref<RendererProgram> RendererProgram::Create(std::initializer_list<ShaderSourceElement> const& a_src)
+  Ref<RendererProgram> RendererProgram::Create(std::initializer_list<ShaderSourceElement> const& a_src,
+                                               ShaderDefines const & a_defines)
   {
+    return Create(std::vector<ShaderSourceElement>(a_src), a_defines);
+  }
+
+  Ref<RendererProgram> RendererProgram::Create(std::vector<ShaderSourceElement> const& a_src,
+                                               ShaderDefines const & a_defines)
+  {
+    ShaderDefines defines = NormaliseDefines(a_defines);
+    uint64_t key = ProgramKey(a_src, defines);
+
+    auto it = s_programCache.find(key);
+    if (it != s_programCache.end())
+    {
+      Ref<RendererProgram> ref(it->second);
+      if (!ref.IsNull())
+        return ref;
+    }
+
     RendererProgram* pRP = new RendererProgram();
     Ref<RendererProgram> ref(pRP);
-    pRP->Init(a_src);
+    pRP->Init(a_src, defines, key);
+    s_programCache[key] = pRP->GetRefID();
     return ref;
   }
 
+  Ref<RendererProgram> RendererProgram::Variant(ShaderDefines const & a_defines)
+  {
+    return Create(m_src, a_defines);
+  }
+
   RendererProgram::~RendererProgram()
   {
+    auto it = s_programCache.find(m_cacheKey);
+    if (it != s_programCache.end() && it->second.GetID() == GetRefID().GetID())
+      s_programCache.erase(it);
+
     RenderState state = RenderState::Create();
     state.Set<RenderState::Attr::Type>(RenderState::Type::Command);
     state.Set<RenderState::Attr::Command>(RenderState::Command::RendererProgramDelete);
 
-    RENDER_SUBMIT(state, [resID = GetRefID().GetID()]()
+    RENDER_SUBMIT(state, [resID = GetHandle()]()
     {
       RT_RendererProgram* pRP = RenderThreadData::Instance()->rendererPrograms.at(resID);
       if (pRP == nullptr)
       {
-        LOG_WARN("RendererProgram::~RendererProgram: RefID '{}' does not exist!", resID);
+        LOG_WARN("RendererProgram::~RendererProgram: handle '{}' does not exist!", resID.index);
         return;
       }
       pRP->Destroy();
@@ -56,8 +207,31 @@ namespace Engine
     });
   }
 
+  bool RendererProgram::IsReady() const
+  {
+    return m_status->Get() == impl::ProgramStatus::Ready;
+  }
+
+  bool RendererProgram::HasFailed() const
+  {
+    return m_status->Get() == impl::ProgramStatus::Failed;
+  }
+
+  //Returns once parsed, or failed. A program whose parse job was dropped goes straight
+  //from Parsing to Failed, with empty ShaderData.
+  void RendererProgram::WaitForParse() const
+  {
+    impl::ProgramStatus::State state = m_status->Get();
+    while (state == impl::ProgramStatus::Parsing)
+    {
+      std::this_thread::yield();
+      state = m_status->Get();
+    }
+  }
+
   uint32_t RendererProgram::UniformBufferSize() const
   {
+    WaitForParse();
     return m_shaderData->GetUniformDataSize();
   }
 
@@ -68,16 +242,16 @@ namespace Engine
     state.Set<RenderState::Attr::Command>(RenderState::Command::RendererProgramInit);
     ShaderSource * ptr = new ShaderSource(a_src);
 
-    RENDER_SUBMIT(state, [resID = GetRefID().GetID(), ptr = ptr]()
+    RENDER_SUBMIT(state, [resID = GetHandle(), ptr = ptr]()
     {
       RT_RendererProgram* pRP = RenderThreadData::Instance()->rendererPrograms.at(resID);
       if (pRP == nullptr)
       {
-        LOG_WARN("RendererProgram::Init: RefID '{}' does not exist!", resID);
+        LOG_WARN("RendererProgram::Init: handle '{}' does not exist!", resID.index);
         return;
       }
       if (!pRP->Init(*ptr))
-        LOG_WARN("RendererProgram::Init: Failed! RefID: {}", resID);
+        LOG_WARN("RendererProgram::Init: Failed! handle: {}", resID.index);
       delete ptr;
     });
   }*/
@@ -88,12 +262,12 @@ namespace Engine
     state.Set<RenderState::Attr::Type>(RenderState::Type::Command);
     state.Set<RenderState::Attr::Command>(RenderState::Command::RendererProgramDestroy);
 
-    RENDER_SUBMIT(state, [resID = GetRefID().GetID()]()
+    RENDER_SUBMIT(state, [resID = GetHandle()]()
     {
       RT_RendererProgram* pRP = RenderThreadData::Instance()->rendererPrograms.at(resID);
       if (pRP == nullptr)
       {
-        LOG_WARN("RendererProgram::Destroy: RefID '{}' does not exist!", resID);
+        LOG_WARN("RendererProgram::Destroy: handle '{}' does not exist!", resID.index);
         return;
       }
       pRP->Destroy();
@@ -106,12 +280,12 @@ namespace Engine
     state.Set<RenderState::Attr::Type>(RenderState::Type::Command);
     state.Set<RenderState::Attr::Command>(RenderState::Command::RendererProgramBind);
 
-    RENDER_SUBMIT(state, [resID = GetRefID().GetID()]()
+    RENDER_SUBMIT(state, [resID = GetHandle()]()
     {
       RT_RendererProgram* pRP = RenderThreadData::Instance()->rendererPrograms.at(resID);
       if (pRP == nullptr)
       {
-        LOG_WARN("RendererProgram::Bind: RefID '{}' does not exist!", resID);
+        LOG_WARN("RendererProgram::Bind: handle '{}' does not exist!", resID.index);
         return;
       }
       pRP->Bind();
@@ -124,12 +298,12 @@ namespace Engine
     state.Set<RenderState::Attr::Type>(RenderState::Type::Command);
     state.Set<RenderState::Attr::Command>(RenderState::Command::RendererProgramUnbind);
 
-    RENDER_SUBMIT(state, [resID = GetRefID().GetID()]()
+    RENDER_SUBMIT(state, [resID = GetHandle()]()
     {
       RT_RendererProgram* pRP = RenderThreadData::Instance()->rendererPrograms.at(resID);
       if (pRP == nullptr)
       {
-        LOG_WARN("RendererProgram::Unbind: RefID '{}' does not exist!", resID);
+        LOG_WARN("RendererProgram::Unbind: handle '{}' does not exist!", resID.index);
         return;
       }
       pRP->Unbind();
@@ -142,15 +316,16 @@ namespace Engine
     state.Set<RenderState::Attr::Type>(RenderState::Type::Command);
     state.Set<RenderState::Attr::Command>(RenderState::Command::RendererProgramUploadUniform);
 
+    WaitForParse();
     byte * buf_data = (byte*)RENDER_ALLOCATE(m_shaderData->GetUniformDataSize());
     memcpy(buf_data, a_buf, m_shaderData->GetUniformDataSize());
 
-    RENDER_SUBMIT(state, [resID = GetRefID().GetID(), buf = buf_data]()
+    RENDER_SUBMIT(state, [resID = GetHandle(), buf = buf_data]()
     {
       RT_RendererProgram* pRP = RenderThreadData::Instance()->rendererPrograms.at(resID);
       if (pRP == nullptr)
       {
-        LOG_WARN("RendererProgram::UploadUniformBuffer: RefID '{}' does not exist!", resID);
+        LOG_WARN("RendererProgram::UploadUniformBuffer: handle '{}' does not exist!", resID.index);
         return;
       }
       pRP->UploadUniformBuffer(buf);
@@ -159,6 +334,7 @@ namespace Engine
 
   ShaderUniformDeclaration const* RendererProgram::FindUniformDeclaration(std::string const& a_name) const
   {
+    WaitForParse();
     for (size_t i = 0; i < m_shaderData->GetUniforms().size(); i++)
     {
       ShaderUniformDeclaration const * pdecl = &m_shaderData->GetUniforms()[i];
@@ -181,12 +357,12 @@ namespace Engine
     void* buf_data = RENDER_ALLOCATE(a_size);
     memcpy(buf_data, a_buf, a_size);
 
-    RENDER_SUBMIT(state, [resID = GetRefID().GetID(), size = a_size, buf_name = buf_name, buf_data = buf_data]()
+    RENDER_SUBMIT(state, [resID = GetHandle(), size = a_size, buf_name = buf_name, buf_data = buf_data]()
     {
       RT_RendererProgram* pRP = RenderThreadData::Instance()->rendererPrograms.at(resID);
       if (pRP == nullptr)
       {
-        LOG_WARN("RendererProgram::Bind: RefID '{}' does not exist!", resID);
+        LOG_WARN("RendererProgram::Bind: handle '{}' does not exist!", resID.index);
         return;
       }
       std::string name;
@@ -206,12 +382,12 @@ namespace Engine
     void* buf_name = RENDER_ALLOCATE(sze_name);
     Core::Serialize(buf_name, &a_name);
 
-    RENDER_SUBMIT(state, [resID = GetRefID().GetID(), size = a_size, buf_name = buf_name, buf_data = a_buf]()
+    RENDER_SUBMIT(state, [resID = GetHandle(), size = a_size, buf_name = buf_name, buf_data = a_buf]()
     {
       RT_RendererProgram* pRP = RenderThreadData::Instance()->rendererPrograms.at(resID);
       if (pRP == nullptr)
       {
-        LOG_WARN("RendererProgram::Bind: RefID '{}' does not exist!", resID);
+        LOG_WARN("RendererProgram::Bind: handle '{}' does not exist!", resID.index);
         return;
       }
       std::string name;
@@ -3,26 +3,50 @@
 #ifndef RENDERERPROGRAM_H
 #define RENDERERPROGRAM_H
 
-#include "Resource.h"
+#include <vector>
+
+#include "RenderResource.h"
 #include "ShaderUniform.h"
 #include "Memory.h"
 #include "core_utils.h"
 
 namespace Engine
 {
-  class RendererProgram : public Resource
+  namespace impl
+  {
+    class ProgramStatus;
+  }
+
+  //Shaders are parsed on a worker thread and compiled asynchronously on the render
+  //thread. Check IsReady() before drawing with the program.
+  //
+  //Programs are cached on the hash of their sources and defines. Creating a program 
+  //that already exists returns the existing one. Variants of a source share their 
+  //uniform layout. Create and Variant should only be called from the main thread.
+  class RendererProgram : public RenderResource<RendererProgram>
   {
-    void Init(std::initializer_list<ShaderSourceElement> const&);
+    void Init(std::vector<ShaderSourceElement> const&, ShaderDefines const&, uint64_t key);
     RendererProgram();
 
     RendererProgram(RendererProgram const&) = delete;
     RendererProgram& operator=(RendererProgram const&) = delete;
   public:
 
-    static Ref<RendererProgram> Create(std::initializer_list<ShaderSourceElement> const&);
+    static Ref<RendererProgram> Create(std::initializer_list<ShaderSourceElement> const&,
+                                       ShaderDefines const & = ShaderDefines());
+    static Ref<RendererProgram> Create(std::vector<ShaderSourceElement> const&,
+                                       ShaderDefines const & = ShaderDefines());
+
+    //Get or create this program compiled with a different set of defines.
+    Ref<RendererProgram> Variant(ShaderDefines const&);
 
     ~RendererProgram();
 
+    //Compiled, linked and uniforms resolved.
+    bool IsReady() const;
+    bool HasFailed() const;
+
+    //These will block until parsing has finished.
     uint32_t UniformBufferSize() const;
 
     void Destroy();
@@ -39,11 +63,19 @@ namespace Engine
     void Bind();
     void Unbind();
 
+  private:
+
+    void WaitForParse() const;
+
   private:
     //TODO this needs to be Ref<ShaderData const>
     // Now that we have access to the uniform data, we can create a buffer to transform
     // uniforms over to the render thread
     Ref<ShaderData> m_shaderData;
+    Ref<impl::ProgramStatus> m_status;
+
+    std::vector<ShaderSourceElement> m_src;
+    uint64_t m_cacheKey;
   };
 }
 
@@ -2,6 +2,9 @@
 
 #include <fstream>
 #include <sstream>
+#include <unordered_map>
+#include <ctype.h>
+#include <stdlib.h>
 
 #include "ShaderSource.h"
 #include "Serialize.h"
@@ -12,51 +15,333 @@ namespace Engine
   //------------------------------------------------------------------------------------------------
   // Helpful functions
   //------------------------------------------------------------------------------------------------
+  //Line comments end before the newline. Block comments become a space, keeping any
+  //newlines inside them, so line numbers in compile errors still match the file.
   static std::string RemoveComments(std::string const& a_src)
   {
-    std::stringstream ss(a_src);
     std::string result;
-    char c;
-    while (ss.get(c))
+    result.reserve(a_src.size());
+
+    size_t i = 0;
+    while (i < a_src.size())
     {
-      if (c == '/')
+      if (a_src.compare(i, 2, "//") == 0)
+      {
+        i = a_src.find('\n', i);
+        if (i == std::string::npos)
+          break;
+      }
+      else if (a_src.compare(i, 2, "/*") == 0)
       {
-        if (ss.get(c))
+        size_t end = a_src.find("*/", i + 2);
+        end = (end == std::string::npos) ? a_src.size() : end + 2;
+        result += ' ';
+        for (; i < end; i++)
         {
-          if (c == '/')
-            ss.ignore(std::numeric_limits<std::streamsize>::max(), '\n');
-          else if (c == '*')
-          {
-            while (ss.get(c))
-            {
-              if (c == '*')
-              {
-                if (ss.get(c))
-                {
-                  if (c == '/')
-                    break;
-                }
-              }
-            }
-          }
-          else
-          {
-            result += '/';
-            result += c;
-          }
+          if (a_src[i] == '\n')
+            result += '\n';
         }
-        else
+      }
+      else
+      {
+        result += a_src[i++];
+      }
+    }
+    return result;
+  }
+
+  //Removes backslash-newline pairs, so a directive continued over several lines is
+  //read as one.
+  static std::string JoinContinuedLines(std::string const & a_src)
+  {
+    std::string result;
+    result.reserve(a_src.size());
+
+    size_t i = 0;
+    while (i < a_src.size())
+    {
+      if (a_src[i] == '\\')
+      {
+        if (a_src.compare(i + 1, 1, "\n") == 0)
         {
-          result += c;
-          break;
+          i += 2;
+          continue;
         }
+        if (a_src.compare(i + 1, 2, "\r\n") == 0)
+        {
+          i += 3;
+          continue;
+        }
+      }
+      result += a_src[i++];
+    }
+    return result;
+  }
+
+  //Index of the first character which is neither whitespace nor part of a comment
+  static size_t SkipWhitespaceAndComments(std::string const & a_src, size_t a_pos)
+  {
+    while (a_pos < a_src.size())
+    {
+      if (isspace(static_cast<unsigned char>(a_src[a_pos])))
+      {
+        a_pos++;
+      }
+      else if (a_src.compare(a_pos, 2, "//") == 0)
+      {
+        a_pos = a_src.find('\n', a_pos);
+        if (a_pos == std::string::npos)
+          return a_src.size();
+      }
+      else if (a_src.compare(a_pos, 2, "/*") == 0)
+      {
+        size_t end = a_src.find("*/", a_pos + 2);
+        if (end == std::string::npos)
+          return a_src.size();
+        a_pos = end + 2;
+      }
+      else
+      {
+        break;
+      }
+    }
+    return a_pos;
+  }
+
+  //------------------------------------------------------------------------------------------------
+  // Preprocessor
+  //------------------------------------------------------------------------------------------------
+
+  //Object-like macros only; function-like macros are left alone. Name to replacement.
+  typedef std::unordered_map<std::string, std::string> MacroTable;
+
+  //Stops macros which expand to themselves
+  static int const MaxExpansionDepth = 16;
+
+  static bool IsIdentifierStart(char a_c)
+  {
+    return a_c == '_' || isalpha(static_cast<unsigned char>(a_c));
+  }
+
+  static bool IsIdentifierChar(char a_c)
+  {
+    return a_c == '_' || isalnum(static_cast<unsigned char>(a_c));
+  }
+
+  //Skips leading whitespace. Empty if no identifier follows.
+  static std::string ReadIdentifier(std::string const & a_str, size_t & a_pos)
+  {
+    while (a_pos < a_str.size() && isspace(static_cast<unsigned char>(a_str[a_pos])))
+      a_pos++;
+
+    size_t start = a_pos;
+    if (a_pos < a_str.size() && IsIdentifierStart(a_str[a_pos]))
+    {
+      while (a_pos < a_str.size() && IsIdentifierChar(a_str[a_pos]))
+        a_pos++;
+    }
+    return a_str.substr(start, a_pos - start);
+  }
+
+  static std::string ExpandMacros(std::string const & a_line, MacroTable const & a_macros, int a_depth)
+  {
+    if (a_depth >= MaxExpansionDepth)
+      return a_line;
+
+    std::string result;
+    size_t i = 0;
+    while (i < a_line.size())
+    {
+      if (IsIdentifierStart(a_line[i]))
+      {
+        std::string name = ReadIdentifier(a_line, i);
+        auto it = a_macros.find(name);
+        if (it == a_macros.end())
+          result += name;
+        else
+          result += ExpandMacros(it->second, a_macros, a_depth + 1);
+      }
+      else if (isdigit(static_cast<unsigned char>(a_line[i])))
+      {
+        //Keep literals such as 0x1F or 2u whole
+        while (i < a_line.size() && IsIdentifierChar(a_line[i]))
+          result += a_line[i++];
       }
       else
-        result += c;
+      {
+        result += a_line[i++];
+      }
     }
     return result;
   }
 
+  //Evaluates the expression of an #if or #elif. Supports integers, macros, defined,
+  //parentheses, unary ! - +, and binary + - < <= > >= == != && ||. Anything else
+  //evaluates to 0, as do undefined names.
+  class ConditionParser
+  {
+  public:
+
+    ConditionParser(std::string const & a_expr, MacroTable const & a_macros, int a_depth)
+      : m_expr(a_expr)
+      , m_pos(0)
+      , m_macros(a_macros)
+      , m_depth(a_depth)
+    {
+
+    }
+
+    long long Evaluate()
+    {
+      return ParseOr();
+    }
+
+  private:
+
+    bool Match(char const * a_op)
+    {
+      while (m_pos < m_expr.size() && isspace(static_cast<unsigned char>(m_expr[m_pos])))
+        m_pos++;
+
+      size_t length = strlen(a_op);
+      if (m_expr.compare(m_pos, length, a_op) != 0)
+        return false;
+      m_pos += length;
+      return true;
+    }
+
+    long long ParseOr()
+    {
+      long long value = ParseAnd();
+      while (Match("||"))
+      {
+        long long rhs = ParseAnd();
+        value = (value != 0 || rhs != 0) ? 1 : 0;
+      }
+      return value;
+    }
+
+    long long ParseAnd()
+    {
+      long long value = ParseEquality();
+      while (Match("&&"))
+      {
+        long long rhs = ParseEquality();
+        value = (value != 0 && rhs != 0) ? 1 : 0;
+      }
+      return value;
+    }
+
+    long long ParseEquality()
+    {
+      long long value = ParseRelational();
+      for (;;)
+      {
+        if (Match("=="))
+          value = (value == ParseRelational()) ? 1 : 0;
+        else if (Match("!="))
+          value = (value != ParseRelational()) ? 1 : 0;
+        else
+          return value;
+      }
+    }
+
+    long long ParseRelational()
+    {
+      long long value = ParseAdditive();
+      for (;;)
+      {
+        if (Match("<="))
+          value = (value <= ParseAdditive()) ? 1 : 0;
+        else if (Match(">="))
+          value = (value >= ParseAdditive()) ? 1 : 0;
+        else if (Match("<"))
+          value = (value < ParseAdditive()) ? 1 : 0;
+        else if (Match(">"))
+          value = (value > ParseAdditive()) ? 1 : 0;
+        else
+          return value;
+      }
+    }
+
+    long long ParseAdditive()
+    {
+      long long value = ParseUnary();
+      for (;;)
+      {
+        if (Match("+"))
+          value += ParseUnary();
+        else if (Match("-"))
+          value -= ParseUnary();
+        else
+          return value;
+      }
+    }
+
+    long long ParseUnary()
+    {
+      if (Match("!"))
+        return ParseUnary() == 0 ? 1 : 0;
+      if (Match("-"))
+        return -ParseUnary();
+      if (Match("+"))
+        return ParseUnary();
+      return ParsePrimary();
+    }
+
+    long long ParsePrimary()
+    {
+      if (Match("("))
+      {
+        long long value = ParseOr();
+        Match(")");
+        return value;
+      }
+
+      if (m_pos >= m_expr.size())
+        return 0;
+
+      if (IsIdentifierStart(m_expr[m_pos]))
+      {
+        std::string name = ReadIdentifier(m_expr, m_pos);
+        if (name == "defined")
+        {
+          bool paren = Match("(");
+          std::string macro = ReadIdentifier(m_expr, m_pos);
+          if (paren)
+            Match(")");
+          return m_macros.count(macro) != 0 ? 1 : 0;
+        }
+
+        auto it = m_macros.find(name);
+        if (it == m_macros.end() || m_depth + 1 >= MaxExpansionDepth)
+          return 0;
+        return ConditionParser(it->second, m_macros, m_depth + 1).Evaluate();
+      }
+
+      if (isdigit(static_cast<unsigned char>(m_expr[m_pos])))
+      {
+        char const * pStart = m_expr.c_str() + m_pos;
+        char * pEnd = nullptr;
+        long long value = strtoll(pStart, &pEnd, 0);
+        m_pos += size_t(pEnd - pStart);
+        while (m_pos < m_expr.size() && IsIdentifierChar(m_expr[m_pos])) //Suffixes, eg 1u
+          m_pos++;
+        return value;
+      }
+
+      m_pos++;
+      return 0;
+    }
+
+  private:
+
+    std::string const & m_expr;
+    size_t              m_pos;
+    MacroTable const &  m_macros;
+    int                 m_depth;
+  };
+
   //------------------------------------------------------------------------------------------------
   // ShaderSourceElement
   //------------------------------------------------------------------------------------------------
@@ -85,6 +370,11 @@ namespace Engine
   }
 
   void ShaderSource::Init(std::initializer_list<ShaderSourceElement> const& a_list)
+  {
+    Init(std::vector<ShaderSourceElement>(a_list));
+  }
+
+  void ShaderSource::Init(std::vector<ShaderSourceElement> const& a_list)
   {
     Clear();
 
@@ -118,6 +408,140 @@ namespace Engine
     return m_src[static_cast<uint32_t>(a_domain)];
   }
 
+  void ShaderSource::ApplyDefines(ShaderDefines const & a_defines)
+  {
+    if (a_defines.empty())
+      return;
+
+    std::string defineStr;
+    for (auto const & define : a_defines)
+      defineStr += "#define " + define + "\n";
+
+    for (uint32_t i = 0; i < ShaderDomain_COUNT; i++)
+    {
+      std::string & src = m_src[i];
+      if (src.empty())
+        continue;
+
+      //Defines go after #version, which must be the first directive. Only comments
+      //and whitespace may come before it.
+      size_t pos = 0;
+      size_t first = SkipWhitespaceAndComments(src, 0);
+      size_t directivePos = first + 1;
+      if (first < src.size() && src[first] == '#' && ReadIdentifier(src, directivePos) == "version")
+      {
+        //End of the line, not counting newlines inside a block comment
+        pos = directivePos;
+        while (pos < src.size() && src[pos] != '\n')
+        {
+          if (src.compare(pos, 2, "/*") == 0)
+          {
+            size_t end = src.find("*/", pos + 2);
+            pos = (end == std::string::npos) ? src.size() : end + 2;
+          }
+          else
+          {
+            pos++;
+          }
+        }
+
+        if (pos == src.size())
+          src += '\n';
+        pos++;
+      }
+
+      src.insert(pos, defineStr);
+    }
+  }
+
+  std::string ShaderSource::GetPreprocessed(ShaderDomain a_domain) const
+  {
+    struct Branch
+    {
+      bool parentActive;
+      bool taken;       //A branch of this #if has been taken
+    };
+
+    std::vector<Branch> branches;
+    MacroTable macros;
+    bool active = true;
+    std::string result;
+
+    //As a C preprocessor would: continued lines are joined before comments are removed
+    std::stringstream ss(RemoveComments(JoinContinuedLines(Get(a_domain))));
+    std::string line;
+    while (std::getline(ss, line))
+    {
+      size_t pos = line.find_first_not_of(" \t\r");
+      if (pos == std::string::npos || line[pos] != '#')
+      {
+        if (active)
+          result += ExpandMacros(line, macros, 0) + '\n';
+        continue;
+      }
+
+      pos++;
+      std::string directive = ReadIdentifier(line, pos);
+
+      if (directive == "if" || directive == "ifdef" || directive == "ifndef")
+      {
+        bool condition = false;
+        if (active && directive == "if")
+          condition = ConditionParser(line.substr(pos), macros, 0).Evaluate() != 0;
+        else if (active)
+          condition = (macros.count(ReadIdentifier(line, pos)) != 0) == (directive == "ifdef");
+
+        branches.push_back(Branch{active, condition});
+        active = condition;
+        continue;
+      }
+
+      if (directive == "elif" || directive == "else")
+      {
+        if (branches.empty())
+          continue;
+
+        Branch & branch = branches.back();
+        active = branch.parentActive && !branch.taken;
+        if (active && directive == "elif")
+          active = ConditionParser(line.substr(pos), macros, 0).Evaluate() != 0;
+        branch.taken = branch.taken || active;
+        continue;
+      }
+
+      if (directive == "endif")
+      {
+        if (branches.empty())
+          continue;
+
+        active = branches.back().parentActive;
+        branches.pop_back();
+        continue;
+      }
+
+      if (!active)
+        continue;
+
+      if (directive == "define")
+      {
+        std::string name = ReadIdentifier(line, pos);
+        if (!name.empty() && (pos >= line.size() || line[pos] != '('))
+        {
+          size_t valueStart = line.find_first_not_of(" \t", pos);
+          size_t valueEnd = line.find_last_not_of(" \t\r");
+          macros[name] = valueStart == std::string::npos ? std::string() : line.substr(valueStart, valueEnd - valueStart + 1);
+        }
+      }
+      else if (directive == "undef")
+      {
+        macros.erase(ReadIdentifier(line, pos));
+      }
+
+      result += line + '\n';
+    }
+    return result;
+  }
+
   void ShaderSource::Clear()
   {
     for (uint32_t i = 0; i < ShaderDomain_COUNT; i++)
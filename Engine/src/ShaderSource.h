@@ -4,6 +4,7 @@
 #define SHADERSOURCE_H
 
 #include <string>
+#include <vector>
 #include "ShaderUtils.h"
 
 namespace Engine
@@ -14,6 +15,9 @@ namespace Engine
     Path
   };
 
+  //Each entry is the text following '#define', eg "USE_FOG" or "MAX_LIGHTS 4"
+  typedef std::vector<std::string> ShaderDefines;
+
   struct ShaderSourceElement
   {
     ShaderDomain  domain;
@@ -31,8 +35,16 @@ namespace Engine
     ShaderSource();
     ShaderSource(std::initializer_list<ShaderSourceElement> const&);
     void Init(std::initializer_list<ShaderSourceElement> const&);
+    void Init(std::vector<ShaderSourceElement> const&);
     std::string const& Get(ShaderDomain) const;
 
+    //Inserts the defines after the #version directive of each stage.
+    void ApplyDefines(ShaderDefines const &);
+
+    //The stage as the compiler sees it: branches of #if, #ifdef and #ifndef which are
+    //not taken are removed, and object-like macros are expanded. Used for reflection.
+    std::string GetPreprocessed(ShaderDomain) const;
+
     void Clear();
 
   private:
@@ -17,6 +17,8 @@
 */
 
 #include <regex>
+#include <mutex>
+#include <unordered_map>
 
 #include "DgStringFunctions.h"
 
@@ -244,10 +246,14 @@ namespace Engine
     }
 
     byte const * pSrc = static_cast<byte const *>(a_data);
+    if (padding == 0)
+      return Core::Serialize<byte>(buf, pSrc, size_t(dataSize) * count);
+
     for (uint32_t c = 0; c < count; c++)
     {
       buf = Core::Serialize<byte>(buf, pSrc, dataSize);
       buf = Core::AdvancePtr(buf, padding);
+      pSrc += dataSize;
     }
 
     return buf;
@@ -426,7 +432,7 @@ namespace Engine
     state.Set<RenderState::Attr::Type>(RenderState::Type::Command);
     state.Set<RenderState::Attr::Command>(RenderState::Command::BindingPointCreate);
 
-    RENDER_SUBMIT(state, [resID = GetRefID().GetID(), sbtype = a_type, domain = a_domain]()
+    RENDER_SUBMIT(state, [resID = GetHandle(), sbtype = a_type, domain = a_domain]()
     {
       ::Engine::RT_BindingPoint bp;
       if (!bp.Capture(sbtype, domain))
@@ -441,12 +447,12 @@ namespace Engine
     state.Set<RenderState::Attr::Type>(RenderState::Type::Command);
     state.Set<RenderState::Attr::Command>(RenderState::Command::BindingPointDelete);
 
-    RENDER_SUBMIT(state, [resID = GetRefID().GetID()]()
+    RENDER_SUBMIT(state, [resID = GetHandle()]()
     {
       ::Engine::RT_BindingPoint * pbp = ::Engine::RenderThreadData::Instance()->bindingPoints.at(resID);
       if (pbp == nullptr)
       {
-        LOG_WARN("BindingPoint::~BindingPoint(): RefID '{}' does not exist!", resID);
+        LOG_WARN("BindingPoint::~BindingPoint(): handle '{}' does not exist!", resID.index);
         return;
       }
 
@@ -504,11 +510,62 @@ namespace Engine
   static bool IsTypeStringTexture(const std::string& type)
   {
     if (type == "sampler2D")		return true;
+    if (type == "sampler2DArray")	return true;
     if (type == "samplerCube")		return true;
     if (type == "sampler2DShadow")	return true;
     return false;
   }
 
+  //---------------------------------------------------------------------------------------------------
+  // ShaderUniformLayout
+  //---------------------------------------------------------------------------------------------------
+
+  static uint64_t HashUniforms(ShaderUniformList const & a_list, uint64_t a_hash)
+  {
+    uint32_t size = uint32_t(a_list.size());
+    a_hash = Core::Hash64(&size, sizeof(size), a_hash);
+    for (auto const & uniform : a_list)
+    {
+      ShaderDataType type = uniform.GetType();
+      uint32_t count = uniform.GetCount();
+      a_hash = Core::Hash64(uniform.GetName(), a_hash);
+      a_hash = Core::Hash64(&type, sizeof(type), a_hash);
+      a_hash = Core::Hash64(&count, sizeof(count), a_hash);
+    }
+    return a_hash;
+  }
+
+  static bool UniformsEqual(ShaderUniformList const & a_list_0, ShaderUniformList const & a_list_1)
+  {
+    if (a_list_0.size() != a_list_1.size())
+      return false;
+
+    for (size_t i = 0; i < a_list_0.size(); i++)
+    {
+      if (!(a_list_0[i] == a_list_1[i]))
+        return false;
+    }
+    return true;
+  }
+
+  uint64_t ShaderUniformLayout::Hash() const
+  {
+    uint64_t hash = Core::Hash64(&dataSize, sizeof(dataSize));
+    hash = HashUniforms(uniforms, hash);
+    return HashUniforms(textures, hash);
+  }
+
+  bool operator==(ShaderUniformLayout const & a_layout_0, ShaderUniformLayout const & a_layout_1)
+  {
+    return a_layout_0.dataSize == a_layout_1.dataSize
+      && UniformsEqual(a_layout_0.uniforms, a_layout_1.uniforms)
+      && UniformsEqual(a_layout_0.textures, a_layout_1.textures);
+  }
+
+  //Parsing happens on worker threads, so access to the registry is locked.
+  static std::mutex s_layoutMutex;
+  static std::unordered_map<uint64_t, std::weak_ptr<ShaderUniformLayout>> s_layouts;
+
   //---------------------------------------------------------------------------------------------------
   // ShaderData
   //---------------------------------------------------------------------------------------------------
@@ -519,45 +576,74 @@ namespace Engine
   }
   
   ShaderData::ShaderData()
-    : m_dataSize(0)
+    : m_layout(new ShaderUniformLayout())
   {
 
   }
 
   ShaderData::ShaderData(std::initializer_list<ShaderSourceElement> const& a_data)
-    : m_dataSize(0)
+    : m_layout(new ShaderUniformLayout())
   {
     Init(a_data);
   }
 
   void ShaderData::Init(std::initializer_list<ShaderSourceElement> const& a_data)
+  {
+    Init(std::vector<ShaderSourceElement>(a_data));
+  }
+
+  void ShaderData::Init(std::vector<ShaderSourceElement> const& a_data, ShaderDefines const & a_defines)
   {
     Clear();
     m_source.Init(a_data);
+    m_source.ApplyDefines(a_defines);
+
+    //Reflect what the compiler will see, so uniforms a variant compiles out are not
+    //in its layout. Variants which end up with the same uniforms still share one.
     Parse();
     PostProcess();
+    ShareLayout();
     Log();
   }
 
   void ShaderData::Log()
   {
-    for (auto& un : m_uniforms)
+    for (auto& un : m_layout->uniforms)
       un.Log();
   }
 
   void ShaderData::Clear()
   {
-    m_uniforms.clear();
-    //m_textures.clear();
+    //Never clear in place, the layout may be shared.
+    m_layout = std::make_shared<ShaderUniformLayout>();
+  }
+
+  void ShaderData::ShareLayout()
+  {
+    uint64_t hash = m_layout->Hash();
+
+    std::lock_guard<std::mutex> lock(s_layoutMutex);
+    std::weak_ptr<ShaderUniformLayout> & entry = s_layouts[hash];
+    std::shared_ptr<ShaderUniformLayout> existing = entry.lock();
+    if (existing != nullptr && *existing == *m_layout)
+      m_layout = existing;
+    else if (existing == nullptr)
+      entry = m_layout;
+  }
+
+  bool ShaderData::SharesLayoutWith(ShaderData const & a_other) const
+  {
+    return m_layout == a_other.m_layout;
   }
 
   void ShaderData::Parse()
   {
     for (int i = 0; i < ShaderDomain_COUNT; i++)
     {
+      std::string src = m_source.GetPreprocessed(ShaderDomain(i));
       ShaderStructList structList;
-      ExtractStructs(ShaderDomain(i), structList);
-      ExtractUniforms(ShaderDomain(i), structList);
+      ExtractStructs(src, structList);
+      ExtractUniforms(ShaderDomain(i), src, structList);
       //ExtractUniformBlocks(ShaderDomain(i));
     }
   }
@@ -565,17 +651,17 @@ namespace Engine
   void ShaderData::PostProcess()
   {
     uint32_t offset = 0;
-    for (auto & uniform : m_uniforms)
+    for (auto & uniform : m_layout->uniforms)
     {
       uniform.SetDataOffset(offset);
       offset += uniform.GetDataSize();
     }
-    m_dataSize = offset;
+    m_layout->dataSize = offset;
   }
 
-  void ShaderData::ExtractStructs(ShaderDomain a_domain, ShaderStructList & a_out)
+  void ShaderData::ExtractStructs(std::string const & a_src, ShaderStructList & a_out)
   {
-    std::string subject = m_source.Get(a_domain);
+    std::string subject = a_src;
 
     std::smatch match;
     std::regex r(STRUCT_EXPRESSION);
@@ -614,10 +700,9 @@ namespace Engine
     }
   }
 
-  void ShaderData::ExtractUniforms(ShaderDomain a_domain, ShaderStructList const & a_structs)
+  void ShaderData::ExtractUniforms(ShaderDomain a_domain, std::string const & a_src, ShaderStructList const & a_structs)
   {
-    std::string subject = m_source.Get(a_domain);
-    varDeclList vars = FindUniformDecls(subject);
+    varDeclList vars = FindUniformDecls(a_src);
 
     for (auto const& var : vars)
     {
@@ -658,7 +743,7 @@ namespace Engine
 
   void ShaderData::PushUniform(ShaderUniformDeclaration a_decl)
   {
-    for (ShaderUniformDeclaration& decl: m_uniforms)
+    for (ShaderUniformDeclaration& decl: m_layout->uniforms)
     {
       if (a_decl == decl)
       {
@@ -666,12 +751,12 @@ namespace Engine
         return;
       }
     }
-    m_uniforms.push_back(a_decl);
+    m_layout->uniforms.push_back(a_decl);
   }
 
-  ShaderUniformDeclaration* ShaderData::FindUniform(std::string const& a_name)
+  ShaderUniformDeclaration const * ShaderData::FindUniform(std::string const& a_name) const
   {
-    for (ShaderUniformDeclaration& uniform : m_uniforms)
+    for (ShaderUniformDeclaration const & uniform : m_layout->uniforms)
     {
       if (uniform.GetName() == a_name)
         return &uniform;
@@ -679,11 +764,11 @@ namespace Engine
     return nullptr;
   }
 
-  uint32_t ShaderData::FindUniformIndex(std::string const& a_name)
+  uint32_t ShaderData::FindUniformIndex(std::string const& a_name) const
   {
-    for (uint32_t i = 0; i < uint32_t(m_uniforms.size()); i++)
+    for (uint32_t i = 0; i < uint32_t(m_layout->uniforms.size()); i++)
     {
-      if (m_uniforms[i].GetName() == a_name)
+      if (m_layout->uniforms[i].GetName() == a_name)
         return i;
     }
     return INVALID_INDEX;
@@ -691,7 +776,7 @@ namespace Engine
 
   uint32_t ShaderData::GetUniformDataSize() const
   {
-    return m_dataSize;
+    return m_layout->dataSize;
   }
 
   ShaderSource const& ShaderData::GetShaderSource() const
@@ -701,11 +786,11 @@ namespace Engine
 
   ShaderUniformList const& ShaderData::GetUniforms() const
   {
-    return m_uniforms;
+    return m_layout->uniforms;
   }
 
-  ShaderUniformList& ShaderData::GetUniforms()
+  ShaderUniformList const& ShaderData::GetTextures() const
   {
-    return m_uniforms;
+    return m_layout->textures;
   }
 }
\ No newline at end of file
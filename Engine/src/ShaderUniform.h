@@ -20,11 +20,12 @@
 #define SHADERUNIFORM_H
 
 #include <string>
+#include <memory>
 #include <stdint.h>
 #include "DgDynamicArray.h"
 #include "core_Assert.h"
 #include "Memory.h"
-#include "Resource.h"
+#include "RenderResource.h"
 #include "ShaderUtils.h"
 #include "ShaderSource.h"
 
@@ -67,6 +68,7 @@ namespace Engine
 
   //A data type of STRUCT will just be padding. This can be used 
   //to pad out the front and back of a struct.
+  //For layouts known at compile time, prefer std140Packer (std140Packer.h).
   class std140ItemDeclaration
   {
   public:
@@ -169,6 +171,18 @@ namespace Engine
 
   typedef Dg::DynamicArray<ShaderUniformDeclaration> ShaderUniformList;
 
+  //Reflected uniforms of a program. Never modified once shared; programs with
+  //identical uniforms (typically variants of the same source) share one instance.
+  struct ShaderUniformLayout
+  {
+    uint32_t          dataSize = 0;
+    ShaderUniformList uniforms;
+    ShaderUniformList textures;
+
+    uint64_t Hash() const;
+    friend bool operator==(ShaderUniformLayout const&, ShaderUniformLayout const&);
+  };
+
   class ShaderData : public Resource
   {
   public:
@@ -179,17 +193,19 @@ namespace Engine
     static Ref<ShaderData> Create(std::initializer_list<ShaderSourceElement> const&);
 
     void Init(std::initializer_list<ShaderSourceElement> const&);
+    void Init(std::vector<ShaderSourceElement> const&, ShaderDefines const & = ShaderDefines());
 
     void Clear();
-    ShaderUniformDeclaration* FindUniform(std::string const&);
-    uint32_t FindUniformIndex(std::string const&);
+    ShaderUniformDeclaration const * FindUniform(std::string const&) const;
+    uint32_t FindUniformIndex(std::string const&) const;
 
     uint32_t GetUniformDataSize() const;
     ShaderSource const & GetShaderSource() const;
     ShaderUniformList const & GetUniforms() const;
-    ShaderUniformList & GetUniforms();
     ShaderUniformList const & GetTextures() const;
-    ShaderUniformList & GetTextures();
+
+    //True if both refer to the same layout instance.
+    bool SharesLayoutWith(ShaderData const &) const;
 
     //DEBUG
     void Log();
@@ -200,19 +216,18 @@ namespace Engine
 
     void Parse();
     void PostProcess();
-    void ExtractStructs(ShaderDomain, ShaderStructList &);
-    void ExtractUniforms(ShaderDomain, ShaderStructList const &);
+    void ExtractStructs(std::string const & src, ShaderStructList &);
+    void ExtractUniforms(ShaderDomain, std::string const & src, ShaderStructList const &);
     static size_t FindStruct(std::string const &, ShaderStructList const &);
     void PushUniform(ShaderUniformDeclaration);
+    void ShareLayout();
   private:
-    uint32_t            m_dataSize;
 
-    ShaderSource        m_source;
-    ShaderUniformList   m_uniforms;
-    ShaderUniformList   m_textures;
+    ShaderSource                          m_source;
+    std::shared_ptr<ShaderUniformLayout>  m_layout;
   };
 
-  class BindingPoint : public Resource
+  class BindingPoint : public RenderResource<BindingPoint>
   {
     void Init(StorageBlockType, ShaderDomain);
     BindingPoint();
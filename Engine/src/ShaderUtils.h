@@ -33,6 +33,7 @@ namespace Engine
     MAT4x2, MAT4x3,
 
     TEXTURE2D,
+    TEXTURE2DARRAY,
     //TEXTURECUBE
 
     STRUCT //This must always be last. Do I even need this?
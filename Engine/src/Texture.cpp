@@ -5,10 +5,92 @@
 #include "Renderer.h"
 #include "RT_Texture.h"
 #include "RenderThreadData.h"
+#include "DgMath.h"
+#include "WorkerPool.h"
+#include "ThreadPool/gc_ThreadPool.h"
+#include "ThreadPool/gc_Job.h"
 
 namespace Engine
 {
+  //-----------------------------------------------------------------------------------------------
+  // TextureLoadJob
+  //-----------------------------------------------------------------------------------------------
+
+  TextureLoadOptions::TextureLoadOptions()
+    : generateMipmaps(false)
+    , format(TextureFormat::RGBA8)
+  {
+
+  }
+
+  //Decodes and converts a texture off the main thread.
+  class TextureLoadJob : public GC::Job
+  {
+  public:
+
+    TextureLoadJob(Ref<impl::TextureStaging> const & a_staging,
+                   Ref<impl::TextureStatus> const & a_status,
+                   Texture2D::Decoder const & a_decoder,
+                   TextureLoadOptions const & a_opts)
+      : m_staging(a_staging)
+      , m_status(a_status)
+      , m_decoder(a_decoder)
+      , m_opts(a_opts)
+      , m_result(false)
+      , m_ran(false)
+    {
+
+    }
+
+    //The pool drops jobs it has not started when it shuts down. The texture will never
+    //be decoded, so fail it rather than leave it on the placeholder.
+    ~TextureLoadJob()
+    {
+      if (m_ran)
+        return;
+
+      m_staging->data.Clear();
+      m_status->Set(impl::TextureStatus::Failed);
+    }
+
+    void Run() override
+    {
+      m_ran = true;
+      TextureData & data = m_staging->data;
+      m_result = m_decoder(data) && data.pPixels != nullptr;
+      if (!m_result)
+        return;
+
+      if (m_opts.generateMipmaps)
+        data.GenerateMipmaps(m_opts.mipmapOptions);
+
+      if (m_opts.format != TextureFormat::RGBA8)
+        m_result = data.Compress(m_opts.format);
+    }
+
+    void Done() override
+    {
+      if (!m_result)
+        m_staging->data.Clear();
+      m_status->Set(m_result ? impl::TextureStatus::Decoded : impl::TextureStatus::Failed);
+    }
+
+  private:
+
+    Ref<impl::TextureStaging>   m_staging;
+    Ref<impl::TextureStatus>    m_status;
+    Texture2D::Decoder          m_decoder;
+    TextureLoadOptions          m_opts;
+    bool                        m_result;
+    bool                        m_ran;
+  };
+
+  //-----------------------------------------------------------------------------------------------
+  // Texture2D
+  //-----------------------------------------------------------------------------------------------
+
   Texture2D::Texture2D()
+    : m_keepCPUCopy(true)
   {
 
   }
@@ -18,6 +100,24 @@ namespace Engine
     return Ref<Texture2D>(new Texture2D());
   }
 
+  Ref<Texture2D> Texture2D::Clone() const
+  {
+    Texture2D * pClone = new Texture2D();
+    pClone->m_data.Duplicate(m_data);
+    pClone->m_keepCPUCopy = m_keepCPUCopy;
+    return Ref<Texture2D>(pClone);
+  }
+
+  void Texture2D::SetKeepCPUCopy(bool a_keep)
+  {
+    m_keepCPUCopy = a_keep;
+  }
+
+  TextureData const & Texture2D::GetData() const
+  {
+    return m_data;
+  }
+
   void Texture2D::Set(uint32_t a_width, uint32_t a_height, RGBA * a_pPixels, TextureFlags a_flags)
   {
     m_data.Set(a_width, a_height, a_pPixels, a_flags);
@@ -31,14 +131,10 @@ namespace Engine
     state.Set<RenderState::Attr::Type>(RenderState::Type::Command);
     state.Set<RenderState::Attr::Command>(RenderState::Command::TextureDelete);
 
-    RENDER_SUBMIT(state, [resID = GetRefID().GetID()]()
+    RENDER_SUBMIT(state, [resID = GetHandle()]()
     {
-      RT_Texture2D* pTexture =  RenderThreadData::Instance()->textures.at(resID);
-      if (pTexture == nullptr)
-        return;
-
-      pTexture->Destroy();
-      RenderThreadData::Instance()->textures.erase(resID);
+      RT_Texture2D::CancelPending(resID);
+      RT_Texture2D::Delete(resID);
     });
   }
 
@@ -48,22 +144,163 @@ namespace Engine
     state.Set<RenderState::Attr::Type>(RenderState::Type::Command);
     state.Set<RenderState::Attr::Command>(RenderState::Command::TextureCreate);
 
+    //Shares the pixels with the render thread rather than copying them
     TextureData data;
     data.Duplicate(m_data);
-    
-    RENDER_SUBMIT(state, [resID = GetRefID().GetID(), data = data]() mutable
+    if (!m_keepCPUCopy)
+      m_data.Clear();
+
+    m_status = Ref<impl::TextureStatus>();
+    m_staging = Ref<impl::TextureStaging>();
+
+    //TextureData has no destructor, so the reference must be moved in: a copy would be
+    //left behind here and never released.
+    RENDER_SUBMIT(state, [resID = GetHandle(), data = std::move(data)]() mutable
     {
-      RT_Texture2D *pTexture =  RenderThreadData::Instance()->textures.at(resID);
-      if (pTexture != nullptr)
-        pTexture->Destroy();
-      else
-        pTexture = RenderThreadData::Instance()->textures.insert(resID, RT_Texture2D());
-      
-      pTexture->Init(data);
+      RT_Texture2D::CancelPending(resID);
+      RT_Texture2D::Create(resID, data);
       data.Clear();
     });
   }
 
+  //A batch is staged in a single render allocation:
+  //
+  //  [StagedTexture x count][RendererID x count]
+  //
+  //Pixels are not copied; each StagedTexture holds a reference to the texture's pixel
+  //storage, released by the render thread once uploaded. The RendererID block is scratch
+  //space for the render thread to create the names into.
+  struct StagedTexture
+  {
+    RenderHandle  handle;
+    TextureData   data;
+  };
+
+  void Texture2D::UploadBatch(Ref<Texture2D> const * a_textures, uint32_t a_count)
+  {
+    if (a_count == 0)
+      return;
+
+    size_t size = a_count * (sizeof(StagedTexture) + sizeof(RendererID));
+    byte * pMem = static_cast<byte*>(RENDER_ALLOCATE(static_cast<uint32_t>(size)));
+
+    StagedTexture * pTextures = reinterpret_cast<StagedTexture*>(pMem);
+    RendererID * pIDs = reinterpret_cast<RendererID*>(pMem + a_count * sizeof(StagedTexture));
+
+    for (uint32_t i = 0; i < a_count; i++)
+    {
+      Texture2D * pTexture = a_textures[i].operator->();
+      StagedTexture * pStaged = new (&pTextures[i]) StagedTexture();
+      pStaged->handle = pTexture->GetHandle();
+      pStaged->data.Duplicate(pTexture->m_data);
+
+      pTexture->m_status = Ref<impl::TextureStatus>();
+      pTexture->m_staging = Ref<impl::TextureStaging>();
+      if (!pTexture->m_keepCPUCopy)
+        pTexture->m_data.Clear();
+    }
+
+    RenderState state = RenderState::Create();
+    state.Set<RenderState::Attr::Type>(RenderState::Type::Command);
+    state.Set<RenderState::Attr::Command>(RenderState::Command::TextureCreate);
+
+    RENDER_SUBMIT(state, [pTextures, pIDs, count = a_count]()
+    {
+      RT_Texture2D::CreateRendererIDs(count, pIDs);
+      for (uint32_t i = 0; i < count; i++)
+      {
+        StagedTexture & staged = pTextures[i];
+        RT_Texture2D::CancelPending(staged.handle);
+        RT_Texture2D::Create(staged.handle, staged.data, pIDs[i]);
+        staged.data.Clear();
+      }
+    });
+  }
+
+  void Texture2D::LoadAsync(Decoder const & a_decoder, TextureLoadOptions const & a_opts)
+  {
+    m_status = Ref<impl::TextureStatus>(new impl::TextureStatus());
+    m_staging = Ref<impl::TextureStaging>(new impl::TextureStaging());
+
+    TextureLoadJob * pJob = new TextureLoadJob(m_staging, m_status, a_decoder, a_opts);
+    GC::ThreadPool * pPool = WorkerPool::Instance();
+    if (pPool != nullptr)
+    {
+      pPool->Schedule(pJob);
+    }
+    else
+    {
+      pJob->Run();
+      pJob->Done();
+      delete pJob;
+    }
+
+    RenderState state = RenderState::Create();
+    state.Set<RenderState::Attr::Type>(RenderState::Type::Command);
+    state.Set<RenderState::Attr::Command>(RenderState::Command::TextureCreate);
+
+    //We hold the staging data until the render thread has picked it up. If another load
+    //was started since, this one has been superseded and the staging data is gone.
+    RENDER_SUBMIT(state, [resID = GetHandle(),
+                          stagingID = m_staging->GetRefID(),
+                          statusID = m_status->GetRefID()]()
+    {
+      RT_Texture2D::CancelPending(resID);
+
+      PendingTexture pending;
+      pending.handle = resID;
+      pending.staging = Ref<impl::TextureStaging>(stagingID);
+      pending.status = Ref<impl::TextureStatus>(statusID);
+      if (pending.staging.IsNull() || pending.status.IsNull())
+        return;
+      RenderThreadData::Instance()->pendingTextures.push_back(pending);
+    });
+  }
+
+  bool Texture2D::IsReady() const
+  {
+    return m_status.IsNull() || m_status->Get() == impl::TextureStatus::Ready;
+  }
+
+  bool Texture2D::HasFailed() const
+  {
+    return !m_status.IsNull() && m_status->Get() == impl::TextureStatus::Failed;
+  }
+
+  void Texture2D::SetUploadBudget(uint32_t a_bytes)
+  {
+    RenderState state = RenderState::Create();
+    state.Set<RenderState::Attr::Type>(RenderState::Type::Command);
+    state.Set<RenderState::Attr::Command>(RenderState::Command::TextureSetUploadBudget);
+
+    RENDER_SUBMIT(state, [bytes = a_bytes]()
+    {
+      RenderThreadData::Instance()->textureUploadBudget = bytes;
+    });
+  }
+
+  void Texture2D::SetResidencyBudget(uint64_t a_bytes)
+  {
+    RenderState state = RenderState::Create();
+    state.Set<RenderState::Attr::Type>(RenderState::Type::Command);
+    state.Set<RenderState::Attr::Command>(RenderState::Command::TextureSetResidencyBudget);
+
+    RENDER_SUBMIT(state, [bytes = a_bytes]()
+    {
+      RenderThreadData::Instance()->textureResidency.SetBudget(bytes);
+    });
+  }
+
+  TextureResidencyStats Texture2D::GetResidencyStats()
+  {
+    return RT_Texture2D::GetResidencyStats();
+  }
+
+  bool Texture2D::Resize(ResizeMethod a_method, uint32_t a_factor)
+  {
+    return ScalePixelArt(m_data, m_data, a_method, a_factor);
+  }
+
   void Texture2D::Clear()
   {
     m_data.Clear();
@@ -75,16 +312,9 @@ namespace Engine
     state.Set<RenderState::Attr::Type>(RenderState::Type::Command);
     state.Set<RenderState::Attr::Command>(RenderState::Command::TextureBindToSlot);
 
-    RENDER_SUBMIT(state, [resID = GetRefID().GetID(), slot = a_slot]()
+    RENDER_SUBMIT(state, [resID = GetHandle(), slot = a_slot]()
     {
-      RT_Texture2D* pTexture =  RenderThreadData::Instance()->textures.at(resID);
-      if (pTexture != nullptr)
-      {
-        LOG_WARN("Texture2D::Bind(): ID '{}' does not exist!", resID);
-        return;
-      }
-
-      pTexture->Bind(slot);
+      RT_Texture2D::Bind(resID, slot);
     });
   }
 }
\ No newline at end of file
@@ -20,20 +20,36 @@
 #define TEXTURE_H
 
 #include <stdint.h>
+#include <functional>
+
 #include "TextureData.h"
+#include "TextureResidency.h"
+#include "PixelScaler.h"
 #include "core_utils.h"
-#include "Resource.h"
+#include "RenderResource.h"
 #include "Memory.h"
 
 namespace Engine
 {
-  enum class ResizeMethod
+  namespace impl
+  {
+    class TextureStatus;
+    class TextureStaging;
+  }
+
+  //Conversions applied on the worker thread once a texture has been decoded.
+  struct TextureLoadOptions
   {
-    HQx,
-    BRz
+    TextureLoadOptions();
+
+    bool                generateMipmaps;
+    MipmapBuildOptions  mipmapOptions;
+
+    //RGBA8 leaves the data as decoded.
+    TextureFormat       format;
   };
 
-  class Texture2D : public Resource
+  class Texture2D : public RenderResource<Texture2D>
   {
     Texture2D();
   public:
@@ -46,17 +62,56 @@ namespace Engine
       RGBA      backgroundColor;
     };
 
+  public:
+
+    //Fills in the TextureData. Runs on a worker thread, so must not touch the renderer.
+    typedef std::function<bool(TextureData &)> Decoder;
+
   public:
 
     static Ref<Texture2D> Create();
 
+    //A new texture sharing this one's pixels. Costs nothing until one of them is edited.
+    //The clone must be uploaded separately.
+    Ref<Texture2D> Clone() const;
+
     ~Texture2D();
 
+    //The pixels are kept after uploading by default, so the texture can be edited and
+    //uploaded again. Otherwise they are released once the render thread is done with them.
+    void SetKeepCPUCopy(bool);
+
+    //Empty if the CPU copy was dropped, or the texture was loaded with LoadAsync().
+    TextureData const & GetData() const;
+
     //Once we are done loading/manipulating the texture, we need to upload it to the video card.
     void Upload();
+
+    //Uploads 'count' textures with one render command and one staging allocation.
+    static void UploadBatch(Ref<Texture2D> const * textures, uint32_t count);
     void Clear();
     void Bind(uint32_t slot = 0) const;
 
+    //Decodes and converts on the WorkerPool, then uploads on the render thread within
+    //the per-frame upload budget. A placeholder is bound until the texture is ready.
+    //If the pool is not running, decoding happens inline.
+    void LoadAsync(Decoder const &, TextureLoadOptions const & = TextureLoadOptions());
+
+    //True once the last LoadAsync() has been uploaded, or if none was started.
+    bool IsReady() const;
+    bool HasFailed() const;
+
+    //Bytes of asynchronously loaded data uploaded per frame. Defaults to 4MB.
+    static void SetUploadBudget(uint32_t bytes);
+
+    //Video memory allowed for textures flagged as streamable (TextureFlags::SetIsStreamable).
+    //Least recently used textures lose their top mip levels, then are evicted, to stay
+    //under it. They are streamed back in when next bound. 0 (the default) for no limit.
+    static void SetResidencyBudget(uint64_t bytes);
+
+    //As of the end of the last rendered frame
+    static TextureResidencyStats GetResidencyStats();
+
     void Set(uint32_t width, uint32_t height, RGBA * pixels, TextureFlags flags);
 
     //Loading...
@@ -69,7 +124,9 @@ namespace Engine
     //uint32_t GetHeight() const;
 
     //void Resize(uint32_t width, uint32_t height);
-    //void Resize(ResizeMethod, int factor);
+
+    //Upscales pixel art by 'factor' (2 to 4). Upload() must be called again afterwards.
+    bool Resize(ResizeMethod, uint32_t factor);
 
     //RGBA& GetPixel(uint32_t width, uint32_t height);
     //void SetPixel(uint32_t width, uint32_t height, RGBA value);
@@ -80,7 +137,10 @@ namespace Engine
 
   private:
 
-    TextureData m_data;
+    TextureData               m_data;
+    Ref<impl::TextureStatus>  m_status;
+    Ref<impl::TextureStaging> m_staging;
+    bool                      m_keepCPUCopy;
   };
 }
 
@@ -0,0 +1,162 @@
+//@group Renderer
+
+#include <new>
+
+#include "TextureArray.h"
+#include "RenderState.h"
+#include "Renderer.h"
+#include "RT_Texture.h"
+#include "RenderThreadData.h"
+
+namespace Engine
+{
+  //-----------------------------------------------------------------------------------------------
+  // Texture2DArray
+  //-----------------------------------------------------------------------------------------------
+
+  Texture2DArray::Texture2DArray()
+  {
+
+  }
+
+  Ref<Texture2DArray> Texture2DArray::Create()
+  {
+    return Ref<Texture2DArray>(new Texture2DArray());
+  }
+
+  Texture2DArray::~Texture2DArray()
+  {
+    Clear();
+
+    RenderState state = RenderState::Create();
+    state.Set<RenderState::Attr::Type>(RenderState::Type::Command);
+    state.Set<RenderState::Attr::Command>(RenderState::Command::TextureArrayDelete);
+
+    RENDER_SUBMIT(state, [resID = GetHandle()]()
+    {
+      RT_Texture2DArray* pTexture =  RenderThreadData::Instance()->textureArrays.at(resID);
+      if (pTexture == nullptr)
+        return;
+
+      pTexture->Destroy();
+      RenderThreadData::Instance()->textureArrays.erase(resID);
+    });
+  }
+
+  bool Texture2DArray::CanHold(TextureData const & a_data) const
+  {
+    if (m_layers.empty())
+      return true;
+
+    TextureData const & first = m_layers[0];
+    return m_layers.size() < MaxTextureArrayLayers
+      && a_data.width == first.width
+      && a_data.height == first.height
+      && a_data.mipLevels == first.mipLevels
+      && a_data.flags.GetFormat() == first.flags.GetFormat();
+  }
+
+  int32_t Texture2DArray::AddLayer(TextureData const & a_data)
+  {
+    if (!CanHold(a_data))
+      return -1;
+
+    m_layers.push_back(TextureData());
+    m_layers.back().Duplicate(a_data);
+    return static_cast<int32_t>(m_layers.size() - 1);
+  }
+
+  uint32_t Texture2DArray::GetLayerCount() const
+  {
+    return static_cast<uint32_t>(m_layers.size());
+  }
+
+  void Texture2DArray::Upload()
+  {
+    if (m_layers.empty())
+      return;
+
+    //Layers share their pixels with the render thread, which releases them once uploaded.
+    uint32_t count = static_cast<uint32_t>(m_layers.size());
+    TextureData * pLayers = static_cast<TextureData*>(RENDER_ALLOCATE(count * sizeof(TextureData)));
+    for (uint32_t i = 0; i < count; i++)
+      new (&pLayers[i]) TextureData(m_layers[i]);
+
+    RenderState state = RenderState::Create();
+    state.Set<RenderState::Attr::Type>(RenderState::Type::Command);
+    state.Set<RenderState::Attr::Command>(RenderState::Command::TextureArrayCreate);
+
+    RENDER_SUBMIT(state, [resID = GetHandle(), pLayers, count]()
+    {
+      RT_Texture2DArray *pTexture =  RenderThreadData::Instance()->textureArrays.at(resID);
+      if (pTexture != nullptr)
+        pTexture->Destroy();
+      else
+        pTexture = RenderThreadData::Instance()->textureArrays.insert(resID, RT_Texture2DArray());
+
+      pTexture->Init(pLayers, count);
+      for (uint32_t i = 0; i < count; i++)
+        pLayers[i].Clear();
+    });
+  }
+
+  void Texture2DArray::Clear()
+  {
+    for (TextureData & layer : m_layers)
+      layer.Clear();
+    m_layers.clear();
+  }
+
+  void Texture2DArray::Bind(uint32_t a_slot) const
+  {
+    RenderState state = RenderState::Create();
+    state.Set<RenderState::Attr::Type>(RenderState::Type::Command);
+    state.Set<RenderState::Attr::Command>(RenderState::Command::TextureArrayBindToSlot);
+
+    RENDER_SUBMIT(state, [resID = GetHandle(), slot = a_slot]()
+    {
+      RT_Texture2DArray* pTexture =  RenderThreadData::Instance()->textureArrays.at(resID);
+      if (pTexture == nullptr)
+      {
+        RT_Texture2DArray::BindPlaceholder(slot);
+        return;
+      }
+
+      pTexture->Bind(slot);
+    });
+  }
+
+  //-----------------------------------------------------------------------------------------------
+  // BuildTextureArrays
+  //-----------------------------------------------------------------------------------------------
+
+  void BuildTextureArrays(TextureData const * a_pImages, uint32_t a_count,
+                          std::vector<Ref<Texture2DArray>> & a_arrays,
+                          std::vector<TextureArrayLayer> & a_layers)
+  {
+    //Maps are built from a handful of tile sizes, so a linear search for an array with
+    //room is cheap. Full arrays are skipped; a new one is started alongside them.
+    size_t firstArray = a_arrays.size();
+    for (uint32_t i = 0; i < a_count; i++)
+    {
+      TextureArrayLayer result = {0, 0};
+      int32_t layer = -1;
+      for (size_t a = firstArray; a < a_arrays.size() && layer < 0; a++)
+      {
+        layer = a_arrays[a]->AddLayer(a_pImages[i]);
+        result.array = static_cast<uint32_t>(a);
+      }
+
+      if (layer < 0)
+      {
+        Ref<Texture2DArray> array = Texture2DArray::Create();
+        layer = array->AddLayer(a_pImages[i]);
+        result.array = static_cast<uint32_t>(a_arrays.size());
+        a_arrays.push_back(array);
+      }
+
+      result.layer = static_cast<uint32_t>(layer);
+      a_layers.push_back(result);
+    }
+  }
+}
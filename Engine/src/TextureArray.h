@@ -0,0 +1,63 @@
+//@group Renderer
+
+#ifndef TEXTUREARRAY_H
+#define TEXTUREARRAY_H
+
+#include <stdint.h>
+#include <vector>
+
+#include "TextureData.h"
+#include "RenderResource.h"
+#include "Memory.h"
+
+namespace Engine
+{
+  //The minimum GL_MAX_ARRAY_TEXTURE_LAYERS an implementation may report.
+  uint32_t const MaxTextureArrayLayers = 256;
+
+  //Same-sized images stored as the layers of one texture. Shaders sample it with a
+  //sampler2DArray and a layer index per vertex or per instance, so all surfaces
+  //using the array can be drawn with a single texture binding.
+  class Texture2DArray : public RenderResource<Texture2DArray>
+  {
+    Texture2DArray();
+  public:
+
+    static Ref<Texture2DArray> Create();
+
+    ~Texture2DArray();
+
+    //Shares the pixels with 'data'. Returns the layer index, or -1 if the array is full
+    //or the size, format or number of mip levels differs from the first layer.
+    int32_t AddLayer(TextureData const & data);
+
+    bool CanHold(TextureData const &) const;
+    uint32_t GetLayerCount() const;
+
+    //Uploads all layers. Must be called again after adding layers.
+    void Upload();
+
+    //Releases the CPU copy of the layers. The uploaded texture is unaffected.
+    void Clear();
+    void Bind(uint32_t slot = 0) const;
+
+  private:
+
+    std::vector<TextureData> m_layers;
+  };
+
+  //Where an image ended up.
+  struct TextureArrayLayer
+  {
+    uint32_t  array;
+    uint32_t  layer;
+  };
+
+  //Sorts images into one array per size and format, e.g. wall and floor tiles. Arrays
+  //are appended to 'arrays'; 'layers' receives one entry per image, in order.
+  void BuildTextureArrays(TextureData const * images, uint32_t count,
+                          std::vector<Ref<Texture2DArray>> & arrays,
+                          std::vector<TextureArrayLayer> & layers);
+}
+
+#endif
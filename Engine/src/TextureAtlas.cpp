@@ -0,0 +1,191 @@
+//@group Renderer
+
+#include <map>
+#include <algorithm>
+
+#include "TextureAtlas.h"
+#include "DgBinPacker.h"
+#include "core_Log.h"
+
+namespace Engine
+{
+  static uint32_t NextPowerOfTwo(uint32_t a_value)
+  {
+    uint32_t result = 1;
+    while (result < a_value)
+      result <<= 1;
+    return result;
+  }
+
+  static int32_t WrapIndex(int32_t a_index, int32_t a_size, bool a_repeat)
+  {
+    if (a_repeat)
+    {
+      a_index %= a_size;
+      return a_index < 0 ? a_index + a_size : a_index;
+    }
+    return a_index < 0 ? 0 : (a_index >= a_size ? a_size - 1 : a_index);
+  }
+
+  TextureAtlasBuilder::TextureAtlasBuilder()
+    : m_maxPageSize(2048)
+    , m_padding(2)
+  {
+
+  }
+
+  void TextureAtlasBuilder::SetMaxPageSize(uint32_t a_size)
+  {
+    m_maxPageSize = a_size;
+  }
+
+  void TextureAtlasBuilder::SetPadding(uint32_t a_padding)
+  {
+    m_padding = a_padding;
+  }
+
+  void TextureAtlasBuilder::SetFlags(TextureFlags a_flags)
+  {
+    m_flags = a_flags;
+  }
+
+  uint32_t TextureAtlasBuilder::Add(TextureData const * a_pImage)
+  {
+    uint32_t index = static_cast<uint32_t>(m_entries.size());
+    m_entries.push_back(Entry{a_pImage, index});
+    return index;
+  }
+
+  void TextureAtlasBuilder::Blit(TextureData const & a_image, RGBA * a_pPage, uint32_t a_pageWidth, uint32_t a_x, uint32_t a_y) const
+  {
+    int32_t w = int32_t(a_image.width);
+    int32_t h = int32_t(a_image.height);
+    int32_t pad = int32_t(m_padding);
+    bool repeat = a_image.flags.GetWrap() == TextureWrap::Repeat;
+
+    //a_x, a_y is the corner of the gutter
+    for (int32_t y = -pad; y < h + pad; y++)
+    {
+      int32_t sy = WrapIndex(y, h, repeat);
+      RGBA * pDst = a_pPage + size_t(int32_t(a_y) + y + pad) * a_pageWidth + a_x;
+      RGBA const * pSrc = a_image.pPixels + size_t(sy) * w;
+
+      for (int32_t x = -pad; x < 0; x++)
+        pDst[x + pad] = pSrc[WrapIndex(x, w, repeat)];
+
+      memcpy(pDst + pad, pSrc, size_t(w) * sizeof(RGBA));
+
+      for (int32_t x = w; x < w + pad; x++)
+        pDst[x + pad] = pSrc[WrapIndex(x, w, repeat)];
+    }
+  }
+
+  bool TextureAtlasBuilder::Build(TextureAtlas & a_out) const
+  {
+    //Pages have no destructor, so release them before dropping them
+    for (TextureData & page : a_out.pages)
+      page.Clear();
+    a_out.pages.clear();
+    a_out.regions.clear();
+    a_out.regions.resize(m_entries.size());
+
+    for (Entry const & entry : m_entries)
+    {
+      TextureData const & image = *entry.pImage;
+      if (image.flags.GetFormat() != TextureFormat::RGBA8)
+      {
+        LOG_ERROR("TextureAtlasBuilder::Build(): Image {} is not RGBA8. Convert the pages instead", entry.index);
+        return false;
+      }
+
+      if (image.width + 2 * m_padding > m_maxPageSize || image.height + 2 * m_padding > m_maxPageSize)
+      {
+        LOG_ERROR("TextureAtlasBuilder::Build(): Image {} ({}x{}) is too large for a page", entry.index, image.width, image.height);
+        return false;
+      }
+    }
+
+    std::vector<Entry> remaining = m_entries;
+    while (!remaining.empty())
+    {
+      Dg::BinPacker<int> packer;
+      std::map<Dg::BinPkr_ItemID, Entry> itemMap;
+
+      for (Entry const & entry : remaining)
+      {
+        int w = int(entry.pImage->width + 2 * m_padding);
+        int h = int(entry.pImage->height + 2 * m_padding);
+        Dg::BinPkr_ItemID id = packer.RegisterItem(w, h);
+        itemMap.insert(std::pair<Dg::BinPkr_ItemID, Entry>(id, entry));
+      }
+
+      Dg::BinPacker<int>::Bin bin;
+      bin.dimensions[Dg::Element::width] = 64;
+      bin.dimensions[Dg::Element::height] = 64;
+      bin.maxDimensions[Dg::Element::width] = int(m_maxPageSize);
+      bin.maxDimensions[Dg::Element::height] = int(m_maxPageSize);
+      packer.Fill(bin);
+
+      if (bin.items.size() == 0)
+      {
+        LOG_ERROR("TextureAtlasBuilder::Build(): Failed to place any images on a page");
+        return false;
+      }
+
+      //Size the page to what was used
+      uint32_t usedWidth = 0;
+      uint32_t usedHeight = 0;
+      for (auto const & item : bin.items)
+      {
+        Entry const & entry = itemMap.at(item.id);
+        uint32_t right = uint32_t(item.xy[Dg::Element::x]) + entry.pImage->width + 2 * m_padding;
+        uint32_t bottom = uint32_t(item.xy[Dg::Element::y]) + entry.pImage->height + 2 * m_padding;
+        usedWidth = right > usedWidth ? right : usedWidth;
+        usedHeight = bottom > usedHeight ? bottom : usedHeight;
+      }
+
+      //The maximum need not be a power of two
+      uint32_t pageWidth = std::min(NextPowerOfTwo(usedWidth), m_maxPageSize);
+      uint32_t pageHeight = std::min(NextPowerOfTwo(usedHeight), m_maxPageSize);
+      uint32_t pageIndex = static_cast<uint32_t>(a_out.pages.size());
+
+      RGBA * pPixels = new RGBA[size_t(pageWidth) * pageHeight];
+      for (size_t i = 0; i < size_t(pageWidth) * pageHeight; i++)
+        pPixels[i].data = 0;
+
+      std::vector<bool> placed(m_entries.size(), false);
+      for (auto const & item : bin.items)
+      {
+        Entry const & entry = itemMap.at(item.id);
+        uint32_t x = uint32_t(item.xy[Dg::Element::x]);
+        uint32_t y = uint32_t(item.xy[Dg::Element::y]);
+        Blit(*entry.pImage, pPixels, pageWidth, x, y);
+
+        AtlasRegion & region = a_out.regions[entry.index];
+        region.page = pageIndex;
+        region.x = x + m_padding;
+        region.y = y + m_padding;
+        region.width = entry.pImage->width;
+        region.height = entry.pImage->height;
+        region.uv[0] = float(region.x) / float(pageWidth);
+        region.uv[1] = float(region.y) / float(pageHeight);
+        region.uv[2] = float(region.x + region.width) / float(pageWidth);
+        region.uv[3] = float(region.y + region.height) / float(pageHeight);
+
+        placed[entry.index] = true;
+      }
+
+      a_out.pages.push_back(TextureData(pageWidth, pageHeight, pPixels, m_flags));
+
+      std::vector<Entry> leftovers;
+      for (Entry const & entry : remaining)
+      {
+        if (!placed[entry.index])
+          leftovers.push_back(entry);
+      }
+      remaining.swap(leftovers);
+    }
+
+    return true;
+  }
+}
@@ -0,0 +1,78 @@
+//@group Renderer
+
+#ifndef TEXTUREATLAS_H
+#define TEXTUREATLAS_H
+
+#include <stdint.h>
+#include <vector>
+
+#include "TextureData.h"
+
+namespace Engine
+{
+  //Where a source image ended up.
+  struct AtlasRegion
+  {
+    uint32_t  page;
+    uint32_t  x;
+    uint32_t  y;
+    uint32_t  width;
+    uint32_t  height;
+    float     uv[4];  //u0, v0, u1, v1
+  };
+
+  struct TextureAtlas
+  {
+    //Owned by the atlas. Call Clear() on each page once they have been uploaded.
+    std::vector<TextureData>  pages;
+
+    //One entry per image, in the order they were added
+    std::vector<AtlasRegion>  regions;
+  };
+
+  //Packs sprites and wall tiles into as few pages as possible.
+  //
+  //Each image is surrounded by a gutter of 'padding' pixels, filled by extending the
+  //edges of the image outwards (or wrapping, for images set to repeat). This keeps
+  //filtering and lower mip levels from picking up colour from neighbouring images.
+  class TextureAtlasBuilder
+  {
+  public:
+
+    TextureAtlasBuilder();
+
+    //Pages never grow larger than this, even if it is not a power of two. Default 2048.
+    void SetMaxPageSize(uint32_t);
+
+    //Gutter width in pixels. Default 2.
+    void SetPadding(uint32_t);
+
+    //Flags for the atlas pages
+    void SetFlags(TextureFlags);
+
+    //Images are not copied and must outlive Build(). Returns the index of the region.
+    uint32_t Add(TextureData const *);
+
+    //Returns false if an image could not fit on an empty page.
+    bool Build(TextureAtlas & out) const;
+
+  private:
+
+    struct Entry
+    {
+      TextureData const * pImage;
+      uint32_t            index;
+    };
+
+    void Blit(TextureData const & image, RGBA * pPage, uint32_t pageWidth, uint32_t x, uint32_t y) const;
+
+  private:
+
+    uint32_t              m_maxPageSize;
+    uint32_t              m_padding;
+    TextureFlags          m_flags;
+    std::vector<Entry>    m_entries;
+  };
+}
+
+#endif
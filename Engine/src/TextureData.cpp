@@ -1,8 +1,11 @@
 //@group Renderer
 
 #include "TextureData.h"
+#include "BlockCompression.h"
+#include "Palette.h"
 #include "Serialize.h"
 #include "DgBit.h"
+#include "core_Log.h"
 
 namespace Engine
 {
@@ -13,7 +16,9 @@ namespace Engine
       Wrap          = 2,
       Filter        = 2,
       MipmapFilter  = 2,
-      IsMipmapped   = 1
+      IsMipmapped   = 1,
+      Format        = 3,
+      IsStreamable  = 1
     };
 
     enum class Begin : uint32_t
@@ -22,6 +27,8 @@ namespace Engine
       Filter        = Wrap + static_cast<uint32_t>(Size::Wrap),
       MipmapFilter  = Filter + static_cast<uint32_t>(Size::Filter),
       IsMipmapped   = MipmapFilter + static_cast<uint32_t>(Size::MipmapFilter),
+      Format        = IsMipmapped + static_cast<uint32_t>(Size::IsMipmapped),
+      IsStreamable  = Format + static_cast<uint32_t>(Size::Format),
     };
   }
 
@@ -55,6 +62,11 @@ namespace Engine
     return (Dg::GetSubInt<uint32_t, static_cast<uint32_t>(Begin::IsMipmapped), static_cast<uint32_t>(Size::IsMipmapped)>(m_data) != 0);
   }
 
+  TextureFormat TextureFlags::GetFormat() const
+  {
+    return static_cast<TextureFormat>(Dg::GetSubInt<uint32_t, static_cast<uint32_t>(Begin::Format), static_cast<uint32_t>(Size::Format)>(m_data));
+  }
+
   void TextureFlags::SetWrap(TextureWrap a_val)
   {
     m_data = Dg::SetSubInt<uint32_t, static_cast<uint32_t>(Begin::Wrap), static_cast<uint32_t>(Size::Wrap)>(m_data, static_cast<uint32_t>(a_val));
@@ -70,10 +82,26 @@ namespace Engine
     m_data = Dg::SetSubInt<uint32_t, static_cast<uint32_t>(Begin::MipmapFilter), static_cast<uint32_t>(Size::MipmapFilter)>(m_data, static_cast<uint32_t>(a_val));
   }
 
+  bool TextureFlags::IsStreamable() const
+  {
+    return (Dg::GetSubInt<uint32_t, static_cast<uint32_t>(Begin::IsStreamable), static_cast<uint32_t>(Size::IsStreamable)>(m_data) != 0);
+  }
+
   void TextureFlags::SetIsMipmapped(bool a_val)
   {
     uint32_t val = a_val ? 1 : 0;
-    m_data = Dg::SetSubInt<uint32_t, static_cast<uint32_t>(Begin::MipmapFilter), static_cast<uint32_t>(Size::MipmapFilter)>(m_data, val);
+    m_data = Dg::SetSubInt<uint32_t, static_cast<uint32_t>(Begin::IsMipmapped), static_cast<uint32_t>(Size::IsMipmapped)>(m_data, val);
+  }
+
+  void TextureFlags::SetFormat(TextureFormat a_val)
+  {
+    m_data = Dg::SetSubInt<uint32_t, static_cast<uint32_t>(Begin::Format), static_cast<uint32_t>(Size::Format)>(m_data, static_cast<uint32_t>(a_val));
+  }
+
+  void TextureFlags::SetIsStreamable(bool a_val)
+  {
+    uint32_t val = a_val ? 1 : 0;
+    m_data = Dg::SetSubInt<uint32_t, static_cast<uint32_t>(Begin::IsStreamable), static_cast<uint32_t>(Size::IsStreamable)>(m_data, val);
   }
 
   uint32_t TextureFlags::GetData() const
@@ -93,7 +121,9 @@ namespace Engine
   TextureData::TextureData()
     : width(0)
     , height(0)
+    , mipLevels(1)
     , pPixels(nullptr)
+    , m_pStorage(nullptr)
   {
 
   }
@@ -102,7 +132,9 @@ namespace Engine
     : flags(a_flags)
     , width(a_width)
     , height(a_height)
+    , mipLevels(1)
     , pPixels(nullptr)
+    , m_pStorage(nullptr)
   {
     Set(a_width, a_height, a_pPixels, a_flags);
   }
@@ -110,7 +142,9 @@ namespace Engine
   TextureData::TextureData(TextureData const & a_other)
     : width(0)
     , height(0)
+    , mipLevels(1)
     , pPixels(nullptr)
+    , m_pStorage(nullptr)
   {
     Duplicate(a_other);
   }
@@ -126,24 +160,33 @@ namespace Engine
     : flags(a_other.flags)
     , width(a_other.width)
     , height(a_other.height)
+    , mipLevels(a_other.mipLevels)
     , pPixels(a_other.pPixels)
+    , m_pStorage(a_other.m_pStorage)
   {
     a_other.width = 0;
     a_other.height = 0;
+    a_other.mipLevels = 1;
     a_other.pPixels = nullptr;
+    a_other.m_pStorage = nullptr;
   }
 
   TextureData & TextureData::operator=(TextureData && a_other) noexcept
   {
     if (this != &a_other)
     {
+      Clear();
       flags = a_other.flags;
       width = a_other.width;
       height = a_other.height;
+      mipLevels = a_other.mipLevels;
       pPixels = a_other.pPixels;
+      m_pStorage = a_other.m_pStorage;
       a_other.width = 0;
       a_other.height = 0;
+      a_other.mipLevels = 1;
       a_other.pPixels = nullptr;
+      a_other.m_pStorage = nullptr;
     }
 
     return *this;
@@ -154,8 +197,10 @@ namespace Engine
     Clear();
     width = a_width;
     height = a_height;
+    mipLevels = 1;
     flags = a_flags;
-    pPixels = a_pixels;
+    if (a_pixels != nullptr)
+      SetStorage(PixelStorage::Adopt(a_pixels, DataSize() / sizeof(RGBA)));
   }
 
   void* TextureData::Serialize(void* a_pBuf)
@@ -165,7 +210,8 @@ namespace Engine
     pCurrent = Core::Serialize(pCurrent, &flagData, 1);
     pCurrent = Core::Serialize(pCurrent, &width, 1);
     pCurrent = Core::Serialize(pCurrent, &height, 1);
-    pCurrent = Core::Serialize(pCurrent, &pPixels->data, size_t(width) * height);
+    pCurrent = Core::Serialize(pCurrent, &mipLevels, 1);
+    pCurrent = Core::Serialize(pCurrent, &pPixels->data, DataSize() / sizeof(RGBA));
     return pCurrent;
   }
 
@@ -176,9 +222,12 @@ namespace Engine
     pCurrent = Core::Deserialize(pCurrent, &flagData, 1);
     pCurrent = Core::Deserialize(pCurrent, &width, 1);
     pCurrent = Core::Deserialize(pCurrent, &height, 1);
-    pCurrent = Core::Deserialize(pCurrent, &pPixels->data, size_t(width) * height);
+    pCurrent = Core::Deserialize(pCurrent, &mipLevels, 1);
     flags.SetData(flagData);
-    return pCurrent;
+
+    size_t count = DataSize() / sizeof(RGBA);
+    SetStorage(PixelStorage::View(static_cast<RGBA const *>(pCurrent), count));
+    return Core::AdvancePtr(pCurrent, count * sizeof(RGBA));
   }
 
   void TextureData::Duplicate(TextureData const& a_other)
@@ -188,8 +237,10 @@ namespace Engine
     flags = a_other.flags;
     width = a_other.width;
     height = a_other.height;
-    pPixels = new RGBA[width * height];
-    memcpy(pPixels, a_other.pPixels, sizeof(RGBA) * (size_t)width * height);
+    mipLevels = a_other.mipLevels;
+    if (a_other.m_pStorage != nullptr)
+      a_other.m_pStorage->AddRef();
+    SetStorage(a_other.m_pStorage);
   }
 
   void TextureData::Clear()
@@ -197,8 +248,37 @@ namespace Engine
     flags.SetData(0);
     width = 0;
     height = 0;
-    delete[] pPixels;
-    pPixels = nullptr;
+    mipLevels = 1;
+    SetStorage(nullptr);
+  }
+
+  PixelStorage const * TextureData::GetStorage() const
+  {
+    return m_pStorage;
+  }
+
+  void TextureData::SetStorage(PixelStorage * a_pStorage)
+  {
+    if (m_pStorage != nullptr)
+      m_pStorage->Release();
+    m_pStorage = a_pStorage;
+    pPixels = a_pStorage == nullptr ? nullptr : a_pStorage->Data();
+  }
+
+  RGBA * TextureData::MutablePixels()
+  {
+    if (m_pStorage == nullptr)
+      return nullptr;
+
+    if (!m_pStorage->IsExclusive())
+    {
+      size_t count = m_pStorage->Count();
+      RGBA * pCopy = new RGBA[count];
+      memcpy(pCopy, pPixels, count * sizeof(RGBA));
+      SetStorage(PixelStorage::Adopt(pCopy, count));
+    }
+
+    return m_pStorage->MutableData();
   }
 
   size_t TextureData::Size() const
@@ -207,7 +287,163 @@ namespace Engine
     result += Core::SerializedSize(flags.GetData());
     result += Core::SerializedSize(width);
     result += Core::SerializedSize(height);
-    result += (sizeof(RGBA::DataType) * width * height);
+    result += Core::SerializedSize(mipLevels);
+    result += DataSize();
+    return result;
+  }
+
+  size_t TextureData::PixelCount() const
+  {
+    size_t result = 0;
+    for (uint32_t i = 0; i < mipLevels; i++)
+      result += size_t(LevelWidth(i)) * LevelHeight(i);
     return result;
   }
+
+  size_t TextureData::DataSize() const
+  {
+    size_t result = 0;
+    for (uint32_t i = 0; i < mipLevels; i++)
+      result += LevelDataSize(i);
+    return result;
+  }
+
+  size_t TextureData::LevelDataSize(uint32_t a_level) const
+  {
+    return ImageDataSize(flags.GetFormat(), LevelWidth(a_level), LevelHeight(a_level));
+  }
+
+  uint32_t TextureData::LevelWidth(uint32_t a_level) const
+  {
+    return MipLevelSize(width, a_level);
+  }
+
+  uint32_t TextureData::LevelHeight(uint32_t a_level) const
+  {
+    return MipLevelSize(height, a_level);
+  }
+
+  RGBA const * TextureData::Level(uint32_t a_level) const
+  {
+    //Level sizes are a multiple of sizeof(RGBA), so levels stay aligned.
+    RGBA const * pLevel = pPixels;
+    for (uint32_t i = 0; i < a_level; i++)
+      pLevel += LevelDataSize(i) / sizeof(RGBA);
+    return pLevel;
+  }
+
+  void TextureData::GenerateMipmaps(MipmapBuildOptions const & a_opts)
+  {
+    if (pPixels == nullptr || width == 0 || height == 0)
+      return;
+
+    if (flags.GetFormat() != TextureFormat::RGBA8)
+    {
+      LOG_WARN("TextureData::GenerateMipmaps(): Can only build mipmaps from RGBA8 data");
+      return;
+    }
+
+    uint32_t levels = MipLevelCount(width, height);
+    size_t baseCount = size_t(width) * height;
+
+    size_t total = 0;
+    for (uint32_t i = 0; i < levels; i++)
+      total += size_t(MipLevelSize(width, i)) * MipLevelSize(height, i);
+
+    RGBA * pChain = new RGBA[total];
+    memcpy(pChain, pPixels, sizeof(RGBA) * baseCount);
+    SetStorage(PixelStorage::Adopt(pChain, total));
+    mipLevels = levels;
+
+    RGBA * pLevel = pChain;
+    for (uint32_t i = 1; i < mipLevels; i++)
+    {
+      RGBA * pNext = pLevel + size_t(LevelWidth(i - 1)) * LevelHeight(i - 1);
+      BuildMipLevel(pLevel, LevelWidth(i - 1), LevelHeight(i - 1), pNext, flags.GetWrap(), a_opts);
+      pLevel = pNext;
+    }
+
+    flags.SetIsMipmapped(true);
+  }
+
+  bool TextureData::Compress(TextureFormat a_format)
+  {
+    if (flags.GetFormat() != TextureFormat::RGBA8)
+      return false;
+
+    if (a_format == TextureFormat::RGBA8 || pPixels == nullptr)
+      return true;
+
+    if (BlockSize(a_format) == 0)
+      return false;
+
+    size_t total = 0;
+    for (uint32_t i = 0; i < mipLevels; i++)
+      total += ImageDataSize(a_format, LevelWidth(i), LevelHeight(i));
+
+    RGBA * pBlocks = new RGBA[total / sizeof(RGBA)];
+    byte * pDst = reinterpret_cast<byte*>(pBlocks);
+    for (uint32_t i = 0; i < mipLevels; i++)
+    {
+      CompressImage(Level(i), LevelWidth(i), LevelHeight(i), a_format, pDst);
+      pDst += ImageDataSize(a_format, LevelWidth(i), LevelHeight(i));
+    }
+
+    SetStorage(PixelStorage::Adopt(pBlocks, total / sizeof(RGBA)));
+    flags.SetFormat(a_format);
+    return true;
+  }
+
+  bool TextureData::ToIndexed(RGBA const * a_pPalette, uint32_t a_count)
+  {
+    if (flags.GetFormat() != TextureFormat::RGBA8)
+      return false;
+
+    if (pPixels == nullptr)
+      return true;
+
+    PaletteLookup lookup(a_pPalette, a_count);
+
+    size_t total = 0;
+    for (uint32_t i = 0; i < mipLevels; i++)
+      total += ImageDataSize(TextureFormat::Index8, LevelWidth(i), LevelHeight(i));
+
+    RGBA * pIndexed = new RGBA[total / sizeof(RGBA)];
+    byte * pDst = reinterpret_cast<byte*>(pIndexed);
+    for (uint32_t i = 0; i < mipLevels; i++)
+    {
+      RGBAToIndexed(Level(i), size_t(LevelWidth(i)) * LevelHeight(i), lookup, pDst);
+      pDst += ImageDataSize(TextureFormat::Index8, LevelWidth(i), LevelHeight(i));
+    }
+
+    SetStorage(PixelStorage::Adopt(pIndexed, total / sizeof(RGBA)));
+    flags.SetFormat(TextureFormat::Index8);
+    return true;
+  }
+
+  bool TextureData::ToRGBA(RGBA const * a_pPalette)
+  {
+    if (flags.GetFormat() != TextureFormat::Index8)
+      return flags.GetFormat() == TextureFormat::RGBA8;
+
+    if (pPixels == nullptr)
+    {
+      flags.SetFormat(TextureFormat::RGBA8);
+      return true;
+    }
+
+    size_t total = PixelCount();
+    RGBA * pExpanded = new RGBA[total];
+    RGBA * pDst = pExpanded;
+    for (uint32_t i = 0; i < mipLevels; i++)
+    {
+      size_t count = size_t(LevelWidth(i)) * LevelHeight(i);
+      IndexedToRGBA(reinterpret_cast<byte const *>(Level(i)), count, a_pPalette, pDst);
+      pDst += count;
+    }
+
+    SetStorage(PixelStorage::Adopt(pExpanded, total));
+    flags.SetFormat(TextureFormat::RGBA8);
+    return true;
+  }
 }
\ No newline at end of file
@@ -5,6 +5,8 @@
 
 #include <stdint.h>
 #include "core_utils.h"
+#include "MipmapBuilder.h"
+#include "PixelStorage.h"
 
 namespace Engine
 {
@@ -31,6 +33,15 @@ namespace Engine
     Linear_Linear
   };
 
+  //How pixel data is stored. Compressed formats hold 4x4 blocks, see BlockCompression.h.
+  enum class TextureFormat
+  {
+    RGBA8,
+    BC1,    //RGB, 1-bit alpha
+    BC3,    //RGBA
+    Index8  //8-bit palette indices, see Palette.h
+  };
+
   class TextureFlags
   {
   public:
@@ -41,11 +52,19 @@ namespace Engine
     TextureFilter GetFilter() const;
     TextureMipmapFilter GetMipmapFilter() const;
     bool IsMipmapped() const;
+    TextureFormat GetFormat() const;
+
+    //Streamable textures can be evicted, or have their top mip levels dropped, to keep
+    //video memory under budget. The render thread keeps a reference to the pixels to
+    //stream them back in, so the CPU copy is kept alive (free if memory mapped).
+    bool IsStreamable() const;
 
     void SetWrap(TextureWrap);
     void SetFilter(TextureFilter);
     void SetMipmapFilter(TextureMipmapFilter);
     void SetIsMipmapped(bool);
+    void SetFormat(TextureFormat);
+    void SetIsStreamable(bool);
 
     void SetData(uint32_t);
     uint32_t GetData() const;
@@ -55,13 +74,16 @@ namespace Engine
     uint32_t m_data;
   };
 
+  //Copies share pixel storage, so are cheap. Pixels are immutable while shared; use
+  //MutablePixels() to edit, which copies the pixels first if needed. There is no
+  //destructor, so this can be captured in render commands. Call Clear() to release.
   class TextureData
   {
   public:
 
     TextureData();
 
-    //Takes ownership of a_pixels
+    //Takes ownership of a_pixels, which must be allocated with new RGBA[]
     TextureData(uint32_t a_width, uint32_t a_height, RGBA * a_pixels, TextureFlags a_flags);
 
     TextureData(TextureData const &);
@@ -73,18 +95,66 @@ namespace Engine
     //Takes ownership of a_pixels
     void Set(uint32_t a_width, uint32_t a_height, RGBA * a_pixels, TextureFlags a_flags);
 
+    //Shares the pixel storage of the other
     void Duplicate(TextureData const &);
     size_t Size() const;
+
+    //Copy on write. Returns nullptr if there are no pixels.
+    RGBA * MutablePixels();
+
+    //The shared pixel storage, or nullptr if there are no pixels
+    PixelStorage const * GetStorage() const;
+
+    //Builds the full mip chain from the base level. Levels are stored one after the
+    //other in pPixels, largest first.
+    //Mipmaps must be built before compressing.
+    void GenerateMipmaps(MipmapBuildOptions const & = MipmapBuildOptions());
+
+    //Encodes every level into a block compressed format. This is slow, so should be
+    //done when converting assets rather than at load time. Returns false if the data
+    //is not RGBA8 or the format is not a block format.
+    bool Compress(TextureFormat);
+
+    //Converts every level to 8-bit palette indices. Colours not in the palette take the
+    //nearest entry. Returns false if the data is not RGBA8.
+    bool ToIndexed(RGBA const * palette, uint32_t count);
+
+    //Expands indexed data back to RGBA8. 'palette' must hold PaletteSize colours.
+    bool ToRGBA(RGBA const * palette);
+
+    //Total pixels over all levels
+    size_t PixelCount() const;
+
+    //Bytes of pixel data over all levels, in the stored format
+    size_t DataSize() const;
+    size_t LevelDataSize(uint32_t level) const;
+
+    uint32_t LevelWidth(uint32_t level) const;
+    uint32_t LevelHeight(uint32_t level) const;
+
+    //For other formats, points to the first block or index of the level.
+    RGBA const * Level(uint32_t level) const;
     void* Serialize(void*);
 
-    //Will not allocate pixel data, but just point to it
+    //Will not allocate pixel data, but just point to it. The buffer, for example a memory
+    //mapped pack file, must outlive this and all copies.
     void const * Deserialize(void const*);
     void Clear();
 
-    TextureFlags  flags;
-    uint32_t      width;
-    uint32_t      height;
-    RGBA *        pPixels;
+    TextureFlags    flags;
+    uint32_t        width;
+    uint32_t        height;
+    uint32_t        mipLevels;
+    RGBA const *    pPixels;
+
+  private:
+
+    //Releases the current storage. Takes over the reference to the new one.
+    void SetStorage(PixelStorage *);
+
+  private:
+
+    PixelStorage *  m_pStorage;
   };
 }
 
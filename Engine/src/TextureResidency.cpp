@@ -0,0 +1,295 @@
+//@group Renderer/RenderThread
+
+#include "TextureResidency.h"
+
+namespace Engine
+{
+  //-----------------------------------------------------------------------------------------------
+  // TextureResidencyStats
+  //-----------------------------------------------------------------------------------------------
+
+  TextureResidencyStats::TextureResidencyStats()
+    : binds(0)
+    , hits(0)
+    , evictions(0)
+    , mipDrops(0)
+    , restores(0)
+    , residentBytes(0)
+    , budget(0)
+  {
+
+  }
+
+  float TextureResidencyStats::HitRate() const
+  {
+    if (binds == 0)
+      return 1.0f;
+    return static_cast<float>(double(hits) / double(binds));
+  }
+
+  //-----------------------------------------------------------------------------------------------
+  // TextureResidency
+  //-----------------------------------------------------------------------------------------------
+
+  TextureResidency::TextureResidency()
+    : m_head(None)
+    , m_tail(None)
+    , m_frame(0)
+  {
+
+  }
+
+  TextureResidency::~TextureResidency()
+  {
+    Clear();
+  }
+
+  void TextureResidency::SetBudget(uint64_t a_bytes)
+  {
+    m_stats.budget = a_bytes;
+  }
+
+  void TextureResidency::Add(RenderHandle a_handle, TextureData const & a_data)
+  {
+    if (!a_handle.IsValid())
+      return;
+
+    if (a_handle.index >= m_entries.size())
+    {
+      Entry empty = {};
+      empty.prev = None;
+      empty.next = None;
+      m_entries.resize(size_t(a_handle.index) + 1, empty);
+    }
+
+    Entry & entry = m_entries[a_handle.index];
+    if (entry.inUse)
+    {
+      m_stats.residentBytes -= ResidentBytes(entry.data, entry.baseLevel);
+      entry.data.Clear();
+      Unlink(a_handle.index);
+    }
+
+    entry.data.Duplicate(a_data);
+    entry.generation = a_handle.generation;
+    entry.baseLevel = 0;
+    entry.lastUsed = m_frame;
+    entry.inUse = true;
+    entry.queued = false;
+    Link(a_handle.index);
+
+    m_stats.residentBytes += ResidentBytes(entry.data, 0);
+  }
+
+  void TextureResidency::Remove(RenderHandle a_handle)
+  {
+    Entry * pEntry = Find(a_handle);
+    if (pEntry == nullptr)
+      return;
+
+    m_stats.residentBytes -= ResidentBytes(pEntry->data, pEntry->baseLevel);
+    pEntry->data.Clear();
+    pEntry->inUse = false;
+    pEntry->queued = false;
+    Unlink(a_handle.index);
+  }
+
+  bool TextureResidency::Touch(RenderHandle a_handle)
+  {
+    Entry * pEntry = Find(a_handle);
+    if (pEntry == nullptr)
+      return true;
+
+    m_stats.binds++;
+    pEntry->lastUsed = m_frame;
+    if (m_head != a_handle.index)
+    {
+      Unlink(a_handle.index);
+      Link(a_handle.index);
+    }
+
+    if (pEntry->baseLevel == 0)
+    {
+      m_stats.hits++;
+      return true;
+    }
+
+    if (!pEntry->queued)
+    {
+      pEntry->queued = true;
+      m_restoreQueue.push_back(a_handle.index);
+    }
+    return false;
+  }
+
+  void TextureResidency::Restore(size_t a_bytes, std::vector<Change> & a_out)
+  {
+    size_t uploaded = 0;
+    size_t i = 0;
+    for (; i < m_restoreQueue.size(); i++)
+    {
+      uint32_t index = m_restoreQueue[i];
+      Entry & entry = m_entries[index];
+
+      //Removed since it was queued
+      if (!entry.inUse || !entry.queued)
+        continue;
+
+      size_t size = ResidentBytes(entry.data, 0);
+      if (uploaded != 0 && uploaded + size > a_bytes)
+        break;
+
+      entry.queued = false;
+      m_stats.residentBytes += size - ResidentBytes(entry.data, entry.baseLevel);
+      entry.baseLevel = 0;
+      m_stats.restores++;
+      uploaded += size;
+      a_out.push_back(Change{RenderHandle{index, entry.generation}, 0});
+    }
+    m_restoreQueue.erase(m_restoreQueue.begin(), m_restoreQueue.begin() + i);
+  }
+
+  void TextureResidency::Trim(std::vector<Change> & a_out)
+  {
+    if (!OverBudget())
+      return;
+
+    //The list is in order of last use, so everything past the first texture used this
+    //frame was also used this frame.
+    std::vector<uint32_t> changed;
+
+    //Dropping the top level frees three quarters of a texture, and it stays usable.
+    for (uint32_t i = m_tail; i != None && OverBudget(); i = m_entries[i].prev)
+    {
+      Entry & entry = m_entries[i];
+      if (entry.lastUsed == m_frame)
+        break;
+
+      if (entry.baseLevel + 1 >= entry.data.mipLevels)
+        continue;
+
+      m_stats.residentBytes -= ResidentBytes(entry.data, entry.baseLevel) - ResidentBytes(entry.data, entry.baseLevel + 1);
+      entry.baseLevel++;
+      m_stats.mipDrops++;
+      changed.push_back(i);
+    }
+
+    for (uint32_t i = m_tail; i != None && OverBudget(); i = m_entries[i].prev)
+    {
+      Entry & entry = m_entries[i];
+      if (entry.lastUsed == m_frame)
+        break;
+
+      if (entry.baseLevel >= entry.data.mipLevels)
+        continue;
+
+      m_stats.residentBytes -= ResidentBytes(entry.data, entry.baseLevel);
+      entry.baseLevel = entry.data.mipLevels;
+      m_stats.evictions++;
+      changed.push_back(i);
+    }
+
+    //A texture may have lost a level and then been evicted. Only report where it ended up.
+    for (size_t c = 0; c < changed.size(); c++)
+    {
+      uint32_t index = changed[c];
+      bool reported = false;
+      for (size_t p = 0; p < c && !reported; p++)
+        reported = changed[p] == index;
+
+      if (!reported)
+        a_out.push_back(Change{RenderHandle{index, m_entries[index].generation}, m_entries[index].baseLevel});
+    }
+  }
+
+  void TextureResidency::EndFrame()
+  {
+    m_frame++;
+  }
+
+  TextureData const * TextureResidency::GetData(RenderHandle a_handle) const
+  {
+    Entry const * pEntry = Find(a_handle);
+    return pEntry == nullptr ? nullptr : &pEntry->data;
+  }
+
+  uint32_t TextureResidency::GetBaseLevel(RenderHandle a_handle) const
+  {
+    Entry const * pEntry = Find(a_handle);
+    return pEntry == nullptr ? 0 : pEntry->baseLevel;
+  }
+
+  TextureResidencyStats const & TextureResidency::GetStats() const
+  {
+    return m_stats;
+  }
+
+  void TextureResidency::Clear()
+  {
+    for (Entry & entry : m_entries)
+      entry.data.Clear();
+    m_entries.clear();
+    m_restoreQueue.clear();
+    m_head = None;
+    m_tail = None;
+    m_stats.residentBytes = 0;
+  }
+
+  TextureResidency::Entry * TextureResidency::Find(RenderHandle a_handle)
+  {
+    if (a_handle.index >= m_entries.size())
+      return nullptr;
+
+    Entry & entry = m_entries[a_handle.index];
+    if (!entry.inUse || entry.generation != a_handle.generation)
+      return nullptr;
+    return &entry;
+  }
+
+  TextureResidency::Entry const * TextureResidency::Find(RenderHandle a_handle) const
+  {
+    return const_cast<TextureResidency*>(this)->Find(a_handle);
+  }
+
+  void TextureResidency::Link(uint32_t a_index)
+  {
+    Entry & entry = m_entries[a_index];
+    entry.prev = None;
+    entry.next = m_head;
+    if (m_head != None)
+      m_entries[m_head].prev = a_index;
+    m_head = a_index;
+    if (m_tail == None)
+      m_tail = a_index;
+  }
+
+  void TextureResidency::Unlink(uint32_t a_index)
+  {
+    Entry & entry = m_entries[a_index];
+    if (entry.prev != None)
+      m_entries[entry.prev].next = entry.next;
+    else
+      m_head = entry.next;
+
+    if (entry.next != None)
+      m_entries[entry.next].prev = entry.prev;
+    else
+      m_tail = entry.prev;
+
+    entry.prev = None;
+    entry.next = None;
+  }
+
+  size_t TextureResidency::ResidentBytes(TextureData const & a_data, uint32_t a_baseLevel)
+  {
+    size_t size = 0;
+    for (uint32_t i = a_baseLevel; i < a_data.mipLevels; i++)
+      size += a_data.LevelDataSize(i);
+    return size;
+  }
+
+  bool TextureResidency::OverBudget() const
+  {
+    return m_stats.budget != 0 && m_stats.residentBytes > m_stats.budget;
+  }
+}
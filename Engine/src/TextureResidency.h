@@ -0,0 +1,118 @@
+//@group Renderer/RenderThread
+
+#ifndef TEXTURERESIDENCY_H
+#define TEXTURERESIDENCY_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <vector>
+
+#include "TextureData.h"
+#include "RenderResource.h"
+
+namespace Engine
+{
+  struct TextureResidencyStats
+  {
+    TextureResidencyStats();
+
+    //Fraction of binds which found the texture fully resident
+    float HitRate() const;
+
+    uint64_t  binds;          //Binds of streamable textures
+    uint64_t  hits;           //... which were fully resident
+    uint64_t  evictions;      //Textures removed from video memory
+    uint64_t  mipDrops;       //Top mip levels dropped
+    uint64_t  restores;       //Textures streamed back in to full detail
+    uint64_t  residentBytes;  //Video memory held by streamable textures
+    uint64_t  budget;         //0 if unlimited
+  };
+
+  //Decides which streamable textures stay in video memory. Only does the bookkeeping;
+  //the caller applies the changes to the actual textures. Render thread only.
+  //
+  //Textures are kept in least recently used order. When over budget, textures not used
+  //this frame first lose their top mip level, oldest first, and are only evicted if
+  //that is not enough. A texture which is bound while evicted or degraded is queued to
+  //be streamed back in. Until then the lower levels, or a placeholder, are used.
+  class TextureResidency
+  {
+  public:
+
+    //New first resident mip level for a texture. baseLevel == mipLevels means evicted.
+    struct Change
+    {
+      RenderHandle  handle;
+      uint32_t      baseLevel;
+    };
+
+    TextureResidency();
+    ~TextureResidency();
+
+    //Bytes of video memory for all streamable textures. 0 for no limit.
+    void SetBudget(uint64_t);
+
+    //Starts tracking a texture, which is fully resident. Shares its pixels.
+    void Add(RenderHandle, TextureData const &);
+    void Remove(RenderHandle);
+
+    //Records a bind. Returns false if the texture is not fully resident; it will be
+    //handed out by Restore() on a later call.
+    bool Touch(RenderHandle);
+
+    //Queued textures to bring back to full detail, oldest first, up to 'bytes' of data.
+    //The first always goes through.
+    void Restore(size_t bytes, std::vector<Change> & out);
+
+    //Degrades or evicts textures until under budget.
+    void Trim(std::vector<Change> & out);
+
+    //Textures used this frame will not be trimmed until it has ended.
+    void EndFrame();
+
+    //nullptr if the texture is not tracked
+    TextureData const * GetData(RenderHandle) const;
+    uint32_t GetBaseLevel(RenderHandle) const;
+
+    TextureResidencyStats const & GetStats() const;
+
+    void Clear();
+
+  private:
+
+    static uint32_t const None = 0xFFFF'FFFF;
+
+    struct Entry
+    {
+      TextureData data;
+      uint32_t    generation;
+      uint32_t    baseLevel;
+      uint64_t    lastUsed;
+      uint32_t    prev;       //Towards most recently used
+      uint32_t    next;       //Towards least recently used
+      bool        inUse;
+      bool        queued;
+    };
+
+    Entry * Find(RenderHandle);
+    Entry const * Find(RenderHandle) const;
+
+    void Link(uint32_t index);
+    void Unlink(uint32_t index);
+
+    //Bytes of levels [base, mipLevels)
+    static size_t ResidentBytes(TextureData const &, uint32_t baseLevel);
+    bool OverBudget() const;
+
+  private:
+
+    std::vector<Entry>    m_entries;
+    std::vector<uint32_t> m_restoreQueue;
+    uint32_t              m_head;
+    uint32_t              m_tail;
+    uint64_t              m_frame;
+    TextureResidencyStats m_stats;
+  };
+}
+
+#endif
@@ -0,0 +1,95 @@
+//@group Renderer
+
+#include <algorithm>
+
+#include "TextureWorkingSet.h"
+
+namespace Engine
+{
+  TextureWorkingSet::TextureWorkingSet()
+  {
+
+  }
+
+  void TextureWorkingSet::SetLoadOptions(TextureLoadOptions const & a_options)
+  {
+    m_loadOptions = a_options;
+  }
+
+  void TextureWorkingSet::Prefetch(uint32_t const * a_keys, size_t a_count, DecoderFactory const & a_factory)
+  {
+    for (Item & item : m_items)
+      item.wanted = false;
+
+    for (size_t i = 0; i < a_count; i++)
+    {
+      auto it = Find(a_keys[i]);
+      if (it != m_items.end() && it->key == a_keys[i])
+      {
+        it->wanted = true;
+        continue;
+      }
+
+      Texture2D::Decoder decoder = a_factory(a_keys[i]);
+      if (!decoder)
+        continue;
+
+      Ref<Texture2D> texture = Texture2D::Create();
+      texture->LoadAsync(decoder, m_loadOptions);
+      m_items.insert(it, Item{a_keys[i], true, texture});
+    }
+  }
+
+  bool TextureWorkingSet::IsReady() const
+  {
+    return PendingCount() == 0;
+  }
+
+  size_t TextureWorkingSet::PendingCount() const
+  {
+    size_t count = 0;
+    for (Item const & item : m_items)
+    {
+      if (item.wanted && !item.texture->IsReady() && !item.texture->HasFailed())
+        count++;
+    }
+    return count;
+  }
+
+  void TextureWorkingSet::ReleaseUnused()
+  {
+    m_items.erase(std::remove_if(m_items.begin(), m_items.end(), [](Item const & a_item)
+    {
+      return !a_item.wanted;
+    }), m_items.end());
+  }
+
+  Ref<Texture2D> TextureWorkingSet::Get(uint32_t a_key) const
+  {
+    auto it = Find(a_key);
+    if (it == m_items.end() || it->key != a_key)
+      return Ref<Texture2D>();
+    return it->texture;
+  }
+
+  size_t TextureWorkingSet::Size() const
+  {
+    return m_items.size();
+  }
+
+  std::vector<TextureWorkingSet::Item>::iterator TextureWorkingSet::Find(uint32_t a_key)
+  {
+    return std::lower_bound(m_items.begin(), m_items.end(), a_key, [](Item const & a_item, uint32_t a_val)
+    {
+      return a_item.key < a_val;
+    });
+  }
+
+  std::vector<TextureWorkingSet::Item>::const_iterator TextureWorkingSet::Find(uint32_t a_key) const
+  {
+    return std::lower_bound(m_items.begin(), m_items.end(), a_key, [](Item const & a_item, uint32_t a_val)
+    {
+      return a_item.key < a_val;
+    });
+  }
+}
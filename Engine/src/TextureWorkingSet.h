@@ -0,0 +1,67 @@
+//@group Renderer
+
+#ifndef TEXTUREWORKINGSET_H
+#define TEXTUREWORKINGSET_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <vector>
+#include <functional>
+
+#include "Texture.h"
+#include "Memory.h"
+
+namespace Engine
+{
+  //The textures a level needs, keyed by an application defined id (see
+  //GC::GetLevelTextures()). Prefetch() the next level's set while the current one is
+  //still playing, wait for IsReady(), then ReleaseUnused() once the switch is made.
+  //At most the textures of two levels are held at once.
+  class TextureWorkingSet
+  {
+  public:
+
+    //Returns the decoder for a key, or an empty function if there is nothing to load.
+    //Called on the calling thread; the decoder itself runs on a worker thread.
+    typedef std::function<Texture2D::Decoder(uint32_t key)> DecoderFactory;
+
+    TextureWorkingSet();
+
+    void SetLoadOptions(TextureLoadOptions const &);
+
+    //Starts loading every texture in 'keys' which is not already loaded. Textures from
+    //the previous set are kept until ReleaseUnused().
+    void Prefetch(uint32_t const * keys, size_t count, DecoderFactory const &);
+
+    //True once every texture in the last prefetched set has been uploaded, or failed.
+    bool IsReady() const;
+    size_t PendingCount() const;
+
+    //Drops textures which are not in the last prefetched set.
+    void ReleaseUnused();
+
+    //Null if the key is not loaded
+    Ref<Texture2D> Get(uint32_t key) const;
+    size_t Size() const;
+
+  private:
+
+    struct Item
+    {
+      uint32_t        key;
+      bool            wanted;
+      Ref<Texture2D>  texture;
+    };
+
+    //Items are sorted by key
+    std::vector<Item>::iterator Find(uint32_t key);
+    std::vector<Item>::const_iterator Find(uint32_t key) const;
+
+  private:
+
+    std::vector<Item>   m_items;
+    TextureLoadOptions  m_loadOptions;
+  };
+}
+
+#endif
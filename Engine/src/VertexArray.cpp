@@ -43,7 +43,7 @@ namespace Engine
     state.Set<RenderState::Attr::Type>(RenderState::Type::Command);
     state.Set<RenderState::Attr::Command>(RenderState::Command::VertexArrayCreate);
 
-    RENDER_SUBMIT(state, [resID = GetRefID().GetID()]() mutable
+    RENDER_SUBMIT(state, [resID = GetHandle()]() mutable
       {
         ::Engine::RT_VertexArray va;
         va.Init();
@@ -59,18 +59,49 @@ namespace Engine
     return ref;
   }
 
+  void VertexArray::CreateBatch(uint32_t a_count, Ref<VertexArray> * a_out)
+  {
+    if (a_count == 0)
+      return;
+
+    //Handles first, followed by scratch space for the names.
+    byte * pMem = static_cast<byte*>(RENDER_ALLOCATE(a_count * (sizeof(RenderHandle) + sizeof(RendererID))));
+    RenderHandle * pHandles = reinterpret_cast<RenderHandle*>(pMem);
+    RendererID * pIDs = reinterpret_cast<RendererID*>(pMem + a_count * sizeof(RenderHandle));
+
+    for (uint32_t i = 0; i < a_count; i++)
+    {
+      a_out[i] = Ref<VertexArray>(new VertexArray());
+      pHandles[i] = a_out[i]->GetHandle();
+    }
+
+    RenderState state = RenderState::Create();
+    state.Set<RenderState::Attr::Type>(RenderState::Type::Command);
+    state.Set<RenderState::Attr::Command>(RenderState::Command::VertexArrayCreate);
+
+    RENDER_SUBMIT(state, [pHandles, pIDs, count = a_count]()
+      {
+        ::Engine::RT_VertexArray::CreateRendererIDs(count, pIDs);
+        for (uint32_t i = 0; i < count; i++)
+        {
+          ::Engine::RT_VertexArray * pVA = ::Engine::RenderThreadData::Instance()->VAOs.insert(pHandles[i], ::Engine::RT_VertexArray());
+          pVA->Init(pIDs[i]);
+        }
+      });
+  }
+
   VertexArray::~VertexArray()
   {
     RenderState state = RenderState::Create();
     state.Set<RenderState::Attr::Type>(RenderState::Type::Command);
     state.Set<RenderState::Attr::Command>(RenderState::Command::VertexArrayDelete);
 
-    RENDER_SUBMIT(state, [resID = GetRefID().GetID()]() mutable
+    RENDER_SUBMIT(state, [resID = GetHandle()]() mutable
       {
         RT_VertexArray * pVA =  RenderThreadData::Instance()->VAOs.at(resID);
         if (pVA == nullptr)
         {
-          LOG_WARN("VertexArray::~VertexArray: RefID '{}' does not exist!", resID);
+          LOG_WARN("VertexArray::~VertexArray: handle '{}' does not exist!", resID.index);
           return;
         }
         pVA->Destroy();
@@ -84,12 +115,12 @@ namespace Engine
     state.Set<RenderState::Attr::Type>(RenderState::Type::Command);
     state.Set<RenderState::Attr::Command>(RenderState::Command::VertexArrayBind);
 
-    RENDER_SUBMIT(state, [resID = GetRefID().GetID()]() mutable
+    RENDER_SUBMIT(state, [resID = GetHandle()]() mutable
       {
         RT_VertexArray * pID =  RenderThreadData::Instance()->VAOs.at(resID);
         if (pID == nullptr)
         {
-          LOG_WARN("VertexArray::Bind(): RefID '{}' does not exist!", resID);
+          LOG_WARN("VertexArray::Bind(): handle '{}' does not exist!", resID.index);
           return;
         }
         pID->Bind();
@@ -102,12 +133,12 @@ namespace Engine
     state.Set<RenderState::Attr::Type>(RenderState::Type::Command);
     state.Set<RenderState::Attr::Command>(RenderState::Command::VertexArrayUnbind);
 
-    RENDER_SUBMIT(state, [resID = GetRefID().GetID()]()
+    RENDER_SUBMIT(state, [resID = GetHandle()]()
       {
         RT_VertexArray* pID =  RenderThreadData::Instance()->VAOs.at(resID);
         if (pID == nullptr)
         {
-          LOG_WARN("VertexArray::Unbind(): RefID '{}' does not exist!", resID);
+          LOG_WARN("VertexArray::Unbind(): handle '{}' does not exist!", resID.index);
           return;
         }
         pID->Unbind();
@@ -120,12 +151,12 @@ namespace Engine
     state.Set<RenderState::Attr::Type>(RenderState::Type::Command);
     state.Set<RenderState::Attr::Command>(RenderState::Command::VertexArrayAddVertexBuffer);
 
-    RENDER_SUBMIT(state, [vbID = a_vertexBuffer->GetRefID().GetID(), vaoID = GetRefID().GetID()]() mutable
+    RENDER_SUBMIT(state, [vbID = a_vertexBuffer->GetHandle(), vaoID = GetHandle()]() mutable
       {
         RT_VertexArray* pID =  RenderThreadData::Instance()->VAOs.at(vaoID);
         if (pID == nullptr)
         {
-          LOG_WARN("VertexArray::AddVertexBuffer(): RefID '{}' does not exist!", vaoID);
+          LOG_WARN("VertexArray::AddVertexBuffer(): handle '{}' does not exist!", vaoID.index);
           return;
         }
         pID->AddVertexBuffer(vbID);
@@ -138,12 +169,12 @@ namespace Engine
     state.Set<RenderState::Attr::Type>(RenderState::Type::Command);
     state.Set<RenderState::Attr::Command>(RenderState::Command::VertexArraySetIndexBuffer);
 
-    RENDER_SUBMIT(state, [iboID = a_indexBuffer->GetRefID().GetID(), vaoID = GetRefID().GetID()]()
+    RENDER_SUBMIT(state, [iboID = a_indexBuffer->GetHandle(), vaoID = GetHandle()]()
     {
       RT_VertexArray* pID =  RenderThreadData::Instance()->VAOs.at(vaoID);
       if (pID == nullptr)
       {
-        LOG_WARN("VertexArray::SetIndexBuffer(): RefID '{}' does not exist!", vaoID);
+        LOG_WARN("VertexArray::SetIndexBuffer(): handle '{}' does not exist!", vaoID.index);
         return;
       }
       pID->SetIndexBuffer(iboID);
@@ -21,17 +21,21 @@
 
 #include "Memory.h"
 #include "Buffer.h"
-#include "Resource.h"
+#include "RenderResource.h"
 
 namespace Engine 
 {
-  class VertexArray : public Resource
+  class VertexArray : public RenderResource<VertexArray>
   {
     VertexArray();
     void Init();
   public:
 
     static Ref<VertexArray> Create();
+
+    //Creates 'count' vertex arrays with one render command.
+    //Results are written to 'out', which must hold 'count' elements.
+    static void CreateBatch(uint32_t count, Ref<VertexArray> * out);
     ~VertexArray();
 
     void Bind() const;
@@ -0,0 +1,35 @@
+//@group Core
+
+#include <thread>
+
+#include "WorkerPool.h"
+#include "ThreadPool/gc_ThreadPool.h"
+#include "core_Assert.h"
+
+namespace Engine
+{
+  GC::ThreadPool* WorkerPool::s_instance = nullptr;
+
+  bool WorkerPool::Init()
+  {
+    BSR_ASSERT(s_instance == nullptr, "WorkerPool already initialised!");
+
+    //Leave room for the main and render threads.
+    size_t nThreads = std::thread::hardware_concurrency();
+    nThreads = nThreads > 2 ? nThreads - 2 : 1;
+
+    s_instance = new GC::ThreadPool(nThreads);
+    return true;
+  }
+
+  void WorkerPool::ShutDown()
+  {
+    delete s_instance;
+    s_instance = nullptr;
+  }
+
+  GC::ThreadPool* WorkerPool::Instance()
+  {
+    return s_instance;
+  }
+}
@@ -0,0 +1,29 @@
+//@group Core
+
+#ifndef WORKERPOOL_H
+#define WORKERPOOL_H
+
+namespace GC
+{
+  class ThreadPool;
+}
+
+namespace Engine
+{
+  //Worker threads for work which should stay off the main and render threads,
+  //such as parsing shaders and decoding textures.
+  class WorkerPool
+  {
+    static GC::ThreadPool* s_instance;
+  public:
+
+    static bool Init();
+    static void ShutDown();
+
+    //Returns nullptr if the pool has not been initialised. Callers should
+    //then run their jobs inline.
+    static GC::ThreadPool* Instance();
+  };
+}
+
+#endif
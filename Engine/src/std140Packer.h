@@ -0,0 +1,368 @@
+//@group Renderer
+
+#ifndef STD140PACKER_H
+#define STD140PACKER_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <cstring>
+#include <array>
+#include <utility>
+#include <type_traits>
+
+#include "ShaderUtils.h"
+#include "ShaderUniform.h"
+#include "core_utils.h"
+
+// Compile-time std140 layouts for C++ structs. Each field of the struct is described by
+// its GLSL type, its byte offset in the struct and its array count. The std140 layout is
+// computed at compile time and packing reduces to a fixed sequence of memcpys, with
+// neighbouring copies merged.
+//
+// Source data must be tightly packed: a vec3 is 3 floats, a mat4 is 16 floats stored
+// column by column, a bool is 4 bytes. Matrices are column-major.
+//
+// Example:
+//
+//   struct Light
+//   {
+//     float colour[3];
+//     float intensity;
+//     float transform[16];
+//   };
+//
+//   typedef std140Packer<Light,
+//     std140Field<ShaderDataType::VEC3, offsetof(Light, colour)>,
+//     std140Field<ShaderDataType::FLOAT, offsetof(Light, intensity)>,
+//     std140Field<ShaderDataType::MAT4, offsetof(Light, transform)>> LightPacker;
+//
+//   static_assert(LightPacker::Size == 80);
+//   LightPacker::Pack(buffer, light);
+
+namespace Engine
+{
+  template<ShaderDataType Type, size_t SrcOffset, uint32_t Count = 1>
+  struct std140Field
+  {
+    static ShaderDataType const type = Type;
+    static uint32_t const srcOffset = static_cast<uint32_t>(SrcOffset);
+    static uint32_t const count = Count;
+  };
+
+  namespace impl
+  {
+    struct std140FieldDesc
+    {
+      ShaderDataType  type;
+      uint32_t        srcOffset;
+      uint32_t        count;
+    };
+
+    struct std140Copy
+    {
+      uint32_t src;
+      uint32_t dst;
+      uint32_t size;
+    };
+
+    constexpr uint32_t std140Align(uint32_t a_value, uint32_t a_alignment)
+    {
+      return (a_value + a_alignment - 1) / a_alignment * a_alignment;
+    }
+
+    //A matrix is stored as an array of column vectors. Everything else has one column.
+    constexpr uint32_t std140Columns(ShaderDataType a_type)
+    {
+      switch (a_type)
+      {
+        case ShaderDataType::MAT2:
+        case ShaderDataType::MAT2x2:
+        case ShaderDataType::MAT2x3:
+        case ShaderDataType::MAT2x4:
+          return 2;
+        case ShaderDataType::MAT3:
+        case ShaderDataType::MAT3x3:
+        case ShaderDataType::MAT3x2:
+        case ShaderDataType::MAT3x4:
+          return 3;
+        case ShaderDataType::MAT4:
+        case ShaderDataType::MAT4x4:
+        case ShaderDataType::MAT4x2:
+        case ShaderDataType::MAT4x3:
+          return 4;
+        default:
+          return 1;
+      }
+    }
+
+    //Components per column. Returns 0 for types which cannot be placed in a block.
+    constexpr uint32_t std140Rows(ShaderDataType a_type)
+    {
+      switch (a_type)
+      {
+        case ShaderDataType::BOOL:
+        case ShaderDataType::INT:
+        case ShaderDataType::UINT:
+        case ShaderDataType::FLOAT:
+          return 1;
+        case ShaderDataType::BVEC2:
+        case ShaderDataType::IVEC2:
+        case ShaderDataType::UVEC2:
+        case ShaderDataType::VEC2:
+        case ShaderDataType::MAT2:
+        case ShaderDataType::MAT2x2:
+        case ShaderDataType::MAT3x2:
+        case ShaderDataType::MAT4x2:
+          return 2;
+        case ShaderDataType::BVEC3:
+        case ShaderDataType::IVEC3:
+        case ShaderDataType::UVEC3:
+        case ShaderDataType::VEC3:
+        case ShaderDataType::MAT3:
+        case ShaderDataType::MAT3x3:
+        case ShaderDataType::MAT2x3:
+        case ShaderDataType::MAT4x3:
+          return 3;
+        case ShaderDataType::BVEC4:
+        case ShaderDataType::IVEC4:
+        case ShaderDataType::UVEC4:
+        case ShaderDataType::VEC4:
+        case ShaderDataType::MAT4:
+        case ShaderDataType::MAT4x4:
+        case ShaderDataType::MAT2x4:
+        case ShaderDataType::MAT3x4:
+          return 4;
+        default:
+          return 0;
+      }
+    }
+
+    //All block types have 4-byte components.
+    constexpr uint32_t std140ColumnSize(ShaderDataType a_type)
+    {
+      return std140Rows(a_type) * 4;
+    }
+
+    //Arrays and matrices have their column stride rounded up to a vec4.
+    constexpr bool std140IsPadded(ShaderDataType a_type, uint32_t a_count)
+    {
+      return a_count > 1 || std140Columns(a_type) > 1;
+    }
+
+    constexpr uint32_t std140BaseAlignment(ShaderDataType a_type, uint32_t a_count)
+    {
+      if (std140IsPadded(a_type, a_count))
+        return 16;
+      return std140Rows(a_type) == 3 ? 16 : std140ColumnSize(a_type);
+    }
+
+    constexpr uint32_t std140ColumnStride(ShaderDataType a_type, uint32_t a_count)
+    {
+      if (std140IsPadded(a_type, a_count))
+        return 16;
+      return std140ColumnSize(a_type);
+    }
+
+    //-------------------------------------------------------------------------------------
+    // Layout
+    //-------------------------------------------------------------------------------------
+
+    //Offset of each field, followed by the size of the block.
+    template<size_t N>
+    constexpr std::array<uint32_t, N + 1> std140Offsets(std::array<std140FieldDesc, N> const & a_fields)
+    {
+      std::array<uint32_t, N + 1> result{};
+      uint32_t offset = 0;
+      for (size_t i = 0; i < N; i++)
+      {
+        std140FieldDesc const & field = a_fields[i];
+        offset = std140Align(offset, std140BaseAlignment(field.type, field.count));
+        result[i] = offset;
+
+        uint32_t columns = std140Columns(field.type) * field.count;
+        if (std140IsPadded(field.type, field.count))
+          offset += columns * std140ColumnStride(field.type, field.count);
+        else
+          offset += std140ColumnSize(field.type);
+      }
+
+      //A block is padded out to a vec4
+      result[N] = std140Align(offset, 16);
+      return result;
+    }
+
+    template<size_t N>
+    constexpr bool std140FieldsValid(std::array<std140FieldDesc, N> const & a_fields)
+    {
+      for (size_t i = 0; i < N; i++)
+      {
+        if (std140Rows(a_fields[i].type) == 0 || a_fields[i].count == 0)
+          return false;
+      }
+      return true;
+    }
+
+    template<size_t N>
+    constexpr bool std140SourceInBounds(std::array<std140FieldDesc, N> const & a_fields, size_t a_srcSize)
+    {
+      for (size_t i = 0; i < N; i++)
+      {
+        std140FieldDesc const & field = a_fields[i];
+        uint32_t size = std140Columns(field.type) * std140ColumnSize(field.type) * field.count;
+        if (field.srcOffset + size > a_srcSize)
+          return false;
+      }
+      return true;
+    }
+
+    //-------------------------------------------------------------------------------------
+    // Copy sequence
+    //-------------------------------------------------------------------------------------
+
+    template<size_t N>
+    constexpr size_t std140ColumnCopyCount(std::array<std140FieldDesc, N> const & a_fields)
+    {
+      size_t count = 0;
+      for (size_t i = 0; i < N; i++)
+        count += std140Columns(a_fields[i].type) * a_fields[i].count;
+      return count;
+    }
+
+    //One copy per column, before merging.
+    template<size_t R, size_t N>
+    constexpr std::array<std140Copy, R> std140ColumnCopies(std::array<std140FieldDesc, N> const & a_fields,
+                                                           std::array<uint32_t, N + 1> const & a_offsets)
+    {
+      std::array<std140Copy, R> result{};
+      size_t index = 0;
+      for (size_t i = 0; i < N; i++)
+      {
+        std140FieldDesc const & field = a_fields[i];
+        uint32_t columns = std140Columns(field.type) * field.count;
+        uint32_t columnSize = std140ColumnSize(field.type);
+        uint32_t stride = std140ColumnStride(field.type, field.count);
+        for (uint32_t c = 0; c < columns; c++)
+        {
+          result[index] = std140Copy{field.srcOffset + c * columnSize, a_offsets[i] + c * stride, columnSize};
+          index++;
+        }
+      }
+      return result;
+    }
+
+    constexpr bool std140Contiguous(std140Copy const & a_prev, std140Copy const & a_next)
+    {
+      return (a_prev.src + a_prev.size == a_next.src) && (a_prev.dst + a_prev.size == a_next.dst);
+    }
+
+    template<size_t R>
+    constexpr size_t std140MergedCopyCount(std::array<std140Copy, R> const & a_copies)
+    {
+      size_t count = R == 0 ? 0 : 1;
+      for (size_t i = 1; i < R; i++)
+      {
+        if (!std140Contiguous(a_copies[i - 1], a_copies[i]))
+          count++;
+      }
+      return count;
+    }
+
+    template<size_t M, size_t R>
+    constexpr std::array<std140Copy, M> std140MergeCopies(std::array<std140Copy, R> const & a_copies)
+    {
+      std::array<std140Copy, M> result{};
+      if (R == 0)
+        return result;
+
+      size_t index = 0;
+      result[0] = a_copies[0];
+      for (size_t i = 1; i < R; i++)
+      {
+        if (std140Contiguous(a_copies[i - 1], a_copies[i]))
+        {
+          result[index].size += a_copies[i].size;
+        }
+        else
+        {
+          index++;
+          result[index] = a_copies[i];
+        }
+      }
+      return result;
+    }
+  }
+
+  template<typename T, typename ... Fields>
+  class std140Packer
+  {
+    static_assert(sizeof...(Fields) > 0, "std140Packer needs at least one field");
+    static_assert(std::is_trivially_copyable<T>::value, "std140Packer: 'T' must be trivially copyable");
+
+    typedef impl::std140FieldDesc FieldDesc;
+    typedef impl::std140Copy      Copy;
+
+    static constexpr size_t FieldCount = sizeof...(Fields);
+
+    static constexpr std::array<FieldDesc, FieldCount> s_fields = 
+      {{FieldDesc{Fields::type, Fields::srcOffset, Fields::count}...}};
+
+    static_assert(impl::std140FieldsValid(s_fields), "std140Packer: field type cannot be placed in a uniform block, or has a count of 0");
+    static_assert(impl::std140SourceInBounds(s_fields, sizeof(T)), "std140Packer: field extends past the end of the source struct");
+
+    static constexpr std::array<uint32_t, FieldCount + 1> s_offsets = impl::std140Offsets(s_fields);
+
+    static constexpr size_t ColumnCopyCount = impl::std140ColumnCopyCount(s_fields);
+    static constexpr std::array<Copy, ColumnCopyCount> s_columnCopies = 
+      impl::std140ColumnCopies<ColumnCopyCount>(s_fields, s_offsets);
+
+    static constexpr size_t MergedCopyCount = impl::std140MergedCopyCount(s_columnCopies);
+    static constexpr std::array<Copy, MergedCopyCount> s_copies = 
+      impl::std140MergeCopies<MergedCopyCount>(s_columnCopies);
+
+    template<size_t ... I>
+    static void PackImpl(byte * a_pDst, byte const * a_pSrc, std::index_sequence<I...>)
+    {
+      (memcpy(a_pDst + s_copies[I].dst, a_pSrc + s_copies[I].src, s_copies[I].size), ...);
+    }
+
+  public:
+
+    //Size of the block in bytes, including trailing padding.
+    static constexpr uint32_t Size = s_offsets[FieldCount];
+
+    //Number of memcpys a Pack() performs.
+    static constexpr uint32_t CopyCount = static_cast<uint32_t>(MergedCopyCount);
+
+    //std140 offset of a field in the block.
+    static constexpr uint32_t Offset(size_t a_index)
+    {
+      return s_offsets[a_index];
+    }
+
+    //Destination must hold at least 'Size' bytes. Padding bytes are left untouched.
+    static void Pack(void * a_pDst, T const & a_src)
+    {
+      PackImpl(static_cast<byte *>(a_pDst), reinterpret_cast<byte const *>(&a_src),
+               std::make_index_sequence<MergedCopyCount>());
+    }
+
+    //Reflection is only available at runtime, so checking the layout against the
+    //shader has to happen here. Compares type and count of each field in order,
+    //beginning at 'first'.
+    static bool Matches(ShaderUniformList const & a_uniforms, size_t a_first = 0)
+    {
+      if (a_first + FieldCount > a_uniforms.size())
+        return false;
+
+      for (size_t i = 0; i < FieldCount; i++)
+      {
+        ShaderUniformDeclaration const & decl = a_uniforms[a_first + i];
+        if (decl.GetType() != s_fields[i].type || decl.GetCount() != s_fields[i].count)
+          return false;
+      }
+      return true;
+    }
+  };
+}
+
+#endif
@@ -0,0 +1,13 @@
+#version 430 core
+
+in vec2 texCoord;
+flat in float layer;
+out vec4 FragColor;
+
+//All tiles of one size, one per layer
+uniform sampler2DArray u_tiles;
+
+void main()
+{
+  FragColor = texture(u_tiles, vec3(texCoord, layer));
+}
\ No newline at end of file
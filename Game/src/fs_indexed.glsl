@@ -0,0 +1,17 @@
+#version 430 core
+
+in vec2 texCoord;
+out vec4 FragColor;
+
+//8-bit palette indices, stored in the red channel
+uniform sampler2D texture1;
+
+//256 colours per row. Switching rows gives palette effects for free.
+uniform sampler2D u_palette;
+uniform int u_paletteRow;
+
+void main()
+{
+  int index = int(texture(texture1, texCoord).r * 255.0 + 0.5);
+  FragColor = texelFetch(u_palette, ivec2(index, u_paletteRow), 0);
+}
@@ -190,7 +190,6 @@ public:
     m_material = Engine::Material::Create(refProg);
 
     m_material->SetTexture("texture1", m_texture);
-    m_material->Bind();
 
     Engine::UIGroup* pg0 = new Engine::UIGroup("g0", vec3(0.25f, 0.25f, 0.0f), vec3(0.5f, 0.5f, 0.0f));
     Engine::UIButton* btn0 = new Engine::UIButton("btn0", vec3(0.0f, 0.0f, 0.0f), vec3(1.0f, 0.5f, 0.0f));
@@ -242,9 +241,11 @@ public:
   {
     Engine::Renderer::Clear(1.0f, 0.0f, 1.0f);
 
-    m_material->Bind();
-    m_va->Bind();
+    //Program might still be compiling
+    if (!m_material->Bind())
+      return;
 
+    m_va->Bind();
     Engine::Renderer::DrawIndexed(6, false);
 
   }
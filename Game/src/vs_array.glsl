@@ -0,0 +1,17 @@
+#version 430
+
+layout (location = 0) in vec2 inPos;
+layout (location = 1) in vec2 inTexCoord;
+
+//Layer of the tile in the texture array. Per vertex, or per instance with a divisor.
+layout (location = 2) in float inLayer;
+
+out vec2 texCoord;
+flat out float layer;
+
+void main()
+{
+    gl_Position = vec4(inPos, 0.0, 1.0);
+    texCoord = inTexCoord;
+    layer = inLayer;
+}
\ No newline at end of file
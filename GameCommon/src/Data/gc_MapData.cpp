@@ -8,16 +8,6 @@
 
 namespace GC
 {
-  BSP_Node::Meta const BSP_Node::s_meta[6] =
-  {
-    {31, 1},
-    {0, 31},
-    {0, 12},
-    {12, 12},
-    {24, 6},
-    {30, 1},
-  };
-
   Arc const Corner::Arcs[4] = 
   {
     {{0.0f, 1.0f, 0.0f},  {1.0f, 0.0f, 0.0f}},
@@ -51,5 +41,25 @@ namespace GC
 
   }
 
+  void Block::SetX(uint32_t a_val)
+  {
+    m_data = (m_data & 0xFFFFFF00) | (a_val & 0xFF);
+  }
+
+  void Block::SetY(uint32_t a_val)
+  {
+    m_data = (m_data & 0xFFFF00FF) | ((a_val & 0xFF) << 8);
+  }
+
+  void Block::SetW(uint32_t a_val)
+  {
+    m_data = (m_data & 0xFF00FFFF) | ((a_val & 0xFF) << 16);
+  }
+
+  void Block::SetH(uint32_t a_val)
+  {
+    m_data = (m_data & 0x00FFFFFF) | ((a_val & 0xFF) << 24);
+  }
+
   
 }
\ No newline at end of file
@@ -76,7 +76,15 @@ namespace GC
       uint32_t size;
     };
 
-    static Meta const s_meta[6];
+    static constexpr Meta s_meta[6] =
+    {
+      {31, 1},
+      {0, 31},
+      {0, 12},
+      {12, 12},
+      {24, 6},
+      {30, 1},
+    };
 
   public:
 
@@ -113,14 +121,14 @@ namespace GC
     template<Item item>
     uint32_t Get() const
     {
-      DataType ind = static_cast<DataType>(item);
+      constexpr DataType ind = static_cast<DataType>(item);
       return Dg::GetSubInt<DataType, s_meta[ind].loc, s_meta[ind].size>(m_data);
     }
 
     template<Item item>
     void Set(uint32_t a_val)
     {
-      DataType ind = static_cast<DataType>(item);
+      constexpr DataType ind = static_cast<DataType>(item);
       m_data = Dg::SetSubInt<DataType, s_meta[ind].loc, s_meta[ind].size>(m_data, a_val);
     }
 
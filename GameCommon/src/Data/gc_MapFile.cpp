@@ -0,0 +1,345 @@
+#include <string.h>
+#include <type_traits>
+
+#include "gc_MapFile.h"
+#include "DgFileStream.h"
+#include "DgEndian.h"
+#include "core_Log.h"
+
+namespace GC
+{
+  static_assert(sizeof(MapFileHeader) % MapFileAlignment == 0, "MapFileHeader must keep the directory aligned");
+  static_assert(sizeof(MapRecordHeader) % MapFileAlignment == 0, "MapRecordHeader must keep its sections aligned");
+  static_assert(sizeof(Block) == 4 && sizeof(BSP_Node) == 4 && sizeof(AssociatedGeometry) == 4, "Map data must be packed to be used in place");
+  static_assert(std::is_trivially_copyable<Wall>::value && std::is_trivially_copyable<Corner>::value, "Map data must be used in place");
+
+  static size_t AlignUp(size_t a_value)
+  {
+    return (a_value + MapFileAlignment - 1) & ~size_t(MapFileAlignment - 1);
+  }
+
+  static uint32_t SectionIndex(MapSection a_section)
+  {
+    return static_cast<uint32_t>(a_section);
+  }
+
+  //-----------------------------------------------------------------------------------------------
+  // MapFile
+  //-----------------------------------------------------------------------------------------------
+
+  MapFile::MapFile()
+    : m_pData(nullptr)
+    , m_size(0)
+  {
+
+  }
+
+  bool MapFile::Attach(void const * a_pData, size_t a_size)
+  {
+    Clear();
+
+    if ((reinterpret_cast<uintptr_t>(a_pData) % MapFileAlignment) != 0)
+    {
+      LOG_ERROR("MapFile::Attach(): Data is not aligned");
+      return false;
+    }
+
+    m_pData = static_cast<uint8_t const *>(a_pData);
+    m_size = a_size;
+
+    if (!Validate())
+    {
+      Clear();
+      return false;
+    }
+    return true;
+  }
+
+  bool MapFile::Load(std::string const & a_path)
+  {
+    Clear();
+
+    Dg::FileStream fs(a_path, Dg::StreamOpenMode::read);
+    if (!fs.IsOpen())
+    {
+      LOG_ERROR((std::string("Failed to open ") + a_path).c_str());
+      return false;
+    }
+
+    Dg::IO::ReturnType result = fs.GetSize();
+    if (result.error != Dg::ErrorCode::None)
+    {
+      LOG_ERROR("Failed to get the size of {}: {}", a_path, Dg::ErrorCodeToString(result.error));
+      return false;
+    }
+
+    //uint64_t storage keeps the data aligned for Attach()
+    size_t size = size_t(result.value);
+    std::vector<uint64_t> storage((size + sizeof(uint64_t) - 1) / sizeof(uint64_t) + 1);
+    size_t padding = (MapFileAlignment - (reinterpret_cast<uintptr_t>(storage.data()) % MapFileAlignment)) % MapFileAlignment;
+    uint8_t * pData = reinterpret_cast<uint8_t *>(storage.data()) + padding;
+
+    result = fs.Read(pData, Dg::IO::myInt(size));
+    if (result.error != Dg::ErrorCode::None || result.value != Dg::IO::myInt(size))
+    {
+      LOG_ERROR("Failed to read {}: {}", a_path, Dg::ErrorCodeToString(result.error));
+      return false;
+    }
+
+    if (!Attach(pData, size))
+      return false;
+
+    m_storage.swap(storage);
+    return true;
+  }
+
+  void MapFile::Clear()
+  {
+    m_storage.clear();
+    m_pData = nullptr;
+    m_size = 0;
+  }
+
+  uint32_t MapFile::GetMapCount() const
+  {
+    if (m_pData == nullptr)
+      return 0;
+    return reinterpret_cast<MapFileHeader const *>(m_pData)->mapCount;
+  }
+
+  MapView MapFile::GetMap(uint32_t a_index) const
+  {
+    BSR_ASSERT(a_index < GetMapCount(), "MapFile::GetMap(): Index out of range");
+
+    MapFileHeader const * pHeader = reinterpret_cast<MapFileHeader const *>(m_pData);
+    MapDirectoryEntry const * pDirectory = reinterpret_cast<MapDirectoryEntry const *>(m_pData + pHeader->directoryOffset);
+    MapRecordHeader const * pMap = reinterpret_cast<MapRecordHeader const *>(m_pData + pDirectory[a_index].offset);
+
+    MapView view;
+    view.pHeader = pMap;
+    view.blocks = GetSection<Block>(pMap, MapSection::Blocks);
+    view.bspNodes = GetSection<BSP_Node>(pMap, MapSection::BSPNodes);
+    view.walls = GetSection<Wall>(pMap, MapSection::Walls);
+    view.corners = GetSection<Corner>(pMap, MapSection::Corners);
+    view.associatedWalls = GetSection<uint32_t>(pMap, MapSection::AssociatedWalls);
+    view.associatedCorners = GetSection<uint32_t>(pMap, MapSection::AssociatedCorners);
+    view.associatedGeometry = GetSection<AssociatedGeometry>(pMap, MapSection::AssociatedGeometry);
+    view.planes[0] = GetSection<uint16_t>(pMap, MapSection::Plane0);
+    view.planes[1] = GetSection<uint16_t>(pMap, MapSection::Plane1);
+    return view;
+  }
+
+  template<typename T>
+  MapArray<T> MapFile::GetSection(MapRecordHeader const * a_pMap, MapSection a_section) const
+  {
+    MapSectionEntry const & entry = a_pMap->sections[SectionIndex(a_section)];
+    MapArray<T> result;
+    result.data = reinterpret_cast<T const *>(reinterpret_cast<uint8_t const *>(a_pMap) + entry.offset);
+    result.count = entry.count;
+    return result;
+  }
+
+  bool MapFile::Validate() const
+  {
+    if (Dg::Endianness() != Dg::Endian::Little)
+    {
+      LOG_ERROR("MapFile: Map files can only be used on little endian machines");
+      return false;
+    }
+
+    if (m_size < sizeof(MapFileHeader))
+    {
+      LOG_ERROR("MapFile: File is too small");
+      return false;
+    }
+
+    MapFileHeader const * pHeader = reinterpret_cast<MapFileHeader const *>(m_pData);
+    if (pHeader->magic != MapFileMagic)
+    {
+      LOG_ERROR("MapFile: Not a map file");
+      return false;
+    }
+
+    if (pHeader->version != MapFileVersion)
+    {
+      LOG_ERROR("MapFile: Version {} is not supported, expected {}", pHeader->version, MapFileVersion);
+      return false;
+    }
+
+    if (pHeader->fileSize != m_size)
+    {
+      LOG_ERROR("MapFile: File is {} bytes, expected {}", m_size, pHeader->fileSize);
+      return false;
+    }
+
+    if (pHeader->directoryOffset % MapFileAlignment != 0
+      || pHeader->directoryOffset > m_size
+      || uint64_t(pHeader->mapCount) * sizeof(MapDirectoryEntry) > m_size - pHeader->directoryOffset)
+    {
+      LOG_ERROR("MapFile: Map directory is out of range");
+      return false;
+    }
+
+    for (uint32_t i = 0; i < pHeader->mapCount; i++)
+    {
+      if (!ValidateMap(i))
+        return false;
+    }
+    return true;
+  }
+
+  bool MapFile::ValidateMap(uint32_t a_index) const
+  {
+    static uint32_t const s_elementSizes[static_cast<uint32_t>(MapSection::COUNT)] =
+    {
+      uint32_t(sizeof(Block)),
+      uint32_t(sizeof(BSP_Node)),
+      uint32_t(sizeof(Wall)),
+      uint32_t(sizeof(Corner)),
+      uint32_t(sizeof(uint32_t)),
+      uint32_t(sizeof(uint32_t)),
+      uint32_t(sizeof(AssociatedGeometry)),
+      uint32_t(sizeof(uint16_t)),
+      uint32_t(sizeof(uint16_t))
+    };
+
+    MapFileHeader const * pHeader = reinterpret_cast<MapFileHeader const *>(m_pData);
+    MapDirectoryEntry const & entry = reinterpret_cast<MapDirectoryEntry const *>(m_pData + pHeader->directoryOffset)[a_index];
+
+    if (entry.offset % MapFileAlignment != 0
+      || entry.offset > m_size
+      || entry.size > m_size - entry.offset
+      || entry.size < sizeof(MapRecordHeader))
+    {
+      LOG_ERROR("MapFile: Map {} is out of range", a_index);
+      return false;
+    }
+
+    MapRecordHeader const * pMap = reinterpret_cast<MapRecordHeader const *>(m_pData + entry.offset);
+    uint64_t tiles = uint64_t(pMap->width) * uint64_t(pMap->height);
+
+    for (uint32_t s = 0; s < static_cast<uint32_t>(MapSection::COUNT); s++)
+    {
+      MapSectionEntry const & section = pMap->sections[s];
+      if (section.count == 0)
+        continue;
+
+      if (section.elementSize != s_elementSizes[s]
+        || section.offset % MapFileAlignment != 0
+        || section.offset > entry.size
+        || uint64_t(section.count) * section.elementSize > entry.size - section.offset)
+      {
+        LOG_ERROR("MapFile: Section {} of map {} is invalid", s, a_index);
+        return false;
+      }
+    }
+
+    if (pMap->sections[SectionIndex(MapSection::Plane0)].count != tiles
+      || pMap->sections[SectionIndex(MapSection::Plane1)].count != tiles)
+    {
+      LOG_ERROR("MapFile: Planes of map {} do not match its size", a_index);
+      return false;
+    }
+
+    uint32_t geometryCount = pMap->sections[SectionIndex(MapSection::AssociatedGeometry)].count;
+    if (geometryCount != 0 && geometryCount != tiles)
+    {
+      LOG_ERROR("MapFile: Associated geometry of map {} does not match its size", a_index);
+      return false;
+    }
+    return true;
+  }
+
+  //-----------------------------------------------------------------------------------------------
+  // MapFileBuilder
+  //-----------------------------------------------------------------------------------------------
+
+  MapFileBuilder::MapFileBuilder(uint32_t a_mapCount)
+    : m_mapCount(a_mapCount)
+    , m_currentMap(0)
+    , m_mapStart(0)
+  {
+    MapFileHeader header = {};
+    header.magic = MapFileMagic;
+    header.version = MapFileVersion;
+    header.mapCount = a_mapCount;
+    header.directoryOffset = sizeof(MapFileHeader);
+
+    m_data.resize(sizeof(MapFileHeader) + a_mapCount * sizeof(MapDirectoryEntry), 0);
+    memcpy(m_data.data(), &header, sizeof(MapFileHeader));
+    Align();
+  }
+
+  void MapFileBuilder::BeginMap(char const (&a_name)[16], uint16_t a_width, uint16_t a_height,
+                                uint8_t a_ceilingTile, uint8_t a_floorTile)
+  {
+    BSR_ASSERT(m_currentMap < m_mapCount, "MapFileBuilder::BeginMap(): Too many maps");
+
+    if (m_mapStart != 0)
+      EndMap();
+
+    MapRecordHeader header = {};
+    memcpy(header.name, a_name, sizeof(header.name));
+    header.width = a_width;
+    header.height = a_height;
+    header.ceilingTile = a_ceilingTile;
+    header.floorTile = a_floorTile;
+
+    m_mapStart = m_data.size();
+    m_data.resize(m_mapStart + sizeof(MapRecordHeader));
+    memcpy(m_data.data() + m_mapStart, &header, sizeof(MapRecordHeader));
+  }
+
+  void MapFileBuilder::AddSection(MapSection a_section, void const * a_pData, uint32_t a_count, uint32_t a_elementSize,
+                                  uint64_t a_sourceHash)
+  {
+    BSR_ASSERT(m_mapStart != 0, "MapFileBuilder::AddSection(): No map begun");
+
+    Align();
+
+    MapSectionEntry section = {};
+    section.sourceHash = a_sourceHash;
+    section.offset = uint32_t(m_data.size() - m_mapStart);
+    section.count = a_count;
+    section.elementSize = a_elementSize;
+
+    size_t offset = m_mapStart + offsetof(MapRecordHeader, sections) + SectionIndex(a_section) * sizeof(MapSectionEntry);
+    memcpy(m_data.data() + offset, &section, sizeof(MapSectionEntry));
+
+    size_t size = size_t(a_count) * a_elementSize;
+    size_t start = m_data.size();
+    m_data.resize(start + size);
+    if (size != 0)
+      memcpy(m_data.data() + start, a_pData, size);
+  }
+
+  std::vector<uint8_t> const & MapFileBuilder::Finish()
+  {
+    BSR_ASSERT(m_currentMap + (m_mapStart != 0 ? 1 : 0) == m_mapCount, "MapFileBuilder::Finish(): Maps missing");
+
+    if (m_mapStart != 0)
+      EndMap();
+
+    uint64_t fileSize = m_data.size();
+    memcpy(m_data.data() + offsetof(MapFileHeader, fileSize), &fileSize, sizeof(fileSize));
+    return m_data;
+  }
+
+  void MapFileBuilder::Align()
+  {
+    m_data.resize(AlignUp(m_data.size()), 0);
+  }
+
+  void MapFileBuilder::EndMap()
+  {
+    Align();
+
+    MapDirectoryEntry entry;
+    entry.offset = m_mapStart;
+    entry.size = m_data.size() - m_mapStart;
+    memcpy(m_data.data() + sizeof(MapFileHeader) + m_currentMap * sizeof(MapDirectoryEntry), &entry, sizeof(entry));
+
+    m_currentMap++;
+    m_mapStart = 0;
+  }
+}
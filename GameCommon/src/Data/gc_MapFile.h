@@ -0,0 +1,180 @@
+#ifndef GC_MAPFILE_H
+#define GC_MAPFILE_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string>
+#include <vector>
+
+#include "gc_MapData.h"
+
+namespace GC
+{
+  //---------------------------------------------------------------------------------------
+  // GAMEMAPS.BSR
+  //
+  // The file is laid out exactly as it is used, so it can be memory mapped and read in
+  // place. Loading a map only turns offsets into pointers.
+  //
+  //   MapFileHeader
+  //   MapDirectoryEntry[mapCount]
+  //   per map: MapRecordHeader, then its sections
+  //
+  // Every record and section starts on a MapFileAlignment boundary. Section offsets are
+  // from the start of their map record. Little endian only.
+  //
+  // Each section records a hash of what it was built from, so a converter can tell
+  // which sections of an existing file are still up to date.
+  //---------------------------------------------------------------------------------------
+
+  uint32_t const MapFileMagic = 0x4D525342; //"BSRM"
+  uint32_t const MapFileVersion = 2;
+  uint32_t const MapFileAlignment = 16;
+
+  enum class MapSection : uint32_t
+  {
+    Blocks,             //Block
+    BSPNodes,           //BSP_Node, root first
+    Walls,              //Wall
+    Corners,            //Corner
+    AssociatedWalls,    //uint32_t. Per list, a count followed by that many wall indices.
+    AssociatedCorners,  //uint32_t. As above, for corners.
+    AssociatedGeometry, //AssociatedGeometry per tile, row by row. Start of each tile's lists.
+    Plane0,             //uint16_t per tile, row by row
+    Plane1,
+    COUNT
+  };
+
+  struct MapFileHeader
+  {
+    uint32_t  magic;
+    uint32_t  version;
+    uint32_t  mapCount;
+    uint32_t  reserved;
+    uint64_t  fileSize;
+    uint64_t  directoryOffset;
+  };
+
+  struct MapDirectoryEntry
+  {
+    uint64_t  offset;
+    uint64_t  size;
+  };
+
+  struct MapSectionEntry
+  {
+    uint64_t  sourceHash;   //0 if unknown
+    uint32_t  offset;
+    uint32_t  count;
+    uint32_t  elementSize;
+    uint32_t  reserved;
+  };
+
+  struct MapRecordHeader
+  {
+    char            name[16];
+    uint16_t        width;
+    uint16_t        height;
+    uint8_t         ceilingTile;
+    uint8_t         floorTile;
+    uint8_t         reserved[2];
+    MapSectionEntry sections[static_cast<uint32_t>(MapSection::COUNT)];
+  };
+
+  //A section of a map, in place in the file
+  template<typename T>
+  struct MapArray
+  {
+    T const * data;
+    uint32_t  count;
+
+    T const & operator[](uint32_t a_index) const {return data[a_index];}
+    T const * begin() const {return data;}
+    T const * end() const {return data + count;}
+  };
+
+  struct MapView
+  {
+    MapRecordHeader const *       pHeader;
+    MapArray<Block>               blocks;
+    MapArray<BSP_Node>            bspNodes;
+    MapArray<Wall>                walls;
+    MapArray<Corner>              corners;
+    MapArray<uint32_t>            associatedWalls;
+    MapArray<uint32_t>            associatedCorners;
+    MapArray<AssociatedGeometry>  associatedGeometry;
+    MapArray<uint16_t>            planes[2];
+  };
+
+  //Read access to a GAMEMAPS.BSR file. The whole file is checked when attached, so
+  //getting a map afterwards cannot fail.
+  class MapFile
+  {
+  public:
+
+    MapFile();
+
+    //Uses the data in place, e.g. a memory mapped file. It must stay valid while
+    //attached, and be aligned to MapFileAlignment.
+    bool Attach(void const * data, size_t size);
+
+    //Reads the whole file into memory owned by this object.
+    bool Load(std::string const & path);
+
+    void Clear();
+
+    uint32_t GetMapCount() const;
+    MapView GetMap(uint32_t index) const;
+
+  private:
+
+    bool Validate() const;
+    bool ValidateMap(uint32_t index) const;
+
+    template<typename T>
+    MapArray<T> GetSection(MapRecordHeader const *, MapSection) const;
+
+  private:
+
+    std::vector<uint64_t> m_storage;
+    uint8_t const *       m_pData;
+    size_t                m_size;
+  };
+
+  //Assembles a GAMEMAPS.BSR file in memory.
+  class MapFileBuilder
+  {
+  public:
+
+    MapFileBuilder(uint32_t mapCount);
+
+    //Maps are added in order. Sections belong to the last map begun.
+    void BeginMap(char const (&name)[16], uint16_t width, uint16_t height,
+                  uint8_t ceilingTile, uint8_t floorTile);
+    void AddSection(MapSection, void const * data, uint32_t count, uint32_t elementSize,
+                    uint64_t sourceHash = 0);
+
+    template<typename T>
+    void AddSection(MapSection a_section, T const * a_pData, uint32_t a_count, uint64_t a_sourceHash = 0)
+    {
+      AddSection(a_section, a_pData, a_count, uint32_t(sizeof(T)), a_sourceHash);
+    }
+
+    //Every map must have been begun.
+    std::vector<uint8_t> const & Finish();
+
+  private:
+
+    void Align();
+    void EndMap();
+
+  private:
+
+    std::vector<uint8_t>  m_data;
+    uint32_t              m_mapCount;
+    uint32_t              m_currentMap;
+    size_t                m_mapStart;
+  };
+}
+
+#endif
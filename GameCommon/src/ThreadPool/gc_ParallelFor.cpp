@@ -0,0 +1,105 @@
+#include <atomic>
+#include <memory>
+#include <thread>
+
+#include "gc_ParallelFor.h"
+#include "gc_ThreadPool.h"
+#include "gc_Job.h"
+
+namespace GC
+{
+  namespace
+  {
+    //Shared with the jobs, which can outlive the call if they start after
+    //all bands have been claimed.
+    struct BandState
+    {
+      std::function<void(uint32_t, uint32_t)> fn;
+      uint32_t              count;
+      uint32_t              grain;
+      uint32_t              bandCount;
+      std::atomic<uint32_t> next;
+      std::atomic<uint32_t> finished;
+    };
+
+    void RunBands(BandState & a_state)
+    {
+      while (true)
+      {
+        uint32_t band = a_state.next.fetch_add(1);
+        if (band >= a_state.bandCount)
+          break;
+
+        uint32_t begin = band * a_state.grain;
+        uint32_t end = begin + a_state.grain;
+        if (end > a_state.count)
+          end = a_state.count;
+
+        a_state.fn(begin, end);
+        a_state.finished.fetch_add(1);
+      }
+    }
+
+    class BandJob : public Job
+    {
+    public:
+
+      BandJob(std::shared_ptr<BandState> const & a_state)
+        : m_state(a_state)
+      {
+
+      }
+
+      void Run() override
+      {
+        RunBands(*m_state);
+      }
+
+      void Done() override
+      {
+
+      }
+
+    private:
+      std::shared_ptr<BandState> m_state;
+    };
+  }
+
+  void ParallelFor(ThreadPool * a_pPool, uint32_t a_count, uint32_t a_grain,
+                   std::function<void(uint32_t, uint32_t)> const & a_fn)
+  {
+    if (a_count == 0)
+      return;
+
+    if (a_grain == 0)
+      a_grain = 1;
+
+    uint32_t bandCount = (a_count + a_grain - 1) / a_grain;
+    if (a_pPool == nullptr || bandCount == 1)
+    {
+      for (uint32_t begin = 0; begin < a_count; begin += a_grain)
+        a_fn(begin, begin + a_grain > a_count ? a_count : begin + a_grain);
+      return;
+    }
+
+    std::shared_ptr<BandState> state = std::make_shared<BandState>();
+    state->fn = a_fn;
+    state->count = a_count;
+    state->grain = a_grain;
+    state->bandCount = bandCount;
+    state->next = 0;
+    state->finished = 0;
+
+    size_t jobCount = a_pPool->ThreadCount();
+    if (jobCount > bandCount - 1)
+      jobCount = bandCount - 1;
+
+    for (size_t i = 0; i < jobCount; i++)
+      a_pPool->Schedule(new BandJob(state));
+
+    RunBands(*state);
+
+    while (state->finished.load() != bandCount)
+      std::this_thread::yield();
+  }
+}
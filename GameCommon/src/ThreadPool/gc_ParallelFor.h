@@ -0,0 +1,18 @@
+#ifndef GC_PARALLELFOR_H
+#define GC_PARALLELFOR_H
+
+#include <stdint.h>
+#include <functional>
+
+namespace GC
+{
+  class ThreadPool;
+
+  //Splits [0, count) into bands of at most 'grain' and calls fn(begin, end) on each. The
+  //calling thread claims bands as well, so this is safe to call from a pool thread. Returns
+  //once every band has finished. If 'pool' is null, all bands run on the calling thread.
+  void ParallelFor(ThreadPool * pool, uint32_t count, uint32_t grain,
+                   std::function<void(uint32_t, uint32_t)> const & fn);
+}
+
+#endif
@@ -0,0 +1,196 @@
+#include "gc_BSP.h"
+#include "Data/gc_MapData.h"
+#include "core_Log.h"
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__SSE2__)
+#define BSP_USE_SSE
+#include <xmmintrin.h>
+#endif
+
+namespace GC
+{
+  //Points walked together by LocateN()
+  static uint32_t const LocateLanes = 8;
+
+  static inline void PrefetchNode(void const * a_pNode)
+  {
+#ifdef BSP_USE_SSE
+    _mm_prefetch(static_cast<char const *>(a_pNode), _MM_HINT_T0);
+#else
+    (void)a_pNode;
+#endif
+  }
+
+  BSP::BSP()
+    : m_root(NoBlock)
+    , m_depth(0)
+  {
+
+  }
+
+  void BSP::Clear()
+  {
+    m_nodes.clear();
+    m_root = NoBlock;
+    m_depth = 0;
+  }
+
+  bool BSP::Build(BSP_Node const * a_pNodes, uint32_t a_count)
+  {
+    Clear();
+    if (a_count == 0)
+      return true;
+
+    if (a_pNodes[0].Get<BSP_Node::Item::Type>() == BSP_Node::Leaf)
+    {
+      uint32_t block = a_pNodes[0].Get<BSP_Node::Item::BlockIndex>();
+      if (block > MaxIndex)
+      {
+        LOG_ERROR("BSP::Build(): Block index {} is too large", block);
+        return false;
+      }
+      m_root = block | LeafFlag;
+      return true;
+    }
+
+    //Input index of each output node, in breadth first order. Output indices are given
+    //out as nodes are queued, so the queue is the output order.
+    std::vector<uint32_t> order;
+    std::vector<uint32_t> level;
+    std::vector<bool> visited(a_count, false);
+
+    order.push_back(0);
+    level.push_back(1);
+    visited[0] = true;
+
+    for (size_t i = 0; i < order.size(); i++)
+    {
+      BSP_Node const & input = a_pNodes[order[i]];
+      uint32_t const inputChildren[2] =
+      {
+        input.Get<BSP_Node::Item::ChildBelowIndex>(),
+        input.Get<BSP_Node::Item::ChildAboveIndex>()
+      };
+
+      Node node;
+      node.offset = uint16_t(input.Get<BSP_Node::Item::Offset>());
+      node.element = uint16_t(input.Get<BSP_Node::Item::Element>());
+
+      for (int c = 0; c < 2; c++)
+      {
+        uint32_t child = inputChildren[c];
+        if (child >= a_count)
+        {
+          LOG_ERROR("BSP::Build(): Node {} has child {} out of range", order[i], child);
+          Clear();
+          return false;
+        }
+
+        if (a_pNodes[child].Get<BSP_Node::Item::Type>() == BSP_Node::Leaf)
+        {
+          uint32_t block = a_pNodes[child].Get<BSP_Node::Item::BlockIndex>();
+          if (block > MaxIndex)
+          {
+            LOG_ERROR("BSP::Build(): Block index {} is too large", block);
+            Clear();
+            return false;
+          }
+          node.children[c] = uint16_t(block | LeafFlag);
+          continue;
+        }
+
+        //Leaves are shared between branches, but branches never are.
+        if (visited[child] || order.size() > MaxIndex)
+        {
+          LOG_ERROR("BSP::Build(): Node {} is reached twice or the tree is too large", child);
+          Clear();
+          return false;
+        }
+
+        visited[child] = true;
+        node.children[c] = uint16_t(order.size());
+        order.push_back(child);
+        level.push_back(level[i] + 1);
+      }
+
+      m_nodes.push_back(node);
+      if (level[i] > m_depth)
+        m_depth = level[i];
+    }
+
+    m_root = 0;
+    return true;
+  }
+
+  uint32_t BSP::Locate(vec2 const & a_point) const
+  {
+    if (m_root == NoBlock)
+      return NoBlock;
+
+    uint32_t ref = m_root;
+    while ((ref & LeafFlag) == 0)
+    {
+      Node const & node = m_nodes[ref];
+      ref = node.children[a_point[node.element] >= float(node.offset)];
+    }
+    return ref & MaxIndex;
+  }
+
+  void BSP::LocateN(vec2 const * a_pPoints, uint32_t a_count, uint32_t * a_pBlocks) const
+  {
+    if (m_root == NoBlock)
+    {
+      for (uint32_t i = 0; i < a_count; i++)
+        a_pBlocks[i] = NoBlock;
+      return;
+    }
+
+    for (uint32_t first = 0; first < a_count; first += LocateLanes)
+    {
+      uint32_t lanes = a_count - first;
+      if (lanes > LocateLanes)
+        lanes = LocateLanes;
+
+      vec2 const * pPoints = a_pPoints + first;
+      uint32_t refs[LocateLanes];
+      for (uint32_t l = 0; l < lanes; l++)
+        refs[l] = m_root;
+
+      //Each pass moves every lane down one level. The next node is prefetched for a
+      //lane while the others are stepped.
+      bool active = true;
+      while (active)
+      {
+        active = false;
+        for (uint32_t l = 0; l < lanes; l++)
+        {
+          if ((refs[l] & LeafFlag) != 0)
+            continue;
+
+          Node const & node = m_nodes[refs[l]];
+          uint32_t next = node.children[pPoints[l][node.element] >= float(node.offset)];
+          refs[l] = next;
+
+          if ((next & LeafFlag) == 0)
+          {
+            PrefetchNode(&m_nodes[next]);
+            active = true;
+          }
+        }
+      }
+
+      for (uint32_t l = 0; l < lanes; l++)
+        a_pBlocks[first + l] = refs[l] & MaxIndex;
+    }
+  }
+
+  uint32_t BSP::NodeCount() const
+  {
+    return uint32_t(m_nodes.size());
+  }
+
+  uint32_t BSP::Depth() const
+  {
+    return m_depth;
+  }
+}
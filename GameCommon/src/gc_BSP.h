@@ -0,0 +1,62 @@
+#ifndef GC_BSP_H
+#define GC_BSP_H
+
+#include <stdint.h>
+#include <vector>
+
+#include "gc_Types.h"
+
+namespace GC
+{
+  class BSP_Node;
+
+  //Finds the map block a point lies in. Built from the BSP_Node array written by the
+  //converter, with the nodes stored breadth first so the top levels, which every query
+  //passes through, sit together in a few cache lines. Leaves are folded into their
+  //parents, so a query only reads branch nodes.
+  //
+  //A point on a splitting line goes to the child above it. Blocks straddling a line are
+  //in both children, so a point is always placed in a block which covers it, if any
+  //does. Points in solid areas are placed in a nearby block.
+  class BSP
+  {
+  public:
+
+    static uint32_t const NoBlock = 0xFFFF'FFFF;
+
+    BSP();
+
+    //Root at index 0. Returns false, leaving the tree empty, if a child index is out of
+    //range, a node is reached twice or the tree is too large.
+    bool Build(BSP_Node const * nodes, uint32_t count);
+    void Clear();
+
+    //NoBlock if the tree is empty
+    uint32_t Locate(vec2 const &) const;
+
+    //Locates a group of points at once. Several points walk the tree together, so
+    //one point's node load overlaps with another's compare.
+    void LocateN(vec2 const * points, uint32_t count, uint32_t * blocks) const;
+
+    uint32_t NodeCount() const;
+    uint32_t Depth() const;
+
+  private:
+
+    static uint32_t const LeafFlag = 0x8000;
+    static uint32_t const MaxIndex = 0x7FFF;
+
+    struct Node
+    {
+      uint16_t  children[2];  //Below, above. Leaves are a block index with LeafFlag set.
+      uint16_t  offset;
+      uint16_t  element;
+    };
+
+    std::vector<Node> m_nodes;
+    uint32_t          m_root;     //NoBlock if empty
+    uint32_t          m_depth;
+  };
+}
+
+#endif
@@ -29,6 +29,19 @@ namespace GC
     vec3 const NSEW[4] = {VEC_NORTH, VEC_SOUTH, VEC_EAST, VEC_WEST};
   }
 
+  //Codes found in the map planes
+  namespace Tile
+  {
+    //Plane 0
+    uint16_t const WallBegin    = 1;
+    uint16_t const WallEnd      = 63;
+
+    //Plane 1. The tile after a CeilingFloor marker holds the ceiling (high byte)
+    //and floor (low byte) textures.
+    uint16_t const PushWall     = 98;
+    uint16_t const CeilingFloor = 64256;
+  }
+
   static Dg::Endian const BS_FileEndian = Dg::Endian::Little;
 }
 
@@ -0,0 +1,254 @@
+#include <string.h>
+#include <mutex>
+#include <condition_variable>
+
+#include "gc_LevelPrefetcher.h"
+#include "ThreadPool/gc_ThreadPool.h"
+#include "ThreadPool/gc_Job.h"
+#include "core_Log.h"
+
+namespace GC
+{
+  //-----------------------------------------------------------------------------------------------
+  // Level
+  //-----------------------------------------------------------------------------------------------
+
+  Level::Level()
+    : index(-1)
+    , view{}
+  {
+
+  }
+
+  bool Level::Load(int a_index, MapFile const * a_pMaps)
+  {
+    index = a_index;
+    view = MapView{};
+    bsp.Clear();
+
+    if (!map.LoadMap(a_index))
+      return false;
+
+    textures = GetLevelTextures(map);
+
+    if (a_pMaps == nullptr)
+      return true;
+
+    //Empty archive slots are left out of the converted file, so look the map up by name.
+    for (uint32_t i = 0; i < a_pMaps->GetMapCount(); i++)
+    {
+      MapView candidate = a_pMaps->GetMap(i);
+      if (memcmp(candidate.pHeader->name, map.name, sizeof(map.name)) != 0)
+        continue;
+
+      view = candidate;
+      if (!bsp.Build(view.bspNodes.data, view.bspNodes.count))
+      {
+        LOG_ERROR("Failed to build the BSP for map {}", a_index);
+        return false;
+      }
+      return true;
+    }
+
+    LOG_WARN("No converted map found for map {}", a_index);
+    return true;
+  }
+
+  //-----------------------------------------------------------------------------------------------
+  // LevelPrefetcher
+  //-----------------------------------------------------------------------------------------------
+
+  struct LevelPrefetcher::State
+  {
+    State()
+      : pPool(nullptr)
+      , pMaps(nullptr)
+      , wanted(-1)
+      , building(-1)
+    {
+
+    }
+
+    std::mutex              mutex;
+    std::condition_variable cv;
+    ThreadPool *            pPool;
+    MapFile const *         pMaps;
+    int                     wanted;     //-1 if nothing is to be prefetched
+    int                     building;   //-1 if no job is in flight
+    std::unique_ptr<Level>  pReady;
+  };
+
+  class LevelPrefetcher::PrefetchJob : public Job
+  {
+  public:
+
+    PrefetchJob(std::shared_ptr<State> const & a_pState, int a_index)
+      : m_pState(a_pState)
+      , m_index(a_index)
+      , m_ran(false)
+    {
+
+    }
+
+    //The pool drops jobs it has not started when it shuts down. Nothing will be built,
+    //so stop anyone waiting for it.
+    ~PrefetchJob()
+    {
+      if (m_ran)
+        return;
+
+      std::lock_guard<std::mutex> lock(m_pState->mutex);
+      m_pState->building = -1;
+      m_pState->cv.notify_all();
+    }
+
+    void Run() override
+    {
+      m_ran = true;
+
+      MapFile const * pMaps = nullptr;
+      bool wanted = false;
+      {
+        std::lock_guard<std::mutex> lock(m_pState->mutex);
+        pMaps = m_pState->pMaps;
+        wanted = m_pState->wanted == m_index;
+      }
+
+      //Asked for something else while this was queued
+      std::unique_ptr<Level> pLevel;
+      if (wanted)
+      {
+        pLevel.reset(new Level());
+        if (!pLevel->Load(m_index, pMaps))
+          pLevel.reset();
+      }
+
+      std::lock_guard<std::mutex> lock(m_pState->mutex);
+      m_pState->building = -1;
+      if (pLevel != nullptr && m_pState->wanted == m_index)
+        m_pState->pReady.swap(pLevel);
+      StartNext(m_pState);
+      m_pState->cv.notify_all();
+    }
+
+    void Done() override
+    {
+
+    }
+
+  private:
+
+    std::shared_ptr<State>  m_pState;
+    int                     m_index;
+    bool                    m_ran;
+  };
+
+  LevelPrefetcher::LevelPrefetcher()
+    : m_pState(new State())
+  {
+
+  }
+
+  LevelPrefetcher::~LevelPrefetcher()
+  {
+    std::unique_lock<std::mutex> lock(m_pState->mutex);
+    m_pState->wanted = -1;
+    m_pState->pReady.reset();
+    m_pState->cv.wait(lock, [this] {return m_pState->building == -1;});
+  }
+
+  void LevelPrefetcher::SetThreadPool(ThreadPool * a_pPool)
+  {
+    std::lock_guard<std::mutex> lock(m_pState->mutex);
+    m_pState->pPool = a_pPool;
+  }
+
+  void LevelPrefetcher::SetMapFile(MapFile const * a_pMaps)
+  {
+    std::lock_guard<std::mutex> lock(m_pState->mutex);
+    m_pState->pMaps = a_pMaps;
+  }
+
+  void LevelPrefetcher::Prefetch(int const * a_pCandidates, uint32_t a_count)
+  {
+    int index = -1;
+    for (uint32_t i = 0; i < a_count && index < 0; i++)
+    {
+      if (Map_BS::HasMap(a_pCandidates[i]))
+        index = a_pCandidates[i];
+    }
+
+    //Freed outside the lock
+    std::unique_ptr<Level> pDropped;
+
+    std::lock_guard<std::mutex> lock(m_pState->mutex);
+    m_pState->wanted = index;
+    if (m_pState->pReady != nullptr && m_pState->pReady->index != index)
+      pDropped.swap(m_pState->pReady);
+    StartNext(m_pState);
+  }
+
+  void LevelPrefetcher::Prefetch(int a_index)
+  {
+    Prefetch(&a_index, 1);
+  }
+
+  std::unique_ptr<Level> LevelPrefetcher::Take(int a_index)
+  {
+    std::unique_ptr<Level> pLevel;
+    std::unique_ptr<Level> pDropped;
+    MapFile const * pMaps = nullptr;
+    {
+      std::unique_lock<std::mutex> lock(m_pState->mutex);
+      m_pState->cv.wait(lock, [this, a_index] {return m_pState->building != a_index;});
+
+      if (m_pState->pReady != nullptr && m_pState->pReady->index == a_index)
+        pLevel.swap(m_pState->pReady);
+      else
+        pDropped.swap(m_pState->pReady);
+
+      m_pState->wanted = -1;
+      pMaps = m_pState->pMaps;
+    }
+
+    if (pLevel != nullptr)
+      return pLevel;
+
+    pDropped.reset();
+    pLevel.reset(new Level());
+    if (!pLevel->Load(a_index, pMaps))
+      pLevel.reset();
+    return pLevel;
+  }
+
+  void LevelPrefetcher::Cancel()
+  {
+    std::unique_ptr<Level> pDropped;
+
+    std::lock_guard<std::mutex> lock(m_pState->mutex);
+    m_pState->wanted = -1;
+    pDropped.swap(m_pState->pReady);
+  }
+
+  int LevelPrefetcher::GetPending() const
+  {
+    std::lock_guard<std::mutex> lock(m_pState->mutex);
+    if (m_pState->pReady != nullptr)
+      return m_pState->pReady->index;
+    return m_pState->wanted;
+  }
+
+  //Called with the lock held. Only one level is built at a time, and only if the one
+  //wanted is not already prefetched.
+  void LevelPrefetcher::StartNext(std::shared_ptr<State> const & a_pState)
+  {
+    if (a_pState->pPool == nullptr || a_pState->building != -1 || a_pState->wanted < 0)
+      return;
+
+    if (a_pState->pReady != nullptr)
+      return;
+
+    a_pState->building = a_pState->wanted;
+    a_pState->pPool->Schedule(new PrefetchJob(a_pState, a_pState->wanted));
+  }
+}
@@ -0,0 +1,89 @@
+#ifndef GC_LEVELPREFETCHER_H
+#define GC_LEVELPREFETCHER_H
+
+#include <stdint.h>
+#include <memory>
+#include <vector>
+
+#include "gc_Map_BS.h"
+#include "gc_BSP.h"
+#include "gc_LevelTextures.h"
+#include "Data/gc_MapFile.h"
+
+namespace GC
+{
+  class ThreadPool;
+
+  //Everything a level needs from the map data, ready to play.
+  struct Level
+  {
+    Level();
+
+    //Decodes map 'index' from the archive. If 'maps' is given, the converted map of the
+    //same name is looked up and its BSP built. Map_BS::Init() must have been called.
+    bool Load(int index, MapFile const * maps);
+
+    int                           index;
+    Map_BS                        map;
+    std::vector<LevelTextureKey>  textures;
+    MapView                       view;     //pHeader is null if there is no converted map
+    BSP                           bsp;
+  };
+
+  //Prepares the level the player is likely to go to next on a worker thread, while the
+  //current one is played. At most one level is held, or being built, besides the current
+  //one: asking for another drops what was prefetched.
+  //
+  //A call to Prefetch() while a level is still being built is remembered, and started
+  //when that one finishes. Call from the game thread only.
+  class LevelPrefetcher
+  {
+  public:
+
+    LevelPrefetcher();
+
+    //Waits for a level still being built, then drops it.
+    ~LevelPrefetcher();
+
+    //Without a pool nothing is prefetched and Take() loads synchronously.
+    void SetThreadPool(ThreadPool *);
+
+    //The converted maps, or null. Must stay valid while levels may be built.
+    void SetMapFile(MapFile const *);
+
+    //Prefetches the first candidate the archive has a map for. Candidates are in order
+    //of likelihood, e.g. the next map in the episode followed by the elevator targets.
+    void Prefetch(int const * candidates, uint32_t count);
+    void Prefetch(int index);
+
+    //Hands over level 'index'. If it is being built, waits for it; if it was not asked
+    //for, loads it now. Anything else prefetched is dropped. nullptr if the map does not
+    //load.
+    std::unique_ptr<Level> Take(int index);
+
+    //Drops the prefetched level, and any that was asked for but not started.
+    void Cancel();
+
+    //The index prefetched or being built, or -1
+    int GetPending() const;
+
+  private:
+
+    struct State;
+    class PrefetchJob;
+
+    static void StartNext(std::shared_ptr<State> const &);
+
+  private:
+
+    LevelPrefetcher(LevelPrefetcher const &) = delete;
+    LevelPrefetcher & operator=(LevelPrefetcher const &) = delete;
+
+  private:
+
+    //Shared with the job in flight
+    std::shared_ptr<State> m_pState;
+  };
+}
+
+#endif
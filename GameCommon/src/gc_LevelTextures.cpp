@@ -0,0 +1,71 @@
+#include <algorithm>
+
+#include "gc_LevelTextures.h"
+#include "gc_Map_BS.h"
+
+namespace GC
+{
+  static bool IsWall(uint16_t a_val)
+  {
+    return (a_val >= Tile::WallBegin) && (a_val <= Tile::WallEnd);
+  }
+
+  std::vector<LevelTextureKey> GetLevelTextures(Map_BS const & a_map, SpriteLookup const & a_spriteLookup)
+  {
+    std::vector<LevelTextureKey> result;
+    std::vector<uint16_t> objects;
+
+    Dg::HyperArray<uint16_t, 2> const & plane_0 = a_map.planes[0];
+    Dg::HyperArray<uint16_t, 2> const & plane_1 = a_map.planes[1];
+
+    for (size_t y = 0; y < plane_0.length(1); y++)
+    {
+      for (size_t x = 0; x < plane_0.length(0); x++)
+      {
+        uint16_t val = plane_0(x, y);
+        if (IsWall(val))
+          result.push_back(MakeLevelTextureKey(LevelTextureType::Wall, val));
+      }
+    }
+
+    for (size_t y = 0; y < plane_1.length(1); y++)
+    {
+      for (size_t x = 0; x < plane_1.length(0); x++)
+      {
+        uint16_t val = plane_1(x, y);
+        if (val == 0)
+          continue;
+
+        if (val == Tile::CeilingFloor && x + 1 < plane_1.length(0))
+        {
+          uint16_t textures = plane_1(x + 1, y);
+          result.push_back(MakeLevelTextureKey(LevelTextureType::Ceiling, textures >> 8));
+          result.push_back(MakeLevelTextureKey(LevelTextureType::Floor, textures & 0xFF));
+          x++;
+          continue;
+        }
+
+        objects.push_back(val);
+      }
+    }
+
+    //Maps hold thousands of tiles but only a few dozen distinct codes, so remove
+    //duplicates before asking for sprites.
+    if (a_spriteLookup)
+    {
+      std::sort(objects.begin(), objects.end());
+      objects.erase(std::unique(objects.begin(), objects.end()), objects.end());
+
+      std::vector<uint16_t> sprites;
+      for (uint16_t object : objects)
+        a_spriteLookup(object, sprites);
+
+      for (uint16_t sprite : sprites)
+        result.push_back(MakeLevelTextureKey(LevelTextureType::Sprite, sprite));
+    }
+
+    std::sort(result.begin(), result.end());
+    result.erase(std::unique(result.begin(), result.end()), result.end());
+    return result;
+  }
+}
@@ -0,0 +1,46 @@
+#ifndef GC_LEVELTEXTURES_H
+#define GC_LEVELTEXTURES_H
+
+#include <stdint.h>
+#include <vector>
+#include <functional>
+
+namespace GC
+{
+  class Map_BS;
+
+  enum class LevelTextureType : uint32_t
+  {
+    Wall,     //Plane 0 wall code
+    Floor,
+    Ceiling,
+    Sprite    //As given by the SpriteLookup
+  };
+
+  //Identifies one texture a level uses: the type in the high 16 bits, the index in the low.
+  typedef uint32_t LevelTextureKey;
+
+  inline LevelTextureKey MakeLevelTextureKey(LevelTextureType a_type, uint16_t a_index)
+  {
+    return (static_cast<uint32_t>(a_type) << 16) | a_index;
+  }
+
+  inline LevelTextureType GetLevelTextureType(LevelTextureKey a_key)
+  {
+    return static_cast<LevelTextureType>(a_key >> 16);
+  }
+
+  inline uint16_t GetLevelTextureIndex(LevelTextureKey a_key)
+  {
+    return static_cast<uint16_t>(a_key & 0xFFFF);
+  }
+
+  //Appends the sprites drawn for a plane 1 object code. Called once per distinct code.
+  typedef std::function<void(uint16_t objectCode, std::vector<uint16_t> & sprites)> SpriteLookup;
+
+  //Every wall, floor, ceiling and sprite texture the loaded map refers to, sorted and
+  //without duplicates. Without a SpriteLookup, no sprites are included.
+  std::vector<LevelTextureKey> GetLevelTextures(Map_BS const &, SpriteLookup const & = SpriteLookup());
+}
+
+#endif
@@ -1,184 +1,165 @@
+#include <string.h>
 
 #include "DgFileStream.h"
-#include "DgDynamicArray.h"
-#include "DgBinaryReader.h"
 #include "gc_Map_BS.h"
+#include "gc_RLEW.h"
 #include "core_Log.h"
 
 namespace GC
 {
-  bool Map_BS::Init(std::string const & a_path)
+  //Sizes of the records in MAPHEAD and MAPTEMP
+  static size_t const MapHeadSize = sizeof(uint16_t) + MAX_MAPS * sizeof(uint32_t);
+  static size_t const MapHeaderSize = 3 * sizeof(uint32_t) + 3 * sizeof(uint16_t) + 2 * sizeof(uint16_t) + 16;
+
+  uint16_t            Map_BS::s_RLEWtag = 0;
+  Map_BS::MapHeader   Map_BS::s_maps[MAX_MAPS] = {};
+  std::vector<char>   Map_BS::s_gameData;
+
+  //The archives are little endian (BS_FileEndian), whatever the host.
+  static uint16_t ReadU16(char const * a_pData)
   {
-    std::string mapHeaderPath = a_path + "/" + MAPHEADER;
-    s_mapTempPath = a_path + "/" + MAPTEMP;
+    uint8_t const * p = reinterpret_cast<uint8_t const *>(a_pData);
+    return uint16_t(p[0] | (p[1] << 8));
+  }
 
-    Dg::FileStream fs(s_mapTempPath, Dg::StreamOpenMode::read);
+  static uint32_t ReadU32(char const * a_pData)
+  {
+    uint8_t const * p = reinterpret_cast<uint8_t const *>(a_pData);
+    return uint32_t(p[0]) | (uint32_t(p[1]) << 8) | (uint32_t(p[2]) << 16) | (uint32_t(p[3]) << 24);
+  }
+
+  static bool ReadFile(std::string const & a_path, std::vector<char> & a_out)
+  {
+    Dg::FileStream fs(a_path, Dg::StreamOpenMode::read);
     if (!fs.IsOpen())
     {
-      LOG_ERROR((std::string("Failed to open ") + s_mapTempPath).c_str());
+      LOG_ERROR((std::string("Failed to open ") + a_path).c_str());
       return false;
     }
 
-    fs.Close();
-    fs.Open(mapHeaderPath, Dg::StreamOpenMode::read);
-
-    if (!fs.IsOpen())
+    Dg::IO::ReturnType result = fs.GetSize();
+    if (result.error != Dg::ErrorCode::None)
     {
-      LOG_ERROR((std::string("Failed to open ") + mapHeaderPath).c_str());
+      LOG_ERROR("Failed to get the size of {}: {}", a_path, Dg::ErrorCodeToString(result.error));
       return false;
     }
 
-    Dg::EndianConverter ec;
-    ec.SetConversion(GC::BS_FileEndian, Dg::Endianness());
-
-    Dg::BinaryReader reader(&fs, ec);
-    
-    Dg::IO::ReturnType result = reader.Read<uint16_t>(&(s_header.RLEWtag), 1);
-
-    if (result.error != Dg::ErrorCode::None || result.value != 1)
+    a_out.resize(size_t(result.value));
+    result = fs.Read(a_out.data(), Dg::IO::myInt(a_out.size()));
+    if (result.error != Dg::ErrorCode::None || result.value != Dg::IO::myInt(a_out.size()))
     {
-      LOG_ERROR("Failed to read RLEWtag");
+      LOG_ERROR("Failed to read {}: {}", a_path, Dg::ErrorCodeToString(result.error));
       return false;
     }
+    return true;
+  }
 
-    result = reader.Read<uint32_t>(s_header.headeroffsets, MAX_MAPS);
+  bool Map_BS::Init(std::string const & a_path)
+  {
+    std::string mapHeaderPath = a_path + "/" + MAPHEADER;
+    std::string mapTempPath = a_path + "/" + MAPTEMP;
 
-    if (result.error != Dg::ErrorCode::None || result.value != MAX_MAPS)
-    {
-      LOG_ERROR("Failed to read map offsets");
+    std::vector<char> mapHead;
+    std::vector<char> gameData;
+    if (!ReadFile(mapHeaderPath, mapHead) || !ReadFile(mapTempPath, gameData))
       return false;
-    }
-    return true;
+
+    return Init(mapHead.data(), mapHead.size(), std::move(gameData));
   }
 
-  bool Map_BS::LoadMap(int a_index)
+  bool Map_BS::Init(void const * a_pMapHead, size_t a_mapHeadSize, std::vector<char> && a_gameData)
   {
-    Clean();
+    Shutdown();
 
-    struct GameMapHeader
+    if (a_mapHeadSize < MapHeadSize)
     {
-      uint32_t   planeOffsets[3];
-      uint16_t   planeSizes[3];
-      uint16_t   mapWidth;
-      uint16_t   mapHeight;
-      char       mapName[16];
-    };
-
-    char * plane_0_data = nullptr;
-    char * plane_1_data = nullptr;
-    bool isGood = true;
-
-    do
-    {
-      Dg::FileStream fs(s_mapTempPath, Dg::StreamOpenMode::read);
-      if (!fs.IsOpen())
-      {
-        LOG_ERROR((std::string("Failed to open ") + s_mapTempPath).c_str());
-        isGood = false; 
-        break;
-      }
-
-      Dg::EndianConverter ec;
-      ec.SetConversion(GC::BS_FileEndian, Dg::Endianness());
-      Dg::BinaryReader reader(&fs, ec);
+      LOG_ERROR("Map header is {} bytes, expected {}", a_mapHeadSize, MapHeadSize);
+      return false;
+    }
 
-      Dg::IO::ReturnType result = reader.SetPosition(s_header.headeroffsets[a_index]);
-      if (result.error != Dg::ErrorCode::None)
-      {
-        LOG_ERROR("Failed to seek the map file: {}", Dg::ErrorCodeToString(result.error));
-        isGood = false; 
-        break;
-      }
+    char const * pHead = static_cast<char const *>(a_pMapHead);
+    s_RLEWtag = ReadU16(pHead);
 
-      GameMapHeader gameMapHeader;
-      result = reader.Read<uint32_t>(gameMapHeader.planeOffsets, 3);
-      if (result.error != Dg::ErrorCode::None || result.value != 3)
-      {
-        LOG_ERROR("Failed to load plane offsets for map {}: {}", a_index, Dg::ErrorCodeToString(result.error));
-        isGood = false; 
-        break;
-      }
+    //An offset of 0 marks an empty slot. Maps which point outside the archive are left
+    //out here, so LoadMap() only has to check 'present'.
+    char const * pData = a_gameData.data();
+    size_t const dataSize = a_gameData.size();
+    for (int i = 0; i < MAX_MAPS; i++)
+    {
+      uint32_t offset = ReadU32(pHead + sizeof(uint16_t) + i * sizeof(uint32_t));
+      if (offset == 0 || offset == 0xFFFF'FFFF)
+        continue;
 
-      result = reader.Read<uint16_t>(gameMapHeader.planeSizes, 3);
-      if (result.error != Dg::ErrorCode::None || result.value != 3)
+      if (offset > dataSize || dataSize - offset < MapHeaderSize)
       {
-        LOG_ERROR("Failed to load plane sizes for map {}: {}", a_index, Dg::ErrorCodeToString(result.error));
-        isGood = false; 
-        break;
+        LOG_ERROR("Header for map {} is out of range", i);
+        continue;
       }
 
-      result = reader.Read<uint16_t>(&gameMapHeader.mapWidth, 1);
-      if (result.error != Dg::ErrorCode::None || result.value != 1)
+      MapHeader & header = s_maps[i];
+      char const * pHeader = pData + offset;
+      for (int p = 0; p < 3; p++)
       {
-        LOG_ERROR("Failed to load map width for map {}: {}", a_index, Dg::ErrorCodeToString(result.error));
-        isGood = false; 
-        break;
+        header.planeOffsets[p] = ReadU32(pHeader + p * sizeof(uint32_t));
+        header.planeSizes[p] = ReadU16(pHeader + 3 * sizeof(uint32_t) + p * sizeof(uint16_t));
       }
+      header.width = ReadU16(pHeader + 3 * sizeof(uint32_t) + 3 * sizeof(uint16_t));
+      header.height = ReadU16(pHeader + 3 * sizeof(uint32_t) + 4 * sizeof(uint16_t));
+      memcpy(header.name, pHeader + 3 * sizeof(uint32_t) + 5 * sizeof(uint16_t), sizeof(header.name));
 
-      result = reader.Read<uint16_t>(&gameMapHeader.mapHeight, 1);
-      if (result.error != Dg::ErrorCode::None || result.value != 1)
-      {
-        LOG_ERROR("Failed to load map height for map {}: {}", a_index, Dg::ErrorCodeToString(result.error));
-        isGood = false; 
-        break;
-      }
+      //Plane 2 is unused
+      bool inRange = true;
+      for (int p = 0; p < 2; p++)
+        inRange = inRange && header.planeOffsets[p] <= dataSize && dataSize - header.planeOffsets[p] >= header.planeSizes[p];
 
-      result = reader.Read<char>(name, 16);
-      if (result.error != Dg::ErrorCode::None || result.value != 16)
+      if (!inRange)
       {
-        LOG_ERROR("Failed to load map name for map {}: {}", a_index, Dg::ErrorCodeToString(result.error));
-        isGood = false; 
-        break;
+        LOG_ERROR("Plane data for map {} is out of range", i);
+        continue;
       }
 
-      plane_0_data = new char[gameMapHeader.planeSizes[0]]();
-      plane_1_data = new char[gameMapHeader.planeSizes[1]]();
+      header.present = true;
+    }
 
-      result = reader.SetPosition(gameMapHeader.planeOffsets[0]);
-      if (result.error != Dg::ErrorCode::None)
-      {
-        LOG_ERROR("Failed to seek the map file for map {}: {}", a_index, Dg::ErrorCodeToString(result.error));
-        isGood = false; 
-        break;
-      }
+    s_gameData = std::move(a_gameData);
+    return true;
+  }
 
-      result = reader.Read<char>(plane_0_data, gameMapHeader.planeSizes[0]);
-      if (result.error != Dg::ErrorCode::None || result.value != 16)
-      {
-        LOG_ERROR("Failed to load plane 0 data for map {}: {}", a_index, Dg::ErrorCodeToString(result.error));
-        isGood = false; 
-        break;
-      }
+  void Map_BS::Shutdown()
+  {
+    s_RLEWtag = 0;
+    for (MapHeader & header : s_maps)
+      header = MapHeader{};
+    s_gameData = std::vector<char>();
+  }
 
-      result = reader.SetPosition(gameMapHeader.planeOffsets[1]);
-      if (result.error != Dg::ErrorCode::None)
-      {
-        LOG_ERROR("Failed to seek the map file for map {}: {}", a_index, Dg::ErrorCodeToString(result.error));
-        isGood = false; 
-        break;
-      }
+  bool Map_BS::HasMap(int a_index)
+  {
+    return a_index >= 0 && a_index < MAX_MAPS && s_maps[a_index].present;
+  }
 
-      result = reader.Read<char>(plane_1_data, gameMapHeader.planeSizes[1]);
-      if (result.error != Dg::ErrorCode::None || result.value != 16)
-      {
-        LOG_ERROR("Failed to load plane 1 data for map {}: {}", a_index, Dg::ErrorCodeToString(result.error));
-        isGood = false; 
-        break;
-      }
+  bool Map_BS::LoadMap(int a_index)
+  {
+    Clean();
 
-      bool isGood = UncompressPlane(0, plane_0_data, gameMapHeader.planeSizes[0], gameMapHeader.mapWidth, gameMapHeader.mapHeight);
-      isGood = (isGood && UncompressPlane(1, plane_1_data, gameMapHeader.planeSizes[1], gameMapHeader.mapWidth, gameMapHeader.mapHeight));
+    if (!HasMap(a_index))
+    {
+      LOG_ERROR("No map {} in the archive", a_index);
+      return false;
+    }
 
-      if (!isGood)
-        LOG_ERROR("Failed to uncompress planes for map {}", a_index);
-    } while (false);
-     
+    MapHeader const & header = s_maps[a_index];
+    memcpy(name, header.name, sizeof(name));
 
-    delete[] plane_0_data;
-    delete[] plane_1_data;
+    char const * pData = s_gameData.data();
+    bool isGood = UncompressPlane(0, pData + header.planeOffsets[0], header.planeSizes[0], header.width, header.height);
+    isGood = (isGood && UncompressPlane(1, pData + header.planeOffsets[1], header.planeSizes[1], header.width, header.height));
 
     if (!isGood)
+    {
+      LOG_ERROR("Failed to uncompress planes for map {}", a_index);
       Clean();
+    }
 
     return isGood;
   }
@@ -196,45 +177,12 @@ namespace GC
                                uint16_t a_width,
                                uint16_t a_height)
   {
-    Dg::DynamicArray<uint16_t> raw;
-
-    uint16_t pos = 0;
-    char const * pData = a_data;
-
-#define READ16(pData) *((uint16_t const*)pData); pData += 2; pos += 2;
-
-    //There seems to be an extra word at the start of each map, the same value each time (0x2000).
-    //Not sure what this is, so discard.
-    //TODO find out what this value is.
-    uint16_t word = READ16(pData);
-
-    while (pos < a_dataSize)
-    {
-      uint16_t word = READ16(pData);
-
-      if (word == s_header.RLEWtag)
-      {
-        uint16_t count = READ16(pData);
-        uint16_t value = READ16(pData);
-
-        for (uint16_t i = 0; i < count; i++)
-          raw.push_back(value);
-      }
-      else
-        raw.push_back(word);
-    }
-    
-    if (raw.size() != (a_height * a_width))
-    {
-      LOG_ERROR("Plane '{}' has not uncpmpressed to the correct size: '{}' vs '{}' (correct)", a_plane, raw.size(), (a_height * a_width));
-      return false;
-    }
-
+    //Words decode in the order the plane stores them
     planes[a_plane].Set({size_t(a_height), size_t(a_width)});
-    for (size_t y = 0; y < a_width; y++)
+    if (!DecodeRLEW(a_data, a_dataSize, s_RLEWtag, planes[a_plane].data(), size_t(a_width) * a_height))
     {
-      for (size_t x = 0; x < a_height; x++)
-        planes[a_plane](x, y) = raw[(y * a_height) + x];
+      LOG_ERROR("Plane '{}' is corrupt or did not uncompress to {} tiles", a_plane, size_t(a_width) * a_height);
+      return false;
     }
 
     return true;
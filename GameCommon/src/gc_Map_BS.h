@@ -2,7 +2,9 @@
 #define GC_MAP_BS
 
 #include <string>
+#include <vector>
 #include <stdint.h>
+#include <stddef.h>
 
 #include "gc_Constants.h"
 #include "DgHyperArray.h"
@@ -13,7 +15,19 @@ namespace GC
   {
   public:
 
+    //Reads MAPHEAD and the whole of MAPTEMP once. Maps are then decoded from memory,
+    //so LoadMap() does no file I/O and, once this has returned, may be called from any thread.
     static bool Init(std::string const & a_bsPath);
+
+    //As Init(), from archives already in memory. Takes ownership of 'gameData'.
+    static bool Init(void const * mapHead, size_t mapHeadSize, std::vector<char> && gameData);
+
+    //Frees the archive
+    static void Shutdown();
+
+    //False if the index is out of range or the archive holds no map there.
+    static bool HasMap(int);
+
     bool LoadMap(int);
 
     char name[16];
@@ -30,15 +44,21 @@ namespace GC
 
   private:
 
-    struct MapFileType
+    //Header of one map in MAPTEMP, parsed when the archive is loaded
+    struct MapHeader
     {
-      uint16_t	RLEWtag;
-      uint32_t	headeroffsets[MAX_MAPS];
+      uint32_t  planeOffsets[3];
+      uint16_t  planeSizes[3];
+      uint16_t  width;
+      uint16_t  height;
+      char      name[16];
+      bool      present;
     };
 
-    static MapFileType s_header;
-    static std::string s_mapTempPath;
+    static uint16_t             s_RLEWtag;
+    static MapHeader            s_maps[MAX_MAPS];
+    static std::vector<char>    s_gameData;
   };
 }
 
-#endif
\ No newline at end of file
+#endif
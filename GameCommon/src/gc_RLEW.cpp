@@ -0,0 +1,90 @@
+#include <string.h>
+
+#include "gc_RLEW.h"
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__SSE2__)
+#define RLEW_USE_SSE
+#include <emmintrin.h>
+#endif
+
+namespace GC
+{
+  static inline uint16_t ReadWord(uint8_t const * a_pData, size_t a_index)
+  {
+    uint16_t word;
+    memcpy(&word, a_pData + a_index * 2, 2);
+    return word;
+  }
+
+  static inline void FillWords(uint16_t * a_pOut, uint16_t a_value, size_t a_count)
+  {
+    size_t i = 0;
+#ifdef RLEW_USE_SSE
+    __m128i value = _mm_set1_epi16(static_cast<short>(a_value));
+    for (; i + 8 <= a_count; i += 8)
+      _mm_storeu_si128(reinterpret_cast<__m128i *>(a_pOut + i), value);
+#endif
+    for (; i < a_count; i++)
+      a_pOut[i] = a_value;
+  }
+
+  bool DecodeRLEW(void const * a_pData, size_t a_size, uint16_t a_tag, uint16_t * a_pOut, size_t a_count)
+  {
+    uint8_t const * pIn = static_cast<uint8_t const *>(a_pData);
+    size_t const inWords = a_size / 2;
+    size_t in = 1;
+    size_t out = 0;
+
+    if (inWords == 0)
+      return false;
+
+#ifdef RLEW_USE_SSE
+    __m128i const tag = _mm_set1_epi16(static_cast<short>(a_tag));
+#endif
+
+    while (in < inWords)
+    {
+#ifdef RLEW_USE_SSE
+      //Most of a plane is literal words. Copy them eight at a time until a tag turns up.
+      while (in + 8 <= inWords && out + 8 <= a_count)
+      {
+        __m128i words = _mm_loadu_si128(reinterpret_cast<__m128i const *>(pIn + in * 2));
+        if (_mm_movemask_epi8(_mm_cmpeq_epi16(words, tag)) != 0)
+          break;
+
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(a_pOut + out), words);
+        in += 8;
+        out += 8;
+      }
+
+      if (in >= inWords)
+        break;
+#endif
+
+      uint16_t word = ReadWord(pIn, in++);
+      if (word != a_tag)
+      {
+        if (out == a_count)
+          return false;
+
+        a_pOut[out++] = word;
+        continue;
+      }
+
+      if (in + 2 > inWords)
+        return false;
+
+      uint16_t count = ReadWord(pIn, in);
+      uint16_t value = ReadWord(pIn, in + 1);
+      in += 2;
+
+      if (count > a_count - out)
+        return false;
+
+      FillWords(a_pOut + out, value, count);
+      out += count;
+    }
+
+    return out == a_count;
+  }
+}
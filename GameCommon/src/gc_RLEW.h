@@ -0,0 +1,19 @@
+#ifndef GC_RLEW_H
+#define GC_RLEW_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+namespace GC
+{
+  //Decodes an RLEW compressed map plane straight into 'out', which takes exactly 'count'
+  //words. The data starts with one word giving the decoded size in bytes, which is
+  //skipped. After that, 'tag' is followed by a count and a value to repeat; any other
+  //word is copied as is.
+  //
+  //Returns false, with 'out' partly written, if a run is cut off or the data does not
+  //decode to exactly 'count' words. Nothing is written past 'count'.
+  bool DecodeRLEW(void const * data, size_t size, uint16_t tag, uint16_t * out, size_t count);
+}
+
+#endif
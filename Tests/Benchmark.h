@@ -0,0 +1,29 @@
+#ifndef BENCHMARK_H
+#define BENCHMARK_H
+
+#include <chrono>
+#include <stdio.h>
+
+//Throughput benchmarks print their results, so they are left out of the normal test
+//run. Generate the solution with 'premake5 --benchmarks <action>' to build them in;
+//the tests are then wrapped in #ifdef BSR_BENCHMARKS.
+namespace Benchmark
+{
+  //Seconds taken to call fn() once
+  template<typename Fn>
+  double Time(Fn a_fn)
+  {
+    auto begin = std::chrono::high_resolution_clock::now();
+    a_fn();
+    auto end = std::chrono::high_resolution_clock::now();
+    return std::chrono::duration<double>(end - begin).count();
+  }
+
+  //Prints eg "RLEW decode: 512.0 MB/s", given the amount processed in 'unit's.
+  inline void Report(char const * a_name, double a_amount, char const * a_unit, double a_seconds)
+  {
+    printf("%s: %.1f %s/s\n", a_name, a_amount / a_seconds, a_unit);
+  }
+}
+
+#endif
@@ -0,0 +1,85 @@
+#ifndef MAPARCHIVE_H
+#define MAPARCHIVE_H
+
+#include <stdint.h>
+#include <string.h>
+#include <vector>
+
+#include "gc_Constants.h"
+
+//Builds map archives in memory, in the layout of the game's MAPHEAD and GAMEMAPS
+//files, for tests which load maps through GC::Map_BS.
+namespace MapArchive
+{
+  //RLEW tag written to the head of the archive
+  uint16_t const Tag = 0xABCD;
+
+  inline void PushU16(std::vector<char> & a_out, uint16_t a_val)
+  {
+    a_out.push_back(char(a_val & 0xFF));
+    a_out.push_back(char(a_val >> 8));
+  }
+
+  inline void PushU32(std::vector<char> & a_out, uint32_t a_val)
+  {
+    PushU16(a_out, uint16_t(a_val & 0xFFFF));
+    PushU16(a_out, uint16_t(a_val >> 16));
+  }
+
+  //A plane holding 'first' in the first tile and 'fill' in the rest
+  struct Plane
+  {
+    uint16_t first;
+    uint16_t fill;
+  };
+
+  //Compressed as one literal and one run. Returns the offset of the plane.
+  inline uint32_t PushPlane(std::vector<char> & a_out, Plane a_plane, uint16_t a_tiles)
+  {
+    uint32_t offset = uint32_t(a_out.size());
+    PushU16(a_out, uint16_t(a_tiles * 2));
+    PushU16(a_out, a_plane.first);
+    PushU16(a_out, Tag);
+    PushU16(a_out, uint16_t(a_tiles - 1));
+    PushU16(a_out, a_plane.fill);
+    return offset;
+  }
+
+  //Appends the planes then the map header. Returns the offset of the header, which
+  //goes in MAPHEAD.
+  inline uint32_t PushMap(std::vector<char> & a_out, char const * a_name, uint16_t a_width, uint16_t a_height,
+                          Plane a_plane0, Plane a_plane1)
+  {
+    uint16_t tiles = uint16_t(a_width * a_height);
+    uint32_t plane0 = PushPlane(a_out, a_plane0, tiles);
+    uint32_t plane1 = PushPlane(a_out, a_plane1, tiles);
+    uint16_t planeSize = uint16_t(a_out.size() - plane1);
+
+    uint32_t offset = uint32_t(a_out.size());
+    PushU32(a_out, plane0);
+    PushU32(a_out, plane1);
+    PushU32(a_out, 0);
+    PushU16(a_out, planeSize);
+    PushU16(a_out, planeSize);
+    PushU16(a_out, 0);
+    PushU16(a_out, a_width);
+    PushU16(a_out, a_height);
+
+    char name[16] = {};
+    strncpy(name, a_name, sizeof(name) - 1);
+    a_out.insert(a_out.end(), name, name + sizeof(name));
+    return offset;
+  }
+
+  //The tag, then the offset of each map. Maps past 'count' are left out (offset 0).
+  inline std::vector<char> MakeHead(uint32_t const * a_offsets, uint32_t a_count)
+  {
+    std::vector<char> head;
+    PushU16(head, Tag);
+    for (uint32_t i = 0; i < MAX_MAPS; i++)
+      PushU32(head, i < a_count ? a_offsets[i] : 0);
+    return head;
+  }
+}
+
+#endif
@@ -0,0 +1,68 @@
+#include "TestHarness.h"
+#include "gc_BSP.h"
+#include "Data/gc_MapData.h"
+
+static GC::BSP_Node MakeBranch(uint32_t a_element, uint32_t a_offset, uint32_t a_below, uint32_t a_above)
+{
+  GC::BSP_Node node;
+  node.Set<GC::BSP_Node::Item::Type>(GC::BSP_Node::Branch);
+  node.Set<GC::BSP_Node::Item::Element>(a_element);
+  node.Set<GC::BSP_Node::Item::Offset>(a_offset);
+  node.Set<GC::BSP_Node::Item::ChildBelowIndex>(a_below);
+  node.Set<GC::BSP_Node::Item::ChildAboveIndex>(a_above);
+  return node;
+}
+
+static GC::BSP_Node MakeLeaf(uint32_t a_block)
+{
+  GC::BSP_Node node;
+  node.Set<GC::BSP_Node::Item::Type>(GC::BSP_Node::Leaf);
+  node.Set<GC::BSP_Node::Item::BlockIndex>(a_block);
+  return node;
+}
+
+TEST(Stack_BSP, creation_BSP)
+{
+  GC::BSP bsp;
+  CHECK(bsp.Locate(GC::vec2(1.0f, 1.0f)) == GC::BSP::NoBlock);
+
+  //x < 4 is block 0. Otherwise y < 2 is block 1, and the rest block 2.
+  GC::BSP_Node nodes[5] =
+  {
+    MakeBranch(GC::BSP_Node::x, 4, 1, 2),
+    MakeLeaf(0),
+    MakeBranch(GC::BSP_Node::y, 2, 3, 4),
+    MakeLeaf(1),
+    MakeLeaf(2)
+  };
+
+  CHECK(bsp.Build(nodes, 5));
+  CHECK(bsp.NodeCount() == 2);
+  CHECK(bsp.Depth() == 2);
+
+  CHECK(bsp.Locate(GC::vec2(1.0f, 5.0f)) == 0);
+  CHECK(bsp.Locate(GC::vec2(5.0f, 1.0f)) == 1);
+  CHECK(bsp.Locate(GC::vec2(5.0f, 3.0f)) == 2);
+  CHECK(bsp.Locate(GC::vec2(4.0f, 2.0f)) == 2);
+
+  GC::vec2 points[19];
+  uint32_t blocks[19];
+  for (int i = 0; i < 19; i++)
+    points[i] = GC::vec2(float(i % 8) + 0.5f, float(i / 8) + 0.5f);
+
+  bsp.LocateN(points, 19, blocks);
+  bool same = true;
+  for (int i = 0; i < 19; i++)
+    same = same && blocks[i] == bsp.Locate(points[i]);
+  CHECK(same);
+
+  //A child out of range
+  nodes[2] = MakeBranch(GC::BSP_Node::y, 2, 3, 7);
+  CHECK(!bsp.Build(nodes, 5));
+  CHECK(bsp.Locate(GC::vec2(1.0f, 5.0f)) == GC::BSP::NoBlock);
+
+  //A single block
+  CHECK(bsp.Build(&nodes[4], 1));
+  CHECK(bsp.NodeCount() == 0);
+  CHECK(bsp.Locate(GC::vec2(30.0f, 30.0f)) == 2);
+}
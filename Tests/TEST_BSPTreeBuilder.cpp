@@ -0,0 +1,128 @@
+#include <algorithm>
+
+#include "TestHarness.h"
+#include "BSPTreeBuilder.h"
+#include "ThreadPool/gc_ThreadPool.h"
+
+static Block MakeBlock(uint32_t a_x, uint32_t a_y, uint32_t a_w, uint32_t a_h)
+{
+  Block block;
+  block.lowerLeft[Block::X] = uint8_t(a_x);
+  block.lowerLeft[Block::Y] = uint8_t(a_y);
+  block.dimensions[Block::W] = uint8_t(a_w);
+  block.dimensions[Block::H] = uint8_t(a_h);
+  return block;
+}
+
+static bool IsBranch(Node const & a_node, int a_element, float a_offset, uint32_t a_above, uint32_t a_below)
+{
+  return a_node.GetType() == Node::E_Branch
+    && a_node.GetElement() == a_element
+    && a_node.GetOffset() == a_offset
+    && a_node.GetChildAboveInd() == a_above
+    && a_node.GetChildBelowInd() == a_below;
+}
+
+static bool IsLeaf(Node const & a_node, uint32_t a_block)
+{
+  return a_node.GetType() == Node::E_Leaf && a_node.GetBlockID() == a_block;
+}
+
+static bool SameNode(Node const & a_a, Node const & a_b)
+{
+  if (a_a.GetType() == Node::E_Leaf)
+    return IsLeaf(a_b, a_a.GetBlockID());
+  return IsBranch(a_b, a_a.GetElement(), a_a.GetOffset(), a_a.GetChildAboveInd(), a_a.GetChildBelowInd());
+}
+
+//Tiles a square with rows of blocks of varying sizes
+static void MakeBlocks(uint32_t a_size, uint32_t a_seed, Dg::DynamicArray<Block> & a_out)
+{
+  uint32_t state = a_seed;
+  auto next = [&state](uint32_t a_max)
+  {
+    state = state * 1664525u + 1013904223u;
+    return 1 + (state >> 16) % a_max;
+  };
+
+  for (uint32_t y = 0; y < a_size;)
+  {
+    uint32_t h = std::min(next(4), a_size - y);
+    for (uint32_t x = 0; x < a_size;)
+    {
+      uint32_t w = std::min(next(5), a_size - x);
+      a_out.push_back(MakeBlock(x, y, w, h));
+      x += w;
+    }
+    y += h;
+  }
+}
+
+TEST(Stack_BSPTreeBuilder, creation_BSPTreeBuilder)
+{
+  //Areas 2, 1 and 1 in a row. Splitting at x = 2 balances the areas with nothing
+  //straddling, then x = 3 splits the rest. Blocks at or past a plane are above it.
+  Dg::DynamicArray<Block> row;
+  row.push_back(MakeBlock(0, 0, 2, 1));
+  row.push_back(MakeBlock(2, 0, 1, 1));
+  row.push_back(MakeBlock(3, 0, 1, 1));
+
+  BSPTreeBuilder rowTree(row);
+  rowTree.Run();
+  Dg::DynamicArray<Node> const & rowNodes = rowTree.GetResults();
+  CHECK(rowNodes.size() == 5);
+  CHECK(IsBranch(rowNodes[0], Block::X, 2.0f, 1, 4));
+  CHECK(IsBranch(rowNodes[1], Block::X, 3.0f, 2, 3));
+  CHECK(IsLeaf(rowNodes[2], 2));
+  CHECK(IsLeaf(rowNodes[3], 1));
+  CHECK(IsLeaf(rowNodes[4], 0));
+
+  //x = 2 scores 1.5: areas 6 and 3. y = 1 scores 2.5: block 2, area 3, straddles
+  //it and the sides are 2 and 4.
+  Dg::DynamicArray<Block> lShape;
+  lShape.push_back(MakeBlock(0, 0, 2, 1));
+  lShape.push_back(MakeBlock(0, 1, 2, 2));
+  lShape.push_back(MakeBlock(2, 0, 1, 3));
+
+  BSPTreeBuilder lTree(lShape);
+  lTree.Run();
+  Dg::DynamicArray<Node> const & lNodes = lTree.GetResults();
+  CHECK(lNodes.size() == 5);
+  CHECK(IsBranch(lNodes[0], Block::X, 2.0f, 1, 2));
+  CHECK(IsLeaf(lNodes[1], 2));
+  CHECK(IsBranch(lNodes[2], Block::Y, 1.0f, 3, 4));
+  CHECK(IsLeaf(lNodes[3], 1));
+  CHECK(IsLeaf(lNodes[4], 0));
+}
+
+TEST(Stack_BSPTreeBuilder, BSPTreeBuilder_ThreadPool)
+{
+  //Enough blocks that the top nodes are split on the pool
+  Dg::DynamicArray<Block> blocks;
+  MakeBlocks(64, 7, blocks);
+  CHECK(blocks.size() > 256);
+
+  BSPTreeBuilder serial(blocks);
+  serial.Run();
+
+  GC::ThreadPool pool(4);
+  BSPTreeBuilder parallel(blocks);
+  parallel.SetThreadPool(&pool);
+  parallel.Run();
+
+  Dg::DynamicArray<Node> const & expected = serial.GetResults();
+  Dg::DynamicArray<Node> const & result = parallel.GetResults();
+  CHECK(expected.size() == result.size());
+
+  bool same = expected.size() == result.size();
+  for (size_t i = 0; i < expected.size() && same; i++)
+    same = SameNode(expected[i], result[i]);
+  CHECK(same);
+
+  //Building again gives the same tree
+  parallel.Run();
+  same = expected.size() == parallel.GetResults().size();
+  for (size_t i = 0; i < expected.size() && same; i++)
+    same = SameNode(expected[i], parallel.GetResults()[i]);
+  CHECK(same);
+}
@@ -0,0 +1,114 @@
+#include <stdlib.h>
+#include "TestHarness.h"
+#include "BlockCompression.h"
+
+namespace
+{
+  int ChannelError(RGBA a, RGBA b)
+  {
+    int e = abs(int(a.r()) - int(b.r()));
+    e = abs(int(a.g()) - int(b.g())) > e ? abs(int(a.g()) - int(b.g())) : e;
+    e = abs(int(a.b()) - int(b.b())) > e ? abs(int(a.b()) - int(b.b())) : e;
+    return e;
+  }
+}
+
+TEST(Stack_BlockCompression, creation_BlockCompression)
+{
+  CHECK(Engine::BlockSize(Engine::TextureFormat::RGBA8) == 0);
+  CHECK(Engine::BlockSize(Engine::TextureFormat::BC1) == 8);
+  CHECK(Engine::BlockSize(Engine::TextureFormat::BC3) == 16);
+  CHECK(Engine::ImageDataSize(Engine::TextureFormat::RGBA8, 5, 3) == 5 * 3 * 4);
+  CHECK(Engine::ImageDataSize(Engine::TextureFormat::BC1, 5, 3) == 2 * 1 * 8);
+  CHECK(Engine::ImageDataSize(Engine::TextureFormat::BC3, 1, 1) == 16);
+}
+
+TEST(Stack_BlockCompression, BlockCompression_BC1)
+{
+  RGBA src[16];
+  RGBA dst[16];
+  byte block[8];
+
+  //Colours which survive 565 exactly
+  for (int i = 0; i < 16; i++)
+    src[i].data = (i & 1) ? 0xFF0000FF : 0xFFFF0000;
+  Engine::EncodeBC1Block(src, block);
+  Engine::DecodeBC1Block(block, dst);
+  for (int i = 0; i < 16; i++)
+    CHECK(dst[i].data == src[i].data);
+
+  //Gradient along one axis. 16 steps share 4 palette entries, 80 apart.
+  for (int i = 0; i < 16; i++)
+  {
+    src[i].data = 0xFF000000;
+    src[i].r(i * 16);
+    src[i].g(255 - i * 16);
+    src[i].b(64);
+  }
+  Engine::EncodeBC1Block(src, block);
+  Engine::DecodeBC1Block(block, dst);
+  for (int i = 0; i < 16; i++)
+    CHECK(ChannelError(src[i], dst[i]) <= 44);
+
+  //1-bit alpha
+  for (int i = 0; i < 16; i++)
+    src[i].data = i < 8 ? 0x00000000 : 0xFF00FF00;
+  Engine::EncodeBC1Block(src, block);
+  Engine::DecodeBC1Block(block, dst);
+  for (int i = 0; i < 16; i++)
+  {
+    if (i < 8)
+      CHECK(dst[i].a() == 0);
+    else
+      CHECK(dst[i].data == 0xFF00FF00);
+  }
+}
+
+TEST(Stack_BlockCompression, BlockCompression_BC3)
+{
+  RGBA src[16];
+  RGBA dst[16];
+  byte block[16];
+
+  for (int i = 0; i < 16; i++)
+  {
+    src[i].data = 0xFF8040C0;
+    src[i].a(i * 17);
+  }
+  Engine::EncodeBC3Block(src, block);
+  Engine::DecodeBC3Block(block, dst);
+  for (int i = 0; i < 16; i++)
+  {
+    CHECK(ChannelError(src[i], dst[i]) <= 8);
+    CHECK(abs(int(src[i].a()) - int(dst[i].a())) <= 19);
+  }
+  CHECK(dst[0].a() == 0);
+  CHECK(dst[15].a() == 255);
+}
+
+TEST(Stack_BlockCompression, BlockCompression_TextureData)
+{
+  RGBA * pixels = new RGBA[8 * 6];
+  for (int i = 0; i < 8 * 6; i++)
+    pixels[i].data = 0xFF0000FF;
+
+  Engine::TextureData data(8, 6, pixels, Engine::TextureFlags());
+  data.GenerateMipmaps();
+  CHECK(data.mipLevels == 4);
+
+  CHECK(data.Compress(Engine::TextureFormat::BC1));
+  CHECK(data.flags.GetFormat() == Engine::TextureFormat::BC1);
+  CHECK(data.DataSize() == (2 * 2 + 1 + 1 + 1) * 8);
+  CHECK(!data.Compress(Engine::TextureFormat::BC3));
+
+  RGBA decoded[16];
+  Engine::DecodeBC1Block(reinterpret_cast<byte const *>(data.Level(3)), decoded);
+  CHECK(decoded[0].data == 0xFF0000FF);
+
+  Engine::TextureData copy(data);
+  CHECK(copy.DataSize() == data.DataSize());
+  CHECK(memcmp(copy.pPixels, data.pPixels, data.DataSize()) == 0);
+
+  copy.Clear();
+  data.Clear();
+}
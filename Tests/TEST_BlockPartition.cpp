@@ -0,0 +1,138 @@
+#include <vector>
+#include <string>
+#include <algorithm>
+
+#include "TestHarness.h"
+#include "BlockPartition.h"
+
+//'#' is a wall, '.' is open. Rows are y, from 0.
+static Dg::HyperArray<bool, 2> MakeMask(std::vector<std::string> const & a_rows)
+{
+  Dg::HyperArray<bool, 2> mask({a_rows[0].size(), a_rows.size()});
+  for (size_t y = 0; y < a_rows.size(); y++)
+  {
+    for (size_t x = 0; x < a_rows[y].size(); x++)
+      mask(x, y) = a_rows[y][x] == '#';
+  }
+  return mask;
+}
+
+static uint32_t Area(Block const & a_block)
+{
+  return uint32_t(a_block.dimensions[Block::W]) * uint32_t(a_block.dimensions[Block::H]);
+}
+
+//Every open cell is covered by exactly one block, and no wall is
+static bool TilesExactly(std::vector<std::string> const & a_rows, Dg::DynamicArray<Block> const & a_blocks)
+{
+  std::vector<std::string> covered(a_rows.size(), std::string(a_rows[0].size(), '.'));
+  for (size_t i = 0; i < a_blocks.size(); i++)
+  {
+    Block const & block = a_blocks[i];
+    for (size_t y = block.lowerLeft[Block::Y]; y < size_t(block.lowerLeft[Block::Y] + block.dimensions[Block::H]); y++)
+    {
+      for (size_t x = block.lowerLeft[Block::X]; x < size_t(block.lowerLeft[Block::X] + block.dimensions[Block::W]); x++)
+      {
+        if (y >= a_rows.size() || x >= a_rows[y].size() || a_rows[y][x] == '#' || covered[y][x] != '.')
+          return false;
+        covered[y][x] = 'x';
+      }
+    }
+  }
+
+  for (size_t y = 0; y < a_rows.size(); y++)
+  {
+    for (size_t x = 0; x < a_rows[y].size(); x++)
+    {
+      if (a_rows[y][x] == '.' && covered[y][x] != 'x')
+        return false;
+    }
+  }
+  return true;
+}
+
+static bool LargestFirst(Dg::DynamicArray<Block> const & a_blocks)
+{
+  for (size_t i = 1; i < a_blocks.size(); i++)
+  {
+    if (Area(a_blocks[i]) > Area(a_blocks[i - 1]))
+      return false;
+  }
+  return true;
+}
+
+TEST(Stack_BlockPartition, creation_BlockPartition)
+{
+  std::vector<std::vector<std::string>> masks =
+  {
+    {
+      "......",
+      "..##..",
+      "......",
+    },
+    {
+      "########",
+      "#......#",
+      "#.####.#",
+      "#.#..#.#",
+      "#.####.#",
+      "#......#",
+      "########",
+    },
+    {
+      "...#....",
+      "...#....",
+      "#.......",
+      "##...###",
+      "##......",
+    },
+  };
+
+  for (std::vector<std::string> const & rows : masks)
+  {
+    BlockPartition partition(MakeMask(rows));
+    Dg::DynamicArray<Block> blocks = partition.Run();
+    CHECK(TilesExactly(rows, blocks));
+    CHECK(LargestFirst(blocks));
+
+    uint32_t open = 0;
+    for (std::string const & row : rows)
+      open += uint32_t(std::count(row.begin(), row.end(), '.'));
+
+    BlockPartition::Stats const & stats = partition.GetStats();
+    CHECK(stats.blockCount == blocks.size());
+    CHECK(stats.totalArea == open);
+    CHECK(stats.largestArea == Area(blocks[0]));
+    CHECK(stats.smallestArea == Area(blocks[blocks.size() - 1]));
+  }
+
+  //The open row across the top is taken whole before the hole splits the rest
+  BlockPartition first(MakeMask(masks[0]));
+  Dg::DynamicArray<Block> blocks = first.Run();
+  CHECK(blocks.size() == 4);
+  CHECK(blocks[0].lowerLeft[Block::X] == 0 && blocks[0].lowerLeft[Block::Y] == 0);
+  CHECK(blocks[0].dimensions[Block::W] == 6 && blocks[0].dimensions[Block::H] == 1);
+
+  //Nothing open
+  BlockPartition walls(MakeMask({"##", "##"}));
+  CHECK(walls.Run().size() == 0);
+  CHECK(walls.GetStats().blockCount == 0);
+}
+
+TEST(Stack_BlockPartition, BlockPartition_MaxSize)
+{
+  std::vector<std::string> rows =
+  {
+    "........",
+    "........",
+    "........",
+  };
+
+  BlockPartition partition(MakeMask(rows));
+  partition.SetMaxBlockSize(3);
+  Dg::DynamicArray<Block> blocks = partition.Run();
+  CHECK(TilesExactly(rows, blocks));
+  for (size_t i = 0; i < blocks.size(); i++)
+    CHECK(blocks[i].dimensions[Block::W] <= 3 && blocks[i].dimensions[Block::H] <= 3);
+  CHECK(partition.GetStats().totalArea == 24);
+}
@@ -0,0 +1,114 @@
+#include <vector>
+#include <string.h>
+
+#include "TestHarness.h"
+#include "MapArchive.h"
+#include "gc_LevelPrefetcher.h"
+#include "ThreadPool/gc_ThreadPool.h"
+#include "Data/gc_MapData.h"
+
+//Maps with a wall in the first tile, and empty otherwise
+static void InitArchive()
+{
+  MapArchive::Plane const walls = {5, 0};
+  MapArchive::Plane const objects = {0, 0};
+
+  std::vector<char> gameData;
+  MapArchive::PushU16(gameData, 0);
+  uint32_t offsets[3];
+  offsets[0] = MapArchive::PushMap(gameData, "Floor 1", 8, 8, walls, objects);
+  offsets[1] = MapArchive::PushMap(gameData, "Floor 2", 4, 4, walls, objects);
+  offsets[2] = MapArchive::PushMap(gameData, "Floor 3", 2, 2, walls, objects);
+
+  std::vector<char> mapHead = MapArchive::MakeHead(offsets, 3);
+  GC::Map_BS::Init(mapHead.data(), mapHead.size(), std::move(gameData));
+}
+
+TEST(Stack_LevelPrefetcher, creation_LevelPrefetcher)
+{
+  InitArchive();
+
+  GC::ThreadPool pool(1);
+  {
+    GC::LevelPrefetcher prefetcher;
+    prefetcher.SetThreadPool(&pool);
+    CHECK(prefetcher.GetPending() == -1);
+
+    //Next in the episode
+    prefetcher.Prefetch(1);
+    CHECK(prefetcher.GetPending() == 1);
+
+    std::unique_ptr<GC::Level> pLevel = prefetcher.Take(1);
+    CHECK(pLevel != nullptr);
+    CHECK(pLevel->index == 1);
+    CHECK(strcmp(pLevel->map.name, "Floor 2") == 0);
+    CHECK(pLevel->map.planes[0](0, 0) == 5);
+    CHECK(pLevel->textures.size() == 1);
+    CHECK(pLevel->view.pHeader == nullptr);
+    CHECK(prefetcher.GetPending() == -1);
+
+    //The first candidate the archive has
+    int candidates[3] = {7, 2, 0};
+    prefetcher.Prefetch(candidates, 3);
+    CHECK(prefetcher.GetPending() == 2);
+
+    //Only one level is kept, so this replaces it
+    prefetcher.Prefetch(0);
+    CHECK(prefetcher.GetPending() == 0);
+
+    //Not the one prefetched, so loaded now
+    pLevel = prefetcher.Take(2);
+    CHECK(pLevel != nullptr && pLevel->index == 2);
+    CHECK(prefetcher.GetPending() == -1);
+
+    prefetcher.Prefetch(1);
+    prefetcher.Cancel();
+    CHECK(prefetcher.GetPending() == -1);
+
+    CHECK(prefetcher.Take(5) == nullptr);
+
+    //Destroyed with a level in flight
+    prefetcher.Prefetch(0);
+  }
+
+  //With the converted map, which has only the one map and is found by name
+  char const name[16] = "Floor 3";
+  GC::BSP_Node node;
+  node.Set<GC::BSP_Node::Item::Type>(GC::BSP_Node::Leaf);
+  node.Set<GC::BSP_Node::Item::BlockIndex>(0);
+  uint16_t plane[4] = {};
+
+  GC::MapFileBuilder builder(1);
+  builder.BeginMap(name, 2, 2, 0, 0);
+  builder.AddSection(GC::MapSection::BSPNodes, &node, 1);
+  builder.AddSection(GC::MapSection::Plane0, plane, 4);
+  builder.AddSection(GC::MapSection::Plane1, plane, 4);
+  std::vector<uint8_t> file = builder.Finish();
+  std::vector<uint64_t> storage(file.size() / sizeof(uint64_t));
+  memcpy(storage.data(), file.data(), file.size());
+
+  GC::MapFile mapFile;
+  CHECK(mapFile.Attach(storage.data(), file.size()));
+  {
+    GC::LevelPrefetcher prefetcher;
+    prefetcher.SetThreadPool(&pool);
+    prefetcher.SetMapFile(&mapFile);
+    prefetcher.Prefetch(2);
+
+    std::unique_ptr<GC::Level> pLevel = prefetcher.Take(2);
+    CHECK(pLevel != nullptr);
+    CHECK(pLevel->view.pHeader != nullptr);
+    CHECK(pLevel->bsp.Locate(GC::vec2(1.0f, 1.0f)) == 0);
+
+    pLevel = prefetcher.Take(0);
+    CHECK(pLevel != nullptr && pLevel->view.pHeader == nullptr);
+  }
+
+  //No pool
+  GC::LevelPrefetcher prefetcher;
+  prefetcher.Prefetch(0);
+  std::unique_ptr<GC::Level> pLevel = prefetcher.Take(0);
+  CHECK(pLevel != nullptr && pLevel->index == 0);
+
+  GC::Map_BS::Shutdown();
+}
@@ -0,0 +1,43 @@
+#include "TestHarness.h"
+#include "gc_Map_BS.h"
+#include "gc_LevelTextures.h"
+
+TEST(Stack_LevelTextures, creation_LevelTextures)
+{
+  GC::Map_BS map;
+  map.planes[0].Set({4, 4});
+  map.planes[1].Set({4, 4});
+
+  map.planes[0](0, 0) = 5;
+  map.planes[0](1, 0) = 5;
+  map.planes[0](2, 3) = 63;
+  map.planes[0](3, 3) = 64;   //Not a wall
+
+  map.planes[1](0, 1) = GC::Tile::CeilingFloor;
+  map.planes[1](1, 1) = 0x0203;
+  map.planes[1](2, 2) = 30;
+  map.planes[1](3, 2) = 31;
+  map.planes[1](0, 3) = 30;
+
+  std::vector<GC::LevelTextureKey> keys = GC::GetLevelTextures(map);
+  CHECK(keys.size() == 4);
+  CHECK(keys[0] == GC::MakeLevelTextureKey(GC::LevelTextureType::Wall, 5));
+  CHECK(keys[1] == GC::MakeLevelTextureKey(GC::LevelTextureType::Wall, 63));
+  CHECK(keys[2] == GC::MakeLevelTextureKey(GC::LevelTextureType::Floor, 3));
+  CHECK(keys[3] == GC::MakeLevelTextureKey(GC::LevelTextureType::Ceiling, 2));
+
+  int calls = 0;
+  keys = GC::GetLevelTextures(map, [&calls](uint16_t a_code, std::vector<uint16_t> & a_sprites)
+  {
+    calls++;
+    a_sprites.push_back(a_code * 2);
+    a_sprites.push_back(100);
+  });
+
+  CHECK(calls == 2);
+  CHECK(keys.size() == 7);
+  CHECK(GC::GetLevelTextureType(keys[4]) == GC::LevelTextureType::Sprite);
+  CHECK(GC::GetLevelTextureIndex(keys[4]) == 60);
+  CHECK(GC::GetLevelTextureIndex(keys[5]) == 62);
+  CHECK(GC::GetLevelTextureIndex(keys[6]) == 100);
+}
@@ -0,0 +1,59 @@
+#include "TestHarness.h"
+#include "Data/gc_MapFile.h"
+
+TEST(Stack_MapFile, creation_MapFile)
+{
+  char const names[2][16] = {"Wolf1 Map1", "Wolf1 Map2"};
+  uint16_t plane[6] = {1, 2, 3, 4, 5, 6};
+
+  GC::Block blocks[2];
+  blocks[0].SetX(1);
+  blocks[0].SetY(2);
+  blocks[0].SetW(3);
+  blocks[0].SetH(4);
+  blocks[1] = blocks[0];
+  blocks[1].SetX(7);
+
+  GC::MapFileBuilder builder(2);
+  builder.BeginMap(names[0], 3, 2, 10, 11);
+  builder.AddSection(GC::MapSection::Blocks, blocks, 2, 42);
+  builder.AddSection(GC::MapSection::Plane0, plane, 6);
+  builder.AddSection(GC::MapSection::Plane1, plane, 6);
+  builder.BeginMap(names[1], 1, 1, 0, 0);
+  builder.AddSection(GC::MapSection::Plane0, plane, 1);
+  builder.AddSection(GC::MapSection::Plane1, plane + 5, 1);
+
+  std::vector<uint8_t> file = builder.Finish();
+  CHECK(file.size() % GC::MapFileAlignment == 0);
+
+  //Copy to aligned memory, as a mapped file would be
+  std::vector<uint64_t> storage(file.size() / sizeof(uint64_t));
+  memcpy(storage.data(), file.data(), file.size());
+
+  GC::MapFile mapFile;
+  CHECK(mapFile.Attach(storage.data(), file.size()));
+  CHECK(mapFile.GetMapCount() == 2);
+
+  GC::MapView map = mapFile.GetMap(0);
+  CHECK(strcmp(map.pHeader->name, names[0]) == 0);
+  CHECK(map.pHeader->width == 3 && map.pHeader->height == 2);
+  CHECK(map.pHeader->ceilingTile == 10 && map.pHeader->floorTile == 11);
+  CHECK(map.blocks.count == 2);
+  CHECK(map.blocks[1].GetX() == 7 && map.blocks[1].GetH() == 4);
+  CHECK(map.bspNodes.count == 0);
+  CHECK(map.pHeader->sections[uint32_t(GC::MapSection::Blocks)].sourceHash == 42);
+  CHECK(map.planes[1].count == 6 && map.planes[1][5] == 6);
+  CHECK((reinterpret_cast<uintptr_t>(map.planes[0].data) % GC::MapFileAlignment) == 0);
+
+  map = mapFile.GetMap(1);
+  CHECK(map.blocks.count == 0);
+  CHECK(map.planes[1][0] == 6);
+
+  //Truncated
+  CHECK(!mapFile.Attach(storage.data(), file.size() - GC::MapFileAlignment));
+  CHECK(mapFile.GetMapCount() == 0);
+
+  //Wrong version
+  reinterpret_cast<GC::MapFileHeader *>(storage.data())->version++;
+  CHECK(!mapFile.Attach(storage.data(), file.size()));
+}
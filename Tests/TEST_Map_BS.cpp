@@ -0,0 +1,48 @@
+#include <vector>
+#include <string.h>
+
+#include "TestHarness.h"
+#include "MapArchive.h"
+#include "gc_Map_BS.h"
+
+TEST(Stack_Map_BS, creation_Map_BS)
+{
+  std::vector<char> gameData;
+  MapArchive::PushU16(gameData, 0);   //Nothing may start at offset 0
+  uint32_t offsets[4] = {};
+  offsets[0] = MapArchive::PushMap(gameData, "Level 1", 4, 3, {5, 1}, {98, 0});
+  offsets[2] = MapArchive::PushMap(gameData, "Level 3", 2, 2, {5, 1}, {98, 0});
+  offsets[3] = uint32_t(gameData.size());   //Out of range
+
+  std::vector<char> mapHead = MapArchive::MakeHead(offsets, 4);
+
+  CHECK(GC::Map_BS::Init(mapHead.data(), mapHead.size(), std::move(gameData)));
+  CHECK(GC::Map_BS::HasMap(0));
+  CHECK(!GC::Map_BS::HasMap(1));
+  CHECK(GC::Map_BS::HasMap(2));
+  CHECK(!GC::Map_BS::HasMap(3));
+  CHECK(!GC::Map_BS::HasMap(-1));
+  CHECK(!GC::Map_BS::HasMap(MAX_MAPS));
+
+  GC::Map_BS map;
+  CHECK(map.LoadMap(0));
+  CHECK(strcmp(map.name, "Level 1") == 0);
+  CHECK(map.planes[0].length(0) == 3 && map.planes[0].length(1) == 4);
+  CHECK(map.planes[0](0, 0) == 5);
+  CHECK(map.planes[0](2, 3) == 1);
+  CHECK(map.planes[1](0, 0) == 98);
+  CHECK(map.planes[1](1, 2) == 0);
+
+  CHECK(map.LoadMap(2));
+  CHECK(strcmp(map.name, "Level 3") == 0);
+  CHECK(map.planes[0].length(0) == 2 && map.planes[0].length(1) == 2);
+
+  CHECK(!map.LoadMap(1));
+  CHECK(map.name[0] == 0);
+
+  //Too short to hold the offsets
+  CHECK(!GC::Map_BS::Init(mapHead.data(), 10, std::vector<char>()));
+  CHECK(!GC::Map_BS::HasMap(0));
+
+  GC::Map_BS::Shutdown();
+}
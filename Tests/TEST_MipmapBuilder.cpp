@@ -0,0 +1,74 @@
+#include "TestHarness.h"
+#include "TextureData.h"
+
+TEST(Stack_MipmapBuilder, creation_MipmapBuilder)
+{
+  CHECK(Engine::MipLevelCount(1, 1) == 1);
+  CHECK(Engine::MipLevelCount(64, 32) == 7);
+  CHECK(Engine::MipLevelCount(5, 3) == 3);
+  CHECK(Engine::MipLevelSize(5, 1) == 2);
+  CHECK(Engine::MipLevelSize(5, 4) == 1);
+}
+
+TEST(Stack_MipmapBuilder, MipmapBuilder_Box)
+{
+  RGBA src[4];
+  src[0].data = 0xFF000000;
+  src[1].data = 0xFF000000;
+  src[2].data = 0xFFFFFFFF;
+  src[3].data = 0xFFFFFFFF;
+
+  Engine::MipmapBuildOptions opts;
+  opts.sRGB = false;
+
+  RGBA dst;
+  Engine::BuildMipLevel(src, 2, 2, &dst, Engine::TextureWrap::Clamp, opts);
+  CHECK(dst.r() == 128);
+  CHECK(dst.a() == 255);
+
+  //Averaging black and white in linear space lands well above the sRGB midpoint.
+  opts.sRGB = true;
+  Engine::BuildMipLevel(src, 2, 2, &dst, Engine::TextureWrap::Clamp, opts);
+  CHECK(dst.r() == 188);
+  CHECK(dst.g() == 188);
+  CHECK(dst.b() == 188);
+}
+
+TEST(Stack_MipmapBuilder, MipmapBuilder_PremultipliedAlpha)
+{
+  //Transparent red next to opaque green
+  RGBA src[2];
+  src[0].data = 0x000000FF;
+  src[1].data = 0xFF00FF00;
+
+  Engine::MipmapBuildOptions opts;
+  opts.sRGB = false;
+  opts.premultipliedAlpha = true;
+
+  RGBA dst;
+  Engine::BuildMipLevel(src, 2, 1, &dst, Engine::TextureWrap::Clamp, opts);
+  CHECK(dst.r() == 0);
+  CHECK(dst.g() == 255);
+  CHECK(dst.a() == 128);
+}
+
+TEST(Stack_MipmapBuilder, MipmapBuilder_Chain)
+{
+  RGBA * pixels = new RGBA[8 * 4];
+  for (int i = 0; i < 8 * 4; i++)
+    pixels[i].data = 0xFF336699;
+
+  Engine::MipmapBuildOptions opts;
+  opts.filter = Engine::MipmapBuildFilter::Kaiser;
+
+  Engine::TextureData data(8, 4, pixels, Engine::TextureFlags());
+  data.GenerateMipmaps(opts);
+
+  CHECK(data.mipLevels == 4);
+  CHECK(data.flags.IsMipmapped());
+  CHECK(data.flags.GetMipmapFilter() == Engine::TextureMipmapFilter::Nearest_Nearest);
+  CHECK(data.PixelCount() == 32 + 8 + 2 + 1);
+  CHECK(data.Level(3)->data == 0xFF336699);
+
+  data.Clear();
+}
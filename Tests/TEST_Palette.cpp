@@ -0,0 +1,105 @@
+#include "TestHarness.h"
+#include "Palette.h"
+#include "BlockCompression.h"
+
+namespace
+{
+  void MakeGreyPalette(RGBA * a_palette)
+  {
+    for (uint32_t i = 0; i < Engine::PaletteSize; i++)
+    {
+      a_palette[i].data = 0xFF000000;
+      a_palette[i].r(i);
+      a_palette[i].g(i);
+      a_palette[i].b(i);
+    }
+  }
+}
+
+TEST(Stack_Palette, creation_Palette)
+{
+  RGBA palette[Engine::PaletteSize];
+  MakeGreyPalette(palette);
+  palette[200] = palette[10];
+
+  Engine::PaletteLookup lookup(palette, Engine::PaletteSize);
+
+  byte index = 0;
+  CHECK(lookup.Find(palette[42], index));
+  CHECK(index == 42);
+
+  //Duplicates map to the first entry
+  CHECK(lookup.Find(palette[200], index));
+  CHECK(index == 10);
+
+  RGBA notInPalette(0xFF000000);
+  notInPalette.r(100);
+  notInPalette.g(104);
+  notInPalette.b(102);
+  CHECK(!lookup.Find(notInPalette, index));
+  CHECK(lookup.Nearest(notInPalette) == 102);
+}
+
+TEST(Stack_Palette, Palette_Conversion)
+{
+  RGBA palette[Engine::PaletteSize];
+  MakeGreyPalette(palette);
+  Engine::PaletteLookup lookup(palette, Engine::PaletteSize);
+
+  //Runs and odd lengths exercise both the vector and scalar paths
+  size_t const count = 37;
+  RGBA pixels[count];
+  for (size_t i = 0; i < count; i++)
+    pixels[i] = palette[i < 16 ? 7 : (i * 5) & 0xFF];
+  pixels[30].data = 0xFF010203;
+
+  byte indices[count];
+  CHECK(Engine::RGBAToIndexed(pixels, count, lookup, indices) == 1);
+  CHECK(indices[0] == 7);
+  CHECK(indices[15] == 7);
+  CHECK(indices[20] == 100);
+  CHECK(indices[30] == 2);
+
+  RGBA expanded[count];
+  Engine::IndexedToRGBA(indices, count, palette, expanded);
+  for (size_t i = 0; i < count; i++)
+  {
+    if (i != 30)
+      CHECK(expanded[i].data == pixels[i].data);
+  }
+  CHECK(expanded[30].data == palette[2].data);
+}
+
+TEST(Stack_Palette, Palette_TextureData)
+{
+  RGBA palette[Engine::PaletteSize];
+  MakeGreyPalette(palette);
+
+  RGBA * pixels = new RGBA[6 * 3];
+  for (uint32_t i = 0; i < 6 * 3; i++)
+    pixels[i] = palette[i * 3];
+
+  Engine::TextureData data(6, 3, pixels, Engine::TextureFlags());
+  CHECK(data.ToIndexed(palette, Engine::PaletteSize));
+  CHECK(data.flags.GetFormat() == Engine::TextureFormat::Index8);
+
+  //18 indices, padded to a whole RGBA
+  CHECK(data.DataSize() == 20);
+  CHECK(!data.Compress(Engine::TextureFormat::BC1));
+
+  Engine::TextureData copy(data);
+  CHECK(copy.ToRGBA(palette));
+  CHECK(copy.flags.GetFormat() == Engine::TextureFormat::RGBA8);
+  for (uint32_t i = 0; i < 6 * 3; i++)
+    CHECK(copy.pPixels[i].data == palette[i * 3].data);
+
+  Engine::TextureData paletteTexture;
+  Engine::MakePaletteTexture(palette, 1, paletteTexture);
+  CHECK(paletteTexture.width == Engine::PaletteSize);
+  CHECK(paletteTexture.height == 1);
+  CHECK(paletteTexture.pPixels[255].data == palette[255].data);
+
+  paletteTexture.Clear();
+  copy.Clear();
+  data.Clear();
+}
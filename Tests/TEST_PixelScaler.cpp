@@ -0,0 +1,96 @@
+#include <stdio.h>
+#include "TestHarness.h"
+#include "Benchmark.h"
+#include "PixelScaler.h"
+#include "WorkerPool.h"
+
+namespace
+{
+  //Dark diagonal staircase on a light background
+  Engine::TextureData MakeStaircase(uint32_t a_size)
+  {
+    RGBA * pixels = new RGBA[a_size * a_size];
+    for (uint32_t y = 0; y < a_size; y++)
+    {
+      for (uint32_t x = 0; x < a_size; x++)
+        pixels[y * a_size + x].data = x < y ? 0xFF202020 : 0xFFE0E0E0;
+    }
+    return Engine::TextureData(a_size, a_size, pixels, Engine::TextureFlags());
+  }
+}
+
+TEST(Stack_PixelScaler, creation_PixelScaler)
+{
+  Engine::TextureData src = MakeStaircase(8);
+  Engine::TextureData dst;
+
+  CHECK(!Engine::ScalePixelArt(src, dst, Engine::ResizeMethod::HQx, 1));
+  CHECK(!Engine::ScalePixelArt(src, dst, Engine::ResizeMethod::BRz, 5));
+
+  for (uint32_t factor = 2; factor <= 4; factor++)
+  {
+    CHECK(Engine::ScalePixelArt(src, dst, Engine::ResizeMethod::BRz, factor));
+    CHECK(dst.width == 8 * factor);
+    CHECK(dst.height == 8 * factor);
+
+    //Away from the edge, pixels are untouched
+    CHECK(dst.pPixels[0].data == 0xFFE0E0E0);
+    CHECK(dst.pPixels[(dst.height - 1) * dst.width].data == 0xFF202020);
+  }
+
+  src.Clear();
+  dst.Clear();
+}
+
+TEST(Stack_PixelScaler, PixelScaler_SmoothsEdges)
+{
+  Engine::ResizeMethod methods[2] = {Engine::ResizeMethod::HQx, Engine::ResizeMethod::BRz};
+  for (Engine::ResizeMethod method : methods)
+  {
+    Engine::TextureData src = MakeStaircase(8);
+    Engine::TextureData dst;
+    CHECK(Engine::ScalePixelArt(src, dst, method, 4));
+
+    //Blended pixels should appear along the staircase
+    bool blended = false;
+    for (uint32_t i = 0; i < dst.width * dst.height; i++)
+    {
+      if (dst.pPixels[i].data != 0xFF202020 && dst.pPixels[i].data != 0xFFE0E0E0)
+        blended = true;
+    }
+    CHECK(blended);
+
+    src.Clear();
+    dst.Clear();
+  }
+}
+
+#ifdef BSR_BENCHMARKS
+//Throughput in source megapixels per second
+TEST(Stack_PixelScaler, PixelScaler_Benchmark)
+{
+  Engine::WorkerPool::Init();
+
+  uint32_t const size = 512;
+  Engine::TextureData src = MakeStaircase(size);
+  Engine::TextureData dst;
+
+  char const * names[2] = {"HQx", "xBR"};
+  Engine::ResizeMethod methods[2] = {Engine::ResizeMethod::HQx, Engine::ResizeMethod::BRz};
+  for (int m = 0; m < 2; m++)
+  {
+    for (uint32_t factor = 2; factor <= 4; factor++)
+    {
+      double seconds = Benchmark::Time([&]() {Engine::ScalePixelArt(src, dst, methods[m], factor);});
+
+      char name[64];
+      snprintf(name, sizeof(name), "PixelScaler %s %ux", names[m], factor);
+      Benchmark::Report(name, double(size) * size / 1.0e6, "MP", seconds);
+      dst.Clear();
+    }
+  }
+
+  src.Clear();
+  Engine::WorkerPool::ShutDown();
+}
+#endif
@@ -0,0 +1,91 @@
+#include "TestHarness.h"
+#include "TextureData.h"
+
+TEST(Stack_PixelStorage, creation_PixelStorage)
+{
+  RGBA * pixels = new RGBA[4 * 4];
+  for (int i = 0; i < 16; i++)
+    pixels[i].data = 0xFF000000 | uint32_t(i);
+
+  Engine::TextureData data(4, 4, pixels, Engine::TextureFlags());
+  Engine::TextureData copy(data);
+  CHECK(copy.pPixels == data.pPixels);
+
+  //Writing to the copy detaches it
+  RGBA * pMutable = copy.MutablePixels();
+  CHECK(pMutable != data.pPixels);
+  pMutable[0].data = 0xFFFFFFFF;
+  CHECK(data.pPixels[0].data == 0xFF000000);
+  CHECK(copy.pPixels[0].data == 0xFFFFFFFF);
+
+  //No longer shared, so no copy
+  CHECK(copy.MutablePixels() == pMutable);
+
+  //Outlives the original
+  Engine::TextureData other;
+  other.Duplicate(data);
+  data.Clear();
+  CHECK(other.pPixels[15].data == 0xFF00000F);
+
+  copy.Clear();
+  other.Clear();
+}
+
+TEST(Stack_PixelStorage, PixelStorage_Deserialize)
+{
+  RGBA * pixels = new RGBA[2 * 2];
+  for (int i = 0; i < 4; i++)
+    pixels[i].data = 0xFF0000FF;
+
+  Engine::TextureData data(2, 2, pixels, Engine::TextureFlags());
+  size_t size = data.Size();
+  byte * buffer = new byte[size];
+  data.Serialize(buffer);
+
+  //Points into the buffer rather than copying out of it
+  Engine::TextureData loaded;
+  CHECK(loaded.Deserialize(buffer) == buffer + size);
+  CHECK(reinterpret_cast<byte const *>(loaded.pPixels) > buffer);
+  CHECK(reinterpret_cast<byte const *>(loaded.pPixels) < buffer + size);
+  CHECK(loaded.pPixels[3].data == 0xFF0000FF);
+
+  //The buffer is never written to
+  loaded.MutablePixels()[0].data = 0;
+  CHECK(pixels[0].data == 0xFF0000FF);
+  CHECK(reinterpret_cast<RGBA const *>(buffer + size - 4 * sizeof(RGBA))[0].data == 0xFF0000FF);
+
+  loaded.Clear();
+  data.Clear();
+  delete[] buffer;
+}
+
+TEST(Stack_PixelStorage, PixelStorage_UploadHandoff)
+{
+  RGBA * pixels = new RGBA[2 * 2];
+  for (int i = 0; i < 4; i++)
+    pixels[i].data = 0xFF00FF00;
+
+  Engine::TextureData data(2, 2, pixels, Engine::TextureFlags());
+  Engine::PixelStorage const * pStorage = data.GetStorage();
+  CHECK(pStorage != nullptr);
+  CHECK(pStorage->RefCount() == 1);
+
+  //As Texture2D::Upload() hands the pixels to the render thread, keeping a CPU copy
+  Engine::TextureData local;
+  local.Duplicate(data);
+  CHECK(pStorage->RefCount() == 2);
+
+  auto command = [data = std::move(local)]() mutable
+  {
+    data.Clear();
+  };
+  CHECK(local.GetStorage() == nullptr);
+  CHECK(pStorage->RefCount() == 2);
+
+  command();
+  CHECK(pStorage->RefCount() == 1);
+  CHECK(data.MutablePixels() == data.pPixels);
+
+  data.Clear();
+  CHECK(data.GetStorage() == nullptr);
+}
@@ -0,0 +1,110 @@
+#include <vector>
+
+#include "TestHarness.h"
+#include "Benchmark.h"
+#include "gc_RLEW.h"
+
+static uint16_t const s_tag = 0xABCD;
+
+//As the game data is compressed: runs longer than 3, and any tag words, become runs.
+static std::vector<uint16_t> EncodeRLEW(std::vector<uint16_t> const & a_words)
+{
+  std::vector<uint16_t> result;
+  result.push_back(uint16_t(a_words.size() * 2));
+
+  for (size_t i = 0; i < a_words.size();)
+  {
+    size_t run = 1;
+    while (i + run < a_words.size() && a_words[i + run] == a_words[i] && run < 0xFFFF)
+      run++;
+
+    if (run > 3 || a_words[i] == s_tag)
+    {
+      result.push_back(s_tag);
+      result.push_back(uint16_t(run));
+      result.push_back(a_words[i]);
+    }
+    else
+    {
+      for (size_t r = 0; r < run; r++)
+        result.push_back(a_words[i]);
+    }
+    i += run;
+  }
+  return result;
+}
+
+//Open areas broken up by walls and objects, like a real map
+static std::vector<uint16_t> MakePlane(uint32_t a_width, uint32_t a_height, uint32_t a_seed)
+{
+  std::vector<uint16_t> result(a_width * a_height);
+  uint32_t state = a_seed;
+  for (size_t i = 0; i < result.size(); i++)
+  {
+    state = state * 1664525u + 1013904223u;
+    uint32_t r = state >> 24;
+    if (r < 160)
+      result[i] = i > 0 ? result[i - 1] : 1;
+    else if (r < 250)
+      result[i] = uint16_t(1 + (r % 63));
+    else
+      result[i] = s_tag;
+  }
+  return result;
+}
+
+TEST(Stack_RLEW, creation_RLEW)
+{
+  std::vector<uint16_t> plane = MakePlane(64, 64, 7);
+  std::vector<uint16_t> data = EncodeRLEW(plane);
+  size_t size = data.size() * 2;
+
+  std::vector<uint16_t> out(plane.size());
+  CHECK(GC::DecodeRLEW(data.data(), size, s_tag, out.data(), out.size()));
+  CHECK(out == plane);
+
+  //Too much or too little data for the plane
+  CHECK(!GC::DecodeRLEW(data.data(), size, s_tag, out.data(), out.size() - 1));
+  std::vector<uint16_t> larger(plane.size() + 1, 0x1234);
+  CHECK(!GC::DecodeRLEW(data.data(), size, s_tag, larger.data(), larger.size()));
+
+  //A run past the end of the plane does not write past it
+  uint16_t overrun[] = {0, s_tag, 40, 9};
+  std::vector<uint16_t> small(33, 0);
+  CHECK(!GC::DecodeRLEW(overrun, sizeof(overrun), s_tag, small.data(), 32));
+  CHECK(small[32] == 0);
+
+  //A run cut off at the end
+  uint16_t truncated[] = {0, 5, s_tag, 40};
+  CHECK(!GC::DecodeRLEW(truncated, sizeof(truncated), s_tag, small.data(), 32));
+
+  CHECK(!GC::DecodeRLEW(data.data(), 0, s_tag, out.data(), 0));
+}
+
+#ifdef BSR_BENCHMARKS
+//Throughput in decoded megabytes per second
+TEST(Stack_RLEW, RLEW_Benchmark)
+{
+  uint32_t const mapCount = 60;
+  std::vector<std::vector<uint16_t>> maps;
+  for (uint32_t i = 0; i < mapCount; i++)
+    maps.push_back(EncodeRLEW(MakePlane(64, 64, i + 1)));
+
+  std::vector<uint16_t> out(64 * 64);
+  uint32_t const passes = 200;
+  bool good = true;
+
+  double seconds = Benchmark::Time([&]()
+  {
+    for (uint32_t p = 0; p < passes; p++)
+    {
+      for (uint32_t i = 0; i < mapCount; i++)
+        good = GC::DecodeRLEW(maps[i].data(), maps[i].size() * 2, s_tag, out.data(), out.size()) && good;
+    }
+  });
+
+  CHECK(good);
+  double bytes = double(passes) * mapCount * out.size() * sizeof(uint16_t);
+  Benchmark::Report("RLEW decode", bytes / 1.0e6, "MB", seconds);
+}
+#endif
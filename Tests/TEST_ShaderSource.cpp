@@ -0,0 +1,141 @@
+#include "TestHarness.h"
+#include "ShaderSource.h"
+#include "ShaderUniform.h"
+
+static std::string Preprocess(std::string const & a_src, Engine::ShaderDefines const & a_defines)
+{
+  Engine::ShaderSource source({{Engine::ShaderDomain::Fragment, Engine::StrType::Source, a_src}});
+  source.ApplyDefines(a_defines);
+  return source.GetPreprocessed(Engine::ShaderDomain::Fragment);
+}
+
+static bool Contains(std::string const & a_str, char const * a_find)
+{
+  return a_str.find(a_find) != std::string::npos;
+}
+
+TEST(Stack_ShaderSource, creation_ShaderSource)
+{
+  std::string const src =
+    "#version 430\n"
+    "#ifdef USE_FOG\n"
+    "uniform vec4 u_fogColour;\n"
+    "#endif\n"
+    "#if MAX_LIGHTS > 2 && !defined(NO_SHADOWS)\n"
+    "uniform sampler2D u_shadowMap;\n"
+    "#elif defined(CHEAP_SHADOWS)\n"
+    "uniform float u_shadowBias;\n"
+    "#else\n"
+    "uniform int u_shadowBias;\n"
+    "#endif\n"
+    "#ifndef MAX_LIGHTS\n"
+    "#define MAX_LIGHTS 1\n"
+    "#endif\n"
+    "uniform vec3 u_lights[MAX_LIGHTS];\n";
+
+  std::string result = Preprocess(src, {});
+  CHECK(!Contains(result, "u_fogColour"));
+  CHECK(!Contains(result, "u_shadowMap"));
+  CHECK(Contains(result, "uniform int u_shadowBias;"));
+  CHECK(Contains(result, "u_lights[1]"));
+
+  result = Preprocess(src, {"USE_FOG", "MAX_LIGHTS 4"});
+  CHECK(Contains(result, "u_fogColour"));
+  CHECK(Contains(result, "u_shadowMap"));
+  CHECK(!Contains(result, "u_shadowBias"));
+  CHECK(Contains(result, "u_lights[4]"));
+
+  result = Preprocess(src, {"MAX_LIGHTS 4", "NO_SHADOWS", "CHEAP_SHADOWS"});
+  CHECK(!Contains(result, "u_shadowMap"));
+  CHECK(Contains(result, "uniform float u_shadowBias;"));
+
+  //Nested branches inside one which is not taken stay out
+  result = Preprocess("#if 0\n#if 1\nuniform float a;\n#else\nuniform float b;\n#endif\n#endif\nuniform float c;\n", {});
+  CHECK(!Contains(result, "float a") && !Contains(result, "float b") && Contains(result, "float c"));
+}
+
+TEST(Stack_ShaderSource, layouts_ShaderSource)
+{
+  std::vector<Engine::ShaderSourceElement> src =
+  {
+    {Engine::ShaderDomain::Fragment, Engine::StrType::Source,
+      "#version 430\n"
+      "uniform float u_alpha;\n"
+      "#ifdef USE_FOG\n"
+      "uniform vec4 u_fog;\n"
+      "#else\n"
+      "uniform float u_fog;\n"
+      "#endif\n"}
+  };
+
+  Engine::ShaderData plain;
+  plain.Init(src);
+  Engine::ShaderData fog;
+  fog.Init(src, {"USE_FOG"});
+  Engine::ShaderData fog2;
+  fog2.Init(src, {"USE_FOG"});
+
+  //Only the branch compiled in is reflected
+  CHECK(plain.GetUniforms().size() == 2);
+  CHECK(fog.GetUniforms().size() == 2);
+  CHECK(plain.FindUniform("u_fog")->GetType() == Engine::ShaderDataType::FLOAT);
+  CHECK(fog.FindUniform("u_fog")->GetType() == Engine::ShaderDataType::VEC4);
+  CHECK(plain.GetUniformDataSize() < fog.GetUniformDataSize());
+
+  CHECK(!plain.SharesLayoutWith(fog));
+  CHECK(fog.SharesLayoutWith(fog2));
+}
+
+TEST(Stack_ShaderSource, ShaderSource_Comments)
+{
+  //Comments are not part of a macro's value
+  std::string result = Preprocess("#define COUNT 2 // lights\nuniform vec3 u_lights[COUNT];\n", {});
+  CHECK(Contains(result, "uniform vec3 u_lights[2];"));
+  CHECK(!Contains(result, "lights\n"));
+
+  //Directives inside block comments are ignored
+  result = Preprocess("/*\n#define USE_FOG\n*/\n#ifdef USE_FOG\nuniform vec4 u_fog;\n#endif\nuniform float u_a;\n", {});
+  CHECK(!Contains(result, "u_fog"));
+  CHECK(Contains(result, "u_a"));
+
+  //A comment does not join the lines either side of it
+  result = Preprocess("uniform float u_a; /* one\ntwo */ uniform float u_b; // three\nuniform float u_c;\n", {});
+  CHECK(Contains(result, "uniform float u_a;"));
+  CHECK(Contains(result, "uniform float u_b;"));
+  CHECK(Contains(result, "\nuniform float u_c;"));
+}
+
+TEST(Stack_ShaderSource, ShaderSource_Continuation)
+{
+  std::string result = Preprocess("#define COUNT \\\n  3\nuniform float u_a[COUNT];\n", {});
+  CHECK(Contains(result, "uniform float u_a[3];"));
+
+  result = Preprocess("#if defined(A) && \\\n    defined(B)\nuniform float u_ab;\n#endif\n", {"A"});
+  CHECK(!Contains(result, "u_ab"));
+  result = Preprocess("#if defined(A) && \\\n    defined(B)\nuniform float u_ab;\n#endif\n", {"A", "B"});
+  CHECK(Contains(result, "u_ab"));
+}
+
+TEST(Stack_ShaderSource, ShaderSource_Version)
+{
+  //Defines follow the version directive, not a mention of it in a comment
+  Engine::ShaderSource source({{Engine::ShaderDomain::Fragment, Engine::StrType::Source,
+    "// Needs #version 430 for arrays of arrays\n"
+    "/* #version */\n"
+    "  #version 430 core\n"
+    "uniform float u_a;\n"}});
+  source.ApplyDefines({"USE_FOG"});
+
+  std::string const & src = source.Get(Engine::ShaderDomain::Fragment);
+  size_t version = src.find("#version 430 core\n");
+  size_t define = src.find("#define USE_FOG\n");
+  CHECK(version != std::string::npos);
+  CHECK(define == version + strlen("#version 430 core\n"));
+  CHECK(define < src.find("uniform float u_a;"));
+
+  //Without a version directive first, defines go at the start
+  Engine::ShaderSource noVersion({{Engine::ShaderDomain::Fragment, Engine::StrType::Source,
+    "uniform float u_a;\n"}});
+  noVersion.ApplyDefines({"USE_FOG"});
+  CHECK(noVersion.Get(Engine::ShaderDomain::Fragment).find("#define USE_FOG\n") == 0);
+}
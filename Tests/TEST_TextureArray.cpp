@@ -0,0 +1,161 @@
+#include <vector>
+#include "TestHarness.h"
+#include "TextureArray.h"
+#include "Renderer.h"
+
+namespace
+{
+  //Arrays queue a delete command when destroyed. Nothing is executed, so no GL
+  //context is needed.
+  class RendererScope
+  {
+  public:
+
+    RendererScope()
+    {
+      Engine::Renderer::Init();
+    }
+
+    ~RendererScope()
+    {
+      Engine::Renderer::ShutDown();
+    }
+  };
+
+  Engine::TextureData MakeImage(uint32_t a_size, bool a_mipmapped = false)
+  {
+    RGBA * pixels = new RGBA[a_size * a_size];
+    for (uint32_t i = 0; i < a_size * a_size; i++)
+      pixels[i].data = 0xFF000000 | i;
+
+    Engine::TextureData data(a_size, a_size, pixels, Engine::TextureFlags());
+    if (a_mipmapped)
+      data.GenerateMipmaps();
+    return data;
+  }
+
+  void ClearAll(std::vector<Engine::TextureData> & a_images)
+  {
+    for (Engine::TextureData & image : a_images)
+      image.Clear();
+  }
+}
+
+TEST(Stack_TextureArray, creation_TextureArray)
+{
+  RendererScope renderer;
+
+  Engine::TextureData image = MakeImage(8);
+  Engine::TextureData smaller = MakeImage(4);
+  Engine::TextureData mipmapped = MakeImage(8, true);
+  Engine::TextureData compressed = MakeImage(8);
+  CHECK(compressed.Compress(Engine::TextureFormat::BC1));
+
+  {
+    Engine::Ref<Engine::Texture2DArray> array = Engine::Texture2DArray::Create();
+    CHECK(array->CanHold(smaller));
+    CHECK(array->AddLayer(image) == 0);
+    CHECK(array->AddLayer(image) == 1);
+
+    //Layers share the pixels
+    CHECK(image.GetStorage()->RefCount() == 3);
+
+    //Size, mip count and format must match the first layer
+    CHECK(!array->CanHold(smaller));
+    CHECK(!array->CanHold(mipmapped));
+    CHECK(!array->CanHold(compressed));
+    CHECK(array->AddLayer(smaller) == -1);
+    CHECK(array->AddLayer(mipmapped) == -1);
+    CHECK(array->AddLayer(compressed) == -1);
+    CHECK(array->GetLayerCount() == 2);
+
+    //Full
+    for (uint32_t i = 2; i < Engine::MaxTextureArrayLayers; i++)
+      CHECK(array->AddLayer(image) == int32_t(i));
+    CHECK(array->GetLayerCount() == Engine::MaxTextureArrayLayers);
+    CHECK(!array->CanHold(image));
+    CHECK(array->AddLayer(image) == -1);
+
+    array->Clear();
+    CHECK(array->GetLayerCount() == 0);
+    CHECK(image.GetStorage()->RefCount() == 1);
+  }
+
+  image.Clear();
+  smaller.Clear();
+  mipmapped.Clear();
+  compressed.Clear();
+}
+
+TEST(Stack_TextureArray, TextureArray_Build)
+{
+  RendererScope renderer;
+
+  //Two sizes, interleaved, then a size already seen but with mipmaps
+  std::vector<Engine::TextureData> images;
+  for (uint32_t i = 0; i < Engine::MaxTextureArrayLayers + 2; i++)
+    images.push_back(MakeImage(i % 2 == 0 ? 8 : 4));
+  images.push_back(MakeImage(8, true));
+
+  std::vector<Engine::Ref<Engine::Texture2DArray>> arrays;
+  std::vector<Engine::TextureArrayLayer> layers;
+  Engine::BuildTextureArrays(images.data(), uint32_t(images.size()), arrays, layers);
+
+  CHECK(layers.size() == images.size());
+  CHECK(arrays.size() == 3);
+  CHECK(arrays[0]->GetLayerCount() == Engine::MaxTextureArrayLayers / 2 + 1);
+  CHECK(arrays[1]->GetLayerCount() == Engine::MaxTextureArrayLayers / 2 + 1);
+  CHECK(arrays[2]->GetLayerCount() == 1);
+
+  //8x8 in array 0, 4x4 in array 1, in the order given
+  for (uint32_t i = 0; i < Engine::MaxTextureArrayLayers + 2; i++)
+  {
+    CHECK(layers[i].array == i % 2);
+    CHECK(layers[i].layer == i / 2);
+  }
+
+  //Mip count differs from the plain 8x8 images
+  CHECK(layers.back().array == 2 && layers.back().layer == 0);
+
+  for (Engine::Ref<Engine::Texture2DArray> & array : arrays)
+    array->Clear();
+  arrays.clear();
+  ClearAll(images);
+}
+
+TEST(Stack_TextureArray, TextureArray_Rollover)
+{
+  RendererScope renderer;
+
+  std::vector<Engine::TextureData> images;
+  for (uint32_t i = 0; i < Engine::MaxTextureArrayLayers + 1; i++)
+    images.push_back(MakeImage(4));
+  images.push_back(MakeImage(8));
+  images.push_back(MakeImage(4));
+
+  //Arrays built earlier are left alone
+  std::vector<Engine::Ref<Engine::Texture2DArray>> arrays;
+  arrays.push_back(Engine::Texture2DArray::Create());
+  std::vector<Engine::TextureArrayLayer> layers;
+  Engine::BuildTextureArrays(images.data(), uint32_t(images.size()), arrays, layers);
+
+  CHECK(arrays.size() == 4);
+  CHECK(arrays[0]->GetLayerCount() == 0);
+  CHECK(arrays[1]->GetLayerCount() == Engine::MaxTextureArrayLayers);
+
+  //The first image past the limit starts a new array
+  uint32_t last = Engine::MaxTextureArrayLayers - 1;
+  CHECK(layers[last].array == 1 && layers[last].layer == last);
+  CHECK(layers[last + 1].array == 2 && layers[last + 1].layer == 0);
+
+  //A new size gets its own array
+  CHECK(layers[last + 2].array == 3 && layers[last + 2].layer == 0);
+
+  //The full array is skipped
+  CHECK(layers[last + 3].array == 2 && layers[last + 3].layer == 1);
+
+  for (Engine::Ref<Engine::Texture2DArray> & array : arrays)
+    array->Clear();
+  arrays.clear();
+  ClearAll(images);
+}
@@ -0,0 +1,147 @@
+#include "TestHarness.h"
+#include "TextureAtlas.h"
+
+namespace
+{
+  //Every pixel is different: 1 + its index, opaque
+  Engine::TextureData MakeImage(uint32_t a_width, uint32_t a_height, Engine::TextureWrap a_wrap)
+  {
+    RGBA * pixels = new RGBA[a_width * a_height];
+    for (uint32_t i = 0; i < a_width * a_height; i++)
+      pixels[i].data = 0xFF000000 | (i + 1);
+
+    Engine::TextureFlags flags;
+    flags.SetWrap(a_wrap);
+    return Engine::TextureData(a_width, a_height, pixels, flags);
+  }
+
+  uint32_t ImagePixel(Engine::TextureData const & a_image, uint32_t a_x, uint32_t a_y)
+  {
+    return a_image.pPixels[a_y * a_image.width + a_x].data;
+  }
+
+  uint32_t PagePixel(Engine::TextureAtlas const & a_atlas, Engine::AtlasRegion const & a_region, int32_t a_x, int32_t a_y)
+  {
+    Engine::TextureData const & page = a_atlas.pages[a_region.page];
+    return page.pPixels[size_t(int32_t(a_region.y) + a_y) * page.width + uint32_t(int32_t(a_region.x) + a_x)].data;
+  }
+
+  bool UVsMatch(Engine::TextureAtlas const & a_atlas, Engine::AtlasRegion const & a_region)
+  {
+    Engine::TextureData const & page = a_atlas.pages[a_region.page];
+    return a_region.uv[0] == float(a_region.x) / float(page.width)
+      && a_region.uv[1] == float(a_region.y) / float(page.height)
+      && a_region.uv[2] == float(a_region.x + a_region.width) / float(page.width)
+      && a_region.uv[3] == float(a_region.y + a_region.height) / float(page.height);
+  }
+}
+
+TEST(Stack_TextureAtlas, creation_TextureAtlas)
+{
+  Engine::TextureData clamp = MakeImage(4, 3, Engine::TextureWrap::Clamp);
+  Engine::TextureData repeat = MakeImage(5, 4, Engine::TextureWrap::Repeat);
+
+  Engine::TextureAtlasBuilder builder;
+  builder.SetPadding(2);
+  CHECK(builder.Add(&clamp) == 0);
+  CHECK(builder.Add(&repeat) == 1);
+
+  Engine::TextureAtlas atlas;
+  CHECK(builder.Build(atlas));
+  CHECK(atlas.pages.size() == 1);
+  CHECK(atlas.regions.size() == 2);
+
+  Engine::AtlasRegion const & rc = atlas.regions[0];
+  Engine::AtlasRegion const & rr = atlas.regions[1];
+  CHECK(rc.width == 4 && rc.height == 3);
+  CHECK(rr.width == 5 && rr.height == 4);
+  CHECK(UVsMatch(atlas, rc));
+  CHECK(UVsMatch(atlas, rr));
+
+  //The images themselves are copied as is
+  CHECK(PagePixel(atlas, rc, 0, 0) == ImagePixel(clamp, 0, 0));
+  CHECK(PagePixel(atlas, rc, 3, 2) == ImagePixel(clamp, 3, 2));
+  CHECK(PagePixel(atlas, rr, 4, 3) == ImagePixel(repeat, 4, 3));
+
+  //Clamped gutters extend the edges
+  CHECK(PagePixel(atlas, rc, -1, 1) == ImagePixel(clamp, 0, 1));
+  CHECK(PagePixel(atlas, rc, -2, -2) == ImagePixel(clamp, 0, 0));
+  CHECK(PagePixel(atlas, rc, 5, 1) == ImagePixel(clamp, 3, 1));
+  CHECK(PagePixel(atlas, rc, 2, 4) == ImagePixel(clamp, 2, 2));
+
+  //Repeating gutters wrap around
+  CHECK(PagePixel(atlas, rr, -1, 0) == ImagePixel(repeat, 4, 0));
+  CHECK(PagePixel(atlas, rr, -2, 1) == ImagePixel(repeat, 3, 1));
+  CHECK(PagePixel(atlas, rr, 0, -1) == ImagePixel(repeat, 0, 3));
+  CHECK(PagePixel(atlas, rr, 5, 4) == ImagePixel(repeat, 0, 0));
+  CHECK(PagePixel(atlas, rr, 6, 5) == ImagePixel(repeat, 1, 1));
+
+  for (Engine::TextureData & page : atlas.pages)
+    page.Clear();
+  clamp.Clear();
+  repeat.Clear();
+}
+
+TEST(Stack_TextureAtlas, TextureAtlas_Overflow)
+{
+  //With gutters, only one image fits on a page
+  Engine::TextureData a = MakeImage(40, 40, Engine::TextureWrap::Clamp);
+  Engine::TextureData b = MakeImage(40, 40, Engine::TextureWrap::Clamp);
+
+  Engine::TextureAtlasBuilder builder;
+  builder.SetMaxPageSize(64);
+  builder.Add(&a);
+  builder.Add(&b);
+
+  Engine::TextureAtlas atlas;
+  CHECK(builder.Build(atlas));
+  CHECK(atlas.pages.size() == 2);
+  CHECK(atlas.regions[0].page != atlas.regions[1].page);
+  for (Engine::AtlasRegion const & region : atlas.regions)
+  {
+    CHECK(atlas.pages[region.page].width <= 64 && atlas.pages[region.page].height <= 64);
+    CHECK(UVsMatch(atlas, region));
+  }
+  CHECK(PagePixel(atlas, atlas.regions[1], 39, 39) == ImagePixel(b, 39, 39));
+
+  //Too large for any page
+  Engine::TextureData large = MakeImage(62, 8, Engine::TextureWrap::Clamp);
+  builder.Add(&large);
+  CHECK(!builder.Build(atlas));
+
+  for (Engine::TextureData & page : atlas.pages)
+    page.Clear();
+  a.Clear();
+  b.Clear();
+  large.Clear();
+}
+
+TEST(Stack_TextureAtlas, TextureAtlas_Rebuild)
+{
+  Engine::TextureData a = MakeImage(40, 40, Engine::TextureWrap::Clamp);
+
+  //Rounding up to a power of two would give 64
+  Engine::TextureAtlasBuilder builder;
+  builder.SetMaxPageSize(50);
+  builder.Add(&a);
+
+  Engine::TextureAtlas atlas;
+  CHECK(builder.Build(atlas));
+  CHECK(atlas.pages.size() == 1);
+  CHECK(atlas.pages[0].width == 50 && atlas.pages[0].height == 50);
+  CHECK(UVsMatch(atlas, atlas.regions[0]));
+  CHECK(PagePixel(atlas, atlas.regions[0], 41, 41) == ImagePixel(a, 39, 39));
+
+  //Building into the same atlas releases the old pages
+  Engine::TextureData oldPage;
+  oldPage.Duplicate(atlas.pages[0]);
+  CHECK(oldPage.GetStorage()->RefCount() == 2);
+  CHECK(builder.Build(atlas));
+  CHECK(oldPage.GetStorage()->RefCount() == 1);
+  CHECK(atlas.pages[0].GetStorage() != oldPage.GetStorage());
+
+  oldPage.Clear();
+  for (Engine::TextureData & page : atlas.pages)
+    page.Clear();
+  a.Clear();
+}
@@ -0,0 +1,104 @@
+#include <vector>
+#include "TestHarness.h"
+#include "TextureResidency.h"
+
+namespace
+{
+  //8x8 RGBA8 with a full mip chain: 256 + 64 + 16 + 4 bytes
+  Engine::TextureData MakeTexture()
+  {
+    RGBA * pixels = new RGBA[8 * 8];
+    for (int i = 0; i < 64; i++)
+      pixels[i].data = 0xFF808080;
+
+    Engine::TextureFlags flags;
+    flags.SetIsStreamable(true);
+    Engine::TextureData data(8, 8, pixels, flags);
+    data.GenerateMipmaps();
+    return data;
+  }
+
+  Engine::RenderHandle Handle(uint32_t a_index)
+  {
+    return Engine::RenderHandle{a_index, 1};
+  }
+}
+
+TEST(Stack_TextureResidency, creation_TextureResidency)
+{
+  Engine::TextureData data = MakeTexture();
+  CHECK(data.flags.IsStreamable());
+  CHECK(data.DataSize() == 340);
+
+  Engine::TextureResidency residency;
+  residency.Add(Handle(0), data);
+  residency.Add(Handle(1), data);
+  CHECK(residency.GetStats().residentBytes == 680);
+  CHECK(residency.GetData(Handle(0))->pPixels == data.pPixels);
+  CHECK(residency.GetData(Engine::RenderHandle{0, 2}) == nullptr);
+
+  //No budget, nothing to do
+  std::vector<Engine::TextureResidency::Change> changes;
+  residency.EndFrame();
+  residency.Trim(changes);
+  CHECK(changes.empty());
+
+  residency.Remove(Handle(1));
+  CHECK(residency.GetStats().residentBytes == 340);
+
+  residency.Clear();
+  data.Clear();
+}
+
+TEST(Stack_TextureResidency, TextureResidency_Trim)
+{
+  Engine::TextureData data = MakeTexture();
+  Engine::TextureResidency residency;
+  for (uint32_t i = 0; i < 3; i++)
+    residency.Add(Handle(i), data);
+  residency.EndFrame();
+
+  //Texture 0 is the least recently used
+  residency.Touch(Handle(1));
+  residency.Touch(Handle(2));
+  residency.EndFrame();
+  residency.Touch(Handle(2));
+
+  //Dropping the top level of 0 and 1 is enough: 84 + 84 + 340
+  std::vector<Engine::TextureResidency::Change> changes;
+  residency.SetBudget(600);
+  residency.Trim(changes);
+  CHECK(changes.size() == 2);
+  CHECK(changes[0].handle.index == 0 && changes[0].baseLevel == 1);
+  CHECK(changes[1].handle.index == 1 && changes[1].baseLevel == 1);
+  CHECK(residency.GetStats().residentBytes == 508);
+  CHECK(residency.GetStats().mipDrops == 2);
+
+  //Texture 2 was used this frame, so is left alone. Both lose another level, then 0 is
+  //evicted: 0 + 20 + 340
+  changes.clear();
+  residency.SetBudget(360);
+  residency.Trim(changes);
+  CHECK(changes.size() == 2);
+  CHECK(changes[0].handle.index == 0 && changes[0].baseLevel == 4);
+  CHECK(changes[1].handle.index == 1 && changes[1].baseLevel == 2);
+  CHECK(residency.GetStats().evictions == 1);
+  CHECK(residency.GetStats().residentBytes == 360);
+
+  //Binding an evicted texture queues it to stream back in
+  residency.EndFrame();
+  CHECK(!residency.Touch(Handle(0)));
+  CHECK(!residency.Touch(Handle(0)));
+  CHECK(residency.Touch(Handle(2)));
+  changes.clear();
+  residency.Restore(1024, changes);
+  CHECK(changes.size() == 1);
+  CHECK(changes[0].handle.index == 0 && changes[0].baseLevel == 0);
+  CHECK(residency.GetBaseLevel(Handle(0)) == 0);
+  CHECK(residency.GetStats().restores == 1);
+  CHECK(residency.GetStats().binds == 6);
+  CHECK(residency.GetStats().hits == 4);
+
+  residency.Clear();
+  data.Clear();
+}
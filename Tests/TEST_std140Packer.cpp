@@ -0,0 +1,68 @@
+#include <stddef.h>
+#include "TestHarness.h"
+#include "std140Packer.h"
+
+namespace
+{
+  struct Light
+  {
+    float   colour[3];
+    float   intensity;
+    float   transform[16];
+    float   weights[3];
+    int32_t flags;
+    float   normalMat[9];
+  };
+
+  typedef Engine::std140Packer<Light,
+    Engine::std140Field<Engine::ShaderDataType::VEC3,  offsetof(Light, colour)>,
+    Engine::std140Field<Engine::ShaderDataType::FLOAT, offsetof(Light, intensity)>,
+    Engine::std140Field<Engine::ShaderDataType::MAT4,  offsetof(Light, transform)>,
+    Engine::std140Field<Engine::ShaderDataType::FLOAT, offsetof(Light, weights), 3>,
+    Engine::std140Field<Engine::ShaderDataType::INT,   offsetof(Light, flags)>,
+    Engine::std140Field<Engine::ShaderDataType::MAT3,  offsetof(Light, normalMat)>> LightPacker;
+
+  static_assert(LightPacker::Offset(0) == 0, "");
+  static_assert(LightPacker::Offset(1) == 12, "");
+  static_assert(LightPacker::Offset(2) == 16, "");
+  static_assert(LightPacker::Offset(3) == 80, "");
+  static_assert(LightPacker::Offset(4) == 128, "");
+  static_assert(LightPacker::Offset(5) == 144, "");
+  static_assert(LightPacker::Size == 192, "");
+}
+
+TEST(Stack_std140Packer, creation_std140Packer)
+{
+  Light light;
+  for (int i = 0; i < 3; i++)   light.colour[i] = float(i);
+  light.intensity = 3.0f;
+  for (int i = 0; i < 16; i++)  light.transform[i] = float(10 + i);
+  for (int i = 0; i < 3; i++)   light.weights[i] = float(30 + i);
+  light.flags = 42;
+  for (int i = 0; i < 9; i++)   light.normalMat[i] = float(40 + i);
+
+  //Colour, intensity, transform and weights[0] are contiguous at both ends
+  CHECK(LightPacker::CopyCount == 7);
+
+  float buf[LightPacker::Size / sizeof(float)] = {};
+  LightPacker::Pack(buf, light);
+
+  CHECK(buf[0] == 0.0f && buf[1] == 1.0f && buf[2] == 2.0f);
+  CHECK(buf[3] == 3.0f);
+  for (int i = 0; i < 16; i++)
+    CHECK(buf[4 + i] == float(10 + i));
+
+  //Array elements are padded to a vec4
+  CHECK(buf[20] == 30.0f && buf[21] == 0.0f);
+  CHECK(buf[24] == 31.0f);
+  CHECK(buf[28] == 32.0f);
+
+  int32_t flags = 0;
+  memcpy(&flags, &buf[32], sizeof(flags));
+  CHECK(flags == 42);
+
+  //mat3 columns are padded to a vec4
+  CHECK(buf[36] == 40.0f && buf[37] == 41.0f && buf[38] == 42.0f && buf[39] == 0.0f);
+  CHECK(buf[40] == 43.0f);
+  CHECK(buf[44] == 46.0f && buf[46] == 48.0f);
+}
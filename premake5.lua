@@ -1,3 +1,9 @@
+newoption
+{
+  trigger = "benchmarks",
+  description = "Build the throughput benchmarks into the Tests project"
+}
+
 workspace "BSR"
   location ""
   architecture "x64"
@@ -166,6 +172,8 @@ project "Tests"
   {
     "Tests/**.h",
     "Tests/**.cpp",
+    "Editor/src/BSPTreeBuilder.cpp",
+    "Editor/src/BlockPartition.cpp",
   }
 
   links
@@ -184,9 +192,13 @@ project "Tests"
 		"%{IncludeDir.DgLib}",
     "%{wks.location}/Core/src",
     "%{wks.location}/Engine/src",
-    "%{wks.location}/GameCommon/src"
+    "%{wks.location}/GameCommon/src",
+    "%{wks.location}/Editor/src"
   }
 
+  filter "options:benchmarks"
+    defines "BSR_BENCHMARKS"
+
   filter "configurations:Debug"
 	 runtime "Debug"
 	 symbols "on"
@@ -260,6 +272,7 @@ project "Engine"
     "DgLib",
     "Glad",
     "Core",
+    "GameCommon",
     "Vendor/SDL2-2.0.9/lib/x64/SDL2.lib",
     "Vendor/SDL2-2.0.9/lib/x64/SDL2main.lib"
   }
@@ -267,6 +280,7 @@ project "Engine"
   includedirs
   {
     "%{wks.location}/Core/src",
+    "%{wks.location}/GameCommon/src",
 		"%{IncludeDir.spdlog}",
 		"%{IncludeDir.DgLib}",
 		"%{IncludeDir.Glad}",